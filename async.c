@@ -0,0 +1,628 @@
+/**
+ * @file async.c
+ * @brief Ce fichier contient les définitions du moteur d'entrées/sorties asynchrones : io_uring, ou groupe de threads lorsque io_uring n'est pas disponible.
+ */
+
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "projet.h"
+
+/**
+ * @brief Ajoute un morceau en fin de file d'attente du moteur.
+ * @param engine Le moteur.
+ * @param op Le morceau.
+ */
+static void queueOp(AsyncEngine* engine, AsyncOp* op) {
+    op->next = NULL;
+    if (engine->queued_tail != NULL) {
+        engine->queued_tail->next = op;
+    } else {
+        engine->queued_head = op;
+    }
+    engine->queued_tail = op;
+}
+
+/**
+ * @brief Replace un morceau en tête de file d'attente, pour qu'il soit retransmis en premier.
+ * @param engine Le moteur.
+ * @param op Le morceau.
+ */
+static void requeueOp(AsyncEngine* engine, AsyncOp* op) {
+    op->next = engine->queued_head;
+    engine->queued_head = op;
+    if (engine->queued_tail == NULL) {
+        engine->queued_tail = op;
+    }
+}
+
+/**
+ * @brief Ajoute une requête terminée à la file des requêtes dont la fonction reste à appeler.
+ * @param engine Le moteur.
+ * @param request La requête.
+ */
+static void finishRequest(AsyncEngine* engine, AsyncRequest* request) {
+    request->next = NULL;
+    if (engine->ready_tail != NULL) {
+        engine->ready_tail->next = request;
+    } else {
+        engine->ready_head = request;
+    }
+    engine->ready_tail = request;
+}
+
+/**
+ * @brief Vérifie ou note les codes de contrôle des blocs d'un morceau transféré en entier.
+ * 
+ * Une lecture ne porte que sur des blocs entiers, comparés à leur code.
+ * Après une écriture, le code de chaque bloc est recalculé puis écrit, et
+ * les copies non modifiées des blocs qui auraient été chargées dans le cache
+ * pendant le transfert sont retirées.
+ * 
+ * @param partition La partition.
+ * @param op Le morceau.
+ * @return 0 en cas de succès, -1 si un bloc lu est corrompu ou en cas d'erreur.
+ */
+static int checkOp(Partition* partition, AsyncOp* op) {
+    off_t data_start = dataBlockOffset(partition, 0);
+    unsigned shift = partition->block_shift;
+    uint64_t first = (op->first_offset - data_start) >> shift;
+    uint64_t last = (op->first_offset + op->first_length - 1 - data_start) >> shift;
+
+    // Le tampon a avancé avec les transferts partiels, mais pas sa fin
+    off_t offset = op->first_offset;
+    const char* data = (const char*)op->iov.iov_base + op->iov.iov_len - op->first_length;
+    for (uint64_t block = first; block <= last; ++block) {
+        size_t length = dataBlockOffset(partition, block + 1) - offset;
+        if (length > (size_t)(op->first_offset + op->first_length - offset)) {
+            length = op->first_offset + op->first_length - offset;
+        }
+        if (!op->write_mode) {
+            if (verifyBlockChecksum(partition, block, data) == -1) {
+                return -1;
+            }
+        } else if (updateBlockChecksum(partition, offset, data, length) == NO_BLOCK) {
+            return -1;
+        }
+        offset += length;
+        data += length;
+    }
+    if (!op->write_mode) {
+        return 0;
+    }
+    for (uint64_t block = first; block <= last; ++block) {
+        cacheDiscardClean(&partition->cache, block);
+    }
+    return dirtyBlockChecksums(partition, first, last - first + 1);
+}
+
+/**
+ * @brief Traite la fin du transfert d'un morceau.
+ * 
+ * Un transfert partiel ou interrompu est remis en file pour son reste. Un
+ * morceau lu est vérifié, les codes de contrôle d'un morceau écrit notés.
+ * 
+ * @param engine Le moteur.
+ * @param op Le morceau.
+ * @param result Le nombre d'octets transférés, ou l'opposé d'un code errno.
+ */
+static void completeOp(AsyncEngine* engine, AsyncOp* op, ssize_t result) {
+    engine->inflight--;
+    if (result == -EINTR || result == -EAGAIN) {
+        requeueOp(engine, op);
+        return;
+    }
+    if (result > 0 && (size_t)result < op->iov.iov_len) {
+        op->offset += result;
+        op->iov.iov_base = (char*)op->iov.iov_base + result;
+        op->iov.iov_len -= result;
+        requeueOp(engine, op);
+        return;
+    }
+
+    AsyncRequest* request = op->request;
+    engine->stats.ops++;
+    if (result < 0 || (result == 0 && op->iov.iov_len > 0)) {
+        request->result = -1;
+    } else if (checkOp(engine->partition, op) == -1) {
+        request->result = op->write_mode ? -1 : ERROR_CHECKSUM;
+    }
+    if (--request->pending == 0) {
+        finishRequest(engine, request);
+    }
+}
+
+/**
+ * @brief Appelle les fonctions des requêtes terminées puis les libère.
+ * 
+ * Le verrou du moteur est relâché pendant chaque appel, pour que la fonction
+ * puisse soumettre de nouvelles requêtes.
+ * 
+ * @param engine Le moteur, verrouillé.
+ * @return Le nombre de requêtes traitées.
+ */
+static int runCallbacks(AsyncEngine* engine) {
+    int count = 0;
+    while (engine->ready_head != NULL) {
+        AsyncRequest* request = engine->ready_head;
+        engine->ready_head = request->next;
+        if (engine->ready_head == NULL) {
+            engine->ready_tail = NULL;
+        }
+        engine->outstanding--;
+        engine->stats.requests++;
+        pthread_mutex_unlock(&engine->lock);
+        if (request->callback != NULL) {
+            request->callback(request->arg, request->result);
+        }
+        free(request);
+        count++;
+        pthread_mutex_lock(&engine->lock);
+    }
+    return count;
+}
+
+/**
+ * @brief Crée une instance io_uring et projette ses anneaux.
+ * @param ring Les anneaux.
+ * @param entries Le nombre d'entrées souhaité.
+ * @return 0 en cas de succès, -1 si io_uring n'est pas disponible.
+ */
+static int ringSetup(AsyncRing* ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(AsyncRing));
+    ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        ring->fd = -1;
+        return -1;
+    }
+
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    int single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map) {
+        // Les deux anneaux partagent une seule projection
+        if (ring->cq_map_size > ring->sq_map_size) {
+            ring->sq_map_size = ring->cq_map_size;
+        }
+        ring->cq_map_size = ring->sq_map_size;
+    }
+
+    ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED) {
+        ring->sq_map = NULL;
+        close(ring->fd);
+        ring->fd = -1;
+        return -1;
+    }
+    ring->cq_map = single_map ? ring->sq_map
+                              : mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->cq_map == MAP_FAILED || sqes == MAP_FAILED) {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, ring->sqes_size);
+        }
+        if (ring->cq_map != MAP_FAILED && ring->cq_map != ring->sq_map) {
+            munmap(ring->cq_map, ring->cq_map_size);
+        }
+        munmap(ring->sq_map, ring->sq_map_size);
+        close(ring->fd);
+        memset(ring, 0, sizeof(AsyncRing));
+        ring->fd = -1;
+        return -1;
+    }
+
+    char* sq = ring->sq_map;
+    char* cq = ring->cq_map;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->sq_entries = params.sq_entries;
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    ring->sqes = sqes;
+    return 0;
+}
+
+/**
+ * @brief Libère les anneaux et l'instance io_uring.
+ * @param ring Les anneaux.
+ */
+static void ringDestroy(AsyncRing* ring) {
+    if (ring->fd < 0) {
+        return;
+    }
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_map != ring->sq_map) {
+        munmap(ring->cq_map, ring->cq_map_size);
+    }
+    munmap(ring->sq_map, ring->sq_map_size);
+    close(ring->fd);
+    memset(ring, 0, sizeof(AsyncRing));
+    ring->fd = -1;
+}
+
+/**
+ * @brief Signale au noyau les entrées ajoutées à l'anneau et attend éventuellement des complétions.
+ * @param engine Le moteur.
+ * @param min_complete Le nombre de complétions à attendre.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int ringEnter(AsyncEngine* engine, unsigned min_complete) {
+    AsyncRing* ring = &engine->ring;
+    for (;;) {
+        engine->stats.enter_calls++;
+        statsAdd(&engine->partition->stats, STATS_SYSCALLS, 1);
+        int submitted = syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, min_complete,
+                                min_complete > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (submitted >= 0) {
+            ring->to_submit -= submitted;
+            return 0;
+        }
+        if (errno != EINTR) {
+            perror("Erreur lors de la soumission des entrées/sorties asynchrones");
+            return -1;
+        }
+    }
+}
+
+/**
+ * @brief Place un morceau dans l'anneau de soumission.
+ * @param engine Le moteur.
+ * @param op Le morceau.
+ * @return 0 en cas de succès, -1 si l'anneau est plein.
+ */
+static int ringPush(AsyncEngine* engine, AsyncOp* op) {
+    AsyncRing* ring = &engine->ring;
+    unsigned tail = *ring->sq_tail;
+    if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+        return -1;
+    }
+
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = op->write_mode ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = engine->partition->fileDescriptor;
+    sqe->addr = (uint64_t)(uintptr_t)&op->iov;
+    sqe->len = 1;
+    sqe->off = op->offset;
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+    ring->sq_array[index] = index;
+
+    // L'entrée doit être visible du noyau avant la nouvelle queue
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+    return 0;
+}
+
+/**
+ * @brief Traite les complétions présentes dans l'anneau de complétion, sans attendre.
+ * @param engine Le moteur.
+ */
+static void ringReap(AsyncEngine* engine) {
+    AsyncRing* ring = &engine->ring;
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+        AsyncOp* op = (AsyncOp*)(uintptr_t)cqe->user_data;
+        ssize_t result = cqe->res;
+
+        // Rendre l'entrée au noyau avant de traiter le morceau
+        __atomic_store_n(ring->cq_head, ++head, __ATOMIC_RELEASE);
+        completeOp(engine, op, result);
+    }
+}
+
+/**
+ * @brief Boucle d'un thread du groupe : transfère les morceaux de la file de travail.
+ * @param arg Le groupe de threads.
+ * @return NULL.
+ */
+static void* poolWorker(void* arg) {
+    AsyncPool* pool = arg;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->work_head == NULL && !pool->stopping) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        if (pool->work_head == NULL) {
+            break;
+        }
+        AsyncOp* op = pool->work_head;
+        pool->work_head = op->next;
+        if (pool->work_head == NULL) {
+            pool->work_tail = NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        size_t length = op->iov.iov_len;
+        ssize_t done = op->write_mode ? partitionWrite(pool->partition, op->iov.iov_base, length, op->offset)
+                                      : partitionRead(pool->partition, op->iov.iov_base, length, op->offset);
+        op->result = done == (ssize_t)length ? done : -EIO;
+
+        pthread_mutex_lock(&pool->lock);
+        op->next = NULL;
+        if (pool->done_tail != NULL) {
+            pool->done_tail->next = op;
+        } else {
+            pool->done_head = op;
+        }
+        pool->done_tail = op;
+        pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/**
+ * @brief Arrête les threads du groupe.
+ * @param pool Le groupe de threads.
+ */
+static void poolStop(AsyncPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->num_threads; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    pool->num_threads = 0;
+}
+
+/**
+ * @brief Démarre le groupe de threads.
+ * @param pool Le groupe de threads.
+ * @param partition La partition lue et écrite par les threads.
+ * @param num_threads Le nombre de threads.
+ * @return 0 en cas de succès, -1 si aucun thread n'a pu être créé.
+ */
+static int poolStart(AsyncPool* pool, struct Partition* partition, int num_threads) {
+    memset(pool, 0, sizeof(AsyncPool));
+    pool->partition = partition;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (int i = 0; i < num_threads; ++i) {
+        if (pthread_create(&pool->threads[i], NULL, poolWorker, pool) != 0) {
+            break;
+        }
+        pool->num_threads++;
+    }
+    if (pool->num_threads == 0) {
+        perror("Erreur lors de la création des threads d'entrées/sorties");
+        poolStop(pool);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Traite les morceaux terminés par le groupe de threads.
+ * @param engine Le moteur.
+ * @param wait 1 pour attendre au moins un morceau s'il y en a en cours.
+ */
+static void poolReap(AsyncEngine* engine, int wait) {
+    AsyncPool* pool = &engine->pool;
+    pthread_mutex_lock(&pool->lock);
+    while (wait && pool->done_head == NULL && engine->inflight > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    AsyncOp* op = pool->done_head;
+    pool->done_head = pool->done_tail = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    while (op != NULL) {
+        AsyncOp* next = op->next;
+        completeOp(engine, op, op->result);
+        op = next;
+    }
+}
+
+/**
+ * @brief Fonction pour démarrer le moteur asynchrone.
+ * @param engine Le moteur.
+ * @param partition La partition.
+ * @param depth Le nombre maximal de morceaux en cours.
+ * @param backend Le moteur souhaité.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int asyncInit(AsyncEngine* engine, struct Partition* partition, unsigned depth, int backend) {
+    memset(engine, 0, sizeof(AsyncEngine));
+    engine->partition = partition;
+    engine->ring.fd = -1;
+    engine->depth = depth == 0 ? 1 : depth > ASYNC_MAX_DEPTH ? ASYNC_MAX_DEPTH : depth;
+
+    if (backend != ASYNC_BACKEND_THREADS && ringSetup(&engine->ring, engine->depth) == 0) {
+        engine->backend = ASYNC_BACKEND_URING;
+    }
+    if (engine->backend == 0 && backend != ASYNC_BACKEND_URING) {
+        // Repli : un thread par morceau en cours, dans la limite de ASYNC_MAX_THREADS
+        int num_threads = engine->depth < ASYNC_MAX_THREADS ? (int)engine->depth : ASYNC_MAX_THREADS;
+        if (poolStart(&engine->pool, partition, num_threads) == 0) {
+            engine->backend = ASYNC_BACKEND_THREADS;
+        }
+    }
+    if (engine->backend == 0) {
+        return -1;
+    }
+    pthread_mutex_init(&engine->lock, NULL);
+    return 0;
+}
+
+/**
+ * @brief Fonction pour arrêter le moteur asynchrone.
+ * @param engine Le moteur.
+ */
+void asyncDestroy(AsyncEngine* engine) {
+    if (engine->backend == 0) {
+        return;
+    }
+    asyncReap(engine, INT_MAX);
+    if (engine->backend == ASYNC_BACKEND_URING) {
+        ringDestroy(&engine->ring);
+    } else {
+        poolStop(&engine->pool);
+    }
+    pthread_mutex_destroy(&engine->lock);
+    engine->backend = 0;
+}
+
+/**
+ * @brief Fonction pour ajouter une requête préparée aux files du moteur.
+ * @param engine Le moteur.
+ * @param request La requête.
+ */
+void asyncQueue(AsyncEngine* engine, AsyncRequest* request) {
+    pthread_mutex_lock(&engine->lock);
+    engine->outstanding++;
+    request->pending = request->num_ops;
+    if (request->num_ops == 0) {
+        finishRequest(engine, request);
+    }
+    for (int i = 0; i < request->num_ops; ++i) {
+        AsyncOp* op = &request->ops[i];
+        op->request = request;
+        op->first_offset = op->offset;
+        op->first_length = op->iov.iov_len;
+        queueOp(engine, op);
+    }
+    pthread_mutex_unlock(&engine->lock);
+}
+
+/**
+ * @brief Transmet les morceaux en attente, dans la limite de la profondeur.
+ * @param engine Le moteur, verrouillé.
+ * @return Le nombre de morceaux transmis, -1 en cas d'erreur.
+ */
+static int submitOps(AsyncEngine* engine) {
+    int submitted = 0;
+    AsyncOp* work_head = NULL;
+    AsyncOp* work_tail = NULL;
+    while (engine->queued_head != NULL && engine->inflight < engine->depth) {
+        AsyncOp* op = engine->queued_head;
+        if (engine->backend == ASYNC_BACKEND_URING && ringPush(engine, op) == -1) {
+            break;
+        }
+        engine->queued_head = op->next;
+        if (engine->queued_head == NULL) {
+            engine->queued_tail = NULL;
+        }
+        if (engine->backend == ASYNC_BACKEND_THREADS) {
+            // Les morceaux sont confiés aux threads en une seule prise du verrou
+            op->next = NULL;
+            if (work_tail != NULL) {
+                work_tail->next = op;
+            } else {
+                work_head = op;
+            }
+            work_tail = op;
+        }
+        engine->inflight++;
+        submitted++;
+    }
+    if (engine->inflight > engine->stats.max_inflight) {
+        engine->stats.max_inflight = engine->inflight;
+    }
+
+    if (engine->backend == ASYNC_BACKEND_URING) {
+        if (engine->ring.to_submit > 0 && ringEnter(engine, 0) == -1) {
+            return -1;
+        }
+    } else if (work_head != NULL) {
+        AsyncPool* pool = &engine->pool;
+        pthread_mutex_lock(&pool->lock);
+        if (pool->work_tail != NULL) {
+            pool->work_tail->next = work_head;
+        } else {
+            pool->work_head = work_head;
+        }
+        pool->work_tail = work_tail;
+        pthread_cond_broadcast(&pool->work);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return submitted;
+}
+
+/**
+ * @brief Fonction pour transmettre les morceaux en attente.
+ * @param engine Le moteur.
+ * @return Le nombre de morceaux transmis, -1 en cas d'erreur.
+ */
+int asyncSubmit(AsyncEngine* engine) {
+    if (engine->backend == 0) {
+        return -1;
+    }
+    pthread_mutex_lock(&engine->lock);
+    int submitted = submitOps(engine);
+    pthread_mutex_unlock(&engine->lock);
+    return submitted;
+}
+
+/**
+ * @brief Fonction pour traiter les requêtes terminées.
+ * @param engine Le moteur.
+ * @param min Le nombre de requêtes terminées à attendre.
+ * @return Le nombre de requêtes terminées, -1 en cas d'erreur.
+ */
+int asyncReap(AsyncEngine* engine, int min) {
+    if (engine->backend == 0) {
+        return 0;
+    }
+
+    int completed = 0;
+    pthread_mutex_lock(&engine->lock);
+    for (;;) {
+        if (submitOps(engine) == -1) {
+            completed = -1;
+            break;
+        }
+        if (engine->backend == ASYNC_BACKEND_URING) {
+            ringReap(engine);
+        } else {
+            poolReap(engine, 0);
+        }
+        completed += runCallbacks(engine);
+
+        // Les fonctions appelées ont pu soumettre de nouvelles requêtes
+        if (completed >= min || engine->outstanding == 0) {
+            break;
+        }
+        if (engine->inflight == 0) {
+            if (engine->queued_head == NULL) {
+                break;
+            }
+            continue; // Des morceaux remis en file attendent d'être retransmis
+        }
+        if (engine->backend == ASYNC_BACKEND_URING) {
+            if (ringEnter(engine, 1) == -1) {
+                completed = -1;
+                break;
+            }
+        } else {
+            poolReap(engine, 1);
+        }
+    }
+    pthread_mutex_unlock(&engine->lock);
+    return completed;
+}
+
+/**
+ * @brief Fonction pour obtenir les compteurs d'activité du moteur.
+ * @param engine Le moteur.
+ * @param stats Les compteurs à remplir.
+ */
+void asyncGetStats(AsyncEngine* engine, AsyncStats* stats) {
+    pthread_mutex_lock(&engine->lock);
+    *stats = engine->stats;
+    pthread_mutex_unlock(&engine->lock);
+}
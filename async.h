@@ -0,0 +1,226 @@
+/**
+ * @file async.h
+ * @brief Ce fichier contient les déclarations du moteur d'entrées/sorties asynchrones sur la partition.
+ */
+
+#ifndef ASYNC_H_
+#define ASYNC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * @def ASYNC_DEPTH
+ * @brief Nombre maximal par défaut de transferts en cours sur la partition.
+ */
+#define ASYNC_DEPTH 32
+
+/**
+ * @def ASYNC_MAX_DEPTH
+ * @brief Profondeur de file maximale (taille de l'anneau io_uring).
+ */
+#define ASYNC_MAX_DEPTH 256
+
+/**
+ * @def ASYNC_MAX_THREADS
+ * @brief Nombre maximal de threads du moteur de secours.
+ */
+#define ASYNC_MAX_THREADS 64
+
+/**
+ * @def ASYNC_BACKEND_AUTO
+ * @brief Utiliser io_uring s'il est disponible, sinon le groupe de threads.
+ */
+#define ASYNC_BACKEND_AUTO 0
+
+/**
+ * @def ASYNC_BACKEND_URING
+ * @brief Transferts soumis au noyau par io_uring.
+ */
+#define ASYNC_BACKEND_URING 1
+
+/**
+ * @def ASYNC_BACKEND_THREADS
+ * @brief Transferts exécutés en pread/pwrite par un groupe de threads.
+ */
+#define ASYNC_BACKEND_THREADS 2
+
+/**
+ * @brief Fonction appelée à la fin d'une requête asynchrone.
+ * 
+ * @param arg L'argument fourni avec la requête.
+ * @param result Le nombre d'octets transférés, -1 en cas d'erreur.
+ */
+typedef void (*AsyncCallback)(void* arg, int64_t result);
+
+struct AsyncRequest;
+struct Partition;
+
+/**
+ * @struct AsyncOp
+ * @brief Morceau d'une requête asynchrone transféré directement avec la partition.
+ */
+typedef struct AsyncOp {
+    struct AsyncRequest* request; /**< Requête à laquelle appartient le morceau. */
+    off_t offset; /**< Position dans la partition du reste à transférer. */
+    struct iovec iov; /**< Reste du tampon à transférer. */
+    int write_mode; /**< 1 pour une écriture, 0 pour une lecture. */
+    off_t first_offset; /**< Position initiale du morceau dans la partition. */
+    size_t first_length; /**< Longueur initiale du morceau. */
+    ssize_t result; /**< Résultat du transfert (groupe de threads). */
+    struct AsyncOp* next; /**< Morceau suivant dans une file d'attente. */
+} AsyncOp;
+
+/**
+ * @struct AsyncRequest
+ * @brief Requête asynchrone : un transfert positionné sur un fichier, découpé en morceaux.
+ */
+typedef struct AsyncRequest {
+    AsyncCallback callback; /**< Fonction appelée à la fin de la requête. */
+    void* arg; /**< Argument de la fonction. */
+    int64_t result; /**< Nombre d'octets transférés, ou -1 après une erreur. */
+    int pending; /**< Nombre de morceaux non terminés. */
+    int num_ops; /**< Nombre de morceaux. */
+    struct AsyncRequest* next; /**< Requête suivante dans la file des requêtes terminées. */
+    AsyncOp ops[]; /**< Morceaux à transférer directement. */
+} AsyncRequest;
+
+/**
+ * @struct AsyncRing
+ * @brief Anneaux de soumission et de complétion partagés avec le noyau (io_uring).
+ */
+typedef struct {
+    int fd; /**< Descripteur de l'instance io_uring, -1 si aucune. */
+    unsigned* sq_head; /**< Tête de l'anneau de soumission, avancée par le noyau. */
+    unsigned* sq_tail; /**< Queue de l'anneau de soumission. */
+    unsigned* sq_mask; /**< Masque des indices de l'anneau de soumission. */
+    unsigned* sq_array; /**< Indices des entrées soumises. */
+    unsigned sq_entries; /**< Nombre d'entrées de l'anneau de soumission. */
+    unsigned* cq_head; /**< Tête de l'anneau de complétion. */
+    unsigned* cq_tail; /**< Queue de l'anneau de complétion, avancée par le noyau. */
+    unsigned* cq_mask; /**< Masque des indices de l'anneau de complétion. */
+    struct io_uring_sqe* sqes; /**< Entrées de soumission. */
+    struct io_uring_cqe* cqes; /**< Entrées de complétion. */
+    void* sq_map; /**< Projection de l'anneau de soumission. */
+    size_t sq_map_size; /**< Taille de la projection de l'anneau de soumission. */
+    void* cq_map; /**< Projection de l'anneau de complétion (égale à sq_map si partagée). */
+    size_t cq_map_size; /**< Taille de la projection de l'anneau de complétion. */
+    size_t sqes_size; /**< Taille de la projection des entrées de soumission. */
+    unsigned to_submit; /**< Entrées ajoutées à l'anneau et pas encore signalées au noyau. */
+} AsyncRing;
+
+/**
+ * @struct AsyncPool
+ * @brief Groupe de threads exécutant les transferts lorsque io_uring n'est pas disponible.
+ */
+typedef struct {
+    struct Partition* partition; /**< Partition lue et écrite par les threads. */
+    pthread_t threads[ASYNC_MAX_THREADS]; /**< Threads de travail. */
+    int num_threads; /**< Nombre de threads démarrés. */
+    pthread_mutex_t lock; /**< Protège les deux files et stopping. */
+    pthread_cond_t work; /**< Signalé lorsqu'un morceau est ajouté à la file de travail. */
+    pthread_cond_t done; /**< Signalé lorsqu'un morceau est terminé. */
+    AsyncOp* work_head; /**< Premier morceau à transférer. */
+    AsyncOp* work_tail; /**< Dernier morceau à transférer. */
+    AsyncOp* done_head; /**< Premier morceau terminé. */
+    AsyncOp* done_tail; /**< Dernier morceau terminé. */
+    int stopping; /**< 1 lorsque les threads doivent s'arrêter. */
+} AsyncPool;
+
+/**
+ * @struct AsyncStats
+ * @brief Compteurs d'activité du moteur asynchrone.
+ */
+typedef struct {
+    unsigned long requests; /**< Requêtes terminées. */
+    unsigned long ops; /**< Morceaux transférés directement avec la partition. */
+    unsigned long enter_calls; /**< Appels système io_uring_enter. */
+    unsigned long max_inflight; /**< Plus grand nombre de morceaux en cours simultanément. */
+} AsyncStats;
+
+/**
+ * @struct AsyncEngine
+ * @brief Moteur d'entrées/sorties asynchrones de la partition.
+ * 
+ * Les files et les compteurs sont protégés par lock, qui n'est relâché que
+ * pendant l'appel des fonctions des requêtes terminées.
+ */
+typedef struct {
+    struct Partition* partition; /**< Partition sur laquelle portent les transferts. */
+    pthread_mutex_t lock; /**< Protège l'ensemble du moteur. */
+    int backend; /**< ASYNC_BACKEND_URING ou ASYNC_BACKEND_THREADS, 0 si le moteur est arrêté. */
+    unsigned depth; /**< Nombre maximal de morceaux en cours. */
+    unsigned inflight; /**< Nombre de morceaux en cours. */
+    AsyncOp* queued_head; /**< Premier morceau en attente d'une place. */
+    AsyncOp* queued_tail; /**< Dernier morceau en attente d'une place. */
+    AsyncRequest* ready_head; /**< Première requête terminée dont la fonction n'a pas été appelée. */
+    AsyncRequest* ready_tail; /**< Dernière requête terminée. */
+    unsigned outstanding; /**< Nombre de requêtes dont la fonction n'a pas encore été appelée. */
+    AsyncRing ring; /**< Anneaux io_uring. */
+    AsyncPool pool; /**< Groupe de threads. */
+    AsyncStats stats; /**< Compteurs d'activité. */
+} AsyncEngine;
+
+/**
+ * @brief Fonction pour démarrer le moteur asynchrone sur une partition montée.
+ * 
+ * @param engine Le moteur.
+ * @param partition La partition.
+ * @param depth Le nombre maximal de morceaux en cours (limité à ASYNC_MAX_DEPTH).
+ * @param backend ASYNC_BACKEND_AUTO, ASYNC_BACKEND_URING ou ASYNC_BACKEND_THREADS.
+ * @return 0 en cas de succès, -1 si le moteur demandé ne peut pas être démarré.
+ */
+int asyncInit(AsyncEngine* engine, struct Partition* partition, unsigned depth, int backend);
+
+/**
+ * @brief Fonction pour arrêter le moteur asynchrone.
+ * 
+ * Les requêtes en cours sont terminées et leurs fonctions appelées.
+ * 
+ * @param engine Le moteur.
+ */
+void asyncDestroy(AsyncEngine* engine);
+
+/**
+ * @brief Fonction pour ajouter une requête préparée aux files du moteur.
+ * 
+ * Les morceaux sont transmis à la partition au prochain asyncSubmit ou
+ * asyncReap. Une requête sans morceau est terminée immédiatement.
+ * 
+ * @param engine Le moteur.
+ * @param request La requête, libérée par le moteur une fois sa fonction appelée.
+ */
+void asyncQueue(AsyncEngine* engine, AsyncRequest* request);
+
+/**
+ * @brief Fonction pour transmettre les morceaux en attente, dans la limite de la profondeur.
+ * 
+ * @param engine Le moteur.
+ * @return Le nombre de morceaux transmis, -1 en cas d'erreur.
+ */
+int asyncSubmit(AsyncEngine* engine);
+
+/**
+ * @brief Fonction pour traiter les requêtes terminées.
+ * 
+ * Les fonctions des requêtes terminées sont appelées par le thread appelant,
+ * hors du verrou du moteur. Elles peuvent soumettre de nouvelles requêtes.
+ * 
+ * @param engine Le moteur.
+ * @param min Le nombre de requêtes terminées à attendre (0 pour ne pas attendre).
+ * @return Le nombre de requêtes terminées, -1 en cas d'erreur.
+ */
+int asyncReap(AsyncEngine* engine, int min);
+
+/**
+ * @brief Fonction pour obtenir les compteurs d'activité du moteur.
+ * 
+ * @param engine Le moteur.
+ * @param stats Les compteurs à remplir.
+ */
+void asyncGetStats(AsyncEngine* engine, AsyncStats* stats);
+
+#endif /* ASYNC_H_ */
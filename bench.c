@@ -0,0 +1,1518 @@
+/**
+ * @file bench.c
+ * @brief Ce fichier contient la suite de mesures des performances de l'API de fichiers : lectures asynchrones selon la profondeur de file, accès séquentiels et aléatoires de plusieurs tailles, petits fichiers contre grand fichier, créations et suppressions répétées, accès de plusieurs threads et écritures rendues durables par mySync, répertoires, tailles de bloc, clones et copies avant écriture, compression, grande écriture dans une partition fragmentée.
+ *
+ * Chaque mesure rapporte le nombre d'opérations par seconde, le débit et les
+ * latences p50, p99 et p999, sous forme de tableau et, sur demande, aux
+ * formats CSV et JSON :
+ *
+ *     projet_bench [--quick] [--csv fichier] [--json fichier]
+ */
+
+#include <time.h>
+#include <pthread.h>
+
+#include "projet.h"
+
+/**
+ * @def BENCH_PARTITION
+ * @brief Nom de la partition créée pour la mesure, supprimée à la fin.
+ */
+#define BENCH_PARTITION "bench_partition"
+
+/**
+ * @def BENCH_MAX_RESULTS
+ * @brief Nombre maximal de résultats conservés pour les sorties CSV et JSON.
+ */
+#define BENCH_MAX_RESULTS 128
+
+/**
+ * @def BENCH_QUICK_DIVISOR
+ * @brief Facteur de réduction du nombre d'opérations avec l'option --quick.
+ */
+#define BENCH_QUICK_DIVISOR 10
+
+/**
+ * @def BENCH_ASYNC_OPS
+ * @brief Nombre de lectures asynchrones effectuées pour chaque profondeur de file.
+ */
+#define BENCH_ASYNC_OPS 200000
+
+/**
+ * @def BENCH_OPS
+ * @brief Nombre d'opérations des mesures d'accès séquentiels ou aléatoires, par thread.
+ */
+#define BENCH_OPS 100000
+
+/**
+ * @def BENCH_FILE_OPS
+ * @brief Nombre d'opérations des mesures portant sur des fichiers entiers.
+ */
+#define BENCH_FILE_OPS 20000
+
+/**
+ * @def BENCH_MAX_THREADS
+ * @brief Nombre maximal de threads d'une mesure, chacun avec son propre fichier.
+ */
+#define BENCH_MAX_THREADS 8
+
+/**
+ * @def BENCH_MAX_IO
+ * @brief Taille maximale d'une lecture ou d'une écriture, en octets.
+ */
+#define BENCH_MAX_IO 16384
+
+/**
+ * @def BENCH_LARGE_BLOCKS
+ * @brief Nombre de blocs du grand fichier des mesures à un thread.
+ */
+#define BENCH_LARGE_BLOCKS 64
+
+/**
+ * @def BENCH_SMALL_FILES
+ * @brief Nombre de petits fichiers comparés au grand fichier.
+ */
+#define BENCH_SMALL_FILES 8
+
+/**
+ * @def BENCH_SMALL_BLOCKS
+ * @brief Nombre de blocs de chaque petit fichier.
+ */
+#define BENCH_SMALL_BLOCKS 2
+
+/**
+ * @def BENCH_THREAD_BLOCKS
+ * @brief Nombre de blocs du fichier de chaque thread.
+ */
+#define BENCH_THREAD_BLOCKS 8
+
+/**
+ * @def BENCH_SYNC_OPS
+ * @brief Nombre d'ajouts suivis de mySync effectués par chaque thread.
+ */
+#define BENCH_SYNC_OPS 100
+
+/**
+ * @def BENCH_SYNC_BYTES
+ * @brief Nombre d'octets de chaque ajout rendu durable.
+ */
+#define BENCH_SYNC_BYTES 16
+
+/**
+ * @def BENCH_DIR_PARTITION
+ * @brief Nom de la partition temporaire des mesures de répertoires.
+ */
+#define BENCH_DIR_PARTITION "bench_dir_partition"
+
+/**
+ * @def BENCH_DIR_ENTRIES
+ * @brief Nombre de fichiers créés dans un même répertoire par les mesures de répertoires.
+ */
+#define BENCH_DIR_ENTRIES 100000
+
+/**
+ * @def BENCH_DIR_HOT
+ * @brief Nombre de fichiers rouverts en boucle par la mesure des ouvertures répétées.
+ */
+#define BENCH_DIR_HOT 1024
+
+/**
+ * @def BENCH_DIR_STRIDE
+ * @brief Pas entre deux fichiers ouverts successivement, premier avec le nombre de fichiers.
+ */
+#define BENCH_DIR_STRIDE 7919
+
+/**
+ * @def BENCH_DIR_LISTS
+ * @brief Nombre de listes complètes du répertoire mesurées.
+ */
+#define BENCH_DIR_LISTS 20
+
+/**
+ * @def BENCH_BS_PARTITION
+ * @brief Nom de la partition temporaire des mesures de tailles de bloc.
+ */
+#define BENCH_BS_PARTITION "bench_bs_partition"
+
+/**
+ * @def BENCH_BS_SPACE
+ * @brief Taille de la partition des mesures de tailles de bloc, en octets.
+ */
+#define BENCH_BS_SPACE (256ull * 1024 * 1024)
+
+/**
+ * @def BENCH_BS_LARGE
+ * @brief Taille du grand fichier des mesures de tailles de bloc, en octets.
+ */
+#define BENCH_BS_LARGE (32 * 1024 * 1024)
+
+/**
+ * @def BENCH_BS_FILES
+ * @brief Nombre de petits fichiers créés par les mesures de tailles de bloc.
+ */
+#define BENCH_BS_FILES 64
+
+/**
+ * @def BENCH_BS_SMALL
+ * @brief Taille de chacun des petits fichiers des mesures de tailles de bloc, en octets.
+ */
+#define BENCH_BS_SMALL 1000
+
+/**
+ * @def BENCH_CLONE_PARTITION
+ * @brief Nom de la partition temporaire des mesures de clones.
+ */
+#define BENCH_CLONE_PARTITION "bench_clone_partition"
+
+/**
+ * @def BENCH_CLONE_BLOCKS
+ * @brief Nombre de blocs du fichier cloné par les mesures de clones.
+ */
+#define BENCH_CLONE_BLOCKS 4096
+
+/**
+ * @def BENCH_CLONES
+ * @brief Nombre de clones créés par les mesures de clones.
+ */
+#define BENCH_CLONES 1000
+
+/**
+ * @def BENCH_COMPRESS_PARTITION
+ * @brief Nom de la partition temporaire des mesures de compression.
+ */
+#define BENCH_COMPRESS_PARTITION "bench_compress_partition"
+
+/**
+ * @def BENCH_COMPRESS_BYTES
+ * @brief Taille du fichier écrit puis lu par les mesures de compression.
+ */
+#define BENCH_COMPRESS_BYTES (16 * 1024 * 1024)
+
+/**
+ * @def BENCH_COMPRESS_TEXT
+ * @brief Taille du texte de journal d'activité recopié dans le fichier des mesures de compression.
+ */
+#define BENCH_COMPRESS_TEXT (1024 * 1024)
+
+/**
+ * @def BENCH_FRAG_PARTITION
+ * @brief Nom de la partition temporaire de la mesure d'écriture dans une partition fragmentée.
+ */
+#define BENCH_FRAG_PARTITION "bench_frag_partition"
+
+/**
+ * @def BENCH_FRAG_FILES
+ * @brief Nombre de fichiers de deux blocs créés pour fragmenter la partition, dont un sur deux est supprimé ; leurs inodes et leurs entrées occupent aussi la zone de données.
+ */
+#define BENCH_FRAG_FILES 16384
+
+/**
+ * @def BENCH_FRAG_BYTES
+ * @brief Taille du fichier écrit d'un seul myWrite dans les trous de la partition fragmentée, en octets.
+ */
+#define BENCH_FRAG_BYTES (BENCH_FRAG_FILES * 3 / 4 * DEFAULT_BLOCK_SIZE)
+
+/**
+ * @struct BenchResult
+ * @brief Résultat d'une mesure.
+ */
+typedef struct {
+    char workload[40]; /**< Nom de la mesure. */
+    int threads; /**< Nombre de threads. */
+    int io_size; /**< Nombre d'octets transférés par opération. */
+    uint32_t block_size; /**< Taille de bloc de la partition mesurée. */
+    size_t ops; /**< Nombre d'opérations, tous threads confondus. */
+    double seconds; /**< Durée de la mesure. */
+    double p50; /**< Latence médiane, en microsecondes. */
+    double p99; /**< 99e centile de la latence, en microsecondes. */
+    double p999; /**< 99,9e centile de la latence, en microsecondes. */
+    double calls_per_op; /**< Appels io_uring_enter (mesures asynchrones) ou fdatasync (autres mesures) par opération. */
+    int errors; /**< Opérations en erreur. */
+    double wasted; /**< Part des octets alloués qui ne contiennent pas de données (mesures de tailles de bloc), -1 si non mesurée. */
+    double ratio; /**< Octets de données par octet alloué (mesures de compression), -1 si non mesuré. */
+} BenchResult;
+
+/**
+ * @brief Résultats des mesures déjà effectuées.
+ */
+static BenchResult results[BENCH_MAX_RESULTS];
+
+/**
+ * @brief Nombre de résultats dans results.
+ */
+static int num_results = 0;
+
+/**
+ * @brief Diviseur du nombre d'opérations de chaque mesure, BENCH_QUICK_DIVISOR avec --quick.
+ */
+static int divisor = 1;
+
+/**
+ * @brief Nombre de fichiers du répertoire des mesures de répertoires.
+ */
+static int dir_entries = BENCH_DIR_ENTRIES;
+
+/**
+ * @brief Texte écrit par les mesures de compression, créé par benchCompression.
+ */
+static char compress_text[BENCH_COMPRESS_TEXT];
+
+/**
+ * @brief Données écrites par la mesure d'écriture dans une partition fragmentée, créées par benchFragmented.
+ */
+static char frag_data[BENCH_FRAG_BYTES];
+
+/**
+ * @brief Renvoie l'heure de l'horloge monotone.
+ * @return L'heure en nanosecondes.
+ */
+static uint64_t nowNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @brief Compare deux latences pour qsort.
+ * @param a La première latence.
+ * @param b La seconde latence.
+ * @return Un entier négatif, nul ou positif selon l'ordre des latences.
+ */
+static int compareLatencies(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Renvoie un centile de latences triées, au rang le plus proche.
+ * @param sorted Les latences triées, en nanosecondes.
+ * @param count Le nombre de latences, au moins 1.
+ * @param per_mille Le centile, en millièmes.
+ * @return Le centile, en microsecondes.
+ */
+static double percentile(const uint64_t* sorted, size_t count, unsigned per_mille) {
+    size_t rank = (count * per_mille + 999) / 1000;
+    return sorted[rank > 0 ? rank - 1 : 0] / 1000.0;
+}
+
+/**
+ * @brief Affiche l'en-tête du tableau des résultats.
+ */
+static void printHeader() {
+    printf("%-28s %7s %7s %12s %9s %9s %9s %9s %8s %7s\n", "mesure", "threads", "taille",
+           "op/s", "Mo/s", "p50 (us)", "p99 (us)", "p999 (us)", "appels/op", "erreurs");
+}
+
+/**
+ * @brief Enregistre et affiche le résultat d'une mesure.
+ * @param workload Le nom de la mesure.
+ * @param threads Le nombre de threads.
+ * @param io_size Le nombre d'octets transférés par opération.
+ * @param block_size La taille de bloc de la partition mesurée.
+ * @param latencies Les latences des opérations, en nanosecondes, triées par la fonction.
+ * @param ops Le nombre d'opérations.
+ * @param seconds La durée de la mesure.
+ * @param calls Le nombre d'appels système caractéristiques de la mesure (io_uring_enter ou fdatasync).
+ * @param errors Le nombre d'opérations en erreur.
+ * @return 0 si aucune opération n'a échoué, -1 sinon.
+ */
+static int report(const char* workload, int threads, int io_size, uint32_t block_size, uint64_t* latencies,
+                  size_t ops, double seconds, unsigned long calls, int errors) {
+    if (ops == 0 || num_results == BENCH_MAX_RESULTS) {
+        return -1;
+    }
+    qsort(latencies, ops, sizeof(uint64_t), compareLatencies);
+    BenchResult* result = &results[num_results++];
+    snprintf(result->workload, sizeof(result->workload), "%s", workload);
+    result->threads = threads;
+    result->io_size = io_size;
+    result->block_size = block_size;
+    result->ops = ops;
+    result->seconds = seconds;
+    result->p50 = percentile(latencies, ops, 500);
+    result->p99 = percentile(latencies, ops, 990);
+    result->p999 = percentile(latencies, ops, 999);
+    result->calls_per_op = (double)calls / ops;
+    result->errors = errors;
+    result->wasted = -1;
+    result->ratio = -1;
+
+    printf("%-28s %7d %7d %12.0f %9.2f %9.2f %9.2f %9.2f %8.2f %7d\n", result->workload, threads, io_size,
+           ops / seconds, ops * (double)io_size / seconds / (1024 * 1024),
+           result->p50, result->p99, result->p999, result->calls_per_op, errors);
+    fflush(stdout);
+    return errors == 0 ? 0 : -1;
+}
+
+/**
+ * @struct BenchRun
+ * @brief État d'une série de lectures asynchrones aléatoires d'un bloc.
+ */
+typedef struct {
+    file* f; /**< Fichier lu. */
+    int num_blocks; /**< Nombre de blocs du fichier. */
+    int total; /**< Nombre de lectures de la série. */
+    int issued; /**< Lectures lancées. */
+    int completed; /**< Lectures terminées. */
+    int errors; /**< Lectures en erreur. */
+    unsigned seed; /**< État du générateur pseudo-aléatoire. */
+    uint64_t* latencies; /**< Latence de chaque lecture terminée, du lancement à l'appel de readDone. */
+} BenchRun;
+
+/**
+ * @struct BenchSlot
+ * @brief Emplacement d'une lecture en cours : chaque emplacement est réutilisé dès que sa lecture se termine.
+ */
+typedef struct {
+    BenchRun* run; /**< Série à laquelle appartient l'emplacement. */
+    uint64_t start; /**< Heure de lancement de la lecture. */
+    char buffer[DEFAULT_BLOCK_SIZE]; /**< Tampon de la lecture. */
+} BenchSlot;
+
+/**
+ * @brief Lance la lecture d'un bloc tiré au hasard dans l'emplacement donné.
+ * @param slot L'emplacement.
+ */
+static void issueRead(BenchSlot* slot);
+
+/**
+ * @brief Fonction appelée à la fin d'une lecture : relance une lecture tant qu'il en reste.
+ * @param arg L'emplacement de la lecture.
+ * @param result Le nombre d'octets lus, -1 en cas d'erreur.
+ */
+static void readDone(void* arg, int64_t result) {
+    BenchSlot* slot = arg;
+    BenchRun* run = slot->run;
+    run->latencies[run->completed++] = nowNs() - slot->start;
+    if (result != DEFAULT_BLOCK_SIZE) {
+        run->errors++;
+    }
+    if (run->issued < run->total) {
+        issueRead(slot);
+    }
+}
+
+/**
+ * @brief Lance la lecture d'un bloc tiré au hasard dans l'emplacement donné.
+ * @param slot L'emplacement.
+ */
+static void issueRead(BenchSlot* slot) {
+    BenchRun* run = slot->run;
+    run->seed = run->seed * 1103515245u + 12345u;
+    int block = (run->seed >> 8) % run->num_blocks;
+    run->issued++;
+    slot->start = nowNs();
+    if (myReadAsync(run->f, (int64_t)block * DEFAULT_BLOCK_SIZE, slot->buffer, DEFAULT_BLOCK_SIZE, readDone, slot) == -1) {
+        run->latencies[run->completed++] = 0;
+        run->errors++;
+    }
+}
+
+/**
+ * @brief Mesure les lectures asynchrones aléatoires d'un bloc pour une profondeur de file.
+ * @param f Le fichier lu.
+ * @param depth La profondeur de file.
+ * @param backend Le moteur asynchrone.
+ * @return 0 en cas de succès, 1 si le moteur n'est pas disponible, -1 en cas d'erreur.
+ */
+static int measureAsync(file* f, unsigned depth, int backend) {
+    if (myAsyncSetup(f->partition, depth, backend) != backend) {
+        return 1;
+    }
+
+    BenchRun run = { f, f->fileSize / DEFAULT_BLOCK_SIZE, BENCH_ASYNC_OPS / divisor, 0, 0, 0, 12345u, NULL };
+    BenchSlot* slots = malloc(depth * sizeof(BenchSlot));
+    run.latencies = malloc(run.total * sizeof(uint64_t));
+    if (slots == NULL || run.latencies == NULL) {
+        free(slots);
+        free(run.latencies);
+        return -1;
+    }
+
+    AsyncStats before, after;
+    asyncGetStats(&f->partition->async, &before);
+    uint64_t start = nowNs();
+    for (unsigned i = 0; i < depth && run.issued < run.total; ++i) {
+        slots[i].run = &run;
+        issueRead(&slots[i]);
+    }
+    while (run.completed < run.total) {
+        if (myAsyncWait(f->partition, 1) == -1) {
+            break;
+        }
+    }
+    double seconds = (nowNs() - start) / 1e9;
+    asyncGetStats(&f->partition->async, &after);
+
+    char name[40];
+    snprintf(name, sizeof(name), "async_read_%s_qd%u", backend == ASYNC_BACKEND_URING ? "uring" : "threads", depth);
+    int status = report(name, 1, DEFAULT_BLOCK_SIZE, f->partition->block_size, run.latencies, run.completed, seconds,
+                        after.enter_calls - before.enter_calls, run.errors + run.total - run.completed);
+    free(slots);
+    free(run.latencies);
+    return status;
+}
+
+typedef struct BenchContext BenchContext;
+
+/**
+ * @brief Opération mesurée : renvoie 0 en cas de succès, -1 en cas d'erreur.
+ */
+typedef int (*BenchOp)(BenchContext* ctx, int i);
+
+/**
+ * @struct BenchContext
+ * @brief Thread d'une mesure : opérations répétées sur son propre fichier.
+ */
+struct BenchContext {
+    Partition* partition; /**< Partition mesurée. */
+    file* f; /**< Fichier du thread, NULL pour les opérations qui ouvrent leurs fichiers. */
+    BenchOp op; /**< Opération répétée. */
+    int io_size; /**< Nombre d'octets transférés par opération. */
+    int positions; /**< Nombre de positions alignées sur io_size dans le fichier. */
+    unsigned seed; /**< État du générateur pseudo-aléatoire. */
+    int ops; /**< Nombre d'opérations du thread. */
+    uint64_t* latencies; /**< Latence de chaque opération du thread. */
+    int errors; /**< Opérations en erreur. */
+    char buffer[BENCH_MAX_IO]; /**< Tampon des lectures et écritures. */
+};
+
+/**
+ * @brief Lit ou écrit io_size octets à une position du fichier du thread.
+ * @param ctx Le thread.
+ * @param position Le numéro de la position, en multiples de io_size.
+ * @param write_mode 1 pour écrire, 0 pour lire.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int accessAt(BenchContext* ctx, int position, int write_mode) {
+    mySeek(ctx->f, (int64_t)position * ctx->io_size, SEEK_SET);
+    int64_t done = write_mode ? myWrite(ctx->f, ctx->buffer, ctx->io_size) : myRead(ctx->f, ctx->buffer, ctx->io_size);
+    return done == ctx->io_size ? 0 : -1;
+}
+
+/**
+ * @brief Tire une position au hasard dans le fichier du thread.
+ * @param ctx Le thread.
+ * @return Le numéro de la position.
+ */
+static int randomPosition(BenchContext* ctx) {
+    ctx->seed = ctx->seed * 1103515245u + 12345u;
+    return (ctx->seed >> 8) % ctx->positions;
+}
+
+/**
+ * @brief Lecture séquentielle.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opSeqRead(BenchContext* ctx, int i) {
+    return accessAt(ctx, i % ctx->positions, 0);
+}
+
+/**
+ * @brief Lecture séquentielle par une vue, sans copie.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opSeqView(BenchContext* ctx, int i) {
+    ReadView view;
+    int64_t done = myReadView(ctx->f, (int64_t)(i % ctx->positions) * ctx->io_size, ctx->io_size, &view);
+    myReleaseView(&view);
+    return done == ctx->io_size ? 0 : -1;
+}
+
+/**
+ * @brief Écriture séquentielle.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opSeqWrite(BenchContext* ctx, int i) {
+    return accessAt(ctx, i % ctx->positions, 1);
+}
+
+/**
+ * @brief Lecture aléatoire.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opRandRead(BenchContext* ctx, int i) {
+    (void)i;
+    return accessAt(ctx, randomPosition(ctx), 0);
+}
+
+/**
+ * @brief Écriture aléatoire.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opRandWrite(BenchContext* ctx, int i) {
+    (void)i;
+    return accessAt(ctx, randomPosition(ctx), 1);
+}
+
+/**
+ * @brief Ouvre chacun des petits fichiers puis le lit ou l'écrit en entier.
+ * @param ctx Le thread.
+ * @param write_mode 1 pour écrire, 0 pour lire.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int accessSmallFiles(BenchContext* ctx, int write_mode) {
+    int size = BENCH_SMALL_BLOCKS * DEFAULT_BLOCK_SIZE;
+    for (int k = 0; k < BENCH_SMALL_FILES; ++k) {
+        char name[MAX_FILE_NAME];
+        snprintf(name, sizeof(name), "small%d.dat", k);
+        file* f = myOpen(ctx->partition, name);
+        if (f == NULL) {
+            return -1;
+        }
+        mySeek(f, 0, SEEK_SET);
+        int64_t done = write_mode ? myWrite(f, ctx->buffer, size) : myRead(f, ctx->buffer, size);
+        if (done != size) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Lecture de tous les petits fichiers.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opSmallFilesRead(BenchContext* ctx, int i) {
+    (void)i;
+    return accessSmallFiles(ctx, 0);
+}
+
+/**
+ * @brief Écriture de tous les petits fichiers.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opSmallFilesWrite(BenchContext* ctx, int i) {
+    (void)i;
+    return accessSmallFiles(ctx, 1);
+}
+
+/**
+ * @brief Crée un fichier, y écrit un bloc puis le supprime.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opChurn(BenchContext* ctx, int i) {
+    (void)i;
+    file* f = myOpen(ctx->partition, "churn.dat");
+    if (f == NULL || myWrite(f, ctx->buffer, DEFAULT_BLOCK_SIZE) != DEFAULT_BLOCK_SIZE) {
+        return -1;
+    }
+    return deleteFileFromPartition(ctx->partition, "churn.dat");
+}
+
+/**
+ * @brief Ajoute quelques octets au fichier du thread puis appelle mySync.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opAppendSync(BenchContext* ctx, int i) {
+    (void)i;
+    mySeek(ctx->f, 0, SEEK_END);
+    if (myWrite(ctx->f, ctx->buffer, ctx->io_size) != ctx->io_size) {
+        return -1;
+    }
+    return mySync(ctx->partition);
+}
+
+/**
+ * @brief Ajoute io_size octets à la fin du fichier du thread.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opAppend(BenchContext* ctx, int i) {
+    (void)i;
+    mySeek(ctx->f, 0, SEEK_END);
+    return myWrite(ctx->f, ctx->buffer, ctx->io_size) == ctx->io_size ? 0 : -1;
+}
+
+/**
+ * @brief Crée un petit fichier de BENCH_BS_SMALL octets.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération, qui est celui du fichier.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opSmallCreate(BenchContext* ctx, int i) {
+    char name[MAX_FILE_NAME];
+    snprintf(name, sizeof(name), "s%d.dat", i);
+    file* f = myOpen(ctx->partition, name);
+    return f != NULL && myWrite(f, ctx->buffer, BENCH_BS_SMALL) == BENCH_BS_SMALL ? 0 : -1;
+}
+
+/**
+ * @brief Ouvre un fichier du répertoire de mesure.
+ * @param ctx Le thread.
+ * @param number Le numéro du fichier, créé s'il n'existe pas.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int openDirEntry(BenchContext* ctx, int number) {
+    char name[MAX_FILE_NAME];
+    snprintf(name, sizeof(name), "big/f%d", number);
+    return myOpen(ctx->partition, name) != NULL ? 0 : -1;
+}
+
+/**
+ * @brief Crée le fichier suivant du répertoire de mesure.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération, qui est celui du fichier.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opDirCreate(BenchContext* ctx, int i) {
+    return openDirEntry(ctx, i);
+}
+
+/**
+ * @brief Ouvre un fichier du répertoire de mesure jamais ouvert depuis le montage, pris dans le désordre.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opDirOpen(BenchContext* ctx, int i) {
+    return openDirEntry(ctx, (int)((int64_t)i * BENCH_DIR_STRIDE % dir_entries));
+}
+
+/**
+ * @brief Rouvre un fichier parmi les BENCH_DIR_HOT premiers du répertoire de mesure.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opDirReopen(BenchContext* ctx, int i) {
+    return openDirEntry(ctx, i % BENCH_DIR_HOT);
+}
+
+/**
+ * @brief Liste le répertoire de mesure en entier.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opDirList(BenchContext* ctx, int i) {
+    (void)i;
+    char** files = listDirectory(ctx->partition, "big");
+    if (files == NULL) {
+        return -1;
+    }
+    int count = numFiles(files);
+    for (int k = 0; k < count; ++k) {
+        free(files[k]);
+    }
+    free(files);
+    return count == dir_entries ? 0 : -1;
+}
+
+/**
+ * @brief Supprime un fichier du répertoire de mesure.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération, qui est celui du fichier.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opDirDelete(BenchContext* ctx, int i) {
+    char name[MAX_FILE_NAME];
+    snprintf(name, sizeof(name), "big/f%d", i);
+    return deleteFileFromPartition(ctx->partition, name);
+}
+
+/**
+ * @brief Clone le fichier source des mesures de clones.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération, qui est celui du clone.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opClone(BenchContext* ctx, int i) {
+    char name[MAX_FILE_NAME];
+    snprintf(name, sizeof(name), "clone%d.dat", i);
+    return myClone(ctx->partition, "source.dat", name);
+}
+
+/**
+ * @brief Écrit io_size octets à une position aléatoire de l'un des clones, à tour de rôle.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opCloneWrite(BenchContext* ctx, int i) {
+    char name[MAX_FILE_NAME];
+    snprintf(name, sizeof(name), "clone%d.dat", i % (BENCH_CLONES / divisor));
+    if ((ctx->f = myOpen(ctx->partition, name)) == NULL) {
+        return -1;
+    }
+    return accessAt(ctx, randomPosition(ctx), 1);
+}
+
+/**
+ * @brief Supprime un clone.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération, qui est celui du clone.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opCloneDelete(BenchContext* ctx, int i) {
+    char name[MAX_FILE_NAME];
+    snprintf(name, sizeof(name), "clone%d.dat", i);
+    return deleteFileFromPartition(ctx->partition, name);
+}
+
+/**
+ * @brief Écrit io_size octets du texte des mesures de compression à une position du fichier du thread.
+ * @param ctx Le thread.
+ * @param position Le numéro de la position, en multiples de io_size.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int writeText(BenchContext* ctx, int position) {
+    int64_t offset = (int64_t)position * ctx->io_size;
+    mySeek(ctx->f, offset, SEEK_SET);
+    return myWrite(ctx->f, compress_text + offset % BENCH_COMPRESS_TEXT, ctx->io_size) == ctx->io_size ? 0 : -1;
+}
+
+/**
+ * @brief Écriture séquentielle de texte.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opTextSeqWrite(BenchContext* ctx, int i) {
+    return writeText(ctx, i % ctx->positions);
+}
+
+/**
+ * @brief Écriture aléatoire de texte.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opTextRandWrite(BenchContext* ctx, int i) {
+    (void)i;
+    return writeText(ctx, randomPosition(ctx));
+}
+
+/**
+ * @brief Écrit io_size octets des données de la mesure fragmentée d'un seul appel, au début du fichier du thread.
+ * @param ctx Le thread.
+ * @param i Le numéro de l'opération.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int opFragWrite(BenchContext* ctx, int i) {
+    (void)i;
+    mySeek(ctx->f, 0, SEEK_SET);
+    return myWrite(ctx->f, frag_data, ctx->io_size) == ctx->io_size ? 0 : -1;
+}
+
+/**
+ * @brief Boucle d'un thread de mesure : répète son opération en chronométrant chacune.
+ * @param arg Le thread (BenchContext).
+ * @return NULL.
+ */
+static void* runWorker(void* arg) {
+    BenchContext* ctx = arg;
+    for (int i = 0; i < ctx->ops; ++i) {
+        uint64_t start = nowNs();
+        if (ctx->op(ctx, i) == -1) {
+            ctx->errors++;
+        }
+        ctx->latencies[i] = nowNs() - start;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Exécute une mesure avec un ou plusieurs threads et enregistre son résultat.
+ *
+ * Les contextes doivent être préparés par prepareContext ; chaque thread
+ * effectue ops opérations. Le nombre de fdatasync par opération est tiré
+ * des compteurs du journal.
+ *
+ * @param workload Le nom de la mesure.
+ * @param contexts Les threads.
+ * @param num_threads Le nombre de threads.
+ * @param ops Le nombre d'opérations de chaque thread.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int runWorkload(const char* workload, BenchContext* contexts, int num_threads, int ops) {
+    uint64_t* latencies = malloc((size_t)num_threads * ops * sizeof(uint64_t));
+    if (latencies == NULL) {
+        return -1;
+    }
+    Partition* partition = contexts[0].partition;
+    JournalStats before, after;
+    journalGetStats(&partition->journal, &before);
+    pthread_t threads[BENCH_MAX_THREADS];
+    uint64_t start = nowNs();
+    int started = 0;
+    for (; started < num_threads; ++started) {
+        contexts[started].ops = ops;
+        contexts[started].latencies = latencies + (size_t)started * ops;
+        contexts[started].errors = 0;
+        if (pthread_create(&threads[started], NULL, runWorker, &contexts[started]) != 0) {
+            break;
+        }
+    }
+    int errors = started == num_threads ? 0 : 1;
+    for (int i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+        errors += contexts[i].errors;
+    }
+    double seconds = (nowNs() - start) / 1e9;
+    journalGetStats(&partition->journal, &after);
+
+    int status = report(workload, num_threads, contexts[0].io_size, partition->block_size, latencies,
+                        (size_t)started * ops, seconds, after.syncs - before.syncs, errors);
+    free(latencies);
+    return status;
+}
+
+/**
+ * @brief Prépare un thread de mesure.
+ * @param ctx Le thread.
+ * @param partition La partition.
+ * @param f Le fichier du thread, NULL si l'opération ouvre ses fichiers.
+ * @param op L'opération répétée.
+ * @param io_size Le nombre d'octets transférés par opération.
+ * @param seed La graine du générateur pseudo-aléatoire.
+ */
+static void prepareContext(BenchContext* ctx, Partition* partition, file* f, BenchOp op, int io_size, unsigned seed) {
+    ctx->partition = partition;
+    ctx->f = f;
+    ctx->op = op;
+    ctx->io_size = io_size;
+    ctx->positions = f != NULL && f->fileSize >= io_size ? f->fileSize / io_size : 1;
+    ctx->seed = seed;
+    memset(ctx->buffer, 'b', sizeof(ctx->buffer));
+}
+
+/**
+ * @brief Crée un fichier rempli d'un nombre de blocs donné.
+ * @param partition La partition.
+ * @param name Le nom du fichier.
+ * @param blocks Le nombre de blocs.
+ * @return Le fichier, NULL en cas d'erreur.
+ */
+static file* createFile(Partition* partition, const char* name, int blocks) {
+    char block[DEFAULT_BLOCK_SIZE];
+    memset(block, 'f', sizeof(block));
+    file* f = myOpen(partition, (char*)name);
+    for (int b = 0; f != NULL && b < blocks; ++b) {
+        if (myWrite(f, block, DEFAULT_BLOCK_SIZE) != DEFAULT_BLOCK_SIZE) {
+            f = NULL;
+        }
+    }
+    if (f == NULL) {
+        printf("Erreur lors de la création du fichier %s.\n", name);
+    }
+    return f;
+}
+
+/**
+ * @brief Supprime les fichiers d'une mesure, nommés d'après un modèle numéroté.
+ * @param partition La partition.
+ * @param pattern Le modèle du nom, avec un %d.
+ * @param count Le nombre de fichiers.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int deleteFiles(Partition* partition, const char* pattern, int count) {
+    for (int i = 0; i < count; ++i) {
+        char name[MAX_FILE_NAME];
+        snprintf(name, sizeof(name), pattern, i);
+        if (deleteFileFromPartition(partition, name) == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Mesure les lectures asynchrones d'un fichier occupant toute la partition, pour chaque moteur et chaque profondeur de file.
+ *
+ * La partition est démontée puis remontée pour vider le cache de blocs.
+ *
+ * @param partition La partition vide, remplacée par la partition remontée.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int benchAsync(Partition** partition) {
+    file* f = myOpen(*partition, "bench.dat");
+    char block[DEFAULT_BLOCK_SIZE];
+    memset(block, 'b', sizeof(block));
+    while (f != NULL && myWrite(f, block, sizeof(block)) == (int64_t)sizeof(block)) {
+    }
+    if (f == NULL || f->fileSize < DEFAULT_BLOCK_SIZE || myUnmount(*partition) == -1
+        || (*partition = myMount(BENCH_PARTITION)) == NULL || (f = myOpen(*partition, "bench.dat")) == NULL) {
+        printf("Erreur lors de la préparation de la partition de mesure.\n");
+        return -1;
+    }
+
+    int status = 0;
+    int backends[] = { ASYNC_BACKEND_URING, ASYNC_BACKEND_THREADS };
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); ++b) {
+        for (unsigned depth = 1; depth <= 64; depth *= 2) {
+            int result = measureAsync(f, depth, backends[b]);
+            if (result == 1) {
+                printf("Moteur %s indisponible.\n", backends[b] == ASYNC_BACKEND_URING ? "io_uring" : "threads");
+                break;
+            }
+            if (result == -1) {
+                status = -1;
+            }
+        }
+    }
+    // La place du fichier est rendue aux mesures suivantes
+    if (deleteFileFromPartition(*partition, "bench.dat") == -1) {
+        status = -1;
+    }
+    return status;
+}
+
+/**
+ * @brief Mesure les accès d'un seul thread : séquentiels et aléatoires de plusieurs tailles, petits fichiers contre grand fichier, créations et suppressions.
+ *
+ * Les petits fichiers et la tranche du grand fichier lue ou écrite par
+ * opération ont la même taille totale : l'écart mesure le coût de
+ * l'ouverture et des métadonnées de chaque fichier.
+ *
+ * @param partition La partition, sans fichier.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int benchSingleThread(Partition* partition) {
+    static BenchContext ctx;
+    file* large = createFile(partition, "large.dat", BENCH_LARGE_BLOCKS);
+    if (large == NULL) {
+        return -1;
+    }
+    for (int k = 0; k < BENCH_SMALL_FILES; ++k) {
+        char name[MAX_FILE_NAME];
+        snprintf(name, sizeof(name), "small%d.dat", k);
+        if (createFile(partition, name, BENCH_SMALL_BLOCKS) == NULL) {
+            return -1;
+        }
+    }
+
+    struct {
+        const char* name;
+        BenchOp op;
+    } patterns[] = {
+        { "seq_read", opSeqRead }, { "seq_view", opSeqView }, { "seq_write", opSeqWrite },
+        { "rand_read", opRandRead }, { "rand_write", opRandWrite },
+    };
+    int sizes[] = { DEFAULT_BLOCK_SIZE, 4096, BENCH_MAX_IO };
+    int status = 0;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); ++p) {
+            char name[40];
+            snprintf(name, sizeof(name), "%s_%d", patterns[p].name, sizes[s]);
+            prepareContext(&ctx, partition, large, patterns[p].op, sizes[s], 12345u);
+            if (runWorkload(name, &ctx, 1, BENCH_OPS / divisor) == -1) {
+                status = -1;
+            }
+        }
+    }
+
+    int total = BENCH_SMALL_FILES * BENCH_SMALL_BLOCKS * DEFAULT_BLOCK_SIZE;
+    prepareContext(&ctx, partition, NULL, opSmallFilesRead, total, 0);
+    status |= runWorkload("small_files_read", &ctx, 1, BENCH_FILE_OPS / divisor);
+    prepareContext(&ctx, partition, large, opSeqRead, total, 0);
+    status |= runWorkload("large_file_read", &ctx, 1, BENCH_FILE_OPS / divisor);
+    prepareContext(&ctx, partition, NULL, opSmallFilesWrite, total, 0);
+    status |= runWorkload("small_files_write", &ctx, 1, BENCH_FILE_OPS / divisor);
+    prepareContext(&ctx, partition, large, opSeqWrite, total, 0);
+    status |= runWorkload("large_file_write", &ctx, 1, BENCH_FILE_OPS / divisor);
+    prepareContext(&ctx, partition, NULL, opChurn, DEFAULT_BLOCK_SIZE, 0);
+    status |= runWorkload("create_delete", &ctx, 1, BENCH_FILE_OPS / divisor);
+
+    if (deleteFileFromPartition(partition, "large.dat") == -1
+        || deleteFiles(partition, "small%d.dat", BENCH_SMALL_FILES) == -1) {
+        status = -1;
+    }
+    return status;
+}
+
+/**
+ * @brief Mesure la montée en charge de 1 à BENCH_MAX_THREADS threads : lectures et écritures aléatoires, puis ajouts suivis de mySync.
+ *
+ * Chaque thread dispose de son propre fichier de BENCH_THREAD_BLOCKS blocs
+ * présents dans le cache : seuls les verrous de la partition limitent le
+ * parallélisme. Pour les ajouts durables, les threads qui appellent mySync
+ * pendant l'écriture d'une transaction du journal partagent la suivante,
+ * si bien que le nombre de fdatasync par opération diminue avec le nombre
+ * de threads.
+ *
+ * @param partition La partition, sans fichier.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int benchThreads(Partition* partition) {
+    static BenchContext contexts[BENCH_MAX_THREADS];
+    file* files[BENCH_MAX_THREADS];
+    for (int i = 0; i < BENCH_MAX_THREADS; ++i) {
+        char name[MAX_FILE_NAME];
+        snprintf(name, sizeof(name), "thread%d.dat", i);
+        if ((files[i] = createFile(partition, name, BENCH_THREAD_BLOCKS)) == NULL) {
+            return -1;
+        }
+    }
+
+    int status = 0;
+    for (int write_mode = 0; write_mode <= 1; ++write_mode) {
+        for (int num_threads = 1; num_threads <= BENCH_MAX_THREADS; num_threads *= 2) {
+            for (int i = 0; i < num_threads; ++i) {
+                prepareContext(&contexts[i], partition, files[i], write_mode ? opRandWrite : opRandRead,
+                               DEFAULT_BLOCK_SIZE, 12345u + i);
+            }
+            status |= runWorkload(write_mode ? "mt_rand_write" : "mt_rand_read", contexts, num_threads,
+                                  BENCH_OPS / divisor);
+        }
+    }
+    if (deleteFiles(partition, "thread%d.dat", BENCH_MAX_THREADS) == -1) {
+        return -1;
+    }
+
+    for (int i = 0; i < BENCH_MAX_THREADS; ++i) {
+        char name[MAX_FILE_NAME];
+        snprintf(name, sizeof(name), "sync%d.dat", i);
+        if ((files[i] = createFile(partition, name, 0)) == NULL) {
+            return -1;
+        }
+    }
+    for (int num_threads = 1; num_threads <= BENCH_MAX_THREADS; num_threads *= 2) {
+        for (int i = 0; i < num_threads; ++i) {
+            prepareContext(&contexts[i], partition, files[i], opAppendSync, BENCH_SYNC_BYTES, 0);
+        }
+        status |= runWorkload("append_sync", contexts, num_threads, BENCH_SYNC_OPS);
+    }
+    if (deleteFiles(partition, "sync%d.dat", BENCH_MAX_THREADS) == -1) {
+        return -1;
+    }
+    return status;
+}
+
+/**
+ * @brief Mesure les créations, ouvertures, listes et suppressions dans un répertoire de dir_entries fichiers.
+ *
+ * Les mesures utilisent leur propre partition, assez grande pour les
+ * fichiers du répertoire. Après les créations, la partition est démontée
+ * puis remontée : les premières ouvertures descendent l'arbre du répertoire,
+ * les ouvertures répétées d'un petit groupe de fichiers sont servies par le
+ * cache des entrées et la table des fichiers ouverts.
+ *
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int benchDirectory() {
+    static BenchContext ctx;
+    FormatOptions options = { 0, (uint64_t)dir_entries * 2 + 1024, (uint32_t)dir_entries + 64, DEFAULT_BLOCK_SIZE, CODEC_NONE };
+    Partition* partition = myFormatWith(BENCH_DIR_PARTITION, &options);
+    if (partition == NULL || myMkdir(partition, "big") == -1) {
+        printf("Erreur lors de la préparation de la partition de mesure des répertoires.\n");
+        if (partition != NULL) {
+            deletePartition(partition, BENCH_DIR_PARTITION);
+        }
+        return -1;
+    }
+
+    int status = 0;
+    prepareContext(&ctx, partition, NULL, opDirCreate, 0, 0);
+    status |= runWorkload("dir_create", &ctx, 1, dir_entries);
+    if (myUnmount(partition) == -1 || (partition = myMount(BENCH_DIR_PARTITION)) == NULL) {
+        printf("Erreur lors du remontage de la partition de mesure des répertoires.\n");
+        return -1;
+    }
+    prepareContext(&ctx, partition, NULL, opDirOpen, 0, 0);
+    status |= runWorkload("dir_open", &ctx, 1, dir_entries);
+    prepareContext(&ctx, partition, NULL, opDirReopen, 0, 0);
+    status |= runWorkload("dir_reopen", &ctx, 1, BENCH_OPS / divisor);
+    prepareContext(&ctx, partition, NULL, opDirList, 0, 0);
+    status |= runWorkload("dir_list", &ctx, 1, BENCH_DIR_LISTS);
+    prepareContext(&ctx, partition, NULL, opDirDelete, 0, 0);
+    status |= runWorkload("dir_delete", &ctx, 1, dir_entries);
+
+    deletePartition(partition, BENCH_DIR_PARTITION);
+    return status;
+}
+
+/**
+ * @brief Mesure le compromis entre débit et place perdue pour plusieurs tailles de bloc.
+ *
+ * Pour chaque taille, une partition de BENCH_BS_SPACE octets est formatée :
+ * un grand fichier y est écrit par ajouts successifs puis relu après un
+ * remontage, et BENCH_BS_FILES petits fichiers y sont créés. De grands blocs
+ * réduisent le nombre de blocs, d'extents et d'accès au cache par octet
+ * transféré, mais chaque petit fichier, chaque groupe d'inodes et chaque
+ * nœud d'arbre occupe alors un bloc entier : la part des octets alloués qui
+ * ne contiennent pas de données est rapportée avec la création des petits
+ * fichiers.
+ *
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int benchBlockSizes() {
+    static BenchContext ctx;
+    uint32_t block_sizes[] = { MIN_BLOCK_SIZE, 4096, 65536, MAX_BLOCK_SIZE };
+    int status = 0;
+    for (size_t b = 0; b < sizeof(block_sizes) / sizeof(block_sizes[0]); ++b) {
+        uint32_t block_size = block_sizes[b];
+        FormatOptions options = { BENCH_BS_SPACE, 0, BENCH_BS_FILES + 16, block_size, CODEC_NONE };
+        Partition* partition = myFormatWith(BENCH_BS_PARTITION, &options);
+        file* f = partition != NULL ? myOpen(partition, "large.dat") : NULL;
+        if (f == NULL) {
+            printf("Erreur lors de la préparation de la partition de blocs de %u octets.\n", block_size);
+            if (partition != NULL) {
+                deletePartition(partition, BENCH_BS_PARTITION);
+            }
+            return -1;
+        }
+
+        char name[40];
+        snprintf(name, sizeof(name), "bs%u_append", block_size);
+        prepareContext(&ctx, partition, f, opAppend, BENCH_MAX_IO, 0);
+        status |= runWorkload(name, &ctx, 1, BENCH_BS_LARGE / BENCH_MAX_IO / divisor);
+        if (myUnmount(partition) == -1 || (partition = myMount(BENCH_BS_PARTITION)) == NULL
+            || (f = myOpen(partition, "large.dat")) == NULL) {
+            printf("Erreur lors du remontage de la partition de blocs de %u octets.\n", block_size);
+            if (partition != NULL) {
+                deletePartition(partition, BENCH_BS_PARTITION);
+            }
+            return -1;
+        }
+        snprintf(name, sizeof(name), "bs%u_seq_read", block_size);
+        prepareContext(&ctx, partition, f, opSeqRead, BENCH_MAX_IO, 0);
+        status |= runWorkload(name, &ctx, 1, ctx.positions);
+        snprintf(name, sizeof(name), "bs%u_small_create", block_size);
+        prepareContext(&ctx, partition, NULL, opSmallCreate, BENCH_BS_SMALL, 0);
+        status |= runWorkload(name, &ctx, 1, BENCH_BS_FILES);
+
+        // Blocs occupés, métadonnées rangées dans la zone de données comprises
+        SuperBlock* sb = partition->superBlock;
+        double allocated = (double)(sb->num_blocks - sb->free_blocks) * block_size;
+        double data = (double)f->fileSize + (double)BENCH_BS_FILES * BENCH_BS_SMALL;
+        if (num_results > 0) {
+            results[num_results - 1].wasted = allocated > 0 ? 1 - data / allocated : 0;
+        }
+        printf("  blocs de %u octets : %.0f octets alloués pour %.0f octets de données (%.1f %% perdus)\n",
+               block_size, allocated, data, allocated > 0 ? 100 * (1 - data / allocated) : 0);
+        deletePartition(partition, BENCH_BS_PARTITION);
+    }
+    return status;
+}
+
+/**
+ * @brief Mesure le coût d'un clone et des copies avant écriture de ses blocs partagés.
+ *
+ * Un fichier de BENCH_CLONE_BLOCKS blocs est cloné BENCH_CLONES fois, puis
+ * des écritures d'un bloc sont réparties au hasard sur les clones : la
+ * première écriture dans un groupe de blocs partagés le copie. Les mêmes
+ * écritures sont ensuite répétées sur des blocs devenus propres à chaque
+ * clone, ce qui isole le coût de la copie, avant la suppression des clones.
+ *
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int benchClones() {
+    static BenchContext ctx;
+    int clones = BENCH_CLONES / divisor;
+    int writes = BENCH_FILE_OPS / divisor;
+    FormatOptions options = { 0, BENCH_CLONE_BLOCKS + (uint64_t)writes * COW_GROUP_BLOCKS * 2, (uint32_t)clones + 16,
+                              DEFAULT_BLOCK_SIZE, CODEC_NONE };
+    Partition* partition = myFormatWith(BENCH_CLONE_PARTITION, &options);
+    if (partition == NULL || createFile(partition, "source.dat", BENCH_CLONE_BLOCKS) == NULL) {
+        printf("Erreur lors de la préparation de la partition de mesure des clones.\n");
+        if (partition != NULL) {
+            deletePartition(partition, BENCH_CLONE_PARTITION);
+        }
+        return -1;
+    }
+
+    int status = 0;
+    prepareContext(&ctx, partition, NULL, opClone, 0, 0);
+    status |= runWorkload("clone", &ctx, 1, clones);
+    Stats before, after;
+    myStats(partition, &before);
+    prepareContext(&ctx, partition, NULL, opCloneWrite, DEFAULT_BLOCK_SIZE, 12345u);
+    ctx.positions = BENCH_CLONE_BLOCKS;
+    status |= runWorkload("clone_cow_write", &ctx, 1, writes);
+    myStats(partition, &after);
+    prepareContext(&ctx, partition, NULL, opCloneWrite, DEFAULT_BLOCK_SIZE, 12345u);
+    ctx.positions = BENCH_CLONE_BLOCKS;
+    status |= runWorkload("clone_rewrite", &ctx, 1, writes);
+    printf("  %.1f blocs copiés par écriture dans un bloc partagé\n",
+           (double)(after.counters[STATS_BLOCKS_COPIED] - before.counters[STATS_BLOCKS_COPIED]) / writes);
+    prepareContext(&ctx, partition, NULL, opCloneDelete, 0, 0);
+    status |= runWorkload("clone_delete", &ctx, 1, clones);
+
+    deletePartition(partition, BENCH_CLONE_PARTITION);
+    return status;
+}
+
+/**
+ * @brief Mesure les accès à un fichier de texte, sans compression puis compressé par chaque codec.
+ *
+ * Le texte imite un journal d'activité, dont les lignes se ressemblent sans
+ * se répéter. Le fichier est écrit séquentiellement, ce qui donne le taux de
+ * compression (octets de données par octet alloué), puis lu séquentiellement
+ * et au hasard par petits morceaux, qui ne décompressent que leur groupe de
+ * blocs, et enfin réécrit au hasard. Les débits sont ceux des données du
+ * fichier, avant compression.
+ *
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int benchCompression() {
+    static BenchContext ctx;
+    static const char* actions[] = { "open", "read", "write", "seek", "delete" };
+    unsigned seed = 42u;
+    for (int length = 0; length < BENCH_COMPRESS_TEXT;) {
+        seed = seed * 1103515245u + 12345u;
+        length += snprintf(compress_text + length, BENCH_COMPRESS_TEXT - length,
+                           "2024-03-%02u %02u:%02u:%02u user=%u op=%s path=/home/user%u/docs/file%u.txt bytes=%u status=%s\n",
+                           1 + (seed >> 8) % 28, (seed >> 4) % 24, (seed >> 12) % 60, (seed >> 18) % 60, (seed >> 10) % 100,
+                           actions[(seed >> 16) % 5], (seed >> 10) % 100, (seed >> 20) % 1000, (seed >> 6) % 65536,
+                           (seed >> 24) % 16 == 0 ? "error" : "ok");
+    }
+
+    int status = 0;
+    int64_t bytes = BENCH_COMPRESS_BYTES / divisor;
+    for (uint32_t codec = CODEC_NONE; codec < NUM_CODECS; ++codec) {
+        FormatOptions options = { 0, (uint64_t)bytes / DEFAULT_BLOCK_SIZE * 2 + 1024, 16, DEFAULT_BLOCK_SIZE, codec };
+        Partition* partition = myFormatWith(BENCH_COMPRESS_PARTITION, &options);
+        file* f = partition != NULL ? myOpen(partition, "text.log") : NULL;
+        if (f == NULL) {
+            printf("Erreur lors de la préparation de la partition de mesure de la compression.\n");
+            if (partition != NULL) {
+                deletePartition(partition, BENCH_COMPRESS_PARTITION);
+            }
+            return -1;
+        }
+        const char* name = codec == CODEC_NONE ? "none" : codecGet(codec)->name;
+        char workload[40];
+
+        uint64_t free_blocks = partition->superBlock->free_blocks;
+        prepareContext(&ctx, partition, f, opTextSeqWrite, BENCH_MAX_IO, 0);
+        ctx.positions = (int)(bytes / BENCH_MAX_IO);
+        snprintf(workload, sizeof(workload), "compress_%s_seq_write", name);
+        status |= runWorkload(workload, &ctx, 1, ctx.positions);
+        double allocated = (double)(free_blocks - partition->superBlock->free_blocks) * DEFAULT_BLOCK_SIZE;
+        if (num_results > 0) {
+            results[num_results - 1].ratio = allocated > 0 ? f->fileSize / allocated : 0;
+        }
+        printf("  %s : %lld octets de données dans %.0f octets alloués (taux %.2f)\n", name, (long long)f->fileSize,
+               allocated, allocated > 0 ? f->fileSize / allocated : 0);
+
+        prepareContext(&ctx, partition, f, opSeqRead, BENCH_MAX_IO, 0);
+        snprintf(workload, sizeof(workload), "compress_%s_seq_read", name);
+        status |= runWorkload(workload, &ctx, 1, ctx.positions);
+        prepareContext(&ctx, partition, f, opRandRead, DEFAULT_BLOCK_SIZE, 12345u);
+        snprintf(workload, sizeof(workload), "compress_%s_rand_read", name);
+        status |= runWorkload(workload, &ctx, 1, BENCH_FILE_OPS / divisor);
+        prepareContext(&ctx, partition, f, opTextRandWrite, 8 * DEFAULT_BLOCK_SIZE, 12345u);
+        snprintf(workload, sizeof(workload), "compress_%s_rand_write", name);
+        status |= runWorkload(workload, &ctx, 1, BENCH_FILE_OPS / divisor);
+        deletePartition(partition, BENCH_COMPRESS_PARTITION);
+    }
+    return status;
+}
+
+/**
+ * @brief Mesure une grande écriture dans une partition fragmentée et vérifie qu'elle survit à un remontage.
+ *
+ * BENCH_FRAG_FILES fichiers de deux blocs remplissent la partition, puis un
+ * sur deux est supprimé : un seul myWrite de BENCH_FRAG_BYTES octets s'étale
+ * alors sur des milliers d'extents d'un bloc ou deux, dont les changements
+ * d'arbre ne tiennent pas dans une seule transaction du journal et sont
+ * répartis sur plusieurs. Le fichier est relu après mySync et un remontage :
+ * une taille ou un contenu différents comptent comme une erreur. Le nombre
+ * de fichiers n'est pas réduit par --quick.
+ *
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int benchFragmented() {
+    static BenchContext ctx;
+    for (int k = 0; k < BENCH_FRAG_BYTES; ++k) {
+        frag_data[k] = (char)(k % 251);
+    }
+    FormatOptions options = { 0, (uint64_t)BENCH_FRAG_FILES * 5 / 2, BENCH_FRAG_FILES + 16, DEFAULT_BLOCK_SIZE,
+                              CODEC_NONE };
+    Partition* partition = myFormatWith(BENCH_FRAG_PARTITION, &options);
+    int status = partition != NULL ? 0 : -1;
+    for (int k = 0; status == 0 && k < BENCH_FRAG_FILES; ++k) {
+        char name[MAX_FILE_NAME];
+        snprintf(name, sizeof(name), "frag%d.dat", k);
+        file* f = myOpen(partition, name);
+        status = f != NULL && myWrite(f, frag_data, DEFAULT_BLOCK_SIZE + 1) == DEFAULT_BLOCK_SIZE + 1 ? 0 : -1;
+    }
+    for (int k = 0; status == 0 && k < BENCH_FRAG_FILES; k += 2) {
+        char name[MAX_FILE_NAME];
+        snprintf(name, sizeof(name), "frag%d.dat", k);
+        status = deleteFileFromPartition(partition, name);
+    }
+    file* f = status == 0 ? myOpen(partition, "large.dat") : NULL;
+    if (f == NULL) {
+        printf("Erreur lors de la préparation de la partition fragmentée.\n");
+        if (partition != NULL) {
+            deletePartition(partition, BENCH_FRAG_PARTITION);
+        }
+        return -1;
+    }
+
+    prepareContext(&ctx, partition, f, opFragWrite, BENCH_FRAG_BYTES, 0);
+    status = runWorkload("frag_large_write", &ctx, 1, 1);
+    char* data = malloc(BENCH_FRAG_BYTES);
+    if (data == NULL || mySync(partition) == -1 || myUnmount(partition) == -1
+        || (partition = myMount(BENCH_FRAG_PARTITION)) == NULL || (f = myOpen(partition, "large.dat")) == NULL) {
+        printf("Erreur lors du remontage de la partition fragmentée.\n");
+        free(data);
+        if (partition != NULL) {
+            deletePartition(partition, BENCH_FRAG_PARTITION);
+        }
+        return -1;
+    }
+    mySeek(f, 0, SEEK_SET);
+    if (f->fileSize != BENCH_FRAG_BYTES || myRead(f, data, BENCH_FRAG_BYTES) != BENCH_FRAG_BYTES
+        || memcmp(data, frag_data, BENCH_FRAG_BYTES) != 0) {
+        printf("Erreur : le fichier écrit dans la partition fragmentée diffère après le remontage.\n");
+        status = -1;
+    }
+    free(data);
+    deletePartition(partition, BENCH_FRAG_PARTITION);
+    return status;
+}
+
+/**
+ * @brief Écrit les résultats au format CSV, une ligne par mesure.
+ * @param path Le chemin du fichier créé.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int writeCsv(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        perror("Erreur lors de la création du fichier CSV");
+        return -1;
+    }
+    fprintf(out, "workload,threads,io_size,block_size,ops,seconds,ops_per_s,mb_per_s,p50_us,p99_us,p999_us,"
+            "calls_per_op,errors,wasted,ratio\n");
+    for (int i = 0; i < num_results; ++i) {
+        BenchResult* r = &results[i];
+        fprintf(out, "%s,%d,%d,%u,%zu,%.6f,%.1f,%.3f,%.3f,%.3f,%.3f,%.4f,%d,", r->workload, r->threads, r->io_size,
+                r->block_size, r->ops, r->seconds, r->ops / r->seconds,
+                r->ops * (double)r->io_size / r->seconds / (1024 * 1024),
+                r->p50, r->p99, r->p999, r->calls_per_op, r->errors);
+        if (r->wasted >= 0) {
+            fprintf(out, "%.4f", r->wasted);
+        }
+        fprintf(out, ",");
+        if (r->ratio >= 0) {
+            fprintf(out, "%.4f", r->ratio);
+        }
+        fprintf(out, "\n");
+    }
+    return fclose(out) == 0 ? 0 : -1;
+}
+
+/**
+ * @brief Écrit les résultats au format JSON.
+ * @param path Le chemin du fichier créé.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int writeJson(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        perror("Erreur lors de la création du fichier JSON");
+        return -1;
+    }
+    fprintf(out, "{\n  \"results\": [\n");
+    for (int i = 0; i < num_results; ++i) {
+        BenchResult* r = &results[i];
+        fprintf(out, "    {\"workload\": \"%s\", \"threads\": %d, \"io_size\": %d, \"block_size\": %u, \"ops\": %zu, "
+                "\"seconds\": %.6f, \"ops_per_s\": %.1f, \"mb_per_s\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f, "
+                "\"p999_us\": %.3f, \"calls_per_op\": %.4f, \"errors\": %d",
+                r->workload, r->threads, r->io_size, r->block_size, r->ops, r->seconds, r->ops / r->seconds,
+                r->ops * (double)r->io_size / r->seconds / (1024 * 1024), r->p50, r->p99, r->p999,
+                r->calls_per_op, r->errors);
+        if (r->wasted >= 0) {
+            fprintf(out, ", \"wasted\": %.4f", r->wasted);
+        }
+        if (r->ratio >= 0) {
+            fprintf(out, ", \"ratio\": %.4f", r->ratio);
+        }
+        fprintf(out, "}%s\n", i + 1 < num_results ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    return fclose(out) == 0 ? 0 : -1;
+}
+
+/**
+ * @brief Fonction principale de la mesure.
+ *
+ * Mesure les lectures asynchrones sur une partition pleine au cache vide,
+ * puis les accès d'un seul thread et ceux de plusieurs threads, chaque
+ * série supprimant ses fichiers pour rendre la place à la suivante, et enfin
+ * les répertoires, les tailles de bloc, les clones et la compression sur
+ * leurs propres partitions. La colonne appels/op donne le nombre
+ * d'io_uring_enter par lecture pour les mesures asynchrones et le nombre
+ * de fdatasync par opération sinon.
+ *
+ * @param argc Le nombre d'arguments.
+ * @param argv Les arguments : --quick divise le nombre d'opérations par BENCH_QUICK_DIVISOR, --csv et --json suivis d'un chemin écrivent les résultats dans ce fichier.
+ * @return 0 si la mesure s'exécute avec succès, 1 en cas d'erreur.
+ */
+int main(int argc, char** argv) {
+    const char* csv_path = NULL;
+    const char* json_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            divisor = BENCH_QUICK_DIVISOR;
+            dir_entries = BENCH_DIR_ENTRIES / BENCH_QUICK_DIVISOR;
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            printf("Usage : %s [--quick] [--csv fichier] [--json fichier]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Partition* partition = myFormat(BENCH_PARTITION);
+    if (partition == NULL) {
+        return 1;
+    }
+    printHeader();
+    int status = 0;
+    if (benchAsync(&partition) == -1) {
+        status = 1;
+    }
+    if (partition != NULL && (benchSingleThread(partition) == -1 || benchThreads(partition) == -1)) {
+        status = 1;
+    }
+    if (benchDirectory() == -1) {
+        status = 1;
+    }
+    if (benchBlockSizes() == -1) {
+        status = 1;
+    }
+    if (benchClones() == -1) {
+        status = 1;
+    }
+    if (benchCompression() == -1) {
+        status = 1;
+    }
+    if (benchFragmented() == -1) {
+        status = 1;
+    }
+    if ((csv_path != NULL && writeCsv(csv_path) == -1) || (json_path != NULL && writeJson(json_path) == -1)) {
+        status = 1;
+    }
+
+    if (partition != NULL) {
+        deletePartition(partition, BENCH_PARTITION);
+    }
+    return status;
+}
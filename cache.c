@@ -0,0 +1,607 @@
+/**
+ * @file cache.c
+ * @brief Ce fichier contient les définitions du cache de blocs : recherche par table de hachage, éviction LRU, lecture anticipée et écriture différée regroupée.
+ */
+
+#include "projet.h"
+
+/**
+ * @brief Partie du cache à laquelle appartient un bloc.
+ * @param cache Le cache.
+ * @param block Le bloc de données.
+ * @return La partie du cache.
+ */
+static CacheShard* shardOf(BufferCache* cache, uint64_t block) {
+    return &cache->shards[(block / CACHE_SHARD_SPAN) % CACHE_SHARDS];
+}
+
+/**
+ * @brief Calcule la case de la table de hachage d'un bloc.
+ * @param shard La partie du cache.
+ * @param block Le bloc de données.
+ * @return L'indice de la case.
+ */
+static size_t hashBlock(const CacheShard* shard, uint64_t block) {
+    return (block * 2654435761u) & shard->hash_mask;
+}
+
+/**
+ * @brief Retire un tampon de la liste LRU.
+ * @param buffer Le tampon.
+ */
+static void lruUnlink(Buffer* buffer) {
+    buffer->lru_prev->lru_next = buffer->lru_next;
+    buffer->lru_next->lru_prev = buffer->lru_prev;
+}
+
+/**
+ * @brief Place un tampon en tête de la liste LRU (le plus récemment utilisé).
+ * @param shard La partie du cache.
+ * @param buffer Le tampon.
+ */
+static void lruPushFront(CacheShard* shard, Buffer* buffer) {
+    buffer->lru_prev = &shard->lru;
+    buffer->lru_next = shard->lru.lru_next;
+    shard->lru.lru_next->lru_prev = buffer;
+    shard->lru.lru_next = buffer;
+}
+
+/**
+ * @brief Recherche le tampon d'un bloc dans la table de hachage.
+ * @param shard La partie du cache contenant le bloc.
+ * @param block Le bloc de données.
+ * @return Le tampon, NULL si le bloc n'est pas dans le cache.
+ */
+static Buffer* hashLookup(const CacheShard* shard, uint64_t block) {
+    for (Buffer* buffer = shard->hash[hashBlock(shard, block)]; buffer != NULL; buffer = buffer->hash_next) {
+        if (buffer->block == block) {
+            return buffer;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Retire un tampon de la table de hachage.
+ * @param shard La partie du cache.
+ * @param buffer Le tampon, qui doit être valide.
+ */
+static void hashRemove(CacheShard* shard, Buffer* buffer) {
+    Buffer** link = &shard->hash[hashBlock(shard, buffer->block)];
+    while (*link != buffer) {
+        link = &(*link)->hash_next;
+    }
+    *link = buffer->hash_next;
+    buffer->valid = 0;
+}
+
+/**
+ * @brief Écrit en un seul appel une suite de tampons modifiés de blocs consécutifs, puis leurs codes de contrôle.
+ * @param cache Le cache.
+ * @param shard La partie du cache dont les compteurs sont mis à jour.
+ * @param run Les tampons, dans l'ordre de leurs blocs.
+ * @param count Le nombre de tampons (au plus CACHE_CLUSTER_MAX).
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+static int writeRun(BufferCache* cache, CacheShard* shard, Buffer** run, int count) {
+    struct iovec iov[CACHE_CLUSTER_MAX];
+    for (int i = 0; i < count; ++i) {
+        iov[i].iov_base = run[i]->data;
+        iov[i].iov_len = cache->block_size;
+    }
+    ssize_t expected = (ssize_t)count * cache->block_size;
+    if (partitionWritev(cache->partition, iov, count, dataBlockOffset(cache->partition, run[0]->block)) != expected) {
+        return -1;
+    }
+
+    // Les codes de contrôle suivent les données, en une écriture pour toute la suite
+    for (int i = 0; i < count; ++i) {
+        setBlockChecksum(cache->partition, run[i]->block, run[i]->data);
+    }
+    if (dirtyBlockChecksums(cache->partition, run[0]->block, count) == -1) {
+        return -1;
+    }
+    for (int i = 0; i < count; ++i) {
+        run[i]->dirty = 0;
+    }
+    shard->stats.writebacks += count;
+    shard->stats.write_calls++;
+    return 0;
+}
+
+/**
+ * @brief Indique si un bloc de la même partie est dans le cache, modifié et non réservé.
+ * @param cache Le cache.
+ * @param shard La partie du cache, verrouillée.
+ * @param block Le bloc de données.
+ * @return Le tampon du bloc s'il peut être écrit avec ses voisins, NULL sinon.
+ */
+static Buffer* dirtyNeighbour(BufferCache* cache, CacheShard* shard, uint64_t block) {
+    if (shardOf(cache, block) != shard) {
+        return NULL;
+    }
+    Buffer* buffer = hashLookup(shard, block);
+    return (buffer != NULL && buffer->dirty && buffer->pins == 0) ? buffer : NULL;
+}
+
+/**
+ * @brief Écrit un tampon modifié avec les tampons modifiés des blocs voisins.
+ * 
+ * Les blocs modifiés consécutifs présents dans la même partie du cache de
+ * part et d'autre du bloc sont regroupés dans un seul pwritev.
+ * 
+ * @param cache Le cache.
+ * @param shard La partie du cache contenant le tampon, verrouillée.
+ * @param buffer Le tampon à écrire.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+static int writeBack(BufferCache* cache, CacheShard* shard, Buffer* buffer) {
+    Buffer* run[CACHE_CLUSTER_MAX];
+    int before = 0;
+    while (before < CACHE_CLUSTER_MAX / 2 && buffer->block > (uint64_t)before
+           && dirtyNeighbour(cache, shard, buffer->block - before - 1) != NULL) {
+        before++;
+    }
+
+    int count = 0;
+    for (int i = before; i > 0; --i) {
+        run[count++] = hashLookup(shard, buffer->block - i);
+    }
+    run[count++] = buffer;
+    Buffer* next;
+    while (count < CACHE_CLUSTER_MAX && (next = dirtyNeighbour(cache, shard, buffer->block + count - before)) != NULL) {
+        run[count++] = next;
+    }
+    return writeRun(cache, shard, run, count);
+}
+
+/**
+ * @brief Libère le tampon non réservé le moins récemment utilisé d'une partie du cache.
+ * 
+ * Son contenu est écrit auparavant s'il a été modifié.
+ * 
+ * @param cache Le cache.
+ * @param shard La partie du cache, verrouillée.
+ * @return Le tampon, retiré de la table de hachage, NULL si tous les tampons sont réservés (errno vaut alors EBUSY) ou en cas d'erreur.
+ */
+static Buffer* takeVictim(BufferCache* cache, CacheShard* shard) {
+    Buffer* victim = shard->lru.lru_prev;
+    while (victim != &shard->lru && victim->pins > 0) {
+        victim = victim->lru_prev;
+    }
+    if (victim == &shard->lru) {
+        errno = EBUSY;
+        return NULL;
+    }
+    if (victim->valid) {
+        if (victim->dirty && writeBack(cache, shard, victim) == -1) {
+            return NULL;
+        }
+        hashRemove(shard, victim);
+        shard->stats.evictions++;
+    }
+    return victim;
+}
+
+/**
+ * @brief Associe un tampon libre à un bloc et l'insère dans la table de hachage.
+ * @param shard La partie du cache, verrouillée.
+ * @param buffer Le tampon obtenu par takeVictim.
+ * @param block Le bloc de données.
+ * @param pins Le nombre de réservations du tampon.
+ */
+static void installBuffer(CacheShard* shard, Buffer* buffer, uint64_t block, int pins) {
+    buffer->block = block;
+    buffer->valid = 1;
+    buffer->dirty = 0;
+    buffer->pins = pins;
+    size_t slot = hashBlock(shard, block);
+    buffer->hash_next = shard->hash[slot];
+    shard->hash[slot] = buffer;
+    lruUnlink(buffer);
+    lruPushFront(shard, buffer);
+}
+
+/**
+ * @brief Retire un tampon non réservé du cache sans l'écrire.
+ * @param shard La partie du cache, verrouillée.
+ * @param buffer Le tampon.
+ */
+static void dropBuffer(CacheShard* shard, Buffer* buffer) {
+    hashRemove(shard, buffer);
+    buffer->dirty = 0;
+
+    // Le tampon libre sera le prochain réutilisé
+    lruUnlink(buffer);
+    buffer->lru_prev = shard->lru.lru_prev;
+    buffer->lru_next = &shard->lru;
+    shard->lru.lru_prev->lru_next = buffer;
+    shard->lru.lru_prev = buffer;
+}
+
+/**
+ * @brief Fonction pour initialiser le cache de blocs.
+ * @param cache Le cache à initialiser.
+ * @param partition La partition dont les blocs sont mis en cache.
+ * @param memory Mémoire à consacrer aux données, en octets.
+ * @param block_size La taille des blocs de la partition, qui est celle des tampons.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int cacheInit(BufferCache* cache, struct Partition* partition, size_t memory, uint32_t block_size) {
+    memset(cache, 0, sizeof(BufferCache));
+    cache->partition = partition;
+    cache->block_size = block_size;
+    cache->num_buffers = memory / block_size > CACHE_SHARDS ? memory / block_size : CACHE_SHARDS;
+    for (int s = 0; s < CACHE_SHARDS; ++s) {
+        pthread_mutex_init(&cache->shards[s].lock, NULL);
+        pthread_cond_init(&cache->shards[s].loaded, NULL);
+    }
+
+    cache->buffers = calloc(cache->num_buffers, sizeof(Buffer));
+    cache->memory = malloc(cache->num_buffers * cache->block_size);
+    if (cache->buffers == NULL || cache->memory == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour le cache de blocs.");
+        cacheDestroy(cache);
+        return -1;
+    }
+
+    // Les tampons sont répartis entre les parties, chacune avec sa table de hachage
+    size_t first = 0;
+    for (int s = 0; s < CACHE_SHARDS; ++s) {
+        CacheShard* shard = &cache->shards[s];
+        shard->buffers = cache->buffers + first;
+        shard->num_buffers = cache->num_buffers / CACHE_SHARDS + ((size_t)s < cache->num_buffers % CACHE_SHARDS ? 1 : 0);
+
+        size_t hash_size = 1;
+        while (hash_size < 2 * shard->num_buffers) {
+            hash_size *= 2;
+        }
+        shard->hash_mask = hash_size - 1;
+        shard->hash = calloc(hash_size, sizeof(Buffer*));
+        if (shard->hash == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour le cache de blocs.");
+            cacheDestroy(cache);
+            return -1;
+        }
+
+        // Tous les tampons sont libres et chaînés dans la liste LRU
+        shard->lru.lru_next = shard->lru.lru_prev = &shard->lru;
+        for (size_t i = 0; i < shard->num_buffers; ++i) {
+            shard->buffers[i].data = cache->memory + (first + i) * cache->block_size;
+            lruPushFront(shard, &shard->buffers[i]);
+        }
+        first += shard->num_buffers;
+    }
+    return 0;
+}
+
+/**
+ * @brief Fonction pour libérer le cache de blocs.
+ * @param cache Le cache à libérer.
+ */
+void cacheDestroy(BufferCache* cache) {
+    for (int s = 0; s < CACHE_SHARDS; ++s) {
+        free(cache->shards[s].hash);
+        pthread_cond_destroy(&cache->shards[s].loaded);
+        pthread_mutex_destroy(&cache->shards[s].lock);
+    }
+    free(cache->buffers);
+    free(cache->memory);
+    memset(cache, 0, sizeof(BufferCache));
+}
+
+/**
+ * @brief Fonction pour obtenir le tampon d'un bloc de données.
+ * @param cache Le cache.
+ * @param block Le bloc de données.
+ * @param mode CACHE_READ, CACHE_OVERWRITE ou CACHE_LOOKUP.
+ * @return Le tampon du bloc, NULL en cas d'erreur.
+ */
+Buffer* cacheGet(BufferCache* cache, uint64_t block, int mode) {
+    CacheShard* shard = shardOf(cache, block);
+    pthread_mutex_lock(&shard->lock);
+
+    // Un bloc en cours de lecture par un autre thread est attendu
+    Buffer* buffer;
+    while ((buffer = hashLookup(shard, block)) != NULL && buffer->loading) {
+        pthread_cond_wait(&shard->loaded, &shard->lock);
+    }
+    if (buffer != NULL) {
+        shard->stats.hits++;
+        lruUnlink(buffer);
+        lruPushFront(shard, buffer);
+        buffer->pins++;
+        pthread_mutex_unlock(&shard->lock);
+        return buffer;
+    }
+
+    if (mode == CACHE_LOOKUP) {
+        pthread_mutex_unlock(&shard->lock);
+        return NULL;
+    }
+
+    // Réutiliser le tampon libre ou non réservé le moins récemment utilisé
+    Buffer* victim = takeVictim(cache, shard);
+    if (victim == NULL) {
+        pthread_mutex_unlock(&shard->lock);
+        return NULL;
+    }
+    installBuffer(shard, victim, block, 1);
+
+    if (mode == CACHE_READ) {
+        // La lecture se fait hors du verrou : le tampon réservé et marqué ne peut pas être réutilisé
+        shard->stats.misses++;
+        shard->stats.read_calls++;
+        victim->loading = 1;
+        pthread_mutex_unlock(&shard->lock);
+        int failed = partitionRead(cache->partition, victim->data, cache->block_size, dataBlockOffset(cache->partition, block)) != (ssize_t)cache->block_size
+                     || verifyBlockChecksum(cache->partition, block, victim->data) == -1;
+        int error = errno;
+        pthread_mutex_lock(&shard->lock);
+        victim->loading = 0;
+        if (failed) {
+            victim->pins--;
+            hashRemove(shard, victim);
+            victim = NULL;
+            errno = error;
+        }
+        pthread_cond_broadcast(&shard->loaded);
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+    return victim;
+}
+
+/**
+ * @brief Fonction pour charger à l'avance une suite de blocs consécutifs.
+ * @param cache Le cache.
+ * @param block Le premier bloc de données.
+ * @param count Le nombre de blocs.
+ * @return Le nombre de blocs lus depuis la partition, -1 en cas d'erreur de lecture.
+ */
+int cachePrefetch(BufferCache* cache, uint64_t block, uint32_t count) {
+    int loaded = 0;
+    uint32_t i = 0;
+    uint64_t group = UINT64_MAX;
+    size_t room = 0;
+    while (i < count) {
+        // Chaque lecture reste dans les blocs d'une même partie
+        CacheShard* shard = shardOf(cache, block + i);
+        uint64_t group_end = ((block + i) / CACHE_SHARD_SPAN + 1) * CACHE_SHARD_SPAN - block;
+        uint32_t limit = group_end < count ? (uint32_t)group_end : count;
+
+        // Au-delà du nombre de tampons de la partie, les blocs chargés s'évinceraient avant d'être lus
+        if ((block + i) / CACHE_SHARD_SPAN != group) {
+            group = (block + i) / CACHE_SHARD_SPAN;
+            room = shard->num_buffers;
+        }
+        if (room == 0) {
+            i = limit;
+            continue;
+        }
+        if (limit - i > room) {
+            limit = i + room;
+        }
+
+        pthread_mutex_lock(&shard->lock);
+        if (hashLookup(shard, block + i) != NULL) {
+            pthread_mutex_unlock(&shard->lock);
+            i++;
+            continue;
+        }
+
+        // Réserver un tampon pour chaque bloc absent consécutif
+        Buffer* run[CACHE_CLUSTER_MAX];
+        struct iovec iov[CACHE_CLUSTER_MAX];
+        uint64_t first = block + i;
+        int n = 0;
+        while (i < limit && n < CACHE_CLUSTER_MAX && hashLookup(shard, block + i) == NULL) {
+            Buffer* victim = takeVictim(cache, shard);
+            if (victim == NULL) {
+                break;
+            }
+            installBuffer(shard, victim, block + i, 1);
+            victim->loading = 1;
+            run[n] = victim;
+            iov[n].iov_base = victim->data;
+            iov[n].iov_len = cache->block_size;
+            n++;
+            i++;
+        }
+        if (n == 0) {
+            pthread_mutex_unlock(&shard->lock);
+            break; // Tous les tampons sont réservés
+        }
+        room -= n;
+        shard->stats.prefetched += n;
+        shard->stats.read_calls++;
+        pthread_mutex_unlock(&shard->lock);
+
+        // Un seul preadv remplit tous les tampons, hors du verrou
+        ssize_t expected = (ssize_t)n * cache->block_size;
+        int failed = partitionReadv(cache->partition, iov, n, dataBlockOffset(cache->partition, first)) != expected;
+
+        // Un bloc corrompu n'est pas gardé : sa lecture par cacheGet signalera l'erreur
+        uint64_t corrupted = 0;
+        for (int j = 0; j < n && !failed; ++j) {
+            if (verifyBlockChecksum(cache->partition, first + j, run[j]->data) == -1) {
+                corrupted |= (uint64_t)1 << j;
+            }
+        }
+
+        pthread_mutex_lock(&shard->lock);
+        for (int j = 0; j < n; ++j) {
+            run[j]->loading = 0;
+            run[j]->pins--;
+            if (failed || (corrupted >> j & 1)) {
+                hashRemove(shard, run[j]);
+            }
+        }
+        pthread_cond_broadcast(&shard->loaded);
+        pthread_mutex_unlock(&shard->lock);
+        if (failed) {
+            return -1;
+        }
+        loaded += n;
+    }
+    return loaded;
+}
+
+/**
+ * @brief Fonction pour rendre un tampon obtenu par cacheGet.
+ * @param cache Le cache.
+ * @param buffer Le tampon.
+ * @param dirty 1 si le contenu du tampon a été modifié.
+ */
+void cacheRelease(BufferCache* cache, Buffer* buffer, int dirty) {
+    CacheShard* shard = shardOf(cache, buffer->block);
+    pthread_mutex_lock(&shard->lock);
+    if (dirty) {
+        buffer->dirty = 1;
+    }
+    buffer->pins--;
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/**
+ * @brief Fonction pour retirer un bloc libéré du cache sans l'écrire.
+ * @param cache Le cache.
+ * @param block Le bloc de données libéré.
+ */
+void cacheInvalidate(BufferCache* cache, uint64_t block) {
+    CacheShard* shard = shardOf(cache, block);
+    pthread_mutex_lock(&shard->lock);
+    Buffer* buffer = hashLookup(shard, block);
+    if (buffer != NULL && buffer->pins == 0) {
+        dropBuffer(shard, buffer);
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/**
+ * @brief Fonction pour retirer un bloc du cache s'il n'a pas été modifié.
+ * @param cache Le cache.
+ * @param block Le bloc de données.
+ */
+void cacheDiscardClean(BufferCache* cache, uint64_t block) {
+    CacheShard* shard = shardOf(cache, block);
+    pthread_mutex_lock(&shard->lock);
+    Buffer* buffer = hashLookup(shard, block);
+    if (buffer != NULL && !buffer->dirty && buffer->pins == 0) {
+        dropBuffer(shard, buffer);
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/**
+ * @brief Compare deux tampons selon la position de leur bloc (pour qsort).
+ * @param a Pointeur vers le premier tampon.
+ * @param b Pointeur vers le second tampon.
+ * @return Un entier négatif, nul ou positif.
+ */
+static int compareBuffers(const void* a, const void* b) {
+    uint64_t block_a = (*(Buffer* const*)a)->block, block_b = (*(Buffer* const*)b)->block;
+    return (block_a > block_b) - (block_a < block_b);
+}
+
+/**
+ * @brief Fonction pour écrire sur la partition tous les blocs modifiés.
+ * @param cache Le cache.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int cacheFlush(BufferCache* cache) {
+    Buffer** dirty = malloc(cache->num_buffers * sizeof(Buffer*));
+    if (dirty == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour le cache de blocs.");
+        return -1;
+    }
+
+    // Toutes les parties sont verrouillées, dans l'ordre, pour regrouper les blocs voisins
+    for (int s = 0; s < CACHE_SHARDS; ++s) {
+        pthread_mutex_lock(&cache->shards[s].lock);
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < cache->num_buffers; ++i) {
+        if (cache->buffers[i].valid && cache->buffers[i].dirty && !cache->buffers[i].loading) {
+            dirty[count++] = &cache->buffers[i];
+        }
+    }
+    qsort(dirty, count, sizeof(Buffer*), compareBuffers);
+
+    // Les blocs consécutifs sont regroupés dans un même pwritev
+    int status = 0;
+    size_t start = 0;
+    while (start < count) {
+        size_t end = start + 1;
+        while (end < count && end - start < CACHE_CLUSTER_MAX && dirty[end]->block == dirty[end - 1]->block + 1) {
+            end++;
+        }
+        if (writeRun(cache, shardOf(cache, dirty[start]->block), dirty + start, end - start) == -1) {
+            status = -1;
+        }
+        start = end;
+    }
+    for (int s = CACHE_SHARDS - 1; s >= 0; --s) {
+        pthread_mutex_unlock(&cache->shards[s].lock);
+    }
+    free(dirty);
+    return status;
+}
+
+/**
+ * @brief Fonction pour écrire sur la partition les blocs modifiés d'une suite de blocs consécutifs.
+ * @param cache Le cache.
+ * @param block Le premier bloc de données.
+ * @param count Le nombre de blocs.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int cacheFlushRange(BufferCache* cache, uint64_t block, uint64_t count) {
+    int status = 0;
+    uint64_t end = block + count;
+    while (block < end && status == 0) {
+        // Les blocs d'un même groupe de CACHE_SHARD_SPAN blocs sont dans la même partie
+        uint64_t stop = (block / CACHE_SHARD_SPAN + 1) * CACHE_SHARD_SPAN;
+        if (stop > end) {
+            stop = end;
+        }
+        CacheShard* shard = shardOf(cache, block);
+        Buffer* run[CACHE_SHARD_SPAN];
+        int length = 0;
+        pthread_mutex_lock(&shard->lock);
+        for (; block < stop && status == 0; ++block) {
+            Buffer* buffer = hashLookup(shard, block);
+            if (buffer != NULL && buffer->dirty && !buffer->loading) {
+                run[length++] = buffer;
+            } else if (length > 0) {
+                status = writeRun(cache, shard, run, length);
+                length = 0;
+            }
+        }
+        if (length > 0 && status == 0) {
+            status = writeRun(cache, shard, run, length);
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return status;
+}
+
+/**
+ * @brief Fonction pour obtenir les compteurs d'activité du cache.
+ * @param cache Le cache.
+ * @param stats Les compteurs à remplir.
+ */
+void cacheGetStats(BufferCache* cache, CacheStats* stats) {
+    memset(stats, 0, sizeof(CacheStats));
+    for (int s = 0; s < CACHE_SHARDS; ++s) {
+        CacheShard* shard = &cache->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        stats->hits += shard->stats.hits;
+        stats->misses += shard->stats.misses;
+        stats->writebacks += shard->stats.writebacks;
+        stats->evictions += shard->stats.evictions;
+        stats->prefetched += shard->stats.prefetched;
+        stats->read_calls += shard->stats.read_calls;
+        stats->write_calls += shard->stats.write_calls;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
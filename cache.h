@@ -0,0 +1,242 @@
+/**
+ * @file cache.h
+ * @brief Ce fichier contient les déclarations du cache de blocs placé entre les fichiers et la partition.
+ */
+
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+struct Partition;
+
+/**
+ * @def CACHE_MEMORY
+ * @brief Mémoire consacrée par défaut aux données du cache de blocs, en octets.
+ */
+#define CACHE_MEMORY (64 * 1024)
+
+/**
+ * @def CACHE_CLUSTER_MAX
+ * @brief Nombre maximal de blocs consécutifs lus ou écrits en un seul appel système.
+ */
+#define CACHE_CLUSTER_MAX 64
+
+/**
+ * @def CACHE_SHARDS
+ * @brief Nombre de parties du cache, chacune protégée par son propre verrou.
+ */
+#define CACHE_SHARDS 16
+
+/**
+ * @def CACHE_SHARD_SPAN
+ * @brief Nombre de blocs consécutifs confiés à une même partie du cache.
+ * 
+ * Les blocs voisins restent dans la même partie, ce qui permet de les écrire
+ * ensemble lors d'une éviction.
+ */
+#define CACHE_SHARD_SPAN 8
+
+/**
+ * @def CACHE_READ
+ * @brief Le contenu du bloc doit être lu depuis la partition s'il n'est pas dans le cache.
+ */
+#define CACHE_READ 0
+
+/**
+ * @def CACHE_OVERWRITE
+ * @brief Le bloc va être entièrement réécrit : son contenu n'est pas lu depuis la partition.
+ */
+#define CACHE_OVERWRITE 1
+
+/**
+ * @def CACHE_LOOKUP
+ * @brief Le tampon n'est retourné que si le bloc est déjà dans le cache.
+ */
+#define CACHE_LOOKUP 2
+
+/**
+ * @struct Buffer
+ * @brief Tampon du cache contenant l'image d'un bloc de données.
+ */
+typedef struct Buffer {
+    uint64_t block; /**< Bloc de données associé au tampon. */
+    int valid; /**< 1 si le tampon contient un bloc, 0 s'il est libre. */
+    int dirty; /**< 1 si le tampon a été modifié depuis sa dernière écriture sur la partition. */
+    int pins; /**< Nombre d'utilisateurs en cours : un tampon utilisé n'est jamais évincé. */
+    int loading; /**< 1 pendant la lecture du bloc depuis la partition, faite hors du verrou. */
+    struct Buffer* hash_next; /**< Tampon suivant dans la même case de la table de hachage. */
+    struct Buffer* lru_prev; /**< Tampon utilisé plus récemment. */
+    struct Buffer* lru_next; /**< Tampon utilisé moins récemment. */
+    char* data; /**< Contenu du bloc. */
+} Buffer;
+
+/**
+ * @struct CacheStats
+ * @brief Compteurs d'activité du cache de blocs.
+ */
+typedef struct {
+    unsigned long hits; /**< Demandes satisfaites sans accès à la partition. */
+    unsigned long misses; /**< Demandes ayant nécessité une lecture de la partition. */
+    unsigned long writebacks; /**< Blocs modifiés écrits sur la partition. */
+    unsigned long evictions; /**< Tampons réutilisés pour un autre bloc. */
+    unsigned long prefetched; /**< Blocs chargés à l'avance par cachePrefetch. */
+    unsigned long read_calls; /**< Appels système de lecture effectués par le cache. */
+    unsigned long write_calls; /**< Appels système d'écriture effectués par le cache. */
+} CacheStats;
+
+/**
+ * @struct CacheShard
+ * @brief Partie du cache : ses tampons, sa table de hachage et sa liste LRU, protégés par un verrou.
+ */
+typedef struct {
+    pthread_mutex_t lock; /**< Protège tous les champs de la partie et l'état de ses tampons. */
+    pthread_cond_t loaded; /**< Signalé lorsqu'un tampon de la partie a fini d'être lu. */
+    Buffer* buffers; /**< Tableau des tampons de la partie. */
+    size_t num_buffers; /**< Nombre de tampons. */
+    Buffer** hash; /**< Table de hachage des tampons valides, indexée par numéro de bloc. */
+    size_t hash_mask; /**< Taille de la table de hachage moins un (puissance de 2). */
+    Buffer lru; /**< Sentinelle de la liste LRU : lru.lru_next est le plus récent, lru.lru_prev le plus ancien. */
+    CacheStats stats; /**< Compteurs d'activité. */
+} CacheShard;
+
+/**
+ * @struct BufferCache
+ * @brief Cache de blocs de données avec éviction LRU et écriture différée.
+ * 
+ * Les blocs sont répartis entre CACHE_SHARDS parties par groupes de
+ * CACHE_SHARD_SPAN blocs consécutifs, pour que des threads accédant à des
+ * blocs différents prennent des verrous différents. Le contenu d'un tampon
+ * réservé est lu et modifié hors du verrou : c'est le verrou de l'inode
+ * propriétaire du bloc qui en protège l'accès.
+ */
+typedef struct {
+    struct Partition* partition; /**< Partition dont le cache contient les blocs. */
+    Buffer* buffers; /**< Tableau de tous les tampons. */
+    char* memory; /**< Mémoire contenant les données de tous les tampons. */
+    uint32_t block_size; /**< Taille d'un tampon, celle des blocs de la partition. */
+    size_t num_buffers; /**< Nombre total de tampons. */
+    CacheShard shards[CACHE_SHARDS]; /**< Parties du cache. */
+} BufferCache;
+
+/**
+ * @brief Fonction pour initialiser le cache de blocs.
+ * 
+ * @param cache Le cache à initialiser.
+ * @param partition La partition dont les blocs sont mis en cache.
+ * @param memory Mémoire à consacrer aux données, en octets (au moins un bloc par partie).
+ * @param block_size La taille des blocs de la partition, qui est celle des tampons.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int cacheInit(BufferCache* cache, struct Partition* partition, size_t memory, uint32_t block_size);
+
+/**
+ * @brief Fonction pour libérer le cache de blocs.
+ * 
+ * Les blocs modifiés doivent avoir été écrits avec cacheFlush au préalable.
+ * 
+ * @param cache Le cache à libérer.
+ */
+void cacheDestroy(BufferCache* cache);
+
+/**
+ * @brief Fonction pour obtenir le tampon d'un bloc de données.
+ * 
+ * Le tampon est réservé jusqu'à l'appel de cacheRelease. Si le bloc n'est
+ * pas dans le cache, le tampon le moins récemment utilisé de sa partie est
+ * réutilisé (après écriture de son contenu s'il a été modifié, regroupée
+ * avec celle des blocs voisins modifiés). La lecture du bloc se fait hors du
+ * verrou ; les autres threads qui demandent le même bloc l'attendent. Le
+ * bloc lu est comparé à son code de contrôle.
+ * 
+ * @param cache Le cache.
+ * @param block Le bloc de données.
+ * @param mode CACHE_READ, CACHE_OVERWRITE ou CACHE_LOOKUP.
+ * @return Le tampon du bloc, NULL en cas d'erreur, si tous les tampons sont réservés
+ *         ou si le bloc est absent en mode CACHE_LOOKUP. errno vaut EBADMSG si le
+ *         bloc lu ne correspond pas à son code de contrôle.
+ */
+Buffer* cacheGet(BufferCache* cache, uint64_t block, int mode);
+
+/**
+ * @brief Fonction pour charger à l'avance une suite de blocs consécutifs.
+ * 
+ * Les blocs absents du cache sont lus par groupes consécutifs, chaque groupe
+ * avec un seul preadv directement dans les tampons. Les blocs déjà présents
+ * ne sont pas relus, les blocs corrompus ne sont pas gardés. Une partie du
+ * cache ne reçoit pas plus de blocs qu'elle n'a de tampons, pour que les
+ * blocs chargés ne s'évincent pas les uns les autres avant d'être lus.
+ * 
+ * @param cache Le cache.
+ * @param block Le premier bloc de données.
+ * @param count Le nombre de blocs.
+ * @return Le nombre de blocs lus depuis la partition, -1 en cas d'erreur de lecture.
+ */
+int cachePrefetch(BufferCache* cache, uint64_t block, uint32_t count);
+
+/**
+ * @brief Fonction pour rendre un tampon obtenu par cacheGet.
+ * 
+ * @param cache Le cache.
+ * @param buffer Le tampon.
+ * @param dirty 1 si le contenu du tampon a été modifié.
+ */
+void cacheRelease(BufferCache* cache, Buffer* buffer, int dirty);
+
+/**
+ * @brief Fonction pour retirer un bloc libéré du cache sans l'écrire.
+ * 
+ * @param cache Le cache.
+ * @param block Le bloc de données libéré.
+ */
+void cacheInvalidate(BufferCache* cache, uint64_t block);
+
+/**
+ * @brief Fonction pour retirer un bloc du cache s'il n'a pas été modifié.
+ * 
+ * Utilisée après une écriture faite directement sur la partition : une
+ * copie du bloc chargée pendant l'écriture ne serait plus à jour.
+ * 
+ * @param cache Le cache.
+ * @param block Le bloc de données.
+ */
+void cacheDiscardClean(BufferCache* cache, uint64_t block);
+
+/**
+ * @brief Fonction pour écrire sur la partition tous les blocs modifiés.
+ * 
+ * Les blocs sont écrits dans l'ordre croissant de leur position, chaque
+ * suite de blocs consécutifs avec un seul pwritev, toutes parties
+ * confondues.
+ * 
+ * @param cache Le cache.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int cacheFlush(BufferCache* cache);
+
+/**
+ * @brief Fonction pour écrire sur la partition les blocs modifiés d'une suite de blocs consécutifs.
+ * 
+ * Seules les parties du cache qui contiennent les blocs sont verrouillées,
+ * chacune à son tour : les blocs modifiés consécutifs d'une même partie
+ * sont écrits avec un seul pwritev. Les autres blocs du cache ne sont ni
+ * parcourus ni écrits.
+ * 
+ * @param cache Le cache.
+ * @param block Le premier bloc de données.
+ * @param count Le nombre de blocs.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int cacheFlushRange(BufferCache* cache, uint64_t block, uint64_t count);
+
+/**
+ * @brief Fonction pour obtenir les compteurs d'activité du cache, cumulés sur toutes ses parties.
+ * 
+ * @param cache Le cache.
+ * @param stats Les compteurs à remplir.
+ */
+void cacheGetStats(BufferCache* cache, CacheStats* stats);
+
+#endif /* CACHE_H_ */
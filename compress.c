@@ -0,0 +1,299 @@
+/**
+ * @file compress.c
+ * @brief Ce fichier contient les définitions des codecs de compression : codec LZ4 intégré, sans bibliothèque externe, et table des codecs.
+ */
+
+#include <string.h>
+
+#include "compress.h"
+
+/**
+ * @def LZ4_MIN_MATCH
+ * @brief Longueur minimale d'une correspondance, retranchée de la longueur codée.
+ */
+#define LZ4_MIN_MATCH 4
+
+/**
+ * @def LZ4_HASH_BITS
+ * @brief Nombre de bits de l'empreinte de quatre octets qui indexe la table des positions.
+ */
+#define LZ4_HASH_BITS 12
+
+/**
+ * @def LZ4_LAST_LITERALS
+ * @brief Nombre d'octets de la fin d'une suite toujours rangés comme littéraux.
+ */
+#define LZ4_LAST_LITERALS 5
+
+/**
+ * @def LZ4_MATCH_LIMIT
+ * @brief Une correspondance commence au moins LZ4_MATCH_LIMIT octets avant la fin de la suite.
+ */
+#define LZ4_MATCH_LIMIT 12
+
+/**
+ * @def LZ4_MAX_OFFSET
+ * @brief Plus grande distance d'une correspondance, codée sur deux octets.
+ */
+#define LZ4_MAX_OFFSET 65535
+
+/**
+ * @def LZ4_SKIP_SHIFT
+ * @brief Sans correspondance, le pas de la recherche grandit d'un octet tous les 2^LZ4_SKIP_SHIFT octets examinés.
+ */
+#define LZ4_SKIP_SHIFT 6
+
+/**
+ * @brief Lit quatre octets, sans contrainte d'alignement.
+ * @param p Les octets.
+ * @return Leur valeur.
+ */
+static uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Calcule l'empreinte de quatre octets.
+ * @param value Les quatre octets.
+ * @return L'empreinte, sur LZ4_HASH_BITS bits.
+ */
+static uint32_t hash4(uint32_t value) {
+    return (value * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+/**
+ * @brief Écrit une longueur au-delà de 15 sous forme d'octets 255 suivis du reste.
+ * @param out La position d'écriture, avancée.
+ * @param end La fin du tampon.
+ * @param length La longueur, diminuée de 15.
+ * @return 0 en cas de succès, -1 si le tampon est plein.
+ */
+static int writeLength(uint8_t** out, const uint8_t* end, size_t length) {
+    while (length >= 255) {
+        if (*out >= end) {
+            return -1;
+        }
+        *(*out)++ = 255;
+        length -= 255;
+    }
+    if (*out >= end) {
+        return -1;
+    }
+    *(*out)++ = (uint8_t)length;
+    return 0;
+}
+
+/**
+ * @brief Écrit une séquence LZ4 : des littéraux, puis une correspondance si match_length est non nul.
+ * @param out La position d'écriture, avancée.
+ * @param end La fin du tampon.
+ * @param literals Les littéraux.
+ * @param literal_length Le nombre de littéraux.
+ * @param offset La distance de la correspondance.
+ * @param match_length La longueur de la correspondance, 0 pour la dernière séquence.
+ * @return 0 en cas de succès, -1 si le tampon est plein.
+ */
+static int writeSequence(uint8_t** out, const uint8_t* end, const uint8_t* literals, size_t literal_length,
+                         uint32_t offset, size_t match_length) {
+    if (*out >= end) {
+        return -1;
+    }
+    uint8_t* token = (*out)++;
+    *token = (uint8_t)((literal_length >= 15 ? 15 : literal_length) << 4);
+    if (literal_length >= 15 && writeLength(out, end, literal_length - 15) == -1) {
+        return -1;
+    }
+    if ((size_t)(end - *out) < literal_length) {
+        return -1;
+    }
+    memcpy(*out, literals, literal_length);
+    *out += literal_length;
+    if (match_length == 0) {
+        return 0;
+    }
+
+    if (end - *out < 2) {
+        return -1;
+    }
+    *(*out)++ = (uint8_t)offset;
+    *(*out)++ = (uint8_t)(offset >> 8);
+    size_t coded = match_length - LZ4_MIN_MATCH;
+    *token |= (uint8_t)(coded >= 15 ? 15 : coded);
+    return coded >= 15 ? writeLength(out, end, coded - 15) : 0;
+}
+
+/**
+ * @brief Compresse une suite d'octets au format de blocs LZ4.
+ *
+ * Chaque position est cherchée dans une table des dernières positions de
+ * chaque empreinte de quatre octets ; une correspondance trouvée est
+ * prolongée vers l'arrière puis vers l'avant. Le pas de la recherche
+ * grandit lorsque rien ne correspond, si bien que des octets
+ * incompressibles sont parcourus rapidement.
+ *
+ * @param source Les octets.
+ * @param size Le nombre d'octets.
+ * @param destination Le tampon des octets compressés.
+ * @param capacity La taille du tampon.
+ * @return Le nombre d'octets compressés, -1 s'ils ne tiennent pas dans le tampon.
+ */
+static int64_t lz4Compress(const void* source, size_t size, void* destination, size_t capacity) {
+    const uint8_t* src = source;
+    uint8_t* out = destination;
+    const uint8_t* end = out + capacity;
+    uint32_t table[1 << LZ4_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    // Les positions sont rangées plus un : 0 marque une empreinte jamais vue
+    size_t anchor = 0, position = 0;
+    while (size >= LZ4_MATCH_LIMIT && position + LZ4_MATCH_LIMIT <= size) {
+        uint32_t value = read32(src + position);
+        uint32_t hash = hash4(value);
+        size_t candidate = table[hash];
+        table[hash] = (uint32_t)position + 1;
+        if (candidate == 0 || position - (candidate - 1) > LZ4_MAX_OFFSET || read32(src + candidate - 1) != value) {
+            position += 1 + ((position - anchor) >> LZ4_SKIP_SHIFT);
+            continue;
+        }
+
+        size_t reference = candidate - 1;
+        while (position > anchor && reference > 0 && src[position - 1] == src[reference - 1]) {
+            position--;
+            reference--;
+        }
+        size_t length = LZ4_MIN_MATCH, limit = size - LZ4_LAST_LITERALS - position;
+        while (length < limit && src[position + length] == src[reference + length]) {
+            length++;
+        }
+        if (writeSequence(&out, end, src + anchor, position - anchor, (uint32_t)(position - reference), length) == -1) {
+            return -1;
+        }
+        position += length;
+        anchor = position;
+        if (position + LZ4_MATCH_LIMIT <= size) {
+            table[hash4(read32(src + position - 2))] = (uint32_t)(position - 2) + 1;
+        }
+    }
+    if (writeSequence(&out, end, src + anchor, size - anchor, 0, 0) == -1) {
+        return -1;
+    }
+    return out - (uint8_t*)destination;
+}
+
+/**
+ * @brief Lit une longueur prolongée par des octets 255.
+ * @param in La position de lecture, avancée.
+ * @param end La fin des octets compressés.
+ * @param length La longueur, augmentée.
+ * @return 0 en cas de succès, -1 si les octets compressés s'arrêtent avant la fin de la longueur.
+ */
+static int readLength(const uint8_t** in, const uint8_t* end, size_t* length) {
+    uint8_t byte;
+    do {
+        if (*in >= end) {
+            return -1;
+        }
+        byte = *(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return 0;
+}
+
+/**
+ * @brief Décompresse le début d'une suite d'octets au format de blocs LZ4.
+ *
+ * Chaque longueur et chaque distance est vérifiée : des octets corrompus ne
+ * font jamais lire ou écrire hors des tampons. La décompression s'arrête dès
+ * que capacity octets sont produits, pour ne décompresser que le début d'un
+ * groupe de blocs.
+ *
+ * @param source Les octets compressés.
+ * @param size Le nombre d'octets compressés.
+ * @param destination Le tampon des octets décompressés.
+ * @param capacity Le nombre d'octets voulus.
+ * @return Le nombre d'octets décompressés, -1 si les octets compressés sont invalides.
+ */
+static int64_t lz4Decompress(const void* source, size_t size, void* destination, size_t capacity) {
+    const uint8_t* in = source;
+    const uint8_t* in_end = in + size;
+    uint8_t* out = destination;
+    uint8_t* out_end = out + capacity;
+
+    while (in < in_end && out < out_end) {
+        uint8_t token = *in++;
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && readLength(&in, in_end, &literal_length) == -1) {
+            return -1;
+        }
+        if ((size_t)(in_end - in) < literal_length) {
+            return -1;
+        }
+        size_t copied = (size_t)(out_end - out) < literal_length ? (size_t)(out_end - out) : literal_length;
+        memcpy(out, in, copied);
+        out += copied;
+        in += literal_length;
+        if (in == in_end || out == out_end) {
+            break; // Dernière séquence, ou assez d'octets produits
+        }
+
+        if (in_end - in < 2) {
+            return -1;
+        }
+        size_t offset = in[0] | (size_t)in[1] << 8;
+        in += 2;
+        size_t match_length = token & 15;
+        if (match_length == 15 && readLength(&in, in_end, &match_length) == -1) {
+            return -1;
+        }
+        match_length += LZ4_MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(out - (uint8_t*)destination)) {
+            return -1;
+        }
+
+        // Une correspondance proche recopie des octets qu'elle vient de produire
+        const uint8_t* reference = out - offset;
+        copied = (size_t)(out_end - out) < match_length ? (size_t)(out_end - out) : match_length;
+        if (offset >= copied) {
+            memcpy(out, reference, copied);
+        } else {
+            for (size_t i = 0; i < copied; ++i) {
+                out[i] = reference[i];
+            }
+        }
+        out += copied;
+    }
+    return out - (uint8_t*)destination;
+}
+
+/**
+ * @brief Codecs disponibles, indexés par leur numéro ; CODEC_NONE n'a pas de fonctions.
+ */
+static const Codec codecs[NUM_CODECS] = {
+    { "none", NULL, NULL },
+    { "lz4", lz4Compress, lz4Decompress },
+};
+
+/**
+ * @brief Fonction pour obtenir un codec à partir de son numéro.
+ * @param codec Le numéro du codec.
+ * @return Le codec, NULL pour CODEC_NONE ou un numéro inconnu.
+ */
+const Codec* codecGet(uint32_t codec) {
+    return codec != CODEC_NONE && codec < NUM_CODECS ? &codecs[codec] : NULL;
+}
+
+/**
+ * @brief Fonction pour obtenir le numéro d'un codec à partir de son nom.
+ * @param name Le nom du codec, "none" pour CODEC_NONE.
+ * @return Le numéro du codec, -1 si le nom est inconnu.
+ */
+int codecFind(const char* name) {
+    for (int codec = 0; codec < NUM_CODECS; ++codec) {
+        if (strcmp(codecs[codec].name, name) == 0) {
+            return codec;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file compress.h
+ * @brief Ce fichier contient les déclarations des codecs de compression des blocs de données : table des codecs et codec LZ4 intégré.
+ */
+
+#ifndef COMPRESS_H_
+#define COMPRESS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def CODEC_NONE
+ * @brief Numéro d'un fichier ou d'une partition qui ne compresse pas ses données.
+ */
+#define CODEC_NONE 0
+
+/**
+ * @def CODEC_LZ4
+ * @brief Numéro du codec LZ4 intégré : format de blocs LZ4, compression gloutonne rapide.
+ */
+#define CODEC_LZ4 1
+
+/**
+ * @def NUM_CODECS
+ * @brief Nombre de numéros de codecs, CODEC_NONE compris.
+ */
+#define NUM_CODECS 2
+
+/**
+ * @struct Codec
+ * @brief Codec de compression : un nom et deux fonctions sans état, utilisables par plusieurs threads.
+ */
+typedef struct {
+    const char* name; /**< Nom du codec, tel qu'il est donné sur la ligne de commande. */
+
+    /**
+     * @brief Compresse une suite d'octets.
+     * @param source Les octets.
+     * @param size Le nombre d'octets.
+     * @param destination Le tampon des octets compressés.
+     * @param capacity La taille du tampon.
+     * @return Le nombre d'octets compressés, -1 s'ils ne tiennent pas dans le tampon.
+     */
+    int64_t (*compress)(const void* source, size_t size, void* destination, size_t capacity);
+
+    /**
+     * @brief Décompresse le début d'une suite d'octets compressés.
+     * @param source Les octets compressés.
+     * @param size Le nombre d'octets compressés.
+     * @param destination Le tampon des octets décompressés.
+     * @param capacity Le nombre d'octets voulus : la décompression s'arrête lorsqu'il est atteint.
+     * @return Le nombre d'octets décompressés, -1 si les octets compressés sont invalides.
+     */
+    int64_t (*decompress)(const void* source, size_t size, void* destination, size_t capacity);
+} Codec;
+
+/**
+ * @brief Fonction pour obtenir un codec à partir de son numéro.
+ * @param codec Le numéro du codec.
+ * @return Le codec, NULL pour CODEC_NONE ou un numéro inconnu.
+ */
+const Codec* codecGet(uint32_t codec);
+
+/**
+ * @brief Fonction pour obtenir le numéro d'un codec à partir de son nom.
+ * @param name Le nom du codec, "none" pour CODEC_NONE.
+ * @return Le numéro du codec, -1 si le nom est inconnu.
+ */
+int codecFind(const char* name);
+
+#endif /* COMPRESS_H_ */
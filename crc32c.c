@@ -0,0 +1,280 @@
+/**
+ * @file crc32c.c
+ * @brief Ce fichier contient les définitions du calcul des CRC32C : instruction crc32 de SSE4.2 sur trois suites d'octets, ou tables de la version portable.
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#endif
+
+#include "crc32c.h"
+
+/**
+ * @brief Tables de la version portable : table[k][n] est le CRC de l'octet n suivi de k octets nuls.
+ */
+static uint32_t table[8][256];
+
+/**
+ * @brief Tables qui prolongent un CRC de CRC32C_LONG octets nuls, un octet du CRC à la fois.
+ */
+static uint32_t shift_long[4][256];
+
+/**
+ * @brief Tables qui prolongent un CRC de CRC32C_SHORT octets nuls, un octet du CRC à la fois.
+ */
+static uint32_t shift_short[4][256];
+
+/**
+ * @brief 1 si l'instruction crc32 est utilisée.
+ */
+static int hardware;
+
+/**
+ * @brief Garantit le calcul unique des tables.
+ */
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Multiplie une matrice de GF(2) par un vecteur.
+ * @param matrix Les 32 colonnes de la matrice.
+ * @param vector Le vecteur, un bit par ligne.
+ * @return Le produit.
+ */
+static uint32_t gf2Times(const uint32_t* matrix, uint32_t vector) {
+    uint32_t sum = 0;
+    for (; vector != 0; vector >>= 1, matrix++) {
+        if (vector & 1) {
+            sum ^= *matrix;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Compose deux matrices de GF(2).
+ * @param product Reçoit la matrice qui applique b puis a.
+ * @param a La seconde matrice appliquée.
+ * @param b La première matrice appliquée.
+ */
+static void gf2Multiply(uint32_t* product, const uint32_t* a, const uint32_t* b) {
+    uint32_t result[32];
+    for (int n = 0; n < 32; ++n) {
+        result[n] = gf2Times(a, b[n]);
+    }
+    memcpy(product, result, sizeof(result));
+}
+
+/**
+ * @brief Construit les tables qui prolongent un CRC d'un nombre donné d'octets nuls.
+ * 
+ * Le CRC de A suivi de B s'obtient en prolongeant celui de A d'autant
+ * d'octets nuls que B en compte, puis en y ajoutant (ou exclusif) celui de B
+ * calculé depuis zéro : c'est ce qui permet de calculer des suites d'octets
+ * indépendamment les unes des autres.
+ * 
+ * @param shift Les tables à remplir.
+ * @param length Le nombre d'octets nuls.
+ */
+static void buildShift(uint32_t shift[4][256], size_t length) {
+    // Opérateur d'un bit nul, élevé au carré trois fois : celui d'un octet nul
+    uint32_t power[32], result[32];
+    power[0] = CRC32C_POLY;
+    for (int n = 1; n < 32; ++n) {
+        power[n] = 1u << (n - 1);
+    }
+    for (int i = 0; i < 3; ++i) {
+        gf2Multiply(power, power, power);
+    }
+
+    // Exponentiation rapide de l'opérateur d'un octet nul
+    for (int n = 0; n < 32; ++n) {
+        result[n] = 1u << n;
+    }
+    for (; length != 0; length >>= 1) {
+        if (length & 1) {
+            gf2Multiply(result, power, result);
+        }
+        gf2Multiply(power, power, power);
+    }
+    for (uint32_t n = 0; n < 256; ++n) {
+        shift[0][n] = gf2Times(result, n);
+        shift[1][n] = gf2Times(result, n << 8);
+        shift[2][n] = gf2Times(result, n << 16);
+        shift[3][n] = gf2Times(result, n << 24);
+    }
+}
+
+/**
+ * @brief Calcule les tables et choisit la version utilisée.
+ */
+static void initTables() {
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t crc = n;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (CRC32C_POLY & -(crc & 1));
+        }
+        table[0][n] = crc;
+    }
+    for (uint32_t n = 0; n < 256; ++n) {
+        for (int k = 1; k < 8; ++k) {
+            table[k][n] = (table[k - 1][n] >> 8) ^ table[0][table[k - 1][n] & 0xFF];
+        }
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        buildShift(shift_long, CRC32C_LONG);
+        buildShift(shift_short, CRC32C_SHORT);
+        hardware = 1;
+    }
+#endif
+}
+
+/**
+ * @brief Calcule un CRC avec les tables de la version portable, huit octets à la fois.
+ * @param crc Le CRC courant, inversé.
+ * @param bytes Les octets.
+ * @param length Le nombre d'octets.
+ * @return Le nouveau CRC, inversé.
+ */
+static uint32_t crc32cSoftware(uint32_t crc, const unsigned char* bytes, size_t length) {
+    while (length > 0 && ((uintptr_t)bytes & 7) != 0) {
+        crc = table[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+        length--;
+    }
+    // Les octets sont assemblés un à un : le résultat ne dépend pas de l'ordre des octets du processeur
+    while (length >= 8) {
+        uint32_t low = crc ^ ((uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24);
+        uint32_t high = (uint32_t)bytes[4] | (uint32_t)bytes[5] << 8 | (uint32_t)bytes[6] << 16 | (uint32_t)bytes[7] << 24;
+        crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24]
+              ^ table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+        bytes += 8;
+        length -= 8;
+    }
+    while (length > 0) {
+        crc = table[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+        length--;
+    }
+    return crc;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief Prolonge un CRC d'octets nuls à l'aide de tables construites par buildShift.
+ * @param shift Les tables.
+ * @param crc Le CRC.
+ * @return Le CRC prolongé.
+ */
+static inline __attribute__((always_inline)) uint32_t shiftCrc(const uint32_t shift[4][256], uint32_t crc) {
+    return shift[0][crc & 0xFF] ^ shift[1][(crc >> 8) & 0xFF] ^ shift[2][(crc >> 16) & 0xFF] ^ shift[3][crc >> 24];
+}
+
+/**
+ * @brief Calcule le CRC de huit octets avec l'instruction crc32.
+ * @param crc Le CRC courant, inversé.
+ * @param bytes Les huit octets.
+ * @return Le nouveau CRC, inversé.
+ */
+__attribute__((target("sse4.2"), always_inline))
+static inline uint32_t crc32Word(uint32_t crc, const unsigned char* bytes) {
+#if defined(__x86_64__)
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+    return (uint32_t)_mm_crc32_u64(crc, word);
+#else
+    uint32_t low, high;
+    memcpy(&low, bytes, sizeof(low));
+    memcpy(&high, bytes + 4, sizeof(high));
+    return _mm_crc32_u32(_mm_crc32_u32(crc, low), high);
+#endif
+}
+
+/**
+ * @brief Calcule un CRC par groupes de trois suites consécutives d'une longueur donnée.
+ * 
+ * L'instruction crc32 peut commencer à chaque cycle mais rend son résultat
+ * trois cycles plus tard : les trois suites sont calculées ensemble, puis
+ * leurs codes combinés par les tables du prolongement par des octets nuls.
+ * 
+ * @param crc Le CRC courant, inversé.
+ * @param bytes Les octets, avancés au-delà des groupes calculés.
+ * @param length Le nombre d'octets, diminué de ceux des groupes calculés.
+ * @param lane La longueur de chaque suite, multiple de 8.
+ * @param shift Les tables qui prolongent un CRC de lane octets nuls.
+ * @return Le nouveau CRC, inversé.
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32Lanes(uint32_t crc, const unsigned char** bytes, size_t* length, size_t lane, const uint32_t shift[4][256]) {
+    while (*length >= 3 * lane) {
+        const unsigned char* next = *bytes;
+        const unsigned char* end = next + lane;
+        uint32_t crc1 = 0, crc2 = 0;
+        do {
+            crc = crc32Word(crc, next);
+            crc1 = crc32Word(crc1, next + lane);
+            crc2 = crc32Word(crc2, next + 2 * lane);
+            next += 8;
+        } while (next < end);
+        crc = shiftCrc(shift, crc) ^ crc1;
+        crc = shiftCrc(shift, crc) ^ crc2;
+        *bytes += 3 * lane;
+        *length -= 3 * lane;
+    }
+    return crc;
+}
+
+/**
+ * @brief Calcule un CRC avec l'instruction crc32 de SSE4.2.
+ * @param crc Le CRC courant, inversé.
+ * @param bytes Les octets.
+ * @param length Le nombre d'octets.
+ * @return Le nouveau CRC, inversé.
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32cHardwareKernel(uint32_t crc, const unsigned char* bytes, size_t length) {
+    while (length > 0 && ((uintptr_t)bytes & 7) != 0) {
+        crc = _mm_crc32_u8(crc, *bytes++);
+        length--;
+    }
+    crc = crc32Lanes(crc, &bytes, &length, CRC32C_LONG, shift_long);
+    crc = crc32Lanes(crc, &bytes, &length, CRC32C_SHORT, shift_short);
+    while (length >= 8) {
+        crc = crc32Word(crc, bytes);
+        bytes += 8;
+        length -= 8;
+    }
+    while (length > 0) {
+        crc = _mm_crc32_u8(crc, *bytes++);
+        length--;
+    }
+    return crc;
+}
+#endif
+
+/**
+ * @brief Fonction pour calculer ou prolonger le CRC32C d'une suite d'octets.
+ * @param crc Le CRC32C des octets qui précèdent, 0 pour commencer.
+ * @param data Les octets.
+ * @param length Le nombre d'octets.
+ * @return Le CRC32C de tous les octets.
+ */
+uint32_t crc32c(uint32_t crc, const void* data, size_t length) {
+    pthread_once(&tables_once, initTables);
+#if defined(__x86_64__) || defined(__i386__)
+    if (hardware) {
+        return ~crc32cHardwareKernel(~crc, data, length);
+    }
+#endif
+    return ~crc32cSoftware(~crc, data, length);
+}
+
+/**
+ * @brief Fonction pour savoir si crc32c utilise l'instruction du processeur.
+ * @return 1 si l'instruction crc32 de SSE4.2 est utilisée, 0 pour la version portable.
+ */
+int crc32cHardware() {
+    pthread_once(&tables_once, initTables);
+    return hardware;
+}
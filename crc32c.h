@@ -0,0 +1,53 @@
+/**
+ * @file crc32c.h
+ * @brief Ce fichier contient les déclarations du calcul des codes de contrôle CRC32C des blocs de la partition.
+ */
+
+#ifndef CRC32C_H_
+#define CRC32C_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def CRC32C_POLY
+ * @brief Polynôme de Castagnoli, sous forme réfléchie.
+ */
+#define CRC32C_POLY 0x82F63B78u
+
+/**
+ * @def CRC32C_LONG
+ * @brief Longueur de chacune des trois suites d'octets calculées ensemble pour les grands tampons (multiple de 8).
+ */
+#define CRC32C_LONG 8192
+
+/**
+ * @def CRC32C_SHORT
+ * @brief Longueur de chacune des trois suites d'octets calculées ensemble pour les petits tampons (multiple de 8).
+ * 
+ * Trois suites de 168 octets tiennent dans un bloc de 512 octets.
+ */
+#define CRC32C_SHORT 168
+
+/**
+ * @brief Fonction pour calculer ou prolonger le CRC32C d'une suite d'octets.
+ * 
+ * Lorsque le processeur possède l'instruction crc32 de SSE4.2, trois suites
+ * d'octets sont calculées en même temps pour masquer sa latence, puis leurs
+ * codes sont combinés. Sinon, une version portable lit huit octets à la
+ * fois dans des tables.
+ * 
+ * @param crc Le CRC32C des octets qui précèdent, 0 pour commencer.
+ * @param data Les octets.
+ * @param length Le nombre d'octets.
+ * @return Le CRC32C de tous les octets.
+ */
+uint32_t crc32c(uint32_t crc, const void* data, size_t length);
+
+/**
+ * @brief Fonction pour savoir si crc32c utilise l'instruction du processeur.
+ * @return 1 si l'instruction crc32 de SSE4.2 est utilisée, 0 pour la version portable.
+ */
+int crc32cHardware();
+
+#endif /* CRC32C_H_ */
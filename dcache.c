@@ -0,0 +1,148 @@
+/**
+ * @file dcache.c
+ * @brief Ce fichier contient les définitions du cache des entrées de répertoires, consulté sans verrou lors de la résolution des chemins.
+ */
+
+#include "projet.h"
+
+/**
+ * @brief Donne l'emplacement d'une entrée de répertoire.
+ * @param dcache Le cache.
+ * @param parent L'inode du répertoire.
+ * @param hash L'empreinte du nom.
+ * @return L'emplacement, seul possible pour ce couple (répertoire, nom).
+ */
+static Dentry* dentrySlot(DentryCache* dcache, uint32_t parent, uint32_t hash) {
+    // Les mêmes noms dans des répertoires différents tombent dans des emplacements différents
+    return &dcache->slots[(hash ^ (parent * 2654435761u)) & dcache->mask];
+}
+
+/**
+ * @brief Réserve un emplacement en rendant son compteur de séquence impair.
+ * @param slot L'emplacement.
+ * @param wait 1 pour attendre la fin d'une modification en cours, 0 pour abandonner.
+ * @return 1 si l'emplacement est réservé, 0 sinon.
+ */
+static int reserveDentry(Dentry* slot, int wait) {
+    uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    for (;;) {
+        if (seq % 2 == 0 && __atomic_compare_exchange_n(&slot->seq, &seq, seq + 1, 0, __ATOMIC_ACQUIRE,
+                                                        __ATOMIC_RELAXED)) {
+            return 1;
+        }
+        if (!wait) {
+            return 0;
+        }
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Rend un emplacement réservé par reserveDentry.
+ * @param slot L'emplacement.
+ */
+static void releaseDentry(Dentry* slot) {
+    // Un lecteur qui voit l'une des nouvelles valeurs voit aussi le compteur modifié
+    __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Fonction pour initialiser le cache des entrées de répertoires.
+ * @param dcache Le cache à initialiser.
+ * @param slots Le nombre d'emplacements, puissance de 2.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int dcacheInit(DentryCache* dcache, uint32_t slots) {
+    dcache->slots = calloc(slots, sizeof(Dentry));
+    if (dcache->slots == NULL) {
+        perror("Erreur lors de l'allocation du cache des entrées de répertoires");
+        return -1;
+    }
+    dcache->mask = slots - 1;
+    return 0;
+}
+
+/**
+ * @brief Fonction pour libérer le cache des entrées de répertoires.
+ * @param dcache Le cache.
+ */
+void dcacheDestroy(DentryCache* dcache) {
+    free(dcache->slots);
+    dcache->slots = NULL;
+}
+
+/**
+ * @brief Fonction pour rechercher une entrée de répertoire, sans verrou.
+ * @param dcache Le cache.
+ * @param parent L'inode du répertoire.
+ * @param name Le nom de l'entrée.
+ * @param hash L'empreinte du nom.
+ * @return L'inode désigné par l'entrée, 0 si elle n'est pas dans le cache.
+ */
+uint32_t dcacheLookup(DentryCache* dcache, uint32_t parent, const char* name, uint32_t hash) {
+    Dentry* slot = dentrySlot(dcache, parent, hash);
+    uint32_t before = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    if (before % 2 == 1) {
+        return 0; // Emplacement en cours de modification : l'entrée est cherchée dans son répertoire
+    }
+
+    // Lectures ordonnées avant la relecture du compteur
+    uint32_t found = 0;
+    if (__atomic_load_n(&slot->parent, __ATOMIC_ACQUIRE) == parent
+        && __atomic_load_n(&slot->hash, __ATOMIC_ACQUIRE) == hash) {
+        size_t i = 0;
+        while (i < DCACHE_NAME_MAX) {
+            char c = __atomic_load_n(&slot->name[i], __ATOMIC_ACQUIRE);
+            if (c != name[i]) {
+                break;
+            }
+            if (c == '\0') {
+                found = __atomic_load_n(&slot->inode, __ATOMIC_ACQUIRE);
+                break;
+            }
+            i++;
+        }
+    }
+
+    return __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == before ? found : 0;
+}
+
+/**
+ * @brief Fonction pour ajouter une entrée de répertoire au cache.
+ * @param dcache Le cache.
+ * @param parent L'inode du répertoire.
+ * @param name Le nom de l'entrée.
+ * @param hash L'empreinte du nom.
+ * @param inode L'inode désigné par l'entrée.
+ */
+void dcacheInsert(DentryCache* dcache, uint32_t parent, const char* name, uint32_t hash, uint32_t inode) {
+    size_t length = strlen(name);
+    Dentry* slot = dentrySlot(dcache, parent, hash);
+    if (length >= DCACHE_NAME_MAX || !reserveDentry(slot, 0)) {
+        return;
+    }
+    __atomic_store_n(&slot->parent, parent, __ATOMIC_RELEASE);
+    __atomic_store_n(&slot->hash, hash, __ATOMIC_RELEASE);
+    __atomic_store_n(&slot->inode, inode, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < DCACHE_NAME_MAX; ++i) {
+        __atomic_store_n(&slot->name[i], i < length ? name[i] : '\0', __ATOMIC_RELEASE);
+    }
+    releaseDentry(slot);
+}
+
+/**
+ * @brief Fonction pour retirer une entrée de répertoire du cache.
+ * @param dcache Le cache.
+ * @param parent L'inode du répertoire.
+ * @param name Le nom de l'entrée.
+ * @param hash L'empreinte du nom.
+ */
+void dcacheRemove(DentryCache* dcache, uint32_t parent, const char* name, uint32_t hash) {
+    // Le retrait attend l'ajout en cours : l'entrée ne doit pas survivre à sa suppression
+    Dentry* slot = dentrySlot(dcache, parent, hash);
+    reserveDentry(slot, 1);
+    if (slot->parent == parent && slot->hash == hash && strncmp(slot->name, name, DCACHE_NAME_MAX) == 0) {
+        __atomic_store_n(&slot->parent, 0, __ATOMIC_RELEASE);
+    }
+    releaseDentry(slot);
+}
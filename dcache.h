@@ -0,0 +1,102 @@
+/**
+ * @file dcache.h
+ * @brief Ce fichier contient les déclarations du cache des entrées de répertoires, consulté sans verrou lors de la résolution des chemins.
+ */
+
+#ifndef DCACHE_H_
+#define DCACHE_H_
+
+#include <stdint.h>
+
+/**
+ * @def DCACHE_SLOTS
+ * @brief Nombre d'emplacements du cache des entrées de répertoires (puissance de 2).
+ */
+#define DCACHE_SLOTS 4096
+
+/**
+ * @def DCACHE_NAME_MAX
+ * @brief Taille maximale d'un nom conservé par le cache, '\0' compris : les noms plus longs n'y sont pas mis.
+ */
+#define DCACHE_NAME_MAX 52
+
+/**
+ * @struct Dentry
+ * @brief Emplacement du cache : une entrée de répertoire déjà résolue.
+ */
+typedef struct {
+    uint32_t seq; /**< Compteur de séquence, impair pendant la modification de l'emplacement. */
+    uint32_t parent; /**< Inode du répertoire contenant l'entrée, 0 si l'emplacement est vide. */
+    uint32_t hash; /**< Empreinte du nom. */
+    uint32_t inode; /**< Inode désigné par l'entrée. */
+    char name[DCACHE_NAME_MAX]; /**< Nom de l'entrée. */
+} Dentry;
+
+/**
+ * @struct DentryCache
+ * @brief Cache des entrées de répertoires, à correspondance directe.
+ * 
+ * Chaque couple (répertoire, nom) n'a qu'un emplacement possible, qui
+ * remplace l'entrée précédente. Les recherches ne prennent aucun verrou :
+ * elles relisent l'emplacement si son compteur de séquence a changé. Les
+ * modifications réservent l'emplacement en rendant son compteur impair.
+ * Une entrée doit être ajoutée sous le verrou en lecture de son répertoire
+ * et retirée sous son verrou en écriture, pour qu'un nom supprimé ne puisse
+ * pas y revenir.
+ */
+typedef struct {
+    Dentry* slots; /**< Emplacements du cache. */
+    uint32_t mask; /**< Nombre d'emplacements moins un. */
+} DentryCache;
+
+/**
+ * @brief Fonction pour initialiser le cache des entrées de répertoires.
+ * 
+ * @param dcache Le cache à initialiser.
+ * @param slots Le nombre d'emplacements, puissance de 2.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int dcacheInit(DentryCache* dcache, uint32_t slots);
+
+/**
+ * @brief Fonction pour libérer le cache des entrées de répertoires.
+ * 
+ * @param dcache Le cache, éventuellement jamais initialisé (rempli de zéros).
+ */
+void dcacheDestroy(DentryCache* dcache);
+
+/**
+ * @brief Fonction pour rechercher une entrée de répertoire, sans verrou.
+ * 
+ * @param dcache Le cache.
+ * @param parent L'inode du répertoire.
+ * @param name Le nom de l'entrée.
+ * @param hash L'empreinte du nom.
+ * @return L'inode désigné par l'entrée, 0 si elle n'est pas dans le cache.
+ */
+uint32_t dcacheLookup(DentryCache* dcache, uint32_t parent, const char* name, uint32_t hash);
+
+/**
+ * @brief Fonction pour ajouter une entrée de répertoire au cache.
+ * 
+ * L'ajout est abandonné si un autre thread modifie le même emplacement.
+ * 
+ * @param dcache Le cache.
+ * @param parent L'inode du répertoire.
+ * @param name Le nom de l'entrée.
+ * @param hash L'empreinte du nom.
+ * @param inode L'inode désigné par l'entrée.
+ */
+void dcacheInsert(DentryCache* dcache, uint32_t parent, const char* name, uint32_t hash, uint32_t inode);
+
+/**
+ * @brief Fonction pour retirer une entrée de répertoire du cache.
+ * 
+ * @param dcache Le cache.
+ * @param parent L'inode du répertoire.
+ * @param name Le nom de l'entrée.
+ * @param hash L'empreinte du nom.
+ */
+void dcacheRemove(DentryCache* dcache, uint32_t parent, const char* name, uint32_t hash);
+
+#endif /* DCACHE_H_ */
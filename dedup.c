@@ -0,0 +1,336 @@
+/**
+ * @file dedup.c
+ * @brief Ce fichier contient les définitions de la déduplication des blocs de données : empreintes, table des empreintes en mémoire et calcul parallèle des empreintes.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "projet.h"
+
+/**
+ * @def DEDUP_PRIME1
+ * @brief Premier multiplicateur du mélange des mots, impair et aux bits bien répartis.
+ */
+#define DEDUP_PRIME1 0x9E3779B185EBCA87ULL
+
+/**
+ * @def DEDUP_PRIME2
+ * @brief Second multiplicateur du mélange des mots.
+ */
+#define DEDUP_PRIME2 0xC2B2AE3D27D4EB4FULL
+
+/**
+ * @brief Fait tourner les bits d'un mot vers la gauche.
+ * @param value Le mot.
+ * @param bits Le nombre de bits, entre 1 et 63.
+ * @return Le mot tourné.
+ */
+static uint64_t rotate(uint64_t value, unsigned bits) {
+    return value << bits | value >> (64 - bits);
+}
+
+/**
+ * @brief Mélange un mot du bloc dans l'une des suites de l'empreinte.
+ * @param lane La suite.
+ * @param word Le mot.
+ * @return La suite mise à jour.
+ */
+static uint64_t mixWord(uint64_t lane, uint64_t word) {
+    return rotate(lane + word * DEDUP_PRIME2, 31) * DEDUP_PRIME1;
+}
+
+/**
+ * @brief Fonction pour calculer l'empreinte du contenu d'un bloc.
+ * @param data Le contenu du bloc.
+ * @param size Sa taille en octets.
+ * @return L'empreinte, jamais nulle.
+ */
+uint64_t dedupFingerprint(const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    // Quatre suites indépendantes : les multiplications d'un tour s'exécutent en même temps
+    uint64_t lanes[4] = { DEDUP_PRIME1 + DEDUP_PRIME2, DEDUP_PRIME2, 0, -DEDUP_PRIME1 };
+    size_t i = 0;
+    for (; i + 4 * sizeof(uint64_t) <= size; i += 4 * sizeof(uint64_t)) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            memcpy(&word, bytes + i + lane * sizeof(uint64_t), sizeof(word));
+            lanes[lane] = mixWord(lanes[lane], word);
+        }
+    }
+    uint64_t hash = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) + rotate(lanes[3], 18) + size;
+    for (; i < size; ++i) {
+        hash = mixWord(hash, bytes[i]);
+    }
+
+    // Chaque bit de l'empreinte dépend de tous les bits des suites
+    hash ^= hash >> 33;
+    hash *= DEDUP_PRIME2;
+    hash ^= hash >> 29;
+    hash *= DEDUP_PRIME1;
+    hash ^= hash >> 32;
+    return hash != 0 ? hash : 1;
+}
+
+/**
+ * @brief Donne l'ensemble d'une empreinte.
+ * @param table La table.
+ * @param fingerprint L'empreinte.
+ * @return L'indice de l'ensemble.
+ */
+static uint64_t dedupSet(DedupTable* table, uint64_t fingerprint) {
+    return fingerprint & table->mask;
+}
+
+/**
+ * @brief Donne le verrou d'un ensemble.
+ * @param table La table.
+ * @param set L'indice de l'ensemble.
+ * @return Le verrou.
+ */
+static pthread_mutex_t* dedupLock(DedupTable* table, uint64_t set) {
+    return &table->locks[set & (DEDUP_LOCKS - 1)];
+}
+
+/**
+ * @brief Donne la case d'un bloc dans la table des propriétaires.
+ * @param table La table.
+ * @param block Le bloc.
+ * @return La case.
+ */
+static uint64_t* ownerSlot(DedupTable* table, uint64_t block) {
+    return &table->owners[block & (((uint64_t)1 << table->owner_bits) - 1)];
+}
+
+/**
+ * @brief Fonction pour créer la table des empreintes d'une partition.
+ * @param table La table à initialiser.
+ * @param num_blocks Le nombre de blocs de données de la partition.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int dedupInit(DedupTable* table, uint64_t num_blocks) {
+    uint64_t sets = 1;
+    unsigned bits = 0;
+    while (sets < DEDUP_MAX_SETS && sets * DEDUP_WAYS < num_blocks) {
+        sets *= 2;
+    }
+    while (((uint64_t)1 << bits) < sets * DEDUP_WAYS) {
+        bits++;
+    }
+    table->entries = calloc(sets * DEDUP_WAYS, sizeof(DedupEntry));
+    table->owners = calloc(sets * DEDUP_WAYS, sizeof(uint64_t));
+    if (table->entries == NULL || table->owners == NULL) {
+        perror("Erreur lors de l'allocation de la table des empreintes");
+        free(table->entries);
+        free(table->owners);
+        table->entries = NULL;
+        table->owners = NULL;
+        return -1;
+    }
+    table->mask = sets - 1;
+    table->owner_bits = bits;
+    for (int i = 0; i < DEDUP_LOCKS; ++i) {
+        pthread_mutex_init(&table->locks[i], NULL);
+    }
+    return 0;
+}
+
+/**
+ * @brief Fonction pour libérer la table des empreintes.
+ * @param table La table.
+ */
+void dedupDestroy(DedupTable* table) {
+    if (table->entries == NULL) {
+        return;
+    }
+    for (int i = 0; i < DEDUP_LOCKS; ++i) {
+        pthread_mutex_destroy(&table->locks[i]);
+    }
+    free(table->entries);
+    free(table->owners);
+    table->entries = NULL;
+    table->owners = NULL;
+}
+
+/**
+ * @brief Fonction pour obtenir le propriétaire d'un bloc rangé dans la table.
+ * @param table La table.
+ * @param block Le bloc.
+ * @return L'inode propriétaire, 0 si le bloc n'est plus dans la table.
+ */
+uint32_t dedupOwner(DedupTable* table, uint64_t block) {
+    uint64_t slot = __atomic_load_n(ownerSlot(table, block), __ATOMIC_RELAXED);
+    return slot >> 32 == block >> table->owner_bits ? (uint32_t)slot : 0;
+}
+
+/**
+ * @brief Fonction pour rechercher un bloc d'après son empreinte.
+ * @param table La table.
+ * @param fingerprint L'empreinte.
+ * @param owner Reçoit l'inode propriétaire du bloc trouvé.
+ * @return Le bloc, -1 si aucun bloc encore propriété d'un inode n'a cette empreinte.
+ */
+int64_t dedupLookup(DedupTable* table, uint64_t fingerprint, uint32_t* owner) {
+    uint64_t set = dedupSet(table, fingerprint);
+    DedupEntry* entries = &table->entries[set * DEDUP_WAYS];
+    int64_t found = -1;
+    pthread_mutex_lock(dedupLock(table, set));
+    for (int way = 0; way < DEDUP_WAYS; ++way) {
+        if (entries[way].fingerprint == fingerprint) {
+            *owner = dedupOwner(table, entries[way].block);
+            found = *owner != 0 ? (int64_t)entries[way].block : -1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(dedupLock(table, set));
+    return found;
+}
+
+/**
+ * @brief Fonction pour ranger l'empreinte d'un bloc qu'un inode vient d'écrire.
+ * @param table La table.
+ * @param fingerprint L'empreinte du bloc.
+ * @param block Le bloc.
+ * @param owner L'inode qui possède le bloc, seul, et l'a écrit.
+ */
+void dedupInsert(DedupTable* table, uint64_t fingerprint, uint64_t block, uint32_t owner) {
+    uint64_t set = dedupSet(table, fingerprint);
+    DedupEntry* entries = &table->entries[set * DEDUP_WAYS];
+    pthread_mutex_lock(dedupLock(table, set));
+    // Sans entrée libre, les bits hauts de l'empreinte choisissent l'entrée remplacée
+    int victim = (int)(fingerprint >> 62) % DEDUP_WAYS;
+    for (int way = 0; way < DEDUP_WAYS; ++way) {
+        if (entries[way].fingerprint == fingerprint) {
+            victim = way;
+            break;
+        }
+        if (entries[way].fingerprint == 0 || dedupOwner(table, entries[way].block) == 0) {
+            victim = way;
+        }
+    }
+    entries[victim].fingerprint = fingerprint;
+    entries[victim].block = block;
+    // Un bloc dont les bits hauts ne tiennent pas dans sa case n'a jamais de propriétaire
+    if (block >> table->owner_bits <= UINT32_MAX) {
+        __atomic_store_n(ownerSlot(table, block), (block >> table->owner_bits) << 32 | owner, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(dedupLock(table, set));
+}
+
+/**
+ * @brief Fonction pour retirer de la table une suite de blocs consécutifs.
+ * @param table La table, éventuellement désactivée.
+ * @param block Le premier bloc.
+ * @param length Le nombre de blocs.
+ */
+void dedupForget(DedupTable* table, uint64_t block, uint64_t length) {
+    if (table->owners == NULL) {
+        return;
+    }
+    // La case reprise entre-temps par un autre bloc peut être effacée : il est seulement oublié
+    for (uint64_t i = 0; i < length; ++i) {
+        if (dedupOwner(table, block + i) != 0) {
+            __atomic_store_n(ownerSlot(table, block + i), 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @struct DedupScan
+ * @brief État partagé par les threads du calcul des empreintes.
+ */
+typedef struct {
+    Partition* partition; /**< La partition. */
+    DedupEntry* entries; /**< Les blocs et leurs empreintes. */
+    uint64_t count; /**< Le nombre de blocs. */
+    uint64_t next_task; /**< Prochaine tâche à prendre, incrémentée atomiquement. */
+    int failed; /**< Nombre de threads qui n'ont pas pu allouer leur tampon. */
+} DedupScan;
+
+/**
+ * @brief Calcule les empreintes des tâches restantes, chacune de DEDUP_SCAN_BLOCKS blocs.
+ * 
+ * Un thread sans tampon ne prend aucune tâche : les autres les calculent.
+ * 
+ * @param arg L'état partagé (DedupScan*).
+ * @return NULL.
+ */
+static void* hashWorker(void* arg) {
+    DedupScan* scan = arg;
+    Partition* partition = scan->partition;
+    size_t block_size = partition->block_size;
+    char* buffer = malloc(DEDUP_SCAN_BLOCKS * block_size);
+    if (buffer == NULL) {
+        __atomic_fetch_add(&scan->failed, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    uint64_t task;
+    while ((task = __atomic_fetch_add(&scan->next_task, 1, __ATOMIC_RELAXED)) * DEDUP_SCAN_BLOCKS < scan->count) {
+        uint64_t first = task * DEDUP_SCAN_BLOCKS;
+        uint64_t end = first + DEDUP_SCAN_BLOCKS < scan->count ? first + DEDUP_SCAN_BLOCKS : scan->count;
+        while (first < end) {
+            // Suite de blocs consécutifs dans la partition, lue d'un seul appel
+            uint64_t last = first + 1;
+            while (last < end && scan->entries[last].block == scan->entries[last - 1].block + 1) {
+                last++;
+            }
+            size_t length = (last - first) * block_size;
+            int readable = partitionRead(partition, buffer, length, dataBlockOffset(partition, scan->entries[first].block)) == (ssize_t)length;
+            for (uint64_t i = first; i < last; ++i) {
+                DedupEntry* entry = &scan->entries[i];
+                const char* data = buffer + (i - first) * block_size;
+                entry->fingerprint = readable && verifyBlockChecksum(partition, entry->block, data) == 0 ? dedupFingerprint(data, block_size) : 0;
+            }
+            first = last;
+        }
+    }
+    free(buffer);
+    return NULL;
+}
+
+/**
+ * @brief Fonction pour calculer en parallèle les empreintes d'une liste de blocs de données.
+ * @param partition La partition.
+ * @param entries Les blocs, par numéro croissant ; leurs empreintes sont remplies.
+ * @param count Le nombre de blocs.
+ * @param threads Le nombre de threads, 0 pour un par processeur (au plus DEDUP_MAX_THREADS).
+ * @return Le nombre de threads qui ont calculé des empreintes, -1 si aucun n'a pu allouer son tampon.
+ */
+int dedupHashBlocks(Partition* partition, DedupEntry* entries, uint64_t count, int threads) {
+    if (threads <= 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    uint64_t tasks = (count + DEDUP_SCAN_BLOCKS - 1) / DEDUP_SCAN_BLOCKS;
+    if (threads > DEDUP_MAX_THREADS) {
+        threads = DEDUP_MAX_THREADS;
+    }
+    if ((uint64_t)threads > tasks) {
+        threads = (int)tasks;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    DedupScan scan = { partition, entries, count, 0, 0 };
+    pthread_t workers[DEDUP_MAX_THREADS];
+    // Un thread qui n'a pas pu être créé laisse ses tâches aux autres
+    int started = 1;
+    while (started < threads && pthread_create(&workers[started], NULL, hashWorker, &scan) == 0) {
+        started++;
+    }
+    hashWorker(&scan);
+    for (int i = 1; i < started; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+    // Tant qu'un thread a pu allouer son tampon, toutes les tâches ont été prises
+    if (scan.failed == started) {
+        printf("Erreur : Aucun thread n'a pu allouer son tampon pour le calcul des empreintes.\n");
+        return -1;
+    }
+    if (scan.failed > 0) {
+        printf("Attention : %d threads sur %d n'ont pas pu allouer leur tampon pour le calcul des empreintes.\n", scan.failed, started);
+    }
+    return started - scan.failed;
+}
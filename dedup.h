@@ -0,0 +1,171 @@
+/**
+ * @file dedup.h
+ * @brief Ce fichier contient les déclarations de la déduplication des blocs de données : empreintes, table des empreintes en mémoire et calcul parallèle des empreintes.
+ */
+
+#ifndef DEDUP_H_
+#define DEDUP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/**
+ * @def DEDUP_WAYS
+ * @brief Nombre d'entrées d'un ensemble de la table des empreintes : une empreinte ne peut être rangée que dans son ensemble.
+ */
+#define DEDUP_WAYS 4
+
+/**
+ * @def DEDUP_MAX_SETS
+ * @brief Nombre maximal d'ensembles de la table des empreintes (puissance de 2), soit 16 Mo d'entrées et 8 Mo de propriétaires.
+ */
+#define DEDUP_MAX_SETS (1 << 18)
+
+/**
+ * @def DEDUP_LOCKS
+ * @brief Nombre de verrous de la table des empreintes (puissance de 2), chacun protégeant un ensemble sur DEDUP_LOCKS.
+ */
+#define DEDUP_LOCKS 64
+
+/**
+ * @def DEDUP_SCAN_BLOCKS
+ * @brief Nombre de blocs d'une tâche du calcul parallèle des empreintes, lus par suites de blocs consécutifs.
+ */
+#define DEDUP_SCAN_BLOCKS 64
+
+/**
+ * @def DEDUP_MAX_THREADS
+ * @brief Nombre maximal de threads du calcul parallèle des empreintes.
+ */
+#define DEDUP_MAX_THREADS 64
+
+/**
+ * @struct DedupEntry
+ * @brief Empreinte du contenu d'un bloc de données.
+ */
+typedef struct {
+    uint64_t fingerprint; /**< Empreinte du contenu du bloc, jamais nulle pour un bloc lu. */
+    uint64_t block; /**< Bloc de données. */
+} DedupEntry;
+
+/**
+ * @struct DedupTable
+ * @brief Table des empreintes des blocs récemment écrits, associative par ensembles.
+ * 
+ * Une empreinte désigne un bloc qui avait ce contenu lorsqu'il a été rangé :
+ * le bloc peut avoir changé depuis, et son contenu doit être comparé avant
+ * d'être partagé. La table des propriétaires dit quels blocs ont encore un
+ * sens : le propriétaire d'un bloc est l'inode qui l'a écrit, et il est
+ * effacé lorsque le bloc est libéré ou qu'il perd son dernier partage,
+ * après quoi ses empreintes sont ignorées puis remplacées.
+ * 
+ * La table des propriétaires a autant de cases que la table des entrées,
+ * quelle que soit la taille de la partition : un bloc a sa case d'après ses
+ * bits bas, où sont rangés ses bits hauts et son propriétaire. Un bloc dont
+ * la case est reprise par un autre perd son propriétaire, si bien que ses
+ * empreintes sont ignorées : la table oublie des blocs, sans jamais en
+ * croire un à tort.
+ */
+typedef struct {
+    DedupEntry* entries; /**< Entrées, DEDUP_WAYS par ensemble. NULL si la déduplication est désactivée. */
+    uint64_t* owners; /**< Case de chaque bloc : ses bits hauts sur 32 bits, puis son inode propriétaire, 0 si aucun. */
+    uint64_t mask; /**< Nombre d'ensembles moins un. */
+    unsigned owner_bits; /**< Nombre de bits bas d'un bloc qui donnent sa case dans la table des propriétaires. */
+    pthread_mutex_t locks[DEDUP_LOCKS]; /**< Verrous des ensembles. */
+} DedupTable;
+
+struct Partition;
+
+/**
+ * @brief Fonction pour calculer l'empreinte du contenu d'un bloc.
+ * 
+ * L'empreinte tient sur 64 bits, calculée sur quatre suites de mots
+ * indépendantes : deux blocs d'empreintes différentes sont différents, deux
+ * blocs de même empreinte sont presque toujours identiques.
+ * 
+ * @param data Le contenu du bloc.
+ * @param size Sa taille en octets.
+ * @return L'empreinte, jamais nulle.
+ */
+uint64_t dedupFingerprint(const void* data, size_t size);
+
+/**
+ * @brief Fonction pour créer la table des empreintes d'une partition.
+ * 
+ * @param table La table à initialiser.
+ * @param num_blocks Le nombre de blocs de données de la partition : la table a au plus une entrée par bloc,
+ *                   et au plus DEDUP_MAX_SETS ensembles.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int dedupInit(DedupTable* table, uint64_t num_blocks);
+
+/**
+ * @brief Fonction pour libérer la table des empreintes.
+ * 
+ * @param table La table, éventuellement jamais initialisée (remplie de zéros).
+ */
+void dedupDestroy(DedupTable* table);
+
+/**
+ * @brief Fonction pour rechercher un bloc d'après son empreinte.
+ * 
+ * @param table La table.
+ * @param fingerprint L'empreinte.
+ * @param owner Reçoit l'inode propriétaire du bloc trouvé.
+ * @return Le bloc, -1 si aucun bloc encore propriété d'un inode n'a cette empreinte.
+ */
+int64_t dedupLookup(DedupTable* table, uint64_t fingerprint, uint32_t* owner);
+
+/**
+ * @brief Fonction pour ranger l'empreinte d'un bloc qu'un inode vient d'écrire.
+ * 
+ * Une entrée de même empreinte est remplacée ; sinon, une entrée vide ou
+ * ignorée de l'ensemble, ou à défaut l'une des autres.
+ * 
+ * @param table La table.
+ * @param fingerprint L'empreinte du bloc.
+ * @param block Le bloc.
+ * @param owner L'inode qui possède le bloc, seul, et l'a écrit.
+ */
+void dedupInsert(DedupTable* table, uint64_t fingerprint, uint64_t block, uint32_t owner);
+
+/**
+ * @brief Fonction pour obtenir le propriétaire d'un bloc rangé dans la table.
+ * 
+ * @param table La table.
+ * @param block Le bloc.
+ * @return L'inode propriétaire, 0 si le bloc n'est plus dans la table.
+ */
+uint32_t dedupOwner(DedupTable* table, uint64_t block);
+
+/**
+ * @brief Fonction pour retirer de la table une suite de blocs consécutifs.
+ * 
+ * Appelée pour des blocs libérés, dont le dernier partage disparaît ou que
+ * leur propriétaire modifie sans verrou : leurs empreintes sont ignorées.
+ * 
+ * @param table La table, éventuellement désactivée.
+ * @param block Le premier bloc.
+ * @param length Le nombre de blocs.
+ */
+void dedupForget(DedupTable* table, uint64_t block, uint64_t length);
+
+/**
+ * @brief Fonction pour calculer en parallèle les empreintes d'une liste de blocs de données.
+ * 
+ * Les blocs sont lus directement sur la partition, par suites de blocs
+ * consécutifs, et comparés à leur code de contrôle : un bloc illisible ou
+ * corrompu reçoit l'empreinte 0. Un thread qui ne peut pas allouer son
+ * tampon laisse ses blocs aux autres. Le cache doit avoir été écrit, et
+ * aucun des blocs ne doit changer pendant l'appel.
+ * 
+ * @param partition La partition.
+ * @param entries Les blocs, par numéro croissant ; leurs empreintes sont remplies.
+ * @param count Le nombre de blocs.
+ * @param threads Le nombre de threads, 0 pour un par processeur (au plus DEDUP_MAX_THREADS).
+ * @return Le nombre de threads qui ont calculé des empreintes, -1 si aucun n'a pu allouer son tampon.
+ */
+int dedupHashBlocks(struct Partition* partition, DedupEntry* entries, uint64_t count, int threads);
+
+#endif /* DEDUP_H_ */
@@ -0,0 +1,1032 @@
+/**
+ * @file fsck.c
+ * @brief Ce fichier contient la vérification de la cohérence d'une partition : table des inodes, arbres d'extents, répertoires et table d'allocation, parcourus par plusieurs threads.
+ */
+
+#include <stdarg.h>
+
+#include "projet.h"
+#include "fsck.h"
+
+/**
+ * @def FSCK_GROUP_WORDS
+ * @brief Nombre de mots de la table d'allocation d'un groupe de blocs (65536 blocs), unité de partage du second parcours.
+ */
+#define FSCK_GROUP_WORDS 1024
+
+/**
+ * @def FSCK_SCRUB_SIZE
+ * @brief Nombre maximal d'octets de blocs consécutifs relus en une fois pour les comparer à leurs codes de contrôle.
+ */
+#define FSCK_SCRUB_SIZE (1024 * 1024)
+
+/**
+ * @def FSCK_INODE_PASS
+ * @brief Premier parcours : les groupes d'inodes, qui remplissent la table des blocs référencés.
+ */
+#define FSCK_INODE_PASS 0
+
+/**
+ * @def FSCK_BLOCK_PASS
+ * @brief Second parcours : les groupes de blocs, comparés à la table d'allocation, puis les entrées de chaque inode.
+ */
+#define FSCK_BLOCK_PASS 1
+
+/**
+ * @struct FsckRun
+ * @brief Suite de blocs consécutifs à réparer.
+ */
+typedef struct {
+    uint64_t start; /**< Premier bloc. */
+    uint64_t length; /**< Nombre de blocs. */
+} FsckRun;
+
+/**
+ * @struct FsckRunList
+ * @brief Tableau extensible de suites de blocs, dans l'ordre croissant.
+ */
+typedef struct {
+    FsckRun* runs; /**< Les suites. */
+    size_t count; /**< Nombre de suites. */
+    size_t capacity; /**< Taille allouée du tableau. */
+} FsckRunList;
+
+/**
+ * @struct FsckShare
+ * @brief Compteur de la table des partages à corriger.
+ */
+typedef struct {
+    uint64_t block; /**< Le bloc. */
+    uint16_t found; /**< Le compteur lu pendant la vérification. */
+    uint16_t expected; /**< Le nombre de références du bloc en plus de la première. */
+} FsckShare;
+
+/**
+ * @struct FsckContext
+ * @brief État partagé par les threads de la vérification.
+ */
+typedef struct {
+    Partition* partition; /**< La partition vérifiée. */
+    const FsckOptions* options; /**< Les options. */
+    uint64_t* referenced; /**< Blocs référencés, un bit par bloc, marqués par des additions atomiques. */
+    uint16_t* references; /**< Références de chaque bloc de données partagé en plus de la première, comptées par des additions atomiques. */
+    uint64_t* linked; /**< Inodes désignés par une entrée de répertoire, un bit par inode. */
+    uint64_t* relinked; /**< Inodes désignés par plusieurs entrées. */
+    uint64_t* free_listed; /**< Inodes de la liste des inodes libres. */
+    uint32_t next_inode; /**< Plus petit numéro d'inode jamais attribué. */
+    uint32_t num_chunks; /**< Nombre de groupes d'inodes alloués. */
+    uint64_t words; /**< Nombre de mots de la table d'allocation. */
+    uint64_t groups; /**< Nombre de groupes de blocs. */
+    int pass; /**< Parcours en cours, FSCK_INODE_PASS ou FSCK_BLOCK_PASS. */
+    uint64_t num_tasks; /**< Nombre de tâches du parcours en cours. */
+    uint64_t next_task; /**< Prochaine tâche du parcours, prise par une addition atomique. */
+    uint64_t messages; /**< Nombre de problèmes signalés, pour n'en décrire que les premiers. */
+    pthread_mutex_t print_lock; /**< Sérialise l'affichage des problèmes. */
+} FsckContext;
+
+/**
+ * @struct FsckWorker
+ * @brief État propre à un thread de la vérification, sans verrou.
+ */
+typedef struct {
+    FsckContext* context; /**< L'état partagé. */
+    pthread_t thread; /**< Le thread. */
+    int status; /**< 0, ou -1 après une erreur d'allocation mémoire. */
+    FsckReport report; /**< Compteurs du thread, additionnés à la fin. */
+    FsckRunList leaked; /**< Blocs occupés qu'aucun inode ne référence. */
+    FsckRunList unallocated; /**< Blocs référencés mais libres. */
+    FsckShare* shares; /**< Blocs dont le compteur de partage est faux. */
+    size_t num_shares; /**< Nombre d'entrées de shares. */
+    size_t share_capacity; /**< Taille allouée de shares. */
+    uint32_t* sizes; /**< Fichiers dont la taille dépasse leurs blocs. */
+    size_t num_sizes; /**< Nombre d'entrées de sizes. */
+    size_t size_capacity; /**< Taille allouée de sizes. */
+    uint64_t occupied; /**< Blocs marqués occupés dans les groupes examinés. */
+    uint64_t shared; /**< Blocs partagés dans les groupes examinés. */
+    char* buffer; /**< Tampon de FSCK_SCRUB_SIZE octets pour relire les blocs de données. */
+    uint64_t scrub_start; /**< Premier bloc de la suite en attente de relecture. */
+    uint64_t scrub_count; /**< Nombre de blocs de la suite en attente. */
+} FsckWorker;
+
+/**
+ * @struct DirWalk
+ * @brief État du parcours des feuilles de l'arbre d'un répertoire, de gauche à droite.
+ */
+typedef struct {
+    uint64_t entries; /**< Entrées rencontrées. */
+    uint32_t last_hash; /**< Empreinte de la dernière entrée. */
+    uint64_t leaves; /**< Feuilles rencontrées. */
+    int64_t next; /**< Feuille suivante annoncée par la dernière feuille. */
+} DirWalk;
+
+/**
+ * @brief Descriptions des sortes de problèmes, indexées par FSCK_DUPLICATE_BLOCKS à FSCK_BAD_SHARES.
+ */
+static const char* problem_names[FSCK_NUM_PROBLEMS] = {
+    "blocs référencés plusieurs fois", "blocs occupés non référencés", "blocs référencés mais libres",
+    "extents et nœuds invalides", "tailles de fichiers trop grandes", "inodes invalides",
+    "entrées de répertoires invalides", "blocs corrompus", "compteurs d'allocation faux",
+    "compteurs de partage faux"
+};
+
+/**
+ * @brief Compte un problème et le décrit s'il fait partie des FSCK_MAX_MESSAGES premiers.
+ * @param worker Le thread qui l'a trouvé.
+ * @param kind La sorte de problème.
+ * @param count Le nombre de blocs ou d'éléments concernés.
+ * @param format La description, au format de printf.
+ */
+__attribute__((format(printf, 4, 5)))
+static void problem(FsckWorker* worker, int kind, uint64_t count, const char* format, ...) {
+    FsckContext* context = worker->context;
+    worker->report.problems[kind] += count;
+    if (__atomic_fetch_add(&context->messages, 1, __ATOMIC_RELAXED) >= FSCK_MAX_MESSAGES) {
+        return;
+    }
+    va_list arguments;
+    va_start(arguments, format);
+    pthread_mutex_lock(&context->print_lock);
+    vprintf(format, arguments);
+    printf("\n");
+    pthread_mutex_unlock(&context->print_lock);
+    va_end(arguments);
+}
+
+/**
+ * @brief Ajoute une suite de blocs à un tableau, en prolongeant la dernière si elle la touche.
+ * @param worker Le thread, marqué en erreur si la mémoire manque.
+ * @param list Le tableau.
+ * @param start Le premier bloc.
+ * @param length Le nombre de blocs.
+ */
+static void addRun(FsckWorker* worker, FsckRunList* list, uint64_t start, uint64_t length) {
+    if (list->count > 0 && list->runs[list->count - 1].start + list->runs[list->count - 1].length == start) {
+        list->runs[list->count - 1].length += length;
+        return;
+    }
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity > 0 ? list->capacity * 2 : 64;
+        FsckRun* runs = realloc(list->runs, capacity * sizeof(FsckRun));
+        if (runs == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour la vérification");
+            worker->status = -1;
+            return;
+        }
+        list->runs = runs;
+        list->capacity = capacity;
+    }
+    list->runs[list->count].start = start;
+    list->runs[list->count].length = length;
+    list->count++;
+}
+
+/**
+ * @brief Ajoute à un tableau les suites de bits à 1 d'un mot de la table d'allocation.
+ * @param worker Le thread.
+ * @param list Le tableau.
+ * @param word L'indice du mot.
+ * @param bits Les bits des blocs à ajouter.
+ */
+static void addBits(FsckWorker* worker, FsckRunList* list, uint64_t word, uint64_t bits) {
+    while (bits != 0) {
+        uint32_t first = __builtin_ctzll(bits);
+        uint64_t rest = bits >> first;
+        uint32_t length = ~rest == 0 ? 64 - first : (uint32_t)__builtin_ctzll(~rest);
+        addRun(worker, list, word * 64 + first, length);
+        bits &= length == 64 ? 0 : ~(((1ULL << length) - 1) << first);
+    }
+}
+
+/**
+ * @brief Lit un bit d'une table de bits.
+ * @param bits La table.
+ * @param index L'indice du bit.
+ * @return 1 si le bit est à 1, 0 sinon.
+ */
+static int testBit(const uint64_t* bits, uint64_t index) {
+    return (bits[index / 64] >> (index % 64)) & 1;
+}
+
+/**
+ * @brief Met à 1 un bit d'une table de bits partagée.
+ * @param bits La table.
+ * @param index L'indice du bit.
+ * @return 1 si le bit était déjà à 1, 0 sinon.
+ */
+static int setBit(uint64_t* bits, uint64_t index) {
+    uint64_t mask = 1ULL << (index % 64);
+    return (__atomic_fetch_or(&bits[index / 64], mask, __ATOMIC_RELAXED) & mask) != 0;
+}
+
+/**
+ * @brief Indique si le premier bloc d'un groupe d'inodes laisse la place du groupe dans la partition.
+ * @param context L'état partagé.
+ * @param chunk L'indice du groupe.
+ * @return 1 si les inodes du groupe peuvent être lus, 0 sinon.
+ */
+static int validChunk(FsckContext* context, uint32_t chunk) {
+    Partition* partition = context->partition;
+    uint64_t first = partition->inode_map[chunk];
+    uint64_t num_blocks = partition->superBlock->num_blocks;
+    return first < num_blocks && partition->inode_chunk_blocks <= num_blocks - first;
+}
+
+/**
+ * @brief Donne un inode attribué, dont le groupe peut être lu.
+ * @param context L'état partagé.
+ * @param inode_number Le numéro de l'inode.
+ * @return L'inode, NULL si le numéro n'a jamais été attribué ou si son groupe est hors de la partition.
+ */
+static inode* assignedInode(FsckContext* context, uint32_t inode_number) {
+    if (inode_number == NO_INODE || inode_number >= context->next_inode
+        || !validChunk(context, inode_number / INODES_PER_CHUNK)) {
+        return NULL;
+    }
+    return inodeAt(context->partition, inode_number);
+}
+
+/**
+ * @brief Donne les blocs partagés d'un mot de la table d'allocation.
+ * @param partition La partition.
+ * @param word L'indice du mot.
+ * @return Un bit à 1 par bloc dont le compteur de partage n'est pas nul.
+ */
+static uint64_t sharedMask(Partition* partition, uint64_t word) {
+    uint64_t num_blocks = partition->superBlock->num_blocks;
+    uint64_t first = word * 64, end = num_blocks - first > 64 ? first + 64 : num_blocks;
+    uint64_t mask = 0;
+    for (uint64_t block = first; block < end; ++block) {
+        if (partition->shares[block] != 0) {
+            mask |= 1ULL << (block - first);
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief Note une suite de blocs dans la table des blocs référencés.
+ * @param worker Le thread.
+ * @param start Le premier bloc.
+ * @param length Le nombre de blocs.
+ * @param owner L'inode qui les référence, NO_INODE pour un groupe d'inodes.
+ * @param data 1 pour des blocs de données d'un fichier : un bloc partagé déjà référencé compte une référence de plus.
+ * @return 0 en cas de succès, 1 si l'un des blocs était déjà référencé, -1 si la suite sort de la partition.
+ */
+static int markBlocks(FsckWorker* worker, uint64_t start, uint64_t length, uint32_t owner, int data) {
+    FsckContext* context = worker->context;
+    uint64_t num_blocks = context->partition->superBlock->num_blocks;
+    if (start >= num_blocks || length > num_blocks - start) {
+        problem(worker, FSCK_BAD_EXTENTS, 1, "Inode %u : les blocs %llu à %llu sont hors de la partition.",
+                owner, (unsigned long long)start, (unsigned long long)(start + length - 1));
+        return -1;
+    }
+    worker->report.blocks += length;
+
+    uint64_t duplicates = 0;
+    uint64_t block = start, end = start + length;
+    while (block < end) {
+        uint64_t word = block / 64;
+        uint32_t first = block % 64;
+        uint32_t count = (end - block < 64 - first) ? (uint32_t)(end - block) : 64 - first;
+        uint64_t mask = (count == 64) ? ~0ULL : ((1ULL << count) - 1) << first;
+        uint64_t previous = __atomic_fetch_or(&context->referenced[word], mask, __ATOMIC_RELAXED);
+        uint64_t shared = data && (previous & mask) != 0 ? sharedMask(context->partition, word) & previous & mask : 0;
+        for (uint64_t bits = shared; bits != 0; bits &= bits - 1) {
+            __atomic_fetch_add(&context->references[word * 64 + __builtin_ctzll(bits)], 1, __ATOMIC_RELAXED);
+        }
+        duplicates += __builtin_popcountll(previous & mask & ~shared);
+        block += count;
+    }
+    if (duplicates > 0) {
+        problem(worker, FSCK_DUPLICATE_BLOCKS, duplicates, "Inode %u : %llu des blocs %llu à %llu sont déjà référencés.",
+                owner, (unsigned long long)duplicates, (unsigned long long)start, (unsigned long long)(end - 1));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Vérifie un extent et note ses blocs.
+ * @param worker Le thread.
+ * @param owner L'inode du fichier.
+ * @param extent L'extent.
+ * @param cluster Le nombre de blocs d'un groupe si le fichier est compressé, 0 sinon.
+ * @param logical Le bloc logique où doit commencer l'extent, avancé au-delà de l'extent ou de son groupe.
+ */
+static void checkExtent(FsckWorker* worker, uint32_t owner, const Extent* extent, uint32_t cluster, uint64_t* logical) {
+    if (extent->length == 0 || extent->logical != *logical) {
+        problem(worker, FSCK_BAD_EXTENTS, 1, "Inode %u : l'extent du bloc logique %u ne suit pas le bloc logique %llu.",
+                owner, extent->logical, (unsigned long long)*logical);
+    } else if (cluster != 0 && extent->length > cluster) {
+        problem(worker, FSCK_BAD_EXTENTS, 1, "Inode %u : le groupe du bloc logique %u occupe %u blocs au lieu d'au plus %u.",
+                owner, extent->logical, extent->length, cluster);
+    }
+    if (extent->length > 0) {
+        markBlocks(worker, extent->physical, extent->length, owner, 1);
+    }
+    // Chaque extent d'un fichier compressé décrit un groupe entier
+    *logical = (uint64_t)extent->logical + (cluster != 0 ? cluster : extent->length);
+}
+
+/**
+ * @brief Lit un nœud d'arbre et signale un nœud illisible ou corrompu.
+ * @param worker Le thread.
+ * @param owner L'inode propriétaire de l'arbre.
+ * @param block Le bloc du nœud.
+ * @param node Le nœud à remplir.
+ * @param size La taille du nœud.
+ * @return 0 en cas de succès, -1 si le nœud ne peut pas être utilisé.
+ */
+static int readNode(FsckWorker* worker, uint32_t owner, uint64_t block, void* node, size_t size) {
+    errno = 0;
+    if (readTreeNode(worker->context->partition, block, node, size) == 0) {
+        return 0;
+    }
+    if (errno == EBADMSG) {
+        problem(worker, FSCK_CORRUPTED_BLOCKS, 1, "Inode %u : le nœud du bloc %llu ne correspond pas à son code de contrôle.",
+                owner, (unsigned long long)block);
+    } else {
+        problem(worker, FSCK_BAD_EXTENTS, 1, "Inode %u : le nœud du bloc %llu est illisible.", owner, (unsigned long long)block);
+    }
+    return -1;
+}
+
+/**
+ * @brief Vérifie un sous-arbre d'extents et note ses nœuds et ses blocs.
+ *
+ * Un nœud déjà référencé n'est pas suivi : un arbre qui boucle est signalé
+ * une fois, sans être parcouru indéfiniment.
+ *
+ * @param worker Le thread.
+ * @param owner L'inode du fichier.
+ * @param block Le bloc de la racine du sous-arbre.
+ * @param depth La profondeur attendue du nœud, -1 pour la racine de l'arbre.
+ * @param cluster Le nombre de blocs d'un groupe si le fichier est compressé, 0 sinon.
+ * @param logical Le premier bloc logique attendu, avancé au-delà du sous-arbre.
+ */
+static void checkExtentTree(FsckWorker* worker, uint32_t owner, uint64_t block, int depth, uint32_t cluster, uint64_t* logical) {
+    ExtentNode node;
+    if (markBlocks(worker, block, 1, owner, 0) != 0 || readNode(worker, owner, block, &node, sizeof(ExtentNode)) == -1) {
+        return;
+    }
+    int max = node.depth == 0 ? (int)EXTENT_LEAF_MAX : (int)EXTENT_INDEX_MAX;
+    if ((depth >= 0 && node.depth != depth) || node.depth >= EXTENT_TREE_MAX_DEPTH || node.count == 0 || node.count > max) {
+        problem(worker, FSCK_BAD_EXTENTS, 1, "Inode %u : le nœud d'extents du bloc %llu est invalide (profondeur %u, %u entrées).",
+                owner, (unsigned long long)block, node.depth, node.count);
+        return;
+    }
+    for (int i = 0; i < node.count; ++i) {
+        if (node.depth == 0) {
+            checkExtent(worker, owner, &node.extents[i], cluster, logical);
+            continue;
+        }
+        if (node.index[i].logical != *logical) {
+            problem(worker, FSCK_BAD_EXTENTS, 1, "Inode %u : le fils du bloc %llu commence au bloc logique %u au lieu de %llu.",
+                    owner, (unsigned long long)block, node.index[i].logical, (unsigned long long)*logical);
+        }
+        checkExtentTree(worker, owner, node.index[i].child, node.depth - 1, cluster, logical);
+    }
+}
+
+/**
+ * @brief Vérifie un fichier : ses extents, son arbre d'extents et sa taille.
+ * @param worker Le thread.
+ * @param inode_number Le numéro de l'inode.
+ * @param inode_of_file L'inode.
+ */
+static void checkFile(FsckWorker* worker, uint32_t inode_number, const inode* inode_of_file) {
+    int64_t limit = (int64_t)INLINE_DATA_MAX;
+    uint32_t codec = inode_of_file->flags >> INODE_CODEC_SHIFT;
+    uint32_t cluster = codec != CODEC_NONE ? worker->context->partition->cluster_blocks : 0;
+    if (codec != CODEC_NONE && (codecGet(codec) == NULL || cluster == 0)) {
+        problem(worker, FSCK_BAD_EXTENTS, 1, "Inode %u : codec %u inconnu ou inutilisable sur la partition.", inode_number, codec);
+        return;
+    }
+    if (inode_of_file->flags & INODE_INLINE) {
+        if (inode_of_file->block_count != 0) {
+            problem(worker, FSCK_BAD_EXTENTS, 1, "Inode %u : rangé dans son inode mais associé à %u blocs.",
+                    inode_number, inode_of_file->block_count);
+        }
+    } else if (inode_of_file->num_extents > NUM_DIRECT_EXTENTS) {
+        problem(worker, FSCK_BAD_EXTENTS, 1, "Inode %u : %u extents directs.", inode_number, inode_of_file->num_extents);
+        return;
+    } else {
+        uint64_t logical = 0;
+        for (int e = 0; e < inode_of_file->num_extents; ++e) {
+            checkExtent(worker, inode_number, &inode_of_file->extents[e], cluster, &logical);
+        }
+        if (inode_of_file->extent_tree != NO_BLOCK) {
+            checkExtentTree(worker, inode_number, (uint64_t)inode_of_file->extent_tree, -1, cluster, &logical);
+        }
+        // Le dernier groupe d'un fichier compressé peut n'en couvrir qu'une partie
+        if (cluster != 0 && logical > inode_of_file->block_count && logical - cluster < inode_of_file->block_count) {
+            logical = inode_of_file->block_count;
+        }
+        if (logical != inode_of_file->block_count) {
+            problem(worker, FSCK_BAD_EXTENTS, 1, "Inode %u : ses extents couvrent %llu blocs au lieu de %u.",
+                    inode_number, (unsigned long long)logical, inode_of_file->block_count);
+        }
+        limit = (int64_t)inode_of_file->block_count << worker->context->partition->block_shift;
+    }
+
+    if (inode_of_file->fileSize < 0 || inode_of_file->fileSize > limit) {
+        problem(worker, FSCK_BAD_SIZES, 1, "Inode %u : taille de %lld octets pour %lld octets de place.",
+                inode_number, (long long)inode_of_file->fileSize, (long long)limit);
+        if (worker->num_sizes == worker->size_capacity) {
+            size_t capacity = worker->size_capacity > 0 ? worker->size_capacity * 2 : 64;
+            uint32_t* sizes = realloc(worker->sizes, capacity * sizeof(uint32_t));
+            if (sizes == NULL) {
+                perror("Erreur lors de l'allocation de mémoire pour la vérification");
+                worker->status = -1;
+                return;
+            }
+            worker->sizes = sizes;
+            worker->size_capacity = capacity;
+        }
+        worker->sizes[worker->num_sizes++] = inode_number;
+    }
+}
+
+/**
+ * @brief Vérifie une entrée de répertoire et note l'inode qu'elle désigne.
+ * @param worker Le thread.
+ * @param directory Le numéro de l'inode du répertoire.
+ * @param entry L'entrée.
+ */
+static void checkEntry(FsckWorker* worker, uint32_t directory, const DirEntry* entry) {
+    FsckContext* context = worker->context;
+    worker->report.entries++;
+    inode* target = entry->inode != ROOT_INODE ? assignedInode(context, entry->inode) : NULL;
+    if (target == NULL) {
+        problem(worker, FSCK_BAD_ENTRIES, 1, "Répertoire %u : une entrée désigne l'inode %u, qui n'existe pas.",
+                directory, entry->inode);
+        return;
+    }
+    char name[MAX_FILE_NAME + 1];
+    memcpy(name, target->name, MAX_FILE_NAME);
+    name[MAX_FILE_NAME] = '\0';
+    if (name[0] == '\0') {
+        problem(worker, FSCK_BAD_ENTRIES, 1, "Répertoire %u : une entrée désigne l'inode libre %u.", directory, entry->inode);
+        return;
+    }
+    if (hashName(name) != entry->hash) {
+        problem(worker, FSCK_BAD_ENTRIES, 1, "Répertoire %u : l'entrée de '%s' (inode %u) a une empreinte fausse.",
+                directory, name, entry->inode);
+    }
+    if (setBit(context->linked, entry->inode)) {
+        setBit(context->relinked, entry->inode);
+    }
+}
+
+/**
+ * @brief Vérifie un sous-arbre de répertoire, note ses nœuds et vérifie ses entrées.
+ *
+ * Les feuilles sont atteintes de gauche à droite : leurs entrées doivent
+ * être triées par empreinte, et chacune doit être chaînée à la suivante.
+ *
+ * @param worker Le thread.
+ * @param directory Le numéro de l'inode du répertoire.
+ * @param block Le bloc de la racine du sous-arbre.
+ * @param depth La profondeur attendue du nœud, -1 pour la racine de l'arbre.
+ * @param walk L'état du parcours des feuilles.
+ */
+static void checkDirTree(FsckWorker* worker, uint32_t directory, uint64_t block, int depth, DirWalk* walk) {
+    DirNode node;
+    if (markBlocks(worker, block, 1, directory, 0) != 0 || readNode(worker, directory, block, &node, sizeof(DirNode)) == -1) {
+        return;
+    }
+    int max = node.depth == 0 ? (int)DIR_LEAF_MAX : (int)DIR_INDEX_MAX;
+    if ((depth >= 0 && node.depth != depth) || node.depth >= DIR_TREE_MAX_DEPTH || node.count > max
+        || (node.depth > 0 && node.count == 0)) {
+        problem(worker, FSCK_BAD_EXTENTS, 1, "Répertoire %u : le nœud du bloc %llu est invalide (profondeur %u, %u entrées).",
+                directory, (unsigned long long)block, node.depth, node.count);
+        return;
+    }
+    if (node.depth > 0) {
+        for (int i = 0; i < node.count; ++i) {
+            checkDirTree(worker, directory, node.index[i].child, node.depth - 1, walk);
+        }
+        return;
+    }
+
+    // Une feuille vidée par des suppressions reste chaînée aux autres
+    if (walk->leaves > 0 && walk->next != (int64_t)block) {
+        problem(worker, FSCK_BAD_ENTRIES, 1, "Répertoire %u : la feuille du bloc %llu n'est pas chaînée à la précédente.",
+                directory, (unsigned long long)block);
+    }
+    walk->leaves++;
+    walk->next = node.next;
+    for (int i = 0; i < node.count; ++i) {
+        if (walk->entries > 0 && node.entries[i].hash < walk->last_hash) {
+            problem(worker, FSCK_BAD_ENTRIES, 1, "Répertoire %u : les entrées du bloc %llu ne sont pas triées.",
+                    directory, (unsigned long long)block);
+        }
+        walk->last_hash = node.entries[i].hash;
+        walk->entries++;
+        checkEntry(worker, directory, &node.entries[i]);
+    }
+}
+
+/**
+ * @brief Vérifie un répertoire : son arbre, ses entrées et leur nombre.
+ * @param worker Le thread.
+ * @param inode_number Le numéro de l'inode.
+ * @param directory L'inode.
+ */
+static void checkDirectory(FsckWorker* worker, uint32_t inode_number, const inode* directory) {
+    worker->report.directories++;
+    DirWalk walk = { 0, 0, 0, NO_BLOCK };
+    if (directory->dir_tree != NO_BLOCK) {
+        checkDirTree(worker, inode_number, (uint64_t)directory->dir_tree, -1, &walk);
+    }
+    if (walk.next != NO_BLOCK) {
+        problem(worker, FSCK_BAD_ENTRIES, 1, "Répertoire %u : la dernière feuille est chaînée au bloc %lld.",
+                inode_number, (long long)walk.next);
+    }
+    if ((int64_t)walk.entries != directory->fileSize) {
+        problem(worker, FSCK_BAD_ENTRIES, 1, "Répertoire %u : %llu entrées au lieu de %lld.",
+                inode_number, (unsigned long long)walk.entries, (long long)directory->fileSize);
+    }
+}
+
+/**
+ * @brief Vérifie un inode attribué, libre ou utilisé.
+ * @param worker Le thread.
+ * @param inode_number Le numéro de l'inode.
+ * @param checked L'inode.
+ */
+static void checkInode(FsckWorker* worker, uint32_t inode_number, const inode* checked) {
+    int listed = testBit(worker->context->free_listed, inode_number);
+    if (inode_number != ROOT_INODE && checked->name[0] == '\0') {
+        if (!listed) {
+            problem(worker, FSCK_BAD_INODES, 1, "Inode %u : libre, mais absent de la liste des inodes libres.", inode_number);
+        }
+        return;
+    }
+    if (listed) {
+        problem(worker, FSCK_BAD_INODES, 1, "Inode %u : utilisé, mais dans la liste des inodes libres.", inode_number);
+    }
+    worker->report.inodes++;
+    if (memchr(checked->name, '\0', MAX_FILE_NAME) == NULL) {
+        problem(worker, FSCK_BAD_INODES, 1, "Inode %u : son nom n'est pas terminé.", inode_number);
+    }
+    if (checked->type == INODE_DIRECTORY) {
+        checkDirectory(worker, inode_number, checked);
+    } else if (checked->type == INODE_FILE && inode_number != ROOT_INODE) {
+        checkFile(worker, inode_number, checked);
+    } else {
+        problem(worker, FSCK_BAD_INODES, 1, "Inode %u : type %u invalide.", inode_number, checked->type);
+    }
+}
+
+/**
+ * @brief Vérifie un groupe d'inodes (premier parcours).
+ * @param worker Le thread.
+ * @param chunk L'indice du groupe.
+ */
+static void checkChunk(FsckWorker* worker, uint32_t chunk) {
+    FsckContext* context = worker->context;
+    Partition* partition = context->partition;
+    if (!validChunk(context, chunk)) {
+        problem(worker, FSCK_BAD_INODES, INODES_PER_CHUNK, "Groupe d'inodes %u : son premier bloc %llu est hors de la partition.",
+                chunk, (unsigned long long)partition->inode_map[chunk]);
+        return;
+    }
+    markBlocks(worker, partition->inode_map[chunk], partition->inode_chunk_blocks, NO_INODE, 0);
+    for (uint32_t i = 0; i < INODES_PER_CHUNK; ++i) {
+        uint32_t inode_number = chunk * INODES_PER_CHUNK + i;
+        if (inode_number != NO_INODE && inode_number < context->next_inode) {
+            checkInode(worker, inode_number, inodeAt(partition, inode_number));
+        }
+    }
+}
+
+/**
+ * @brief Vérifie que chaque inode utilisé d'un groupe est désigné par exactement une entrée (second parcours).
+ * @param worker Le thread.
+ * @param chunk L'indice du groupe.
+ */
+static void checkLinks(FsckWorker* worker, uint32_t chunk) {
+    FsckContext* context = worker->context;
+    if (!validChunk(context, chunk)) {
+        return;
+    }
+    for (uint32_t i = 0; i < INODES_PER_CHUNK; ++i) {
+        uint32_t inode_number = chunk * INODES_PER_CHUNK + i;
+        if (inode_number == NO_INODE || inode_number >= context->next_inode) {
+            continue;
+        }
+        inode* checked = inodeAt(context->partition, inode_number);
+        int linked = testBit(context->linked, inode_number);
+        if (inode_number == ROOT_INODE) {
+            if (linked) {
+                problem(worker, FSCK_BAD_INODES, 1, "Le répertoire racine est désigné par une entrée de répertoire.");
+            }
+        } else if (checked->name[0] != '\0' && !linked) {
+            problem(worker, FSCK_BAD_INODES, 1, "Inode %u ('%.*s') : n'est dans aucun répertoire.",
+                    inode_number, MAX_FILE_NAME, checked->name);
+        } else if (checked->name[0] != '\0' && testBit(context->relinked, inode_number)) {
+            problem(worker, FSCK_BAD_INODES, 1, "Inode %u ('%.*s') : désigné par plusieurs entrées.",
+                    inode_number, MAX_FILE_NAME, checked->name);
+        }
+    }
+}
+
+/**
+ * @brief Relit la suite de blocs en attente et compare chaque bloc à son code de contrôle.
+ *
+ * Un bloc qui ne correspond pas est relu seul : une écriture directe en
+ * cours a pu changer son contenu entre la lecture de son code et celle de
+ * ses octets.
+ *
+ * @param worker Le thread.
+ */
+static void flushScrub(FsckWorker* worker) {
+    if (worker->scrub_count == 0) {
+        return;
+    }
+    Partition* partition = worker->context->partition;
+    uint64_t start = worker->scrub_start;
+    size_t length = (size_t)worker->scrub_count << partition->block_shift;
+    worker->scrub_count = 0;
+    if (partitionRead(partition, worker->buffer, length, dataBlockOffset(partition, start)) != (ssize_t)length) {
+        problem(worker, FSCK_CORRUPTED_BLOCKS, length >> partition->block_shift, "Blocs %llu à %llu : illisibles.",
+                (unsigned long long)start, (unsigned long long)(start + (length >> partition->block_shift) - 1));
+        return;
+    }
+    worker->report.scrubbed_bytes += length;
+    for (uint64_t i = 0; i < length >> partition->block_shift; ++i) {
+        uint64_t block = start + i;
+        char* data = worker->buffer + (i << partition->block_shift);
+        uint32_t expected = __atomic_load_n(&partition->checksums[block], __ATOMIC_RELAXED);
+        if (expected == 0) {
+            continue;
+        }
+        worker->report.scrubbed_blocks++;
+        if (blockChecksum(partition, data) == expected) {
+            continue;
+        }
+        if (partitionRead(partition, data, partition->block_size, dataBlockOffset(partition, block)) == (ssize_t)partition->block_size
+            && verifyBlockChecksum(partition, block, data) == 0) {
+            continue;
+        }
+        problem(worker, FSCK_CORRUPTED_BLOCKS, 1, "Bloc %llu : ne correspond pas à son code de contrôle.", (unsigned long long)block);
+    }
+}
+
+/**
+ * @brief Ajoute un bloc de données à la suite en attente de relecture.
+ * @param worker Le thread.
+ * @param block Le bloc, occupé et référencé.
+ */
+static void scrubBlock(FsckWorker* worker, uint64_t block) {
+    Partition* partition = worker->context->partition;
+    // Nœud d'arbre, groupe d'inodes ou bloc jamais écrit : aucun code à comparer
+    if (__atomic_load_n(&partition->checksums[block], __ATOMIC_RELAXED) == 0) {
+        return;
+    }
+    if (worker->scrub_count > 0 && (worker->scrub_start + worker->scrub_count != block
+                                    || (worker->scrub_count + 1) << partition->block_shift > FSCK_SCRUB_SIZE)) {
+        flushScrub(worker);
+    }
+    if (worker->scrub_count == 0) {
+        worker->scrub_start = block;
+    }
+    worker->scrub_count++;
+}
+
+/**
+ * @brief Ajoute un compteur de partage à corriger.
+ * @param worker Le thread, marqué en erreur si la mémoire manque.
+ * @param block Le bloc.
+ * @param found Le compteur lu.
+ * @param expected Le compteur attendu.
+ */
+static void addShare(FsckWorker* worker, uint64_t block, uint16_t found, uint16_t expected) {
+    if (worker->num_shares == worker->share_capacity) {
+        size_t capacity = worker->share_capacity > 0 ? worker->share_capacity * 2 : 64;
+        FsckShare* shares = realloc(worker->shares, capacity * sizeof(FsckShare));
+        if (shares == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour la vérification");
+            worker->status = -1;
+            return;
+        }
+        worker->shares = shares;
+        worker->share_capacity = capacity;
+    }
+    worker->shares[worker->num_shares].block = block;
+    worker->shares[worker->num_shares].found = found;
+    worker->shares[worker->num_shares].expected = expected;
+    worker->num_shares++;
+}
+
+/**
+ * @brief Compare un groupe de blocs à la table d'allocation et à son résumé (second parcours).
+ * @param worker Le thread.
+ * @param group L'indice du groupe.
+ */
+static void checkGroup(FsckWorker* worker, uint64_t group) {
+    FsckContext* context = worker->context;
+    Partition* partition = context->partition;
+    uint64_t num_blocks = partition->superBlock->num_blocks;
+    uint64_t first = group * FSCK_GROUP_WORDS;
+    uint64_t end = context->words - first > FSCK_GROUP_WORDS ? first + FSCK_GROUP_WORDS : context->words;
+    for (uint64_t word = first; word < end; ++word) {
+        uint64_t allocated = partition->bitmap[word];
+        uint64_t referenced = context->referenced[word];
+        uint64_t valid = ~0ULL;
+        if (word == context->words - 1 && num_blocks % 64 != 0) {
+            // Les bits au-delà du dernier bloc doivent rester occupés pour n'être jamais alloués
+            valid = (1ULL << (num_blocks % 64)) - 1;
+            if ((allocated | valid) != ~0ULL) {
+                problem(worker, FSCK_BAD_COUNTERS, 1, "La table d'allocation marque libres des blocs au-delà du dernier.");
+            }
+        }
+        uint64_t full = allocated == ~0ULL;
+        if (((partition->full_summary[word / 64] >> (word % 64)) & 1) != full) {
+            problem(worker, FSCK_BAD_COUNTERS, 1, "Le résumé de la table d'allocation est faux pour les blocs %llu à %llu.",
+                    (unsigned long long)(word * 64), (unsigned long long)(word * 64 + 63));
+        }
+
+        allocated &= valid;
+        worker->occupied += __builtin_popcountll(allocated);
+
+        // Le compteur d'un bloc partagé est son nombre de références en plus de la première
+        uint64_t shared = sharedMask(partition, word);
+        worker->shared += __builtin_popcountll(shared);
+        for (uint64_t bits = shared; bits != 0; bits &= bits - 1) {
+            uint64_t block = word * 64 + __builtin_ctzll(bits);
+            uint16_t found = partition->shares[block];
+            uint16_t expected = (referenced >> (block % 64)) & 1 ? context->references[block] : 0;
+            if (found != expected) {
+                problem(worker, FSCK_BAD_SHARES, 1, "Bloc %llu : partagé %u fois de plus au lieu de %u.",
+                        (unsigned long long)block, found, expected);
+                addShare(worker, block, found, expected);
+            }
+        }
+        addBits(worker, &worker->leaked, word, allocated & ~referenced);
+        addBits(worker, &worker->unallocated, word, referenced & ~allocated);
+        if (context->options->scrub) {
+            for (uint64_t bits = allocated & referenced; bits != 0; bits &= bits - 1) {
+                scrubBlock(worker, word * 64 + __builtin_ctzll(bits));
+            }
+        }
+    }
+    flushScrub(worker);
+}
+
+/**
+ * @brief Vérifie la liste des inodes libres et note ses inodes.
+ * @param worker Le thread.
+ */
+static void checkFreeList(FsckWorker* worker) {
+    FsckContext* context = worker->context;
+    uint32_t inode_number = context->partition->superBlock->free_inode;
+    while (inode_number != NO_INODE) {
+        inode* listed = inode_number != ROOT_INODE ? assignedInode(context, inode_number) : NULL;
+        if (listed == NULL) {
+            problem(worker, FSCK_BAD_INODES, 1, "La liste des inodes libres contient l'inode %u, qui n'existe pas.", inode_number);
+            return;
+        }
+        if (setBit(context->free_listed, inode_number)) {
+            problem(worker, FSCK_BAD_INODES, 1, "La liste des inodes libres boucle sur l'inode %u.", inode_number);
+            return;
+        }
+        inode_number = listed->next_free;
+    }
+}
+
+/**
+ * @brief Exécute les tâches du parcours en cours jusqu'à ce qu'il n'en reste plus.
+ * @param arg Le thread (FsckWorker*).
+ * @return NULL.
+ */
+static void* runWorker(void* arg) {
+    FsckWorker* worker = arg;
+    FsckContext* context = worker->context;
+    uint64_t task;
+    while (worker->status == 0 && (task = __atomic_fetch_add(&context->next_task, 1, __ATOMIC_RELAXED)) < context->num_tasks) {
+        if (context->pass == FSCK_INODE_PASS) {
+            checkChunk(worker, (uint32_t)task);
+        } else if (task < context->groups) {
+            checkGroup(worker, task);
+        } else {
+            checkLinks(worker, (uint32_t)(task - context->groups));
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Répartit les tâches d'un parcours entre les threads, dont le thread appelant.
+ * @param context L'état partagé.
+ * @param workers Les threads.
+ * @param count Le nombre de threads.
+ * @param pass Le parcours.
+ * @param num_tasks Le nombre de tâches.
+ */
+static void runPass(FsckContext* context, FsckWorker* workers, int count, int pass, uint64_t num_tasks) {
+    context->pass = pass;
+    context->num_tasks = num_tasks;
+    context->next_task = 0;
+    // Un thread qui n'a pas pu être créé laisse ses tâches aux autres
+    int started = 1;
+    while (started < count && pthread_create(&workers[started].thread, NULL, runWorker, &workers[started]) == 0) {
+        started++;
+    }
+    runWorker(&workers[0]);
+    for (int i = 1; i < started; ++i) {
+        pthread_join(workers[i].thread, NULL);
+    }
+}
+
+/**
+ * @brief Applique les réparations possibles des problèmes trouvés.
+ * @param partition La partition, dont les opérations ont repris.
+ * @param workers Les threads, avec leurs blocs et leurs fichiers à réparer.
+ * @param count Le nombre de threads.
+ * @param report Les résultats, dont les problèmes réparés sont mis à jour.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int repair(Partition* partition, FsckWorker* workers, int count, FsckReport* report) {
+    int status = 0;
+    // Un bloc perdu est libéré après la remise à zéro de son compteur de partage
+    for (int i = 0; i < count; ++i) {
+        for (size_t s = 0; s < workers[i].num_shares; ++s) {
+            FsckShare* share = &workers[i].shares[s];
+            report->repaired[FSCK_BAD_SHARES] += repairShares(partition, share->block, share->found, share->expected);
+        }
+    }
+    for (int i = 0; i < count; ++i) {
+        FsckWorker* worker = &workers[i];
+        for (size_t r = 0; r < worker->leaked.count; ++r) {
+            report->repaired[FSCK_LEAKED_BLOCKS] += repairBlocks(partition, worker->leaked.runs[r].start,
+                                                                 worker->leaked.runs[r].length, BLOCK_FREE);
+        }
+        for (size_t r = 0; r < worker->unallocated.count; ++r) {
+            report->repaired[FSCK_UNALLOCATED_BLOCKS] += repairBlocks(partition, worker->unallocated.runs[r].start,
+                                                                      worker->unallocated.runs[r].length, BLOCK_OCCUPIED);
+        }
+        for (size_t s = 0; s < worker->num_sizes; ++s) {
+            int repaired = repairFileSize(partition, worker->sizes[s]);
+            if (repaired == -1) {
+                status = -1;
+            } else {
+                report->repaired[FSCK_BAD_SIZES] += repaired;
+            }
+        }
+    }
+    // Les blocs réparés ont tenu les compteurs à jour : seuls ceux déjà faux sont recalculés
+    if (report->problems[FSCK_BAD_COUNTERS] > 0) {
+        repairAllocationCounters(partition);
+        report->repaired[FSCK_BAD_COUNTERS] = report->problems[FSCK_BAD_COUNTERS];
+    }
+
+    uint64_t repaired = 0;
+    for (int k = 0; k < FSCK_NUM_PROBLEMS; ++k) {
+        repaired += report->repaired[k];
+    }
+    if (repaired > 0 && mySync(partition) == -1) {
+        status = -1;
+    }
+    return status;
+}
+
+/**
+ * @brief Fonction pour vérifier la cohérence d'une partition montée, et la réparer si demandé.
+ * @param partition La partition.
+ * @param options Les options, NULL pour vérifier sans réparer ni relire les données avec un thread par processeur.
+ * @param report Reçoit les résultats.
+ * @return 0 si la partition est cohérente ou a été entièrement réparée, 1 s'il reste des problèmes, -1 en cas d'erreur.
+ */
+int fsckPartition(Partition* partition, const FsckOptions* options, FsckReport* report) {
+    FsckOptions defaults = { 0, 0, 0 };
+    if (options == NULL) {
+        options = &defaults;
+    }
+    uint64_t start = statsNow();
+    memset(report, 0, sizeof(FsckReport));
+    int threads = options->threads > 0 ? options->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) {
+        threads = 1;
+    } else if (threads > FSCK_MAX_THREADS) {
+        threads = FSCK_MAX_THREADS;
+    }
+
+    FsckContext context;
+    memset(&context, 0, sizeof(context));
+    context.partition = partition;
+    context.options = options;
+    pthread_mutex_init(&context.print_lock, NULL);
+    FsckWorker* workers = calloc(threads, sizeof(FsckWorker));
+
+    // Les métadonnées ne changent plus jusqu'à la fin des deux parcours
+    journalFreeze(&partition->journal);
+    SuperBlock* sb = partition->superBlock;
+    context.next_inode = sb->next_inode;
+    context.num_chunks = sb->next_inode > 1 ? (sb->next_inode - 1) / INODES_PER_CHUNK + 1 : 0;
+    context.words = (sb->num_blocks + 63) / 64;
+    context.groups = (context.words + FSCK_GROUP_WORDS - 1) / FSCK_GROUP_WORDS;
+    size_t inode_words = (context.next_inode + 63) / 64;
+    context.referenced = calloc(context.words, sizeof(uint64_t));
+    context.references = calloc(sb->num_blocks, sizeof(uint16_t));
+    context.linked = calloc(inode_words, sizeof(uint64_t));
+    context.relinked = calloc(inode_words, sizeof(uint64_t));
+    context.free_listed = calloc(inode_words, sizeof(uint64_t));
+    int status = workers != NULL && context.referenced != NULL && context.references != NULL && context.linked != NULL && context.relinked != NULL
+                 && context.free_listed != NULL ? 0 : -1;
+    for (int i = 0; status == 0 && i < threads; ++i) {
+        workers[i].context = &context;
+        if (options->scrub && (workers[i].buffer = malloc(FSCK_SCRUB_SIZE)) == NULL) {
+            status = -1;
+        }
+    }
+    if (status == -1) {
+        perror("Erreur lors de l'allocation de mémoire pour la vérification");
+    }
+
+    if (status == 0) {
+        checkFreeList(&workers[0]);
+        runPass(&context, workers, threads, FSCK_INODE_PASS, context.num_chunks);
+        runPass(&context, workers, threads, FSCK_BLOCK_PASS, context.groups + context.num_chunks);
+        uint64_t occupied = 0, shared = 0;
+        for (int i = 0; i < threads; ++i) {
+            occupied += workers[i].occupied;
+            shared += workers[i].shared;
+        }
+        if (sb->free_blocks != sb->num_blocks - occupied) {
+            problem(&workers[0], FSCK_BAD_COUNTERS, 1, "Le superbloc compte %llu blocs libres au lieu de %llu.",
+                    (unsigned long long)sb->free_blocks, (unsigned long long)(sb->num_blocks - occupied));
+        }
+        if (sb->shared_blocks != shared) {
+            problem(&workers[0], FSCK_BAD_COUNTERS, 1, "Le superbloc compte %llu blocs partagés au lieu de %llu.",
+                    (unsigned long long)sb->shared_blocks, (unsigned long long)shared);
+        }
+    }
+    journalThaw(&partition->journal);
+
+    for (int i = 0; status == 0 && i < threads; ++i) {
+        FsckWorker* worker = &workers[i];
+        status = worker->status;
+        for (size_t r = 0; r < worker->leaked.count; ++r) {
+            FsckRun* run = &worker->leaked.runs[r];
+            problem(worker, FSCK_LEAKED_BLOCKS, run->length, "Blocs %llu à %llu : occupés, mais référencés par aucun inode.",
+                    (unsigned long long)run->start, (unsigned long long)(run->start + run->length - 1));
+        }
+        for (size_t r = 0; r < worker->unallocated.count; ++r) {
+            FsckRun* run = &worker->unallocated.runs[r];
+            problem(worker, FSCK_UNALLOCATED_BLOCKS, run->length, "Blocs %llu à %llu : référencés, mais libres.",
+                    (unsigned long long)run->start, (unsigned long long)(run->start + run->length - 1));
+        }
+        report->inodes += worker->report.inodes;
+        report->directories += worker->report.directories;
+        report->entries += worker->report.entries;
+        report->blocks += worker->report.blocks;
+        report->scrubbed_blocks += worker->report.scrubbed_blocks;
+        report->scrubbed_bytes += worker->report.scrubbed_bytes;
+        for (int k = 0; k < FSCK_NUM_PROBLEMS; ++k) {
+            report->problems[k] += worker->report.problems[k];
+        }
+    }
+    if (status == 0 && options->repair) {
+        status = repair(partition, workers, threads, report);
+    }
+    if (context.messages > FSCK_MAX_MESSAGES) {
+        printf("... et %llu autres problèmes.\n", (unsigned long long)(context.messages - FSCK_MAX_MESSAGES));
+    }
+    report->nanoseconds = statsNow() - start;
+    report->threads = threads;
+
+    for (int i = 0; workers != NULL && i < threads; ++i) {
+        free(workers[i].leaked.runs);
+        free(workers[i].unallocated.runs);
+        free(workers[i].shares);
+        free(workers[i].sizes);
+        free(workers[i].buffer);
+    }
+    free(workers);
+    free(context.referenced);
+    free(context.references);
+    free(context.linked);
+    free(context.relinked);
+    free(context.free_listed);
+    pthread_mutex_destroy(&context.print_lock);
+    if (status == -1) {
+        return -1;
+    }
+    for (int k = 0; k < FSCK_NUM_PROBLEMS; ++k) {
+        if (report->problems[k] > report->repaired[k]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Fonction pour obtenir la description d'une sorte de problème.
+ * @param problem La sorte de problème, de FSCK_DUPLICATE_BLOCKS à FSCK_BAD_SHARES.
+ * @return La description.
+ */
+const char* fsckProblemName(int problem) {
+    return problem_names[problem];
+}
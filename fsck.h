@@ -0,0 +1,160 @@
+/**
+ * @file fsck.h
+ * @brief Ce fichier contient les déclarations de la vérification et de la réparation de la cohérence d'une partition.
+ */
+
+#ifndef FSCK_H_
+#define FSCK_H_
+
+#include <stdint.h>
+
+struct Partition;
+
+/**
+ * @def FSCK_MAX_THREADS
+ * @brief Nombre maximal de threads de la vérification.
+ */
+#define FSCK_MAX_THREADS 64
+
+/**
+ * @def FSCK_MAX_MESSAGES
+ * @brief Nombre de problèmes décrits un à un ; les suivants sont seulement comptés.
+ */
+#define FSCK_MAX_MESSAGES 32
+
+/**
+ * @def FSCK_DUPLICATE_BLOCKS
+ * @brief Indice des blocs référencés plusieurs fois, par deux inodes ou par le même, sans être partagés.
+ */
+#define FSCK_DUPLICATE_BLOCKS 0
+
+/**
+ * @def FSCK_LEAKED_BLOCKS
+ * @brief Indice des blocs marqués occupés qu'aucun inode ne référence.
+ */
+#define FSCK_LEAKED_BLOCKS 1
+
+/**
+ * @def FSCK_UNALLOCATED_BLOCKS
+ * @brief Indice des blocs référencés mais marqués libres, qui peuvent être alloués une seconde fois.
+ */
+#define FSCK_UNALLOCATED_BLOCKS 2
+
+/**
+ * @def FSCK_BAD_EXTENTS
+ * @brief Indice des extents et des nœuds d'arbres invalides : hors de la partition, mal ordonnés ou mal comptés.
+ */
+#define FSCK_BAD_EXTENTS 3
+
+/**
+ * @def FSCK_BAD_SIZES
+ * @brief Indice des fichiers plus grands que les blocs qu'ils possèdent.
+ */
+#define FSCK_BAD_SIZES 4
+
+/**
+ * @def FSCK_BAD_INODES
+ * @brief Indice des inodes invalides : type inconnu, liste des inodes libres fausse, inode dans aucun répertoire ou dans plusieurs.
+ */
+#define FSCK_BAD_INODES 5
+
+/**
+ * @def FSCK_BAD_ENTRIES
+ * @brief Indice des entrées de répertoires invalides : inode libre ou inexistant, empreinte fausse, nombre d'entrées faux.
+ */
+#define FSCK_BAD_ENTRIES 6
+
+/**
+ * @def FSCK_CORRUPTED_BLOCKS
+ * @brief Indice des nœuds d'arbres et des blocs de données qui ne correspondent pas à leur code de contrôle.
+ */
+#define FSCK_CORRUPTED_BLOCKS 7
+
+/**
+ * @def FSCK_BAD_COUNTERS
+ * @brief Indice des compteurs faux : blocs libres et blocs partagés du superbloc, résumé de la table d'allocation, bits au-delà du dernier bloc.
+ */
+#define FSCK_BAD_COUNTERS 8
+
+/**
+ * @def FSCK_BAD_SHARES
+ * @brief Indice des blocs dont le compteur de la table des partages ne correspond pas au nombre de références.
+ */
+#define FSCK_BAD_SHARES 9
+
+/**
+ * @def FSCK_NUM_PROBLEMS
+ * @brief Nombre de sortes de problèmes.
+ */
+#define FSCK_NUM_PROBLEMS 10
+
+/**
+ * @struct FsckOptions
+ * @brief Options de fsckPartition.
+ */
+typedef struct {
+    int threads; /**< Nombre de threads, 0 pour un par processeur (au plus FSCK_MAX_THREADS). */
+    int repair; /**< 1 pour réparer les problèmes qui peuvent l'être. */
+    int scrub; /**< 1 pour relire les blocs de données et les comparer à leur code de contrôle. */
+} FsckOptions;
+
+/**
+ * @struct FsckReport
+ * @brief Résultats de fsckPartition.
+ */
+typedef struct {
+    uint64_t inodes; /**< Inodes utilisés examinés. */
+    uint64_t directories; /**< Répertoires parmi eux. */
+    uint64_t entries; /**< Entrées de répertoires examinées. */
+    uint64_t blocks; /**< Blocs référencés : blocs des fichiers, nœuds d'arbres et groupes d'inodes. */
+    uint64_t scrubbed_blocks; /**< Blocs de données relus et comparés à leur code de contrôle. */
+    uint64_t scrubbed_bytes; /**< Octets relus pour cette comparaison. */
+    uint64_t problems[FSCK_NUM_PROBLEMS]; /**< Problèmes trouvés, indexés par FSCK_DUPLICATE_BLOCKS à FSCK_BAD_SHARES. */
+    uint64_t repaired[FSCK_NUM_PROBLEMS]; /**< Problèmes réparés, avec les mêmes indices. */
+    uint64_t nanoseconds; /**< Durée de la vérification, réparations comprises. */
+    int threads; /**< Nombre de threads utilisés. */
+} FsckReport;
+
+/**
+ * @brief Fonction pour vérifier la cohérence d'une partition montée, et la réparer si demandé.
+ * 
+ * La partition peut être utilisée par d'autres threads pendant la
+ * vérification : les opérations qui modifient les métadonnées attendent sa
+ * fin, les lectures continuent. Les groupes d'inodes sont répartis entre
+ * les threads, qui parcourent les extents et les arbres de chaque inode et
+ * notent chaque bloc référencé dans une table partagée ; les groupes de
+ * blocs sont ensuite répartis de la même façon pour comparer cette table à
+ * la table d'allocation, vérifier les compteurs et, si demandé, relire les
+ * blocs de données pour les comparer à leur code de contrôle.
+ * 
+ * Les réparations ont lieu une fois les opérations reprises, chacune dans
+ * sa propre opération du journal, puis sont rendues durables par mySync :
+ * les compteurs de partage sont ramenés au nombre de références, les blocs
+ * perdus sont libérés, les blocs référencés mais libres marqués occupés,
+ * les fichiers trop grands ramenés à la taille de leurs blocs et les
+ * compteurs d'allocation recalculés. Les blocs référencés plusieurs
+ * fois, les arbres et les entrées invalides sont seulement signalés.
+ * 
+ * Les FSCK_MAX_MESSAGES premiers problèmes sont décrits sur la sortie
+ * standard.
+ * 
+ * @param partition La partition.
+ * @param options Les options, NULL pour vérifier sans réparer ni relire les données avec un thread par processeur.
+ * @param report Reçoit les résultats.
+ * @return 0 si la partition est cohérente ou a été entièrement réparée, 1 s'il reste des problèmes, -1 en cas d'erreur.
+ */
+int fsckPartition(struct Partition* partition, const FsckOptions* options, FsckReport* report);
+
+/**
+ * @brief Fonction pour obtenir la description d'une sorte de problème.
+ * 
+ * FSCK_BAD_SHARES, la dernière sorte, désigne les blocs partagés par des
+ * clones ou des instantanés dont le compteur de la table des partages ne
+ * correspond pas au nombre de références trouvées dans les extents.
+ * 
+ * @param problem La sorte de problème, de FSCK_DUPLICATE_BLOCKS à FSCK_BAD_SHARES.
+ * @return La description.
+ */
+const char* fsckProblemName(int problem);
+
+#endif /* FSCK_H_ */
@@ -0,0 +1,1065 @@
+/**
+ * @file journal.c
+ * @brief Ce fichier contient les définitions du journal des métadonnées : transactions regroupées, écriture séquentielle et reprise au montage.
+ */
+
+#include "projet.h"
+
+/**
+ * @brief Calcule l'empreinte d'une transaction (CRC32C, comme les blocs de données).
+ * @param data Les octets de la transaction.
+ * @param length Le nombre d'octets.
+ * @return L'empreinte.
+ */
+static uint32_t journalChecksum(const void* data, size_t length) {
+    return crc32c(0, data, length);
+}
+
+/**
+ * @brief Lit des octets à une position donnée d'un descripteur, en reprenant les lectures partielles.
+ * @param fd Le descripteur.
+ * @param buffer Le tampon de destination.
+ * @param nBytes Le nombre d'octets à lire.
+ * @param offset La position.
+ * @return 0 en cas de succès, -1 en cas d'erreur ou de fin de fichier.
+ */
+static int readAt(int fd, void* buffer, size_t nBytes, off_t offset) {
+    size_t done = 0;
+    while (done < nBytes) {
+        ssize_t n = pread(fd, (char*)buffer + done, nBytes - done, offset + done);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Écrit des octets à une position donnée d'un descripteur, en reprenant les écritures partielles.
+ * @param fd Le descripteur.
+ * @param buffer Le tampon contenant les données.
+ * @param nBytes Le nombre d'octets à écrire.
+ * @param offset La position.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int writeAt(int fd, const void* buffer, size_t nBytes, off_t offset) {
+    size_t done = 0;
+    while (done < nBytes) {
+        ssize_t n = pwrite(fd, (const char*)buffer + done, nBytes - done, offset + done);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Écrit l'en-tête du journal entre deux fdatasync.
+ * 
+ * Le premier rend durables les métadonnées déjà écrites à leur place, pour
+ * que les transactions précédentes n'aient plus à être rejouées ; le second
+ * rend durable l'en-tête avant que ces transactions ne soient écrasées.
+ * 
+ * @param fd Le descripteur de la partition.
+ * @param start La position de l'en-tête du journal.
+ * @param sequence Le numéro de la prochaine transaction, écrite au début du journal.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int writeHeader(int fd, off_t start, uint32_t sequence) {
+    JournalHeader header = { JOURNAL_MAGIC, sequence, 0, 0 };
+    if (fdatasync(fd) == -1 || writeAt(fd, &header, sizeof(header), start) == -1 || fdatasync(fd) == -1) {
+        perror("Erreur lors de l'écriture de l'en-tête du journal");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Vérifie la transaction attendue à une position du journal.
+ * @param log Le contenu du journal, sans son en-tête.
+ * @param log_blocks Le nombre de blocs du journal.
+ * @param position Le bloc où doit commencer la transaction.
+ * @param sequence Le numéro attendu.
+ * @return Le nombre de blocs de la transaction, 0 si elle est absente, incomplète ou invalide.
+ */
+static uint32_t validTransaction(const char* log, uint32_t log_blocks, uint32_t position, uint32_t sequence) {
+    if (position >= log_blocks) {
+        return 0;
+    }
+    const char* start = log + (size_t)position * JOURNAL_BLOCK_SIZE;
+    size_t available = (size_t)(log_blocks - position) * JOURNAL_BLOCK_SIZE;
+    JournalTransactionHeader header;
+    memcpy(&header, start, sizeof(header));
+    if (header.magic != JOURNAL_MAGIC || header.sequence != sequence || header.length < sizeof(header)
+        || header.length > available - sizeof(JournalCommit)) {
+        return 0;
+    }
+
+    JournalCommit commit;
+    memcpy(&commit, start + header.length, sizeof(commit));
+    if (commit.magic != JOURNAL_COMMIT_MAGIC || commit.sequence != sequence
+        || commit.checksum != journalChecksum(start, header.length)) {
+        return 0;
+    }
+
+    // Les enregistrements doivent occuper exactement la transaction
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.num_records; ++i) {
+        JournalRecord record;
+        if (offset + sizeof(record) > header.length) {
+            return 0;
+        }
+        memcpy(&record, start + offset, sizeof(record));
+        offset += sizeof(record);
+        if (record.length > header.length - offset) {
+            return 0;
+        }
+        offset += record.length;
+    }
+    if (offset != header.length) {
+        return 0;
+    }
+    return (header.length + sizeof(JournalCommit) + JOURNAL_BLOCK_SIZE - 1) / JOURNAL_BLOCK_SIZE;
+}
+
+/**
+ * @brief Lit la transaction qui peut commencer à une position du journal.
+ * 
+ * Seul le premier bloc est lu si son en-tête n'est pas celui d'une
+ * transaction : le rejeu ne lit que la partie du journal encore utilisée,
+ * et un journal vide ne coûte qu'une lecture au montage.
+ * 
+ * @param fd Le descripteur de la partition.
+ * @param log_start La position du premier bloc du journal après son en-tête.
+ * @param log Le contenu du journal, rempli aux blocs lus.
+ * @param log_blocks Le nombre de blocs du journal.
+ * @param position Le bloc où peut commencer la transaction.
+ * @return 0 en cas de succès, -1 en cas d'erreur de lecture.
+ */
+static int readTransaction(int fd, off_t log_start, char* log, uint32_t log_blocks, uint32_t position) {
+    if (position >= log_blocks) {
+        return 0;
+    }
+    char* start = log + (size_t)position * JOURNAL_BLOCK_SIZE;
+    off_t offset = log_start + (off_t)position * JOURNAL_BLOCK_SIZE;
+    if (readAt(fd, start, JOURNAL_BLOCK_SIZE, offset) == -1) {
+        return -1;
+    }
+    JournalTransactionHeader header;
+    memcpy(&header, start, sizeof(header));
+    size_t available = (size_t)(log_blocks - position) * JOURNAL_BLOCK_SIZE;
+    if (header.magic != JOURNAL_MAGIC || header.length < sizeof(header)
+        || header.length > available - sizeof(JournalCommit)) {
+        return 0;
+    }
+    size_t size = (header.length + sizeof(JournalCommit) + JOURNAL_BLOCK_SIZE - 1) / JOURNAL_BLOCK_SIZE * JOURNAL_BLOCK_SIZE;
+    if (size > JOURNAL_BLOCK_SIZE) {
+        return readAt(fd, start + JOURNAL_BLOCK_SIZE, size - JOURNAL_BLOCK_SIZE, offset + JOURNAL_BLOCK_SIZE);
+    }
+    return 0;
+}
+
+/**
+ * @brief Indique si une image de bloc est annulée par la libération du bloc dans une transaction ultérieure.
+ * @param revoked_blocks Les blocs libérés.
+ * @param revoked_sequences Le numéro de la dernière transaction libérant chacun de ces blocs.
+ * @param count Le nombre de blocs libérés.
+ * @param block Le bloc de l'image.
+ * @param sequence Le numéro de la transaction contenant l'image.
+ * @return 1 si l'image ne doit pas être appliquée, 0 sinon.
+ */
+static int isRevoked(const uint64_t* revoked_blocks, const uint32_t* revoked_sequences, int count, uint64_t block, uint32_t sequence) {
+    for (int i = 0; i < count; ++i) {
+        if (revoked_blocks[i] == block) {
+            return revoked_sequences[i] > sequence;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Fonction pour rejouer le journal d'une partition avant la projection de ses métadonnées.
+ * @param fd Le descripteur de la partition.
+ * @param start La position de l'en-tête du journal.
+ * @param blocks Le nombre de blocs du journal, en-tête compris.
+ * @param data_start La position de la zone de données.
+ * @param block_size La taille des blocs de données.
+ * @param sequence Reçoit le numéro de la prochaine transaction.
+ * @return Le nombre de transactions rejouées, -1 en cas d'erreur.
+ */
+int journalRecover(int fd, off_t start, uint32_t blocks, off_t data_start, uint32_t block_size, uint32_t* sequence) {
+    JournalHeader header;
+    if (readAt(fd, &header, sizeof(header), start) == -1 || header.magic != JOURNAL_MAGIC || blocks < 2) {
+        printf("Erreur : Le journal de la partition est invalide.\n");
+        return -1;
+    }
+    // Les blocs du journal ne sont lus qu'à mesure que les transactions sont
+    // suivies : les pages jamais lues du tampon ne sont pas allouées
+    uint32_t log_blocks = blocks - 1;
+    off_t log_start = start + JOURNAL_BLOCK_SIZE;
+    char* log = malloc((size_t)log_blocks * JOURNAL_BLOCK_SIZE);
+    uint32_t* positions = malloc(log_blocks * sizeof(uint32_t));
+    if (log == NULL || positions == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour la reprise du journal.");
+        free(log);
+        free(positions);
+        return -1;
+    }
+
+    // Suivre les transactions de numéros consécutifs ; une transaction qui ne
+    // tient pas avant la fin du journal est écrite au début
+    uint32_t expected = header.sequence, position = header.tail, consumed = 0;
+    int count = 0, status = 0;
+    while (consumed < log_blocks) {
+        status = readTransaction(fd, log_start, log, log_blocks, position);
+        uint32_t length = status == 0 ? validTransaction(log, log_blocks, position, expected) : 0;
+        if (status == 0 && length == 0 && position != 0) {
+            consumed += log_blocks - position;
+            position = 0;
+            status = readTransaction(fd, log_start, log, log_blocks, position);
+            length = status == 0 ? validTransaction(log, log_blocks, position, expected) : 0;
+        }
+        if (length == 0 || consumed + length > log_blocks) {
+            break;
+        }
+        positions[count++] = position;
+        position += length;
+        consumed += length;
+        expected++;
+    }
+
+    if (status == -1) {
+        perror("Erreur lors de la lecture du journal");
+        free(log);
+        free(positions);
+        return -1;
+    }
+
+    // Recenser les blocs libérés, puis appliquer les enregistrements dans l'ordre
+    int num_revoked = 0;
+    uint64_t* revoked_blocks = malloc((size_t)log_blocks * JOURNAL_BLOCK_SIZE / sizeof(JournalRecord) * sizeof(uint64_t));
+    uint32_t* revoked_sequences = malloc((size_t)log_blocks * JOURNAL_BLOCK_SIZE / sizeof(JournalRecord) * sizeof(uint32_t));
+    if (revoked_blocks == NULL || revoked_sequences == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour la reprise du journal.");
+        status = -1;
+    }
+    for (int pass = 0; pass < 2 && status == 0; ++pass) {
+        for (int t = 0; t < count && status == 0; ++t) {
+            const char* transaction = log + (size_t)positions[t] * JOURNAL_BLOCK_SIZE;
+            JournalTransactionHeader transaction_header;
+            memcpy(&transaction_header, transaction, sizeof(transaction_header));
+            size_t offset = sizeof(transaction_header);
+            for (uint32_t r = 0; r < transaction_header.num_records && status == 0; ++r) {
+                JournalRecord record;
+                memcpy(&record, transaction + offset, sizeof(record));
+                const char* data = transaction + offset + sizeof(record);
+                offset += sizeof(record) + record.length;
+
+                if (pass == 0 && record.type == JOURNAL_REVOKE) {
+                    int i = 0;
+                    while (i < num_revoked && revoked_blocks[i] != record.target) {
+                        i++;
+                    }
+                    revoked_blocks[i] = record.target;
+                    revoked_sequences[i] = transaction_header.sequence;
+                    num_revoked += i == num_revoked;
+                } else if (pass == 1 && record.type == JOURNAL_METADATA) {
+                    status = writeAt(fd, data, record.length, (off_t)record.target);
+                } else if (pass == 1 && record.type == JOURNAL_BLOCK
+                           && !isRevoked(revoked_blocks, revoked_sequences, num_revoked, record.target, transaction_header.sequence)) {
+                    status = writeAt(fd, data, record.length, data_start + (off_t)record.target * block_size);
+                }
+            }
+        }
+    }
+    free(revoked_blocks);
+    free(revoked_sequences);
+    free(positions);
+    free(log);
+
+    // Vider le journal une fois les métadonnées durables à leur place
+    if (status == 0 && (count > 0 || header.tail != 0)) {
+        status = writeHeader(fd, start, expected);
+    }
+    if (status == -1) {
+        perror("Erreur lors de la reprise du journal");
+        return -1;
+    }
+    if (count > 0) {
+        printf("Journal : %d transaction(s) rejouée(s).\n", count);
+    }
+    *sequence = expected;
+    return count;
+}
+
+/**
+ * @brief Fonction pour écrire l'en-tête d'un journal vide lors du formatage.
+ * @param fd Le descripteur de la partition.
+ * @param start La position de l'en-tête du journal.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int journalFormat(int fd, off_t start) {
+    JournalHeader header = { JOURNAL_MAGIC, 1, 0, 0 };
+    return writeAt(fd, &header, sizeof(header), start);
+}
+
+/**
+ * @brief Fonction pour initialiser le journal d'une partition montée.
+ * @param journal Le journal.
+ * @param partition La partition.
+ * @param start La position de l'en-tête du journal.
+ * @param blocks Le nombre de blocs du journal, en-tête compris.
+ * @param sequence Le numéro de la prochaine transaction.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int journalInit(Journal* journal, struct Partition* partition, off_t start, uint32_t blocks, uint32_t sequence) {
+    memset(journal, 0, sizeof(Journal));
+    journal->partition = partition;
+    journal->start = start;
+    journal->log_blocks = blocks - 1;
+    journal->running.sequence = sequence;
+
+    // Les morceaux modifiés sont repérés par leur position, la partition entière étant projetée
+    journal->dirty_capacity = JOURNAL_DIRTY_INITIAL;
+    journal->dirty = calloc(journal->dirty_capacity, sizeof(uint64_t));
+    if (journal->dirty == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour le journal.");
+        return -1;
+    }
+
+    // Une transaction en attente passe avant les nouvelles opérations
+    pthread_rwlockattr_t attributes;
+    pthread_rwlockattr_init(&attributes);
+    pthread_rwlockattr_setkind_np(&attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&journal->handles, &attributes);
+    pthread_rwlockattr_destroy(&attributes);
+    pthread_mutex_init(&journal->lock, NULL);
+    pthread_mutex_init(&journal->commit_lock, NULL);
+    return 0;
+}
+
+/**
+ * @brief Libère les images de nœuds et les blocs libérés d'une transaction.
+ * @param transaction La transaction, vidée.
+ */
+static void clearTransaction(JournalTransaction* transaction) {
+    for (int i = 0; i < transaction->num_blocks; ++i) {
+        free(transaction->blocks[i]);
+    }
+    free(transaction->blocks);
+    free(transaction->revokes);
+    uint32_t sequence = transaction->sequence;
+    memset(transaction, 0, sizeof(JournalTransaction));
+    transaction->sequence = sequence;
+}
+
+/**
+ * @brief Fonction pour libérer le journal.
+ * @param journal Le journal.
+ */
+void journalDestroy(Journal* journal) {
+    clearTransaction(&journal->running);
+    clearTransaction(&journal->committing);
+    free(journal->dirty);
+    pthread_rwlock_destroy(&journal->handles);
+    pthread_mutex_destroy(&journal->lock);
+    pthread_mutex_destroy(&journal->commit_lock);
+}
+
+/**
+ * @brief Taille maximale de la transaction en cours une fois écrite (journal->lock doit être pris).
+ * @param journal Le journal.
+ * @return La taille en octets, arrondie au bloc supérieur.
+ */
+static size_t transactionSize(const Journal* journal) {
+    size_t size = sizeof(JournalTransactionHeader) + sizeof(JournalCommit)
+                  + (size_t)journal->dirty_chunks * (sizeof(JournalRecord) + JOURNAL_CHUNK)
+                  + (size_t)journal->running.num_blocks * (sizeof(JournalRecord) + JOURNAL_IMAGE_SIZE)
+                  + (size_t)journal->running.num_revokes * sizeof(JournalRecord);
+    return (size + JOURNAL_BLOCK_SIZE - 1) / JOURNAL_BLOCK_SIZE * JOURNAL_BLOCK_SIZE;
+}
+
+/**
+ * @brief Fonction pour commencer une opération qui modifie les métadonnées.
+ * @param journal Le journal.
+ */
+void journalStart(Journal* journal) {
+    pthread_rwlock_rdlock(&journal->handles);
+}
+
+/**
+ * @brief Fonction pour commencer une opération qui s'exécute seule.
+ * @param journal Le journal.
+ */
+void journalStartExclusive(Journal* journal) {
+    // Dans l'ordre de journalCommit : l'opération peut écrire ses propres transactions
+    pthread_mutex_lock(&journal->commit_lock);
+    pthread_rwlock_wrlock(&journal->handles);
+}
+
+/**
+ * @brief Fonction pour terminer une opération commencée par journalStartExclusive.
+ * @param journal Le journal.
+ */
+void journalStopExclusive(Journal* journal) {
+    pthread_rwlock_unlock(&journal->handles);
+    pthread_mutex_unlock(&journal->commit_lock);
+    if (__atomic_load_n(&journal->full, __ATOMIC_RELAXED)) {
+        journalCommit(journal);
+    }
+}
+
+/**
+ * @brief Fonction pour connaître la place que la transaction en cours peut encore occuper dans le journal.
+ * @param journal Le journal.
+ * @return Le nombre d'octets, 0 si la transaction remplit déjà le journal.
+ */
+size_t journalRoom(Journal* journal) {
+    pthread_mutex_lock(&journal->lock);
+    size_t capacity = (size_t)journal->log_blocks * JOURNAL_BLOCK_SIZE;
+    size_t size = transactionSize(journal);
+    pthread_mutex_unlock(&journal->lock);
+    return size < capacity ? capacity - size : 0;
+}
+
+/**
+ * @brief Fonction pour terminer une opération commencée par journalStart.
+ * @param journal Le journal.
+ */
+void journalStop(Journal* journal) {
+    pthread_rwlock_unlock(&journal->handles);
+
+    // Garder de la place pour que chaque transaction tienne dans le journal
+    if (__atomic_load_n(&journal->full, __ATOMIC_RELAXED)) {
+        journalCommit(journal);
+    }
+}
+
+/**
+ * @brief Fonction pour attendre la fin des opérations en cours et empêcher d'en commencer de nouvelles.
+ * @param journal Le journal.
+ */
+void journalFreeze(Journal* journal) {
+    // Comme pour constituer une transaction : les opérations en attente passent après
+    pthread_rwlock_wrlock(&journal->handles);
+}
+
+/**
+ * @brief Fonction pour autoriser de nouveau les opérations arrêtées par journalFreeze.
+ * @param journal Le journal.
+ */
+void journalThaw(Journal* journal) {
+    pthread_rwlock_unlock(&journal->handles);
+}
+
+/**
+ * @brief Note si la transaction en cours doit être écrite sans attendre mySync (journal->lock doit être pris).
+ * @param journal Le journal.
+ */
+static void updateFull(Journal* journal) {
+    int full = transactionSize(journal) > (size_t)journal->log_blocks * JOURNAL_BLOCK_SIZE / 4;
+    __atomic_store_n(&journal->full, full, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Calcule la case initiale d'un morceau dans l'ensemble des morceaux modifiés.
+ * @param chunk Le rang du morceau dans la partition.
+ * @param mask Le nombre de cases de l'ensemble moins un.
+ * @return L'indice de la case.
+ */
+static size_t dirtySlot(uint64_t chunk, size_t mask) {
+    return (size_t)((chunk * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+/**
+ * @brief Ajoute un morceau à un ensemble de morceaux modifiés, sans l'agrandir.
+ * @param dirty Les cases de l'ensemble.
+ * @param mask Le nombre de cases moins un.
+ * @param chunk Le rang du morceau dans la partition.
+ * @return 1 si le morceau a été ajouté, 0 s'il y était déjà.
+ */
+static int insertDirty(uint64_t* dirty, size_t mask, uint64_t chunk) {
+    size_t slot = dirtySlot(chunk, mask);
+    while (dirty[slot] != 0) {
+        if (dirty[slot] == chunk + 1) {
+            return 0;
+        }
+        slot = (slot + 1) & mask;
+    }
+    dirty[slot] = chunk + 1;
+    return 1;
+}
+
+/**
+ * @brief Double le nombre de cases de l'ensemble des morceaux modifiés (journal->lock doit être pris).
+ * @param journal Le journal.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+static int growDirty(Journal* journal) {
+    size_t capacity = journal->dirty_capacity * 2;
+    uint64_t* dirty = calloc(capacity, sizeof(uint64_t));
+    if (dirty == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour le journal.");
+        return -1;
+    }
+    for (size_t i = 0; i < journal->dirty_capacity; ++i) {
+        if (journal->dirty[i] != 0) {
+            insertDirty(dirty, capacity - 1, journal->dirty[i] - 1);
+        }
+    }
+    free(journal->dirty);
+    journal->dirty = dirty;
+    journal->dirty_capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief Fonction pour signaler la modification d'octets de métadonnées projetées.
+ * @param journal Le journal.
+ * @param address L'adresse des octets modifiés.
+ * @param length Le nombre d'octets modifiés.
+ */
+void journalDirty(Journal* journal, const void* address, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    size_t offset = (const char*)address - (const char*)journal->partition->metadata;
+    uint64_t first = offset / JOURNAL_CHUNK, last = (offset + length - 1) / JOURNAL_CHUNK;
+
+    pthread_mutex_lock(&journal->lock);
+    for (uint64_t chunk = first; chunk <= last; ++chunk) {
+        // L'ensemble reste au plus à moitié plein pour des sondages courts
+        if ((journal->dirty_chunks + 1) * 2 > journal->dirty_capacity && growDirty(journal) == -1) {
+            break;
+        }
+        journal->dirty_chunks += insertDirty(journal->dirty, journal->dirty_capacity - 1, chunk);
+    }
+    updateFull(journal);
+    pthread_mutex_unlock(&journal->lock);
+}
+
+/**
+ * @brief Recherche l'image d'un bloc dans une transaction (journal->lock doit être pris).
+ * @param transaction La transaction.
+ * @param block Le bloc de données.
+ * @return L'indice de l'image, -1 si aucune.
+ */
+static int findBlock(const JournalTransaction* transaction, uint64_t block) {
+    for (int i = 0; i < transaction->num_blocks; ++i) {
+        if (transaction->blocks[i]->block == block) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Fonction pour journaliser le nouveau contenu d'un nœud de l'arbre d'extents.
+ * @param journal Le journal.
+ * @param block Le bloc de données du nœud.
+ * @param data Le nœud (JOURNAL_IMAGE_SIZE octets).
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int journalLogBlock(Journal* journal, uint64_t block, const void* data) {
+    JournalTransaction* running = &journal->running;
+    pthread_mutex_lock(&journal->lock);
+    int i = findBlock(running, block);
+    if (i == -1) {
+        if (running->num_blocks == running->block_capacity) {
+            int capacity = running->block_capacity == 0 ? 8 : running->block_capacity * 2;
+            JournalBlock** blocks = realloc(running->blocks, capacity * sizeof(JournalBlock*));
+            if (blocks == NULL) {
+                pthread_mutex_unlock(&journal->lock);
+                perror("Erreur lors de l'allocation de mémoire pour le journal.");
+                return -1;
+            }
+            running->blocks = blocks;
+            running->block_capacity = capacity;
+        }
+        JournalBlock* image = malloc(sizeof(JournalBlock) + JOURNAL_IMAGE_SIZE);
+        if (image == NULL) {
+            pthread_mutex_unlock(&journal->lock);
+            perror("Erreur lors de l'allocation de mémoire pour le journal.");
+            return -1;
+        }
+        image->block = block;
+        image->revoked = 0;
+        i = running->num_blocks++;
+        running->blocks[i] = image;
+    }
+    memcpy(running->blocks[i]->data, data, JOURNAL_IMAGE_SIZE);
+    updateFull(journal);
+    pthread_mutex_unlock(&journal->lock);
+    return 0;
+}
+
+/**
+ * @brief Fonction pour lire un nœud journalisé qui n'est pas encore à sa place.
+ * @param journal Le journal.
+ * @param block Le bloc de données du nœud.
+ * @param data Reçoit le nœud (JOURNAL_IMAGE_SIZE octets).
+ * @return 1 si le bloc a été trouvé, 0 sinon.
+ */
+int journalReadBlock(Journal* journal, uint64_t block, void* data) {
+    pthread_mutex_lock(&journal->lock);
+    // La transaction en cours contient l'image la plus récente
+    const JournalTransaction* transactions[] = { &journal->running, &journal->committing };
+    int found = 0;
+    for (int t = 0; t < 2 && !found; ++t) {
+        int i = findBlock(transactions[t], block);
+        if (i != -1) {
+            memcpy(data, transactions[t]->blocks[i]->data, JOURNAL_IMAGE_SIZE);
+            found = 1;
+        }
+    }
+    pthread_mutex_unlock(&journal->lock);
+    return found;
+}
+
+/**
+ * @brief Ajoute un bloc libéré à une transaction (journal->lock doit être pris).
+ * @param transaction La transaction.
+ * @param block Le bloc de données libéré.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+static int addRevoke(JournalTransaction* transaction, uint64_t block) {
+    if (transaction->num_revokes == transaction->revoke_capacity) {
+        int capacity = transaction->revoke_capacity == 0 ? 8 : transaction->revoke_capacity * 2;
+        uint64_t* revokes = realloc(transaction->revokes, capacity * sizeof(uint64_t));
+        if (revokes == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour le journal.");
+            return -1;
+        }
+        transaction->revokes = revokes;
+        transaction->revoke_capacity = capacity;
+    }
+    transaction->revokes[transaction->num_revokes++] = block;
+    return 0;
+}
+
+/**
+ * @brief Fonction pour signaler la libération d'un bloc dont le contenu a pu être journalisé.
+ * @param journal Le journal.
+ * @param block Le bloc de données libéré.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int journalRevokeBlock(Journal* journal, uint64_t block) {
+    JournalTransaction* running = &journal->running;
+    pthread_mutex_lock(&journal->lock);
+
+    // L'image de la transaction en cours disparaît, celle de la transaction
+    // en cours d'écriture ne sera pas écrite à sa place
+    int i = findBlock(running, block);
+    if (i != -1) {
+        free(running->blocks[i]);
+        running->blocks[i] = running->blocks[--running->num_blocks];
+    }
+    i = findBlock(&journal->committing, block);
+    if (i != -1) {
+        journal->committing.blocks[i]->revoked = 1;
+    }
+
+    // Les transactions déjà écrites ne seront pas rejouées pour ce bloc
+    int status = addRevoke(running, block);
+    updateFull(journal);
+    pthread_mutex_unlock(&journal->lock);
+    return status;
+}
+
+/**
+ * @brief Ajoute un enregistrement à une transaction en construction.
+ * @param buffer La transaction.
+ * @param offset La position de l'enregistrement, avancée après ses données.
+ * @param type Le type de l'enregistrement.
+ * @param target La position ou le bloc concerné.
+ * @param data Les données, ou NULL.
+ * @param length Le nombre d'octets de données.
+ */
+static void appendRecord(char* buffer, size_t* offset, uint32_t type, uint64_t target, const void* data, uint32_t length) {
+    JournalRecord record = { type, length, target };
+    memcpy(buffer + *offset, &record, sizeof(record));
+    if (length > 0) {
+        memcpy(buffer + *offset + sizeof(record), data, length);
+    }
+    *offset += sizeof(record) + length;
+}
+
+/**
+ * @brief Compare deux rangs de morceaux (pour qsort).
+ * @param a Pointeur vers le premier rang.
+ * @param b Pointeur vers le second rang.
+ * @return Un entier négatif, nul ou positif.
+ */
+static int compareChunks(const void* a, const void* b) {
+    uint64_t chunk_a = *(const uint64_t*)a, chunk_b = *(const uint64_t*)b;
+    return (chunk_a > chunk_b) - (chunk_a < chunk_b);
+}
+
+/**
+ * @brief Vide l'ensemble des morceaux modifiés (journal->lock doit être pris).
+ * 
+ * Un ensemble agrandi par une grosse transaction reprend sa taille
+ * initiale, pour que les suivantes n'aient pas à le parcourir en entier.
+ * 
+ * @param journal Le journal.
+ */
+static void clearDirty(Journal* journal) {
+    if (journal->dirty_capacity > JOURNAL_DIRTY_INITIAL) {
+        uint64_t* dirty = calloc(JOURNAL_DIRTY_INITIAL, sizeof(uint64_t));
+        if (dirty != NULL) {
+            free(journal->dirty);
+            journal->dirty = dirty;
+            journal->dirty_capacity = JOURNAL_DIRTY_INITIAL;
+        }
+    }
+    if (journal->dirty_chunks > 0) {
+        memset(journal->dirty, 0, journal->dirty_capacity * sizeof(uint64_t));
+    }
+    journal->dirty_chunks = 0;
+}
+
+/**
+ * @brief Constitue une transaction avec les modifications des opérations terminées.
+ * 
+ * Appelée entre deux opérations (handles pris en écriture et journal->lock
+ * pris). Les suites de morceaux de métadonnées modifiés sont copiées depuis
+ * leur projection, et la transaction en cours devient celle en cours
+ * d'écriture.
+ * 
+ * @param journal Le journal.
+ * @param length Reçoit la taille de la transaction, multiple de JOURNAL_BLOCK_SIZE.
+ * @return La transaction, NULL si elle est vide ou en cas d'erreur d'allocation mémoire.
+ */
+static char* buildTransaction(Journal* journal, size_t* length) {
+    JournalTransaction* running = &journal->running;
+    *length = 0;
+    if (journal->dirty_chunks == 0 && running->num_blocks == 0 && running->num_revokes == 0) {
+        return NULL;
+    }
+    size_t capacity = transactionSize(journal);
+    char* buffer = calloc(1, capacity);
+    uint64_t* chunks = malloc((journal->dirty_chunks + 1) * sizeof(uint64_t));
+    if (buffer == NULL || chunks == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour la transaction.");
+        free(buffer);
+        free(chunks);
+        return NULL;
+    }
+
+    // Les morceaux modifiés, triés par position, forment des suites copiées d'un seul tenant
+    size_t num_chunks = 0;
+    for (size_t i = 0; i < journal->dirty_capacity; ++i) {
+        if (journal->dirty[i] != 0) {
+            chunks[num_chunks++] = journal->dirty[i] - 1;
+        }
+    }
+    qsort(chunks, num_chunks, sizeof(uint64_t), compareChunks);
+
+    const char* metadata = journal->partition->metadata;
+    size_t offset = sizeof(JournalTransactionHeader);
+    uint32_t num_records = 0;
+    size_t c = 0;
+    while (c < num_chunks) {
+        size_t end = c + 1;
+        while (end < num_chunks && chunks[end] == chunks[end - 1] + 1) {
+            end++;
+        }
+        appendRecord(buffer, &offset, JOURNAL_METADATA, chunks[c] * JOURNAL_CHUNK, metadata + chunks[c] * JOURNAL_CHUNK,
+                     (end - c) * JOURNAL_CHUNK);
+        num_records++;
+        c = end;
+    }
+    free(chunks);
+    for (int i = 0; i < running->num_blocks; ++i) {
+        appendRecord(buffer, &offset, JOURNAL_BLOCK, running->blocks[i]->block, running->blocks[i]->data, JOURNAL_IMAGE_SIZE);
+        num_records++;
+    }
+    for (int i = 0; i < running->num_revokes; ++i) {
+        appendRecord(buffer, &offset, JOURNAL_REVOKE, running->revokes[i], NULL, 0);
+        num_records++;
+    }
+
+    JournalTransactionHeader header = { JOURNAL_MAGIC, running->sequence, num_records, (uint32_t)offset };
+    memcpy(buffer, &header, sizeof(header));
+    JournalCommit commit = { JOURNAL_COMMIT_MAGIC, running->sequence, journalChecksum(buffer, offset), 0 };
+    memcpy(buffer + offset, &commit, sizeof(commit));
+    *length = (offset + sizeof(commit) + JOURNAL_BLOCK_SIZE - 1) / JOURNAL_BLOCK_SIZE * JOURNAL_BLOCK_SIZE;
+
+    // Les opérations suivantes modifient une nouvelle transaction
+    clearDirty(journal);
+    journal->committing = *running;
+    memset(running, 0, sizeof(JournalTransaction));
+    running->sequence = journal->committing.sequence + 1;
+    updateFull(journal);
+    journal->stats.records += num_records;
+    return buffer;
+}
+
+/**
+ * @brief Remet les modifications d'une transaction qui n'a pas pu être écrite dans la transaction en cours.
+ * 
+ * La transaction en cours reprend le numéro de celle qui a échoué, pour que
+ * les numéros du journal restent consécutifs.
+ * 
+ * @param journal Le journal.
+ * @param buffer La transaction qui n'a pas pu être écrite.
+ */
+static void requeueTransaction(Journal* journal, const char* buffer) {
+    JournalTransactionHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    size_t offset = sizeof(header);
+    for (uint32_t r = 0; r < header.num_records; ++r) {
+        JournalRecord record;
+        memcpy(&record, buffer + offset, sizeof(record));
+        offset += sizeof(record) + record.length;
+        if (record.type == JOURNAL_METADATA) {
+            journalDirty(journal, (const char*)journal->partition->metadata + record.target, record.length);
+        }
+    }
+
+    // Les images plus récentes de la transaction en cours sont conservées ;
+    // les libérations n'annulent que les images des transactions précédentes
+    pthread_mutex_lock(&journal->lock);
+    JournalTransaction* committing = &journal->committing;
+    for (int i = 0; i < committing->num_revokes; ++i) {
+        addRevoke(&journal->running, committing->revokes[i]);
+    }
+    for (int i = 0; i < committing->num_blocks; ++i) {
+        JournalBlock* image = committing->blocks[i];
+        if (!image->revoked && findBlock(&journal->running, image->block) == -1) {
+            pthread_mutex_unlock(&journal->lock);
+            journalLogBlock(journal, image->block, image->data);
+            pthread_mutex_lock(&journal->lock);
+        }
+    }
+    journal->running.sequence = committing->sequence;
+    clearTransaction(committing);
+    pthread_mutex_unlock(&journal->lock);
+}
+
+/**
+ * @brief Ajoute une transaction au journal puis la rend durable.
+ * 
+ * La transaction est écrite d'un seul tenant, après la précédente ou au
+ * début du journal si elle ne tient pas avant sa fin. Lorsque le journal
+ * est plein, les métadonnées déjà écrites à leur place sont rendues durables
+ * et le journal recommence à son début.
+ * 
+ * @param journal Le journal.
+ * @param buffer La transaction.
+ * @param length Sa taille, multiple de JOURNAL_BLOCK_SIZE.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int appendTransaction(Journal* journal, const char* buffer, size_t length) {
+    int fd = journal->partition->fileDescriptor;
+    uint32_t blocks = length / JOURNAL_BLOCK_SIZE;
+    if (blocks > journal->log_blocks) {
+        printf("Erreur : La transaction dépasse la taille du journal.\n");
+        return -1;
+    }
+
+    uint32_t position = journal->head, skipped = 0;
+    if (position + blocks > journal->log_blocks) {
+        skipped = journal->log_blocks - position;
+        position = 0;
+    }
+    if (journal->used + skipped + blocks > journal->log_blocks) {
+        if (writeHeader(fd, journal->start, journal->committing.sequence) == -1) {
+            return -1;
+        }
+        pthread_mutex_lock(&journal->lock);
+        journal->stats.syncs += 2;
+        journal->stats.resets++;
+        pthread_mutex_unlock(&journal->lock);
+        statsAdd(&journal->partition->stats, STATS_SYSCALLS, 3);
+        journal->used = 0;
+        position = 0;
+        skipped = 0;
+    }
+
+    int status = writeAt(fd, buffer, length, journal->start + (off_t)(1 + position) * JOURNAL_BLOCK_SIZE);
+    if (status == 0) {
+        status = fdatasync(fd);
+    }
+    if (status == -1) {
+        perror("Erreur lors de l'écriture du journal");
+        return -1;
+    }
+    journal->head = position + blocks;
+    journal->used += skipped + blocks;
+
+    pthread_mutex_lock(&journal->lock);
+    journal->stats.transactions++;
+    journal->stats.bytes += length;
+    journal->stats.syncs++;
+    pthread_mutex_unlock(&journal->lock);
+    statsAdd(&journal->partition->stats, STATS_SYSCALLS, 2);
+    return 0;
+}
+
+/**
+ * @brief Écrit à leur place les métadonnées et les nœuds d'une transaction devenue durable.
+ * 
+ * Ces écritures ne sont pas attendues : la transaction reste dans le journal
+ * jusqu'à ce qu'un fdatasync ultérieur les rende durables. Le verrou du
+ * journal est gardé pendant l'écriture des nœuds, pour qu'un bloc libéré
+ * entre-temps ne soit pas réutilisé avant.
+ * 
+ * @param journal Le journal.
+ * @param buffer La transaction.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+static int checkpointTransaction(Journal* journal, const char* buffer) {
+    Partition* partition = journal->partition;
+    JournalTransactionHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    int status = 0;
+    size_t offset = sizeof(header);
+    for (uint32_t r = 0; r < header.num_records; ++r) {
+        JournalRecord record;
+        memcpy(&record, buffer + offset, sizeof(record));
+        if (record.type == JOURNAL_METADATA
+            && partitionWrite(partition, buffer + offset + sizeof(record), record.length, (off_t)record.target) == -1) {
+            status = -1;
+        }
+        offset += sizeof(record) + record.length;
+    }
+
+    pthread_mutex_lock(&journal->lock);
+    JournalTransaction* committing = &journal->committing;
+    for (int i = 0; i < committing->num_blocks; ++i) {
+        JournalBlock* image = committing->blocks[i];
+        if (!image->revoked && partitionWrite(partition, image->data, JOURNAL_IMAGE_SIZE, dataBlockOffset(partition, image->block)) == -1) {
+            status = -1;
+        }
+    }
+    clearTransaction(committing);
+    pthread_mutex_unlock(&journal->lock);
+
+    if (status == -1) {
+        perror("Erreur lors de l'écriture des métadonnées à leur place");
+    }
+    return status;
+}
+
+/**
+ * @brief Constitue la transaction en cours et la rend durable (commit_lock et handles en écriture pris).
+ * @param journal Le journal.
+ * @param keep_handles 0 pour libérer handles dès la transaction constituée, 1 pour le garder.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int writeRunning(Journal* journal, int keep_handles) {
+    pthread_mutex_lock(&journal->lock);
+    int empty = journal->dirty_chunks == 0 && journal->running.num_blocks == 0 && journal->running.num_revokes == 0;
+    size_t length;
+    char* buffer = buildTransaction(journal, &length);
+    unsigned long snapshot = ++journal->snapshots;
+    int status = (buffer == NULL && !empty) ? -1 : 0;
+    pthread_mutex_unlock(&journal->lock);
+    if (!keep_handles) {
+        pthread_rwlock_unlock(&journal->handles);
+    }
+
+    if (buffer != NULL) {
+        status = appendTransaction(journal, buffer, length);
+        if (status == 0) {
+            status = checkpointTransaction(journal, buffer);
+        } else {
+            requeueTransaction(journal, buffer);
+        }
+        free(buffer);
+    } else if (status == 0) {
+        // Rien à journaliser : rendre durables les données écrites par l'appelant
+        status = fdatasync(journal->partition->fileDescriptor);
+        pthread_mutex_lock(&journal->lock);
+        journal->stats.syncs++;
+        pthread_mutex_unlock(&journal->lock);
+        statsAdd(&journal->partition->stats, STATS_SYSCALLS, 1);
+        if (status == -1) {
+            perror("Erreur lors de la synchronisation de la partition");
+        }
+    }
+
+    if (status == 0) {
+        journal->completed = snapshot;
+    }
+    return status;
+}
+
+/**
+ * @brief Fonction pour rendre durables toutes les opérations terminées.
+ * @param journal Le journal.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int journalCommit(Journal* journal) {
+    // Toute transaction constituée après cet instant contient les opérations de l'appelant
+    pthread_mutex_lock(&journal->lock);
+    journal->stats.commit_requests++;
+    unsigned long target = journal->snapshots + 1;
+    pthread_mutex_unlock(&journal->lock);
+
+    pthread_mutex_lock(&journal->commit_lock);
+    if (journal->completed >= target) {
+        pthread_mutex_unlock(&journal->commit_lock);
+        return 0; // Écrite par un autre thread pendant l'attente
+    }
+
+    pthread_rwlock_wrlock(&journal->handles);
+    int status = writeRunning(journal, 0);
+    pthread_mutex_unlock(&journal->commit_lock);
+    return status;
+}
+
+/**
+ * @brief Fonction pour rendre durables les modifications d'une opération commencée par journalStartExclusive, sans la terminer.
+ * @param journal Le journal.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int journalCommitExclusive(Journal* journal) {
+    pthread_mutex_lock(&journal->lock);
+    journal->stats.commit_requests++;
+    pthread_mutex_unlock(&journal->lock);
+    return writeRunning(journal, 1);
+}
+
+/**
+ * @brief Fonction pour vider le journal après avoir rendu durables les métadonnées écrites à leur place.
+ * @param journal Le journal.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int journalCheckpoint(Journal* journal) {
+    pthread_mutex_lock(&journal->commit_lock);
+    pthread_mutex_lock(&journal->lock);
+    uint32_t sequence = journal->running.sequence;
+    pthread_mutex_unlock(&journal->lock);
+
+    int status = writeHeader(journal->partition->fileDescriptor, journal->start, sequence);
+    if (status == 0) {
+        journal->head = 0;
+        journal->used = 0;
+        pthread_mutex_lock(&journal->lock);
+        journal->stats.syncs += 2;
+        pthread_mutex_unlock(&journal->lock);
+    }
+    pthread_mutex_unlock(&journal->commit_lock);
+    return status;
+}
+
+/**
+ * @brief Fonction pour obtenir les compteurs d'activité du journal.
+ * @param journal Le journal.
+ * @param stats Les compteurs à remplir.
+ */
+void journalGetStats(Journal* journal, JournalStats* stats) {
+    pthread_mutex_lock(&journal->lock);
+    *stats = journal->stats;
+    pthread_mutex_unlock(&journal->lock);
+}
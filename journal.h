@@ -0,0 +1,413 @@
+/**
+ * @file journal.h
+ * @brief Ce fichier contient les déclarations du journal des métadonnées, écrit avant leur emplacement définitif.
+ */
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+struct Partition;
+
+/**
+ * @def JOURNAL_BLOCK_SIZE
+ * @brief Taille d'un bloc du journal, indépendante de la taille des blocs de la partition.
+ */
+#define JOURNAL_BLOCK_SIZE 512
+
+/**
+ * @def JOURNAL_IMAGE_SIZE
+ * @brief Taille de l'image journalisée d'un nœud d'arbre, rangé au début de son bloc de données.
+ */
+#define JOURNAL_IMAGE_SIZE 512
+
+/**
+ * @def JOURNAL_BLOCKS
+ * @brief Nombre minimal de blocs du journal, en-tête compris.
+ */
+#define JOURNAL_BLOCKS 64
+
+/**
+ * @def JOURNAL_MAX_BLOCKS
+ * @brief Nombre maximal de blocs du journal choisi au formatage.
+ */
+#define JOURNAL_MAX_BLOCKS 65536
+
+/**
+ * @def JOURNAL_BLOCKS_RATIO
+ * @brief Nombre de blocs de données de la partition par bloc du journal choisi au formatage, entre JOURNAL_BLOCKS et JOURNAL_MAX_BLOCKS.
+ */
+#define JOURNAL_BLOCKS_RATIO 256
+
+/**
+ * @def JOURNAL_MAGIC
+ * @brief Nombre magique de l'en-tête du journal et de chaque transaction ("JRNL").
+ */
+#define JOURNAL_MAGIC 0x4C4E524A
+
+/**
+ * @def JOURNAL_COMMIT_MAGIC
+ * @brief Nombre magique de l'enregistrement qui termine une transaction ("JCMT").
+ */
+#define JOURNAL_COMMIT_MAGIC 0x544D434A
+
+/**
+ * @def JOURNAL_CHUNK
+ * @brief Granularité, en octets, du suivi des métadonnées modifiées.
+ */
+#define JOURNAL_CHUNK 64
+
+/**
+ * @def JOURNAL_DIRTY_INITIAL
+ * @brief Nombre de cases de l'ensemble des morceaux modifiés après chaque transaction (puissance de 2) ; il double lorsqu'il est à moitié plein.
+ */
+#define JOURNAL_DIRTY_INITIAL 256
+
+/**
+ * @def JOURNAL_METADATA
+ * @brief Enregistrement contenant une suite d'octets de métadonnées projetées, repérée par sa position dans la partition.
+ */
+#define JOURNAL_METADATA 1
+
+/**
+ * @def JOURNAL_BLOCK
+ * @brief Enregistrement contenant l'image d'un bloc de données (nœud de l'arbre d'extents).
+ */
+#define JOURNAL_BLOCK 2
+
+/**
+ * @def JOURNAL_REVOKE
+ * @brief Enregistrement annulant les images d'un bloc de données libéré journalisées auparavant.
+ */
+#define JOURNAL_REVOKE 3
+
+/**
+ * @struct JournalHeader
+ * @brief En-tête stocké dans le premier bloc du journal : début de la partie à rejouer.
+ */
+typedef struct {
+    uint32_t magic; /**< Nombre magique (JOURNAL_MAGIC). */
+    uint32_t sequence; /**< Numéro de la première transaction à rejouer. */
+    uint32_t tail; /**< Bloc du journal (après l'en-tête) où commence cette transaction. */
+    uint32_t reserved; /**< Réservé. */
+} JournalHeader;
+
+/**
+ * @struct JournalTransactionHeader
+ * @brief Début d'une transaction dans le journal, suivi de ses enregistrements.
+ */
+typedef struct {
+    uint32_t magic; /**< Nombre magique (JOURNAL_MAGIC). */
+    uint32_t sequence; /**< Numéro de la transaction, consécutif à celui de la précédente. */
+    uint32_t num_records; /**< Nombre d'enregistrements. */
+    uint32_t length; /**< Taille en octets de l'en-tête et des enregistrements, sans la fin de transaction. */
+} JournalTransactionHeader;
+
+/**
+ * @struct JournalRecord
+ * @brief Enregistrement d'une transaction, suivi de length octets de données.
+ */
+typedef struct {
+    uint32_t type; /**< JOURNAL_METADATA, JOURNAL_BLOCK ou JOURNAL_REVOKE. */
+    uint32_t length; /**< Nombre d'octets de données qui suivent. */
+    uint64_t target; /**< Position dans la partition (JOURNAL_METADATA) ou bloc de données (JOURNAL_BLOCK, JOURNAL_REVOKE). */
+} JournalRecord;
+
+/**
+ * @struct JournalCommit
+ * @brief Fin d'une transaction : une transaction n'est rejouée que si sa fin est présente et son empreinte correcte.
+ */
+typedef struct {
+    uint32_t magic; /**< Nombre magique (JOURNAL_COMMIT_MAGIC). */
+    uint32_t sequence; /**< Numéro de la transaction. */
+    uint32_t checksum; /**< Empreinte de l'en-tête et des enregistrements. */
+    uint32_t reserved; /**< Réservé. */
+} JournalCommit;
+
+/**
+ * @struct JournalBlock
+ * @brief Image d'un nœud de l'arbre d'extents en attente d'écriture à sa place.
+ */
+typedef struct {
+    uint64_t block; /**< Bloc de données du nœud. */
+    int revoked; /**< 1 si le bloc a été libéré depuis : l'image ne doit plus être écrite. */
+    char data[]; /**< Début du bloc contenant le nœud (JOURNAL_IMAGE_SIZE octets). */
+} JournalBlock;
+
+/**
+ * @struct JournalTransaction
+ * @brief Nœuds et blocs libérés d'une transaction, en plus des métadonnées modifiées.
+ */
+typedef struct {
+    uint32_t sequence; /**< Numéro de la transaction. */
+    JournalBlock** blocks; /**< Images des nœuds modifiés, une seule par bloc. */
+    int num_blocks; /**< Nombre d'images. */
+    int block_capacity; /**< Taille allouée du tableau blocks. */
+    uint64_t* revokes; /**< Blocs de nœuds libérés. */
+    int num_revokes; /**< Nombre de blocs libérés. */
+    int revoke_capacity; /**< Taille allouée du tableau revokes. */
+} JournalTransaction;
+
+/**
+ * @struct JournalStats
+ * @brief Compteurs d'activité du journal.
+ */
+typedef struct {
+    unsigned long commit_requests; /**< Appels à journalCommit. */
+    unsigned long transactions; /**< Transactions écrites dans le journal. */
+    unsigned long records; /**< Enregistrements écrits. */
+    unsigned long bytes; /**< Octets écrits dans le journal, en-têtes compris. */
+    unsigned long syncs; /**< Appels à fdatasync. */
+    unsigned long resets; /**< Remises à zéro du journal devenu plein. */
+} JournalStats;
+
+/**
+ * @struct Journal
+ * @brief Journal des métadonnées d'une partition, écrit avant leur emplacement définitif.
+ * 
+ * Les métadonnées sont projetées en mémoire de façon privée : leurs
+ * modifications n'atteignent la partition qu'à travers le journal. Chaque
+ * opération qui les modifie est encadrée par journalStart et journalStop et
+ * signale les octets modifiés avec journalDirty. journalCommit copie les
+ * modifications de toutes les opérations terminées dans une transaction,
+ * l'ajoute au journal circulaire en une seule écriture suivie d'un seul
+ * fdatasync, puis écrit les métadonnées à leur place. Les appels concurrents
+ * à journalCommit sont regroupés : ceux qui arrivent pendant une écriture
+ * sont servis ensemble par la suivante.
+ */
+typedef struct Journal {
+    struct Partition* partition; /**< Partition dont le journal protège les métadonnées. */
+    off_t start; /**< Position dans la partition de l'en-tête du journal. */
+    uint32_t log_blocks; /**< Nombre de blocs du journal après l'en-tête. */
+    uint32_t head; /**< Bloc du journal où sera écrite la prochaine transaction. */
+    uint32_t used; /**< Blocs du journal à conserver, depuis le début de la partie à rejouer. */
+    uint64_t* dirty; /**< Ensemble (table à adressage ouvert) des morceaux de JOURNAL_CHUNK octets modifiés depuis la dernière transaction : rang du morceau dans la partition plus un, 0 pour une case vide. */
+    size_t dirty_capacity; /**< Nombre de cases de dirty (puissance de 2). */
+    size_t dirty_chunks; /**< Nombre de morceaux dans dirty. */
+    int full; /**< 1 si la transaction en cours occupe plus du quart du journal : journalStop l'écrit. */
+    JournalTransaction running; /**< Transaction en cours, qui reçoit les modifications. */
+    JournalTransaction committing; /**< Transaction en cours d'écriture, dont les nœuds ne sont pas encore à leur place. */
+    unsigned long snapshots; /**< Nombre de transactions constituées (vides comprises). */
+    unsigned long completed; /**< Numéro de la dernière transaction constituée devenue durable. */
+    pthread_rwlock_t handles; /**< Pris en lecture par chaque opération, en écriture pour constituer une transaction. */
+    pthread_mutex_t lock; /**< Protège dirty, les transactions et les compteurs. */
+    pthread_mutex_t commit_lock; /**< Sérialise les écritures de transactions. */
+    JournalStats stats; /**< Compteurs d'activité. */
+} Journal;
+
+/**
+ * @brief Fonction pour rejouer le journal d'une partition avant la projection de ses métadonnées.
+ * 
+ * Les transactions complètes sont appliquées dans l'ordre de leurs numéros,
+ * à partir de celle désignée par l'en-tête ; la première transaction
+ * incomplète ou invalide termine le journal. Les images d'un bloc libéré
+ * par une transaction ultérieure ne sont pas appliquées. Le journal est
+ * ensuite vidé.
+ * 
+ * @param fd Le descripteur de la partition.
+ * @param start La position de l'en-tête du journal dans la partition.
+ * @param blocks Le nombre de blocs du journal, en-tête compris.
+ * @param data_start La position de la zone de données dans la partition.
+ * @param block_size La taille des blocs de données de la partition.
+ * @param sequence Reçoit le numéro de la prochaine transaction.
+ * @return Le nombre de transactions rejouées, -1 en cas d'erreur.
+ */
+int journalRecover(int fd, off_t start, uint32_t blocks, off_t data_start, uint32_t block_size, uint32_t* sequence);
+
+/**
+ * @brief Fonction pour écrire l'en-tête d'un journal vide lors du formatage.
+ * 
+ * @param fd Le descripteur de la partition.
+ * @param start La position de l'en-tête du journal dans la partition.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int journalFormat(int fd, off_t start);
+
+/**
+ * @brief Fonction pour initialiser le journal d'une partition montée.
+ * 
+ * @param journal Le journal à initialiser.
+ * @param partition La partition, dont les métadonnées sont projetées.
+ * @param start La position de l'en-tête du journal dans la partition.
+ * @param blocks Le nombre de blocs du journal, en-tête compris.
+ * @param sequence Le numéro de la prochaine transaction, renvoyé par journalRecover.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int journalInit(Journal* journal, struct Partition* partition, off_t start, uint32_t blocks, uint32_t sequence);
+
+/**
+ * @brief Fonction pour libérer le journal, sans rien écrire.
+ * 
+ * @param journal Le journal.
+ */
+void journalDestroy(Journal* journal);
+
+/**
+ * @brief Fonction pour commencer une opération qui modifie les métadonnées.
+ * 
+ * Doit être appelée avant de prendre le moindre autre verrou de la
+ * partition : une transaction n'est constituée qu'entre deux opérations.
+ * 
+ * @param journal Le journal.
+ */
+void journalStart(Journal* journal);
+
+/**
+ * @brief Fonction pour commencer une opération qui s'exécute seule.
+ * 
+ * Attend la fin des opérations en cours et des écritures de transactions,
+ * et empêche d'en commencer de nouvelles jusqu'à journalStopExclusive :
+ * l'opération voit des métadonnées qui ne changent pas sous elle, et peut
+ * rendre durables ses modifications par journalCommitExclusive lorsqu'elles
+ * ne tiennent pas dans une seule transaction. Les lectures de fichiers
+ * continuent. Doit être appelée avant de prendre le moindre autre verrou de
+ * la partition.
+ * 
+ * @param journal Le journal.
+ */
+void journalStartExclusive(Journal* journal);
+
+/**
+ * @brief Fonction pour rendre durables les modifications d'une opération commencée par journalStartExclusive, sans la terminer.
+ * 
+ * La transaction en cours est écrite dans le journal puis à sa place,
+ * comme par journalCommit ; l'opération continue dans une nouvelle
+ * transaction. Seul le thread de l'opération peut l'appeler.
+ * 
+ * @param journal Le journal.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int journalCommitExclusive(Journal* journal);
+
+/**
+ * @brief Fonction pour terminer une opération commencée par journalStartExclusive.
+ * 
+ * Aucun verrou de la partition ne doit être pris. La transaction en cours
+ * est écrite si elle occupe une part trop importante du journal.
+ * 
+ * @param journal Le journal.
+ */
+void journalStopExclusive(Journal* journal);
+
+/**
+ * @brief Fonction pour connaître la place que la transaction en cours peut encore occuper dans le journal.
+ * 
+ * Une transaction plus grande que le journal ne pourrait pas être écrite :
+ * une opération qui modifie beaucoup de métadonnées compare d'abord leur
+ * taille à cette place.
+ * 
+ * @param journal Le journal.
+ * @return Le nombre d'octets, 0 si la transaction remplit déjà le journal.
+ */
+size_t journalRoom(Journal* journal);
+
+/**
+ * @brief Fonction pour terminer une opération commencée par journalStart.
+ * 
+ * Aucun verrou de la partition ne doit être pris. La transaction en cours
+ * est écrite si elle occupe une part trop importante du journal.
+ * 
+ * @param journal Le journal.
+ */
+void journalStop(Journal* journal);
+
+/**
+ * @brief Fonction pour attendre la fin des opérations en cours et empêcher d'en commencer de nouvelles.
+ * 
+ * Les métadonnées ne changent plus jusqu'à journalThaw : elles peuvent être
+ * parcourues par plusieurs threads sans autre verrou, pendant que les
+ * lectures de fichiers continuent. L'appelant ne doit pas avoir commencé
+ * d'opération, ni en commencer une, ni appeler journalCommit avant
+ * journalThaw.
+ * 
+ * @param journal Le journal.
+ */
+void journalFreeze(Journal* journal);
+
+/**
+ * @brief Fonction pour autoriser de nouveau les opérations arrêtées par journalFreeze.
+ * 
+ * @param journal Le journal.
+ */
+void journalThaw(Journal* journal);
+
+/**
+ * @brief Fonction pour signaler la modification d'octets de la zone de métadonnées.
+ * 
+ * @param journal Le journal.
+ * @param address L'adresse des octets modifiés dans la projection de la partition.
+ * @param length Le nombre d'octets modifiés.
+ */
+void journalDirty(Journal* journal, const void* address, size_t length);
+
+/**
+ * @brief Fonction pour journaliser le nouveau contenu d'un nœud de l'arbre d'extents.
+ * 
+ * Le nœud n'est écrit à sa place qu'après l'écriture de sa transaction dans
+ * le journal ; d'ici là, journalReadBlock en renvoie le contenu.
+ * 
+ * @param journal Le journal.
+ * @param block Le bloc de données du nœud.
+ * @param data Le nœud (JOURNAL_IMAGE_SIZE octets).
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int journalLogBlock(Journal* journal, uint64_t block, const void* data);
+
+/**
+ * @brief Fonction pour lire un nœud journalisé qui n'est pas encore à sa place.
+ * 
+ * @param journal Le journal.
+ * @param block Le bloc de données du nœud.
+ * @param data Reçoit le nœud (JOURNAL_IMAGE_SIZE octets).
+ * @return 1 si le bloc a été trouvé dans le journal, 0 sinon.
+ */
+int journalReadBlock(Journal* journal, uint64_t block, void* data);
+
+/**
+ * @brief Fonction pour signaler la libération d'un bloc dont le contenu a pu être journalisé.
+ * 
+ * Les images du bloc plus anciennes ne sont plus écrites à sa place, ni
+ * rejouées au montage : le bloc peut être réutilisé pour des données.
+ * 
+ * @param journal Le journal.
+ * @param block Le bloc de données libéré.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+int journalRevokeBlock(Journal* journal, uint64_t block);
+
+/**
+ * @brief Fonction pour rendre durables toutes les opérations terminées.
+ * 
+ * Un seul thread écrit à la fois ; les autres attendent et repartent sans
+ * rien écrire si la transaction écrite pendant leur attente contient déjà
+ * leurs opérations. Une transaction vide n'est pas écrite, mais fdatasync
+ * est toujours appelé pour les données écrites auparavant.
+ * 
+ * @param journal Le journal.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int journalCommit(Journal* journal);
+
+/**
+ * @brief Fonction pour vider le journal après avoir rendu durables les métadonnées écrites à leur place.
+ * 
+ * Utilisée au démontage, après journalCommit : le prochain montage n'a rien à rejouer.
+ * 
+ * @param journal Le journal.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int journalCheckpoint(Journal* journal);
+
+/**
+ * @brief Fonction pour obtenir les compteurs d'activité du journal.
+ * 
+ * @param journal Le journal.
+ * @param stats Les compteurs à remplir.
+ */
+void journalGetStats(Journal* journal, JournalStats* stats);
+
+#endif /* JOURNAL_H_ */
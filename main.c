@@ -0,0 +1,486 @@
+/**
+ * @file main.c
+ * @brief Ce fichier contient le programme interactif de gestion de la partition.
+ */
+
+#include "projet.h"
+#include "replay.h"
+#include "fsck.h"
+
+/**
+ * @def REPLAY_PARTITION
+ * @brief Nom de la partition temporaire utilisée par le rejeu d'une trace sans --partition.
+ */
+#define REPLAY_PARTITION "replay_partition"
+
+/**
+ * @brief Fonction pour afficher l'aide.
+ * @author Boyan
+ */
+void printHelp() {
+    printf("Utilisation :\n");
+    printf("Choix 1 : Ouvre un fichier texte existant. : <nom_fichier.txt>\n");
+    printf("Choix 2 : Ecrit des données dans un fichier texte spécifié. : <nom_fichier.txt> <donnees>\n");
+    printf("Choix 3 : Lit les données depuis un fichier texte existant. : <nom_fichier.txt>\n");
+    printf("Choix 4 : Supprime le fichier ou le répertoire vide voulu\n");
+    printf("Choix 5 : Affiche les fichiers existants d'un répertoire (/ pour la racine), les répertoires terminés par /\n");
+    printf("Choix 7 : Affiche les compteurs d'activité et les latences des fonctions de la partition\n");
+    printf("Choix 8 : Crée un répertoire : <repertoire/sous_repertoire>\n");
+    printf("Choix c : Clone un fichier sans copier ses blocs : <source> <copie>\n");
+    printf("Choix s : Prend un instantané en lecture seule de toute la partition : <repertoire>\n");
+    printf("Choix d : Fusionne les blocs de données identiques de tous les fichiers\n");
+    printf("Les noms de fichiers sont des chemins depuis la racine, par exemple docs/notes.txt\n");
+    printf("Sans menu : projet --replay <trace> [--timed] [--partition <nom>] [--csv <fichier>] [--blocks <n>] [--inodes <n>] [--block-size <octets>] [--compression <codec>] [--dedup] rejoue une trace d'opérations\n");
+    printf("Sans menu : projet --check <partition> [--repair] [--scrub] [--threads <n>] vérifie la cohérence d'une partition\n");
+}
+
+/**
+ * @brief Fonction pour supprimer un fichier.
+ * @param partition La partition.
+ * @author Boyan
+ */
+void deleteFile(Partition* partition) {
+    // Affichage de la liste des fichiers du répertoire choisi
+    char repertoire[100];
+    printf("Entrez le répertoire du fichier (/ pour la racine) : ");
+    scanf(" %[^\n]", repertoire);
+    char** files = listDirectory(partition, repertoire);
+    if (files == NULL) {
+        printf("Erreur lors de la récupération des noms de fichiers.\n");
+        return;
+    }
+    printf("Liste des fichiers :\n");
+    for (int i = 0; files[i] != NULL; ++i) {
+        printf("%d. %s\n", i + 1, files[i]);
+    }
+
+    // Demande à l'utilisateur de choisir le numéro du fichier à supprimer
+    int choix;
+    printf("Entrez le numéro du fichier à supprimer : ");
+    scanf("%d", &choix);
+
+    // Vérification de la validité du choix
+    if (choix < 1 || choix > numFiles(files)) {
+        printf("Numéro de fichier invalide.\n");
+        for (int i = 0; files[i] != NULL; ++i) {
+            free(files[i]);
+        }
+        free(files);
+        return;
+    }
+
+    // Suppression du fichier correspondant au choix de l'utilisateur
+    char fileName[256];
+    snprintf(fileName, sizeof(fileName), "%s/%s", repertoire, files[choix - 1]);
+    if (deleteFileFromPartition(partition, fileName) == 0) {
+        printf("Le fichier '%s' a été supprimé avec succès.\n", fileName);
+    }
+
+    // Libération de la mémoire allouée pour la liste des fichiers
+    for (int i = 0; files[i] != NULL; ++i) {
+        free(files[i]);
+    }
+    free(files);
+}
+
+/**
+ * @brief Fonction pour afficher les compteurs d'activité de la partition.
+ * 
+ * Les latences sont celles des appels chronométrés (un sur
+ * STATS_SAMPLE_PERIOD) ; les centiles sont les bornes supérieures des cases
+ * de l'histogramme qui les contiennent.
+ * 
+ * @param partition La partition.
+ */
+void printStats(Partition* partition) {
+    Stats stats;
+    if (myStats(partition, &stats) == -1) {
+        printf("Erreur lors de la lecture des compteurs.\n");
+        return;
+    }
+
+    printf("%-24s %10s %8s %12s %12s %12s %12s\n", "fonction", "appels", "erreurs", "octets",
+           "moyenne (us)", "p50 <= (us)", "p99 <= (us)");
+    for (int op = 0; op < STATS_NUM_OPS; ++op) {
+        OpStats* counters = &stats.ops[op];
+        double average = counters->timed > 0 ? counters->nanoseconds / 1000.0 / counters->timed : 0;
+        printf("%-24s %10lu %8lu %12lu %12.2f %12.2f %12.2f\n", statsOpName(op), counters->calls,
+               counters->errors, counters->bytes, average,
+               statsPercentile(counters, 500) / 1000.0, statsPercentile(counters, 990) / 1000.0);
+    }
+    for (int c = 0; c < STATS_NUM_COUNTERS; ++c) {
+        printf("%s : %lu\n", statsCounterName(c), stats.counters[c]);
+    }
+}
+
+/**
+ * @brief Fonction pour rejouer une trace passée en ligne de commande.
+ * 
+ * Options : --replay suivi du chemin de la trace (- pour l'entrée
+ * standard), --timed pour respecter les instants enregistrés, --partition
+ * suivi du nom d'une partition à utiliser (montée, ou formatée si elle
+ * n'existe pas, puis conservée) et --csv suivi du chemin du fichier de
+ * résultats. Sans --partition, une partition temporaire est formatée puis
+ * supprimée. --blocks et --inodes donnent le nombre de blocs de données et
+ * d'inodes d'une partition formatée par le rejeu, --block-size la taille de
+ * ses blocs et --compression le codec de ses fichiers (none ou lz4).
+ * --dedup active la déduplication des écritures pendant le rejeu.
+ * 
+ * @param argc Le nombre d'arguments.
+ * @param argv Les arguments.
+ * @return 0 si le rejeu s'exécute avec succès, 1 en cas d'erreur.
+ */
+static int runReplay(int argc, char** argv) {
+    char* trace_path = NULL;
+    char* partition_name = NULL;
+    char* csv_path = NULL;
+    int timed = 0;
+    int dedup = 0;
+    FormatOptions options = { 0, DEFAULT_NUM_BLOCKS, DEFAULT_NUM_INODES, DEFAULT_BLOCK_SIZE, CODEC_NONE };
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--partition") == 0 && i + 1 < argc) {
+            partition_name = argv[++i];
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--blocks") == 0 && i + 1 < argc) {
+            options.num_blocks = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--inodes") == 0 && i + 1 < argc) {
+            options.num_inodes = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--block-size") == 0 && i + 1 < argc) {
+            options.block_size = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--compression") == 0 && i + 1 < argc && codecFind(argv[i + 1]) != -1) {
+            options.compression = (uint32_t)codecFind(argv[++i]);
+        } else if (strcmp(argv[i], "--timed") == 0) {
+            timed = 1;
+        } else if (strcmp(argv[i], "--dedup") == 0) {
+            dedup = 1;
+        } else {
+            trace_path = NULL;
+            break;
+        }
+    }
+    if (trace_path == NULL) {
+        printf("Usage : %s [--replay trace|- [--timed] [--partition nom] [--csv fichier] [--blocks n] [--inodes n] [--block-size octets] [--compression none|lz4] [--dedup]]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* trace = strcmp(trace_path, "-") == 0 ? stdin : fopen(trace_path, "r");
+    if (trace == NULL) {
+        perror("Erreur lors de l'ouverture de la trace");
+        return 1;
+    }
+    Partition* partition = NULL;
+    if (partition_name != NULL) {
+        partition = myMount(partition_name);
+        if (partition == NULL) {
+            partition = myFormatWith(partition_name, &options);
+        }
+    } else {
+        partition = myFormatWith(REPLAY_PARTITION, &options);
+    }
+    if (partition == NULL) {
+        printf("Erreur lors de la préparation de la partition.\n");
+        if (trace != stdin) {
+            fclose(trace);
+        }
+        return 1;
+    }
+
+    int status = dedup && myDedupSetup(partition, 1) == -1 ? 1 : 0;
+    if (status == 0 && replayTrace(partition, trace, timed, csv_path) != 0) {
+        status = 1;
+    }
+    if (trace != stdin) {
+        fclose(trace);
+    }
+    if (partition_name != NULL) {
+        if (myUnmount(partition) == -1) {
+            status = 1;
+        }
+    } else {
+        deletePartition(partition, REPLAY_PARTITION);
+    }
+    return status;
+}
+
+/**
+ * @brief Fonction pour vérifier une partition passée en ligne de commande.
+ * 
+ * Options : --check suivi du nom de la partition, --repair pour réparer les
+ * problèmes qui peuvent l'être, --scrub pour relire les blocs de données et
+ * les comparer à leur code de contrôle, et --threads suivi du nombre de
+ * threads (un par processeur par défaut). Affiche le nombre de problèmes
+ * trouvés et réparés de chaque sorte, puis le débit de la vérification.
+ * 
+ * @param argc Le nombre d'arguments.
+ * @param argv Les arguments.
+ * @return 0 si la partition est cohérente ou a été réparée, 1 sinon.
+ */
+static int runCheck(int argc, char** argv) {
+    char* partition_name = NULL;
+    FsckOptions options = { 0, 0, 0 };
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+            partition_name = argv[++i];
+        } else if (strcmp(argv[i], "--repair") == 0) {
+            options.repair = 1;
+        } else if (strcmp(argv[i], "--scrub") == 0) {
+            options.scrub = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = atoi(argv[++i]);
+        } else {
+            partition_name = NULL;
+            break;
+        }
+    }
+    if (partition_name == NULL) {
+        printf("Usage : %s --check partition [--repair] [--scrub] [--threads n]\n", argv[0]);
+        return 1;
+    }
+    Partition* partition = myMount(partition_name);
+    if (partition == NULL) {
+        printf("Erreur lors du montage de la partition.\n");
+        return 1;
+    }
+
+    FsckReport report;
+    int result = fsckPartition(partition, &options, &report);
+    int status = result == 0 ? 0 : 1;
+    if (result != -1) {
+        for (int k = 0; k < FSCK_NUM_PROBLEMS; ++k) {
+            if (report.problems[k] > 0) {
+                printf("%-36s : %llu trouvés, %llu réparés\n", fsckProblemName(k),
+                       (unsigned long long)report.problems[k], (unsigned long long)report.repaired[k]);
+            }
+        }
+        double seconds = report.nanoseconds / 1e9;
+        printf("%llu inodes (%llu répertoires, %llu entrées) et %llu blocs vérifiés en %.3f s avec %d threads\n",
+               (unsigned long long)report.inodes, (unsigned long long)report.directories, (unsigned long long)report.entries,
+               (unsigned long long)report.blocks, seconds, report.threads);
+        if (seconds > 0) {
+            printf("%.0f inodes/s, %.0f blocs/s", report.inodes / seconds, report.blocks / seconds);
+            if (options.scrub) {
+                printf(", %llu blocs relus à %.1f Mo/s", (unsigned long long)report.scrubbed_blocks,
+                       report.scrubbed_bytes / seconds / (1024 * 1024));
+            }
+            printf("\n");
+        }
+        printf(status == 0 ? "La partition est cohérente.\n" : "La partition n'est pas cohérente.\n");
+    }
+    if (myUnmount(partition) == -1) {
+        status = 1;
+    }
+    return status;
+}
+
+/**
+ * @brief Fonction principale du programme.
+ * 
+ * Sans argument, affiche le menu interactif ; avec --replay, rejoue une
+ * trace d'opérations sans interaction (voir runReplay) ; avec --check,
+ * vérifie une partition (voir runCheck).
+ * 
+ * @param argc Le nombre d'arguments.
+ * @param argv Les arguments.
+ * @return 0 si le programme s'exécute avec succès, 1 en cas d'erreur.
+ * @author Boyan & Lauriane
+ */
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        return runCheck(argc, argv);
+    }
+    if (argc > 1) {
+        return runReplay(argc, argv);
+    }
+
+    char* nom_partition = "ma_partition";
+    // Reprendre la partition existante, ou en formater une nouvelle
+    Partition* partition = myMount(nom_partition);
+    if (partition == NULL) {
+        partition = myFormat(nom_partition);
+    }
+    if (partition == NULL) {
+        printf("Erreur lors du formatage de la partition.\n");
+        return 1;
+    }
+    char choix;
+
+    // Affichage du menu tant que l'utilisateur ne choisit pas de quitter
+    do {
+	printf("\nMenu :\n");
+        printf("1. Ouvrir un fichier \n");
+        printf("2. Ecrire dans un fichier \n");
+        printf("3. Lire depuis un fichier \n");
+        printf("4. Supprime le fichier choisi\n");
+        printf("5. Afficher les fichiers existants \n");
+        printf("6. Afficher l'aide\n");
+        printf("7. Afficher les statistiques\n");
+        printf("8. Créer un répertoire\n");
+        printf("c. Cloner un fichier\n");
+        printf("s. Prendre un instantané\n");
+        printf("d. Dédupliquer les blocs de données\n");
+        printf("9. Quitter\n");
+        printf("Entrez votre choix : ");
+
+        // Lecture du choix de l'utilisateur : premier caractère de la ligne, fin de l'entrée pour quitter
+        char ligne_choix[100];
+        choix = scanf(" %99[^\n]", ligne_choix) == 1 ? ligne_choix[0] : '9';
+
+        // Traitement du choix de l'utilisateur
+        switch (choix) {
+	    case '1':
+                // Appel à la fonction myOpen avec le nom du fichier
+                char nom_fichier[100];
+                printf("Entrez le nom du fichier à ouvrir : ");
+                scanf("%s", nom_fichier);
+                file* monFichier = myOpen(partition, nom_fichier);
+                if (monFichier == NULL) {
+                    printf("Erreur lors de l'ouverture du fichier.\n");
+                } else {
+                    printf("Fichier '%s' ouvert avec succès.\n", nom_fichier);
+                }
+                break;
+                
+            case '2':
+                // Appel à la fonction myWrite avec le nom du fichier et les données
+                char nom_fichier_ecriture[100];
+                char donnees_ecriture[1000];
+                
+                printf("Entrez le nom du fichier : ");
+		scanf(" %[^\n]", nom_fichier_ecriture); // Lire jusqu'au saut de ligne
+		
+		printf("Entrez les données à écrire : ");
+		scanf(" %[^\n]", donnees_ecriture); // Lire jusqu'au saut de ligne
+
+                file* fichier_ecriture = myOpen(partition, nom_fichier_ecriture);
+                if (fichier_ecriture == NULL) {
+                    printf("Erreur lors de l'ouverture du fichier.\n");
+                    return ERROR_FILE_OPEN;
+                } else {
+                    int64_t bytes_ecrits = myWrite(fichier_ecriture, donnees_ecriture, strlen(donnees_ecriture));
+                    if (bytes_ecrits == -1) {
+                        printf("Erreur lors de l'écriture dans le fichier.\n");
+                    } else {
+                        printf("Nombre total d'octets écrits : %lld\n", (long long)bytes_ecrits);
+                    }
+                }
+                break;
+                
+            case '3':
+                    // Appel à la fonction myReadView avec le nom du fichier
+    		char nom_fichier_lecture[100];
+    		printf("Entrez le nom du fichier : ");
+    		scanf(" %[^\n]", nom_fichier_lecture);
+    		file* fichier_lecture = myOpen(partition, nom_fichier_lecture);
+   		if (fichier_lecture == NULL) {
+        		printf("Erreur lors de l'ouverture du fichier.\n");
+   		} else {
+      			// Afficher le fichier depuis son début directement depuis la partition, sans le copier
+      			ReadView vue;
+      			int64_t bytes_lues = myReadView(fichier_lecture, 0, fichier_lecture->fileSize, &vue);
+        		if (bytes_lues == ERROR_CHECKSUM) {
+            			printf("Erreur : Le fichier contient un bloc corrompu.\n");
+        		} else if (bytes_lues < 0) {
+            			printf("Erreur lors de la lecture dans le fichier.\n");
+        		} else {
+            			printf("Données lues depuis le fichier :\n");
+            			for (int i = 0; i < vue.count; ++i) {
+                			fwrite(vue.spans[i].iov_base, 1, vue.spans[i].iov_len, stdout);
+            			}
+            			printf("\nNombre total d'octets lus : %lld\n", (long long)bytes_lues);
+        		}
+        		myReleaseView(&vue);
+    		}
+    		break;
+
+            case '4':
+            	//Appel à la fonction de suppression de fichier deleteFiles
+            	deleteFile(partition);	
+		break;
+
+            case '5':
+                // Appel à la fonction listDirectory avec le répertoire choisi
+                char nom_repertoire[100];
+                printf("Entrez le répertoire (/ pour la racine) : ");
+                scanf(" %[^\n]", nom_repertoire);
+    	        char** files = listDirectory(partition, nom_repertoire);
+	        if (files == NULL) {
+		    printf("Erreur lors de la récupération des noms de fichiers.\n");
+		    break;
+		}
+		    printf("Liste des fichiers :\n");
+		for (int i = 0; files[i] != NULL; ++i) {
+        		printf("%s\n", files[i]);
+        		free(files[i]);
+		}
+		free(files);
+            	break;
+            	
+            case '6':
+                // Affichage de l'aide
+                printHelp();
+                break;
+
+            case '7':
+                // Compteurs d'activité de la partition depuis son montage
+                printStats(partition);
+                break;
+
+            case '8':
+                // Appel à la fonction myMkdir avec le chemin du répertoire
+                char nom_nouveau_repertoire[100];
+                printf("Entrez le chemin du répertoire à créer : ");
+                scanf(" %[^\n]", nom_nouveau_repertoire);
+                if (myMkdir(partition, nom_nouveau_repertoire) == 0) {
+                    printf("Répertoire '%s' créé avec succès.\n", nom_nouveau_repertoire);
+                }
+                break;
+
+            case 'c':
+                // Appel à la fonction myClone avec les chemins de la source et de la copie
+                char nom_source[100], nom_copie[100];
+                printf("Entrez le chemin du fichier à cloner : ");
+                scanf(" %[^\n]", nom_source);
+                printf("Entrez le chemin de la copie : ");
+                scanf(" %[^\n]", nom_copie);
+                if (myClone(partition, nom_source, nom_copie) == 0) {
+                    printf("Fichier '%s' cloné dans '%s'.\n", nom_source, nom_copie);
+                }
+                break;
+
+            case 's':
+                // Appel à la fonction mySnapshot avec le chemin du nouveau répertoire
+                char nom_instantane[100];
+                printf("Entrez le chemin de l'instantané : ");
+                scanf(" %[^\n]", nom_instantane);
+                if (mySnapshot(partition, nom_instantane) == 0) {
+                    printf("Instantané '%s' pris avec succès.\n", nom_instantane);
+                }
+                break;
+
+            case 'd':
+                // Appel à la fonction myDedup, avec un thread par processeur
+                int64_t blocs_liberes = myDedup(partition, 0);
+                if (blocs_liberes != -1) {
+                    printf("%lld blocs de données libérés.\n", (long long)blocs_liberes);
+                }
+                break;
+
+            case '9':
+                // Sortie du programme  
+                printf("Au revoir !\n");
+                break;
+
+            default:
+                printf("Choix invalide. Veuillez réessayer.\n");
+                break;
+        }
+    } while (choix != '9');
+    
+    // La partition est conservée pour la prochaine exécution
+    myUnmount(partition);
+    
+    return 0;
+}
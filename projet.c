@@ -5,470 +5,5799 @@
 
 #include "projet.h"
 
+/**
+ * @brief Calcule le nombre de blocs nécessaires pour stocker un nombre d'octets.
+ * @param bytes Le nombre d'octets à stocker.
+ * @param block_size La taille d'un bloc.
+ * @return Le nombre de blocs de block_size octets nécessaires.
+ */
+static uint64_t blocksFor(uint64_t bytes, uint32_t block_size) {
+    return (bytes + block_size - 1) / block_size;
+}
+
+/**
+ * @brief Indique si une taille de bloc est acceptée.
+ * @param block_size La taille d'un bloc en octets.
+ * @return 1 si c'est une puissance de 2 entre MIN_BLOCK_SIZE et MAX_BLOCK_SIZE, 0 sinon.
+ */
+static int validBlockSize(uint32_t block_size) {
+    return block_size >= MIN_BLOCK_SIZE && block_size <= MAX_BLOCK_SIZE && (block_size & (block_size - 1)) == 0;
+}
+
+/**
+ * @brief Indique si un codec peut compresser les fichiers d'une partition.
+ * @param codec Le numéro du codec, CODEC_NONE pour aucune compression.
+ * @param block_size La taille d'un bloc en octets.
+ * @return 1 si le codec est CODEC_NONE, ou s'il existe et qu'un groupe compte au moins deux blocs ; 0 sinon.
+ */
+static int validCompression(uint32_t codec, uint32_t block_size) {
+    return codec == CODEC_NONE || (codecGet(codec) != NULL && block_size <= COMPRESS_CLUSTER_SIZE / 2);
+}
+
+/**
+ * @brief Nombre de mots de 64 bits de la table d'allocation.
+ * @param num_blocks Le nombre de blocs de données.
+ * @return Le nombre de mots nécessaires pour un bit par bloc.
+ */
+static uint64_t bitmapWords(uint64_t num_blocks) {
+    return (num_blocks + 63) / 64;
+}
+
+/**
+ * @brief Nombre de groupes d'inodes nécessaires pour les inodes 0 à num_inodes.
+ * @param num_inodes Le nombre maximal d'inodes.
+ * @return Le nombre de groupes.
+ */
+static uint32_t inodeChunks(uint32_t num_inodes) {
+    return num_inodes / INODES_PER_CHUNK + 1;
+}
+
+/**
+ * @brief Calcule la position des différentes zones de la partition.
+ * 
+ * Le journal grandit avec le nombre de blocs de données, entre
+ * JOURNAL_BLOCKS et JOURNAL_MAX_BLOCKS blocs du journal, et occupe assez de
+ * blocs de la partition pour les contenir.
+ * 
+ * @param sb Le superbloc à remplir.
+ * @param num_blocks Le nombre de blocs de données.
+ * @param num_inodes Le nombre maximal d'inodes.
+ * @param block_size La taille d'un bloc, acceptée par validBlockSize.
+ */
+static void computeLayout(SuperBlock* sb, uint64_t num_blocks, uint32_t num_inodes, uint32_t block_size) {
+    memset(sb, 0, sizeof(SuperBlock));
+    sb->magic = PARTITION_MAGIC;
+    sb->version = PARTITION_VERSION;
+    sb->block_size = block_size;
+    sb->num_inodes = num_inodes;
+    sb->num_blocks = num_blocks;
+    sb->next_inode = 1;
+    sb->free_inode = NO_INODE;
+    sb->free_blocks = num_blocks;
+
+    uint64_t journal_blocks = num_blocks / JOURNAL_BLOCKS_RATIO;
+    if (journal_blocks < JOURNAL_BLOCKS) {
+        journal_blocks = JOURNAL_BLOCKS;
+    } else if (journal_blocks > JOURNAL_MAX_BLOCKS) {
+        journal_blocks = JOURNAL_MAX_BLOCKS;
+    }
+
+    // Le superbloc occupe le bloc 0, les autres zones se suivent
+    sb->inode_map_start = 1;
+    sb->bitmap_start = sb->inode_map_start + blocksFor(inodeChunks(num_inodes) * sizeof(uint64_t), block_size);
+    sb->summary_start = sb->bitmap_start + blocksFor(bitmapWords(num_blocks) * sizeof(uint64_t), block_size);
+    sb->checksum_start = sb->summary_start + blocksFor(bitmapWords(bitmapWords(num_blocks)) * sizeof(uint64_t), block_size);
+    sb->shares_start = sb->checksum_start + blocksFor(num_blocks * sizeof(uint32_t), block_size);
+    sb->journal_start = sb->shares_start + blocksFor(num_blocks * sizeof(uint16_t), block_size);
+    sb->journal_blocks = (uint32_t)blocksFor(journal_blocks * JOURNAL_BLOCK_SIZE, block_size);
+    sb->data_start = sb->journal_start + sb->journal_blocks;
+    sb->total_blocks = sb->data_start + num_blocks;
+}
+
+/**
+ * @brief Met à jour le résumé de la table d'allocation pour un mot.
+ * 
+ * Le résumé contient un bit par mot de la table, à 1 lorsque tous les blocs
+ * du mot sont occupés : les mots pleins sont sautés 64 à la fois. Un résumé
+ * jamais écrit est nul, comme une table d'allocation vide.
+ * 
+ * @param partition La partition.
+ * @param word L'indice du mot de la table d'allocation.
+ */
+static void updateFullSummary(Partition* partition, uint64_t word) {
+    uint64_t* summary = &partition->full_summary[word / 64];
+    uint64_t bit = 1ULL << (word % 64);
+    uint64_t updated = partition->bitmap[word] == ~0ULL ? *summary | bit : *summary & ~bit;
+    if (updated != *summary) {
+        *summary = updated;
+        journalDirty(&partition->journal, summary, sizeof(uint64_t));
+    }
+}
+
+/**
+ * @brief Marque une suite de blocs consécutifs comme libres ou occupés.
+ * @param partition La partition.
+ * @param start Le premier bloc de la suite.
+ * @param length Le nombre de blocs.
+ * @param state BLOCK_FREE ou BLOCK_OCCUPIED.
+ */
+static void setRunState(Partition* partition, uint64_t start, uint32_t length, int state) {
+    uint64_t block = start, end = start + length;
+    while (block < end) {
+        // Masque des bits du mot courant compris dans la suite
+        uint64_t word = block / 64;
+        uint32_t first = block % 64;
+        uint32_t count = (end - block < 64 - first) ? (uint32_t)(end - block) : 64 - first;
+        uint64_t mask = (count == 64) ? ~0ULL : ((1ULL << count) - 1) << first;
+
+        if (state == BLOCK_OCCUPIED) {
+            partition->bitmap[word] |= mask;
+        } else {
+            partition->bitmap[word] &= ~mask;
+        }
+        updateFullSummary(partition, word);
+        journalDirty(&partition->journal, &partition->bitmap[word], sizeof(uint64_t));
+        block += count;
+    }
+
+    SuperBlock* sb = partition->superBlock;
+    sb->free_blocks = state == BLOCK_OCCUPIED ? sb->free_blocks - length : sb->free_blocks + length;
+    journalDirty(&partition->journal, &sb->free_blocks, sizeof(sb->free_blocks));
+}
+
+/**
+ * @brief Retire les codes de contrôle d'une suite de blocs, qui ne seront plus vérifiés.
+ * @param partition La partition.
+ * @param start Le premier bloc de la suite.
+ * @param length Le nombre de blocs.
+ * @return 1 si l'un des blocs avait un code, 0 sinon.
+ */
+static int clearBlockChecksums(Partition* partition, uint64_t start, uint32_t length) {
+    int cleared = 0;
+    for (uint32_t i = 0; i < length; ++i) {
+        // Une page de la table qui ne contient que des zéros n'est pas recopiée dans la projection
+        if (__atomic_load_n(&partition->checksums[start + i], __ATOMIC_RELAXED) != 0) {
+            __atomic_store_n(&partition->checksums[start + i], 0, __ATOMIC_RELAXED);
+            cleared = 1;
+        }
+    }
+    return cleared;
+}
+
+/**
+ * @brief Rend à la table d'allocation une suite de blocs consécutifs.
+ * @param partition La partition.
+ * @param start Le premier bloc de la suite.
+ * @param length Le nombre de blocs.
+ */
+static void freeRun(Partition* partition, uint64_t start, uint32_t length) {
+    // Les blocs libérés ne doivent plus être écrits depuis le cache : ils sont
+    // retirés avant de pouvoir être alloués à un autre fichier
+    for (uint32_t i = 0; i < length; ++i) {
+        cacheInvalidate(&partition->cache, start + i);
+    }
+    // Un bloc libéré peut devenir un nœud d'arbre, qui porte son propre code de contrôle
+    if (clearBlockChecksums(partition, start, length)) {
+        dirtyBlockChecksums(partition, start, length);
+    }
+    // Ni un nœud d'arbre ni le bloc d'un autre fichier ne doivent être partagés d'après une ancienne empreinte
+    dedupForget(&partition->dedup, start, length);
+
+    pthread_mutex_lock(&partition->alloc_lock);
+    setRunState(partition, start, length, BLOCK_FREE);
+    pthread_mutex_unlock(&partition->alloc_lock);
+    statsAdd(&partition->stats, STATS_BLOCKS_FREED, length);
+}
+
+/**
+ * @brief Recherche le prochain mot de la table d'allocation contenant un bloc libre.
+ * @param partition La partition.
+ * @param word Le premier mot à examiner.
+ * @param end La fin (exclue) de la zone de recherche.
+ * @return L'indice du mot trouvé, end si aucun.
+ */
+static uint64_t nextFreeWord(Partition* partition, uint64_t word, uint64_t end) {
+    while (word < end) {
+        uint64_t summary = ~partition->full_summary[word / 64] >> (word % 64);
+        if (summary != 0) {
+            word += __builtin_ctzll(summary);
+            return word < end ? word : end;
+        }
+        word = (word / 64 + 1) * 64;
+    }
+    return end;
+}
+
+/**
+ * @brief Recherche une suite de blocs libres dans une zone de la table d'allocation.
+ * 
+ * Les mots entièrement occupés sont sautés grâce au résumé, les mots
+ * entièrement libres comptent pour 64 blocs d'un coup, et dans les autres
+ * les suites de bits libres sont mesurées avec ctz.
+ * 
+ * @param partition La partition.
+ * @param first_word Le premier mot de la zone.
+ * @param end_word La fin (exclue) de la zone.
+ * @param wanted Le nombre de blocs souhaité.
+ * @param best_start Le début de la plus longue suite trouvée, mis à jour.
+ * @param best_length La longueur de la plus longue suite trouvée, mise à jour.
+ * @return 1 si une suite d'au moins wanted blocs a été trouvée, 0 sinon.
+ */
+static int scanFreeRuns(Partition* partition, uint64_t first_word, uint64_t end_word, uint32_t wanted, uint64_t* best_start, uint32_t* best_length) {
+    uint64_t run_start = 0, run_length = 0;
+    uint64_t word = nextFreeWord(partition, first_word, end_word);
+
+    while (word < end_word) {
+        uint64_t free_bits = ~partition->bitmap[word];
+        uint32_t bit = 0;
+        while (bit < 64) {
+            uint64_t rest = free_bits >> bit;
+            if (rest == 0) {
+                run_length = 0; // Plus aucun bloc libre dans ce mot
+                break;
+            }
+            uint32_t skip = __builtin_ctzll(rest);
+            if (skip > 0) {
+                run_length = 0; // Un bloc occupé interrompt la suite
+                bit += skip;
+                rest >>= skip;
+            }
+            uint32_t ones = (~rest == 0) ? 64 - bit : (uint32_t)__builtin_ctzll(~rest);
+            if (run_length == 0) {
+                run_start = word * 64 + bit;
+            }
+            run_length += ones;
+            bit += ones;
+            if (run_length >= wanted) {
+                *best_start = run_start;
+                *best_length = wanted;
+                return 1;
+            }
+            if (run_length > *best_length) {
+                *best_start = run_start;
+                *best_length = (uint32_t)run_length;
+            }
+        }
+
+        // Une suite qui atteint la fin du mot ne se prolonge que dans le mot suivant
+        uint64_t next = nextFreeWord(partition, word + 1, end_word);
+        if (next != word + 1) {
+            run_length = 0;
+        }
+        word = next;
+    }
+    return 0;
+}
+
+/**
+ * @brief Alloue une suite de blocs de données consécutifs.
+ * 
+ * La recherche part du dernier bloc alloué, pour que les écritures
+ * successives d'un fichier reçoivent des blocs voisins. Si aucune suite de
+ * la longueur demandée n'existe, la plus longue suite libre trouvée est
+ * allouée.
+ * 
+ * @param partition La partition.
+ * @param wanted Le nombre de blocs souhaité (au moins 1).
+ * @param length Le nombre de blocs effectivement alloués.
+ * @return Le premier bloc alloué, NO_BLOCK si la partition est pleine.
+ */
+static int64_t allocRun(Partition* partition, uint32_t wanted, uint32_t* length) {
+    uint64_t words = bitmapWords(partition->superBlock->num_blocks);
+    uint64_t start = 0;
+    uint32_t found = 0;
+
+    pthread_mutex_lock(&partition->alloc_lock);
+    uint64_t hint = partition->alloc_hint / 64;
+    if (partition->superBlock->free_blocks > 0 && !scanFreeRuns(partition, hint, words, wanted, &start, &found)) {
+        scanFreeRuns(partition, 0, hint, wanted, &start, &found);
+    }
+    if (found == 0) {
+        pthread_mutex_unlock(&partition->alloc_lock);
+        return NO_BLOCK;
+    }
+
+    setRunState(partition, start, found, BLOCK_OCCUPIED); // Marquer les blocs comme occupés
+    partition->alloc_hint = start + found;
+    if (partition->alloc_hint >= partition->superBlock->num_blocks) {
+        partition->alloc_hint = 0;
+    }
+    pthread_mutex_unlock(&partition->alloc_lock);
+    statsAdd(&partition->stats, STATS_BLOCKS_ALLOCATED, found);
+    *length = found;
+    return (int64_t)start;
+}
+
+/**
+ * @brief Alloue un bloc de données libre.
+ * @param partition La partition.
+ * @return L'indice du bloc alloué, NO_BLOCK si la partition est pleine.
+ */
+static int64_t allocateBlock(Partition* partition) {
+    uint32_t length;
+    return allocRun(partition, 1, &length);
+}
+
+/**
+ * @brief Calcule la position dans la partition d'un bloc de données.
+ * @param partition La partition.
+ * @param block L'indice du bloc de données.
+ * @return La position en octets du début du bloc dans la partition.
+ */
+off_t dataBlockOffset(Partition* partition, uint64_t block) {
+    return (off_t)(partition->superBlock->data_start + block) << partition->block_shift;
+}
+
+/**
+ * @brief Fonction pour calculer le code de contrôle d'un bloc de données.
+ * @param partition La partition.
+ * @param data Le contenu du bloc.
+ * @return Le CRC32C du bloc, 1 à la place de 0 qui désigne un bloc non vérifié.
+ */
+uint32_t blockChecksum(Partition* partition, const void* data) {
+    uint32_t checksum = crc32c(0, data, partition->block_size);
+    return checksum != 0 ? checksum : 1;
+}
+
+/**
+ * @brief Fonction pour calculer et noter le code de contrôle d'un bloc de données.
+ * @param partition La partition.
+ * @param block L'indice du bloc dans la zone de données.
+ * @param data Le contenu du bloc.
+ */
+void setBlockChecksum(Partition* partition, uint64_t block, const void* data) {
+    __atomic_store_n(&partition->checksums[block], blockChecksum(partition, data), __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Compare deux pages de la table des codes de contrôle (pour qsort).
+ * @param a Pointeur vers la première page.
+ * @param b Pointeur vers la seconde page.
+ * @return Un entier négatif, nul ou positif.
+ */
+static int comparePages(const void* a, const void* b) {
+    uint64_t page_a = *(const uint64_t*)a, page_b = *(const uint64_t*)b;
+    return page_a < page_b ? -1 : page_a > page_b;
+}
+
+/**
+ * @brief Écrit les pages modifiées de la table des codes de contrôle (checksum_lock doit être pris).
+ * @param partition La partition.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+static int writeChecksumPages(Partition* partition) {
+    qsort(partition->checksum_pages, partition->num_checksum_pages, sizeof(uint64_t), comparePages);
+    off_t table = (off_t)partition->superBlock->checksum_start << partition->block_shift;
+    uint64_t table_size = partition->superBlock->num_blocks * sizeof(uint32_t);
+    int status = 0;
+    int start = 0;
+    while (start < partition->num_checksum_pages) {
+        // Une écriture par suite de pages consécutives, doublons compris
+        int end = start + 1;
+        while (end < partition->num_checksum_pages && partition->checksum_pages[end] <= partition->checksum_pages[end - 1] + 1) {
+            end++;
+        }
+        uint64_t first = partition->checksum_pages[start] * CHECKSUM_PAGE_SIZE;
+        uint64_t last = (partition->checksum_pages[end - 1] + 1) * CHECKSUM_PAGE_SIZE;
+        if (last > table_size) {
+            last = table_size;
+        }
+        // La table n'est pas journalisée : ses octets notés dans la projection sont copiés à leur place
+        if (partitionWrite(partition, (char*)partition->checksums + first, last - first, table + (off_t)first) != (ssize_t)(last - first)) {
+            perror("Erreur lors de l'écriture des codes de contrôle");
+            status = -1;
+        }
+        start = end;
+    }
+    partition->num_checksum_pages = 0;
+    return status;
+}
+
+/**
+ * @brief Fonction pour noter que les codes de contrôle d'une suite de blocs consécutifs sont à écrire.
+ * @param partition La partition.
+ * @param block Le premier bloc de la suite.
+ * @param count Le nombre de blocs.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int dirtyBlockChecksums(Partition* partition, uint64_t block, uint64_t count) {
+    uint64_t first = block * sizeof(uint32_t) / CHECKSUM_PAGE_SIZE;
+    uint64_t last = (block + count - 1) * sizeof(uint32_t) / CHECKSUM_PAGE_SIZE;
+    int status = 0;
+    pthread_mutex_lock(&partition->checksum_lock);
+    for (uint64_t page = first; page <= last; ++page) {
+        // Les écritures séquentielles notent plusieurs fois de suite la même page
+        int n = partition->num_checksum_pages;
+        if (n > 0 && partition->checksum_pages[n - 1] == page) {
+            continue;
+        }
+        if (n == CHECKSUM_DIRTY_MAX && writeChecksumPages(partition) == -1) {
+            status = -1;
+        }
+        partition->checksum_pages[partition->num_checksum_pages++] = page;
+    }
+    pthread_mutex_unlock(&partition->checksum_lock);
+    return status;
+}
+
+/**
+ * @brief Fonction pour écrire sur la partition les codes de contrôle notés par dirtyBlockChecksums.
+ * @param partition La partition.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int flushBlockChecksums(Partition* partition) {
+    pthread_mutex_lock(&partition->checksum_lock);
+    int status = writeChecksumPages(partition);
+    pthread_mutex_unlock(&partition->checksum_lock);
+    return status;
+}
+
+/**
+ * @brief Fonction pour vérifier un bloc de données lu sur la partition.
+ * @param partition La partition.
+ * @param block L'indice du bloc dans la zone de données.
+ * @param data Le contenu lu.
+ * @return 0 si le bloc correspond à son code, -1 sinon (errno vaut alors EBADMSG).
+ */
+int verifyBlockChecksum(Partition* partition, uint64_t block, const void* data) {
+    uint32_t expected = __atomic_load_n(&partition->checksums[block], __ATOMIC_RELAXED);
+    if (expected == 0 || blockChecksum(partition, data) == expected) {
+        return 0;
+    }
+    statsAdd(&partition->stats, STATS_CHECKSUM_ERRORS, 1);
+    errno = EBADMSG;
+    return -1;
+}
+
+/**
+ * @brief Fonction pour noter le code de contrôle d'un bloc après une écriture directe d'une partie de ses octets.
+ * @param partition La partition.
+ * @param offset La position de l'écriture dans la partition.
+ * @param data Les octets écrits.
+ * @param length Le nombre d'octets écrits, sans dépasser la fin du bloc.
+ * @return Le bloc de données écrit, NO_BLOCK si sa relecture a échoué.
+ */
+int64_t updateBlockChecksum(Partition* partition, off_t offset, const void* data, size_t length) {
+    uint64_t block = (uint64_t)(offset - dataBlockOffset(partition, 0)) >> partition->block_shift;
+    if (length == partition->block_size) {
+        setBlockChecksum(partition, block, data);
+        return block;
+    }
+    char* content = malloc(partition->block_size);
+    if (content == NULL || partitionRead(partition, content, partition->block_size, dataBlockOffset(partition, block))
+                               != (ssize_t)partition->block_size) {
+        perror("Erreur lors de la relecture d'un bloc écrit");
+        free(content);
+        return NO_BLOCK;
+    }
+    setBlockChecksum(partition, block, content);
+    free(content);
+    return block;
+}
+
+/**
+ * @brief Fonction pour obtenir l'adresse d'un inode dans la projection de la partition.
+ * @param partition La partition.
+ * @param inode_number Le numéro de l'inode, dont le groupe est déjà alloué.
+ * @return L'inode.
+ */
+inode* inodeAt(Partition* partition, uint32_t inode_number) {
+    uint64_t first_block = partition->inode_map[inode_number / INODES_PER_CHUNK];
+    inode* table = (inode*)((char*)partition->metadata + dataBlockOffset(partition, first_block));
+    return &table[inode_number % INODES_PER_CHUNK];
+}
+
+/**
+ * @brief Donne l'état en mémoire du groupe d'un inode.
+ * @param partition La partition.
+ * @param inode_number Le numéro de l'inode.
+ * @return L'état du groupe, NULL s'il n'a pas encore été créé.
+ */
+static InodeChunk* inodeChunk(Partition* partition, uint32_t inode_number) {
+    return __atomic_load_n(&partition->chunks[inode_number / INODES_PER_CHUNK], __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Crée si besoin l'état en mémoire du groupe d'un inode.
+ * 
+ * Les répertoires sont parcourus sans namespace_lock : deux threads peuvent
+ * créer le même groupe en même temps, seul le premier publié est conservé.
+ * 
+ * @param partition La partition.
+ * @param inode_number Le numéro de l'inode.
+ * @return L'état du groupe, NULL en cas d'erreur d'allocation mémoire.
+ */
+static InodeChunk* createInodeChunk(Partition* partition, uint32_t inode_number) {
+    InodeChunk* chunk = inodeChunk(partition, inode_number);
+    if (chunk != NULL) {
+        return chunk;
+    }
+    chunk = calloc(1, sizeof(InodeChunk));
+    if (chunk == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour les inodes.");
+        return NULL;
+    }
+    for (int i = 0; i < INODES_PER_CHUNK; ++i) {
+        pthread_rwlock_init(&chunk->locks[i], NULL);
+    }
+    // Les verrous sont initialisés avant que le groupe ne soit visible sans verrou
+    InodeChunk* published = NULL;
+    uint32_t index = inode_number / INODES_PER_CHUNK;
+    if (!__atomic_compare_exchange_n(&partition->chunks[index], &published, chunk, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        for (int i = 0; i < INODES_PER_CHUNK; ++i) {
+            pthread_rwlock_destroy(&chunk->locks[i]);
+        }
+        free(chunk);
+        return published;
+    }
+    // Le démontage ne parcourt que les groupes créés, pas toute la table
+    uint32_t used = __atomic_load_n(&partition->chunks_used, __ATOMIC_RELAXED);
+    while (used <= index && !__atomic_compare_exchange_n(&partition->chunks_used, &used, index + 1, 1,
+                                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    return chunk;
+}
+
+/**
+ * @brief Donne le verrou du contenu d'un inode, dont le groupe est déjà créé.
+ * @param partition La partition.
+ * @param inode_number Le numéro de l'inode.
+ * @return Le verrou lecteurs/rédacteur de l'inode.
+ */
+static pthread_rwlock_t* inodeLock(Partition* partition, uint32_t inode_number) {
+    return &inodeChunk(partition, inode_number)->locks[inode_number % INODES_PER_CHUNK];
+}
+
+/**
+ * @brief Attribue un inode libre (namespace_lock doit être pris).
+ * 
+ * Les inodes libérés sont réutilisés en premier. Sinon, le premier numéro
+ * jamais attribué est pris, et la table des inodes grandit d'un groupe de
+ * inode_chunk_blocks blocs de données contigus lorsqu'il en commence un.
+ * 
+ * @param partition La partition.
+ * @return Le numéro de l'inode, NO_INODE si la table est pleine ou la partition sans place.
+ */
+static uint32_t allocInode(Partition* partition) {
+    SuperBlock* sb = partition->superBlock;
+    uint32_t inode_number = sb->free_inode;
+    if (inode_number != NO_INODE) {
+        sb->free_inode = inodeAt(partition, inode_number)->next_free;
+        journalDirty(&partition->journal, &sb->free_inode, sizeof(sb->free_inode));
+        return inode_number;
+    }
+
+    inode_number = sb->next_inode;
+    if (inode_number > sb->num_inodes) {
+        return NO_INODE;
+    }
+    if (inode_number == 1 || inode_number % INODES_PER_CHUNK == 0) {
+        uint32_t length;
+        int64_t first_block = allocRun(partition, partition->inode_chunk_blocks, &length);
+        if (first_block == NO_BLOCK) {
+            return NO_INODE;
+        }
+        if (length < partition->inode_chunk_blocks) {
+            freeRun(partition, first_block, length);
+            return NO_INODE;
+        }
+        // Les blocs ont pu appartenir à un fichier supprimé : le groupe est
+        // remis à zéro et journalisé en entier
+        char* table = (char*)partition->metadata + dataBlockOffset(partition, first_block);
+        memset(table, 0, INODE_CHUNK_SIZE);
+        journalDirty(&partition->journal, table, INODE_CHUNK_SIZE);
+        uint64_t* entry = &partition->inode_map[inode_number / INODES_PER_CHUNK];
+        *entry = (uint64_t)first_block;
+        journalDirty(&partition->journal, entry, sizeof(uint64_t));
+    }
+    sb->next_inode = inode_number + 1;
+    journalDirty(&partition->journal, &sb->next_inode, sizeof(sb->next_inode));
+    return inode_number;
+}
+
+/**
+ * @brief Ajoute un inode dont le nom a été effacé à la liste des inodes libres (namespace_lock doit être pris).
+ * @param partition La partition.
+ * @param inode_number Le numéro de l'inode.
+ */
+static void freeInode(Partition* partition, uint32_t inode_number) {
+    SuperBlock* sb = partition->superBlock;
+    inode* freed = inodeAt(partition, inode_number);
+    // Le type partage sa place et peut être lu par une résolution de chemin concurrente
+    __atomic_store_n(&freed->next_free, sb->free_inode, __ATOMIC_RELAXED);
+    journalDirty(&partition->journal, &freed->next_free, sizeof(freed->next_free));
+    sb->free_inode = inode_number;
+    journalDirty(&partition->journal, &sb->free_inode, sizeof(sb->free_inode));
+}
+
+/**
+ * @brief Libère les verrous, les groupes d'inodes et la projection de la partition, puis la partition.
+ * @param partition La partition.
+ */
+static void freePartition(Partition* partition) {
+    for (uint32_t c = 0; c < partition->chunks_used; ++c) {
+        InodeChunk* chunk = partition->chunks[c];
+        if (chunk != NULL) {
+            for (int i = 0; i < INODES_PER_CHUNK; ++i) {
+                pthread_rwlock_destroy(&chunk->locks[i]);
+            }
+            free(chunk);
+        }
+    }
+    free(partition->chunks);
+    dcacheDestroy(&partition->dentries);
+    dedupDestroy(&partition->dedup);
+    pthread_mutex_destroy(&partition->namespace_lock);
+    pthread_mutex_destroy(&partition->alloc_lock);
+    pthread_mutex_destroy(&partition->checksum_lock);
+    munmap(partition->metadata, partition->metadata_size);
+    if (partition->data_view != NULL) {
+        munmap(partition->data_view, partition->metadata_size);
+    }
+    free(partition);
+}
+
+/**
+ * @brief Vérifie la cohérence de la géométrie décrite par un superbloc.
+ * @param sb Le superbloc lu sur la partition.
+ * @param size La taille du fichier de partition en octets.
+ * @return 1 si la géométrie correspond à celle que calcule computeLayout et tient dans le fichier, 0 sinon.
+ */
+static int checkLayout(const SuperBlock* sb, off_t size) {
+    if (!validBlockSize(sb->block_size) || !validCompression(sb->compression, sb->block_size)
+        || sb->num_inodes == 0 || sb->num_inodes > MAX_INODES
+        || sb->num_blocks == 0 || sb->num_blocks > (uint64_t)size / sb->block_size) {
+        return 0;
+    }
+    SuperBlock expected;
+    computeLayout(&expected, sb->num_blocks, sb->num_inodes, sb->block_size);
+    return sb->data_start == expected.data_start && sb->journal_start == expected.journal_start
+        && sb->checksum_start == expected.checksum_start && sb->shares_start == expected.shares_start
+        && sb->journal_blocks == expected.journal_blocks && sb->total_blocks == expected.total_blocks
+        && (off_t)(sb->total_blocks * sb->block_size) <= size && sb->next_inode >= 1
+        && sb->next_inode <= sb->num_inodes + 1 && sb->free_inode < sb->next_inode;
+}
+
+/**
+ * @brief Crée le répertoire racine d'une partition dont aucun inode n'a encore été attribué.
+ * @param partition La partition.
+ * @return 0 en cas de succès, -1 si la partition n'a pas la place d'un groupe d'inodes.
+ */
+static int createRoot(Partition* partition) {
+    journalStart(&partition->journal);
+    pthread_mutex_lock(&partition->namespace_lock);
+    uint32_t root = allocInode(partition);
+    if (root == ROOT_INODE) {
+        inode* directory = inodeAt(partition, root);
+        memset(directory, 0, sizeof(inode));
+        directory->type = INODE_DIRECTORY;
+        directory->dir_tree = NO_BLOCK;
+        journalDirty(&partition->journal, directory, sizeof(inode));
+    }
+    pthread_mutex_unlock(&partition->namespace_lock);
+    journalStop(&partition->journal);
+    return root == ROOT_INODE ? 0 : -1;
+}
+
+/**
+ * @brief Projette en mémoire une partition ouverte.
+ * @param partition_fd Le descripteur de la partition.
+ * @return La partition montée, NULL si le superbloc est invalide ou en cas d'erreur.
+ */
+static Partition* mapMetadata(int partition_fd) {
+    SuperBlock sb;
+    if (pread(partition_fd, &sb, sizeof(sb), 0) != (ssize_t)sizeof(sb)) {
+        printf("Erreur : Impossible de lire le superbloc.\n");
+        return NULL;
+    }
+    if (sb.magic != PARTITION_MAGIC) {
+        printf("Erreur : La partition n'est pas formatée.\n");
+        return NULL;
+    }
+    if (sb.version != PARTITION_VERSION) {
+        printf("Erreur : Version de partition %u non supportée.\n", sb.version);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(partition_fd, &st) == -1 || !checkLayout(&sb, st.st_size)) {
+        printf("Erreur : La géométrie de la partition est invalide.\n");
+        return NULL;
+    }
+
+    // Rejouer le journal avant de lire les métadonnées
+    uint32_t sequence;
+    uint32_t journal_blocks = (uint32_t)((uint64_t)sb.journal_blocks * sb.block_size / JOURNAL_BLOCK_SIZE);
+    if (journalRecover(partition_fd, (off_t)sb.journal_start * sb.block_size, journal_blocks,
+                       (off_t)sb.data_start * sb.block_size, sb.block_size, &sequence) == -1) {
+        return NULL;
+    }
+    // Le superbloc a pu être modifié par le rejeu
+    if (pread(partition_fd, &sb, sizeof(sb), 0) != (ssize_t)sizeof(sb) || !checkLayout(&sb, st.st_size)) {
+        printf("Erreur : La géométrie de la partition est invalide.\n");
+        return NULL;
+    }
+
+    // Une seule projection, privée, couvre toute la partition : les groupes
+    // d'inodes sont rangés dans la zone de données, et les modifications
+    // n'atteignent la partition qu'à travers le journal. Seules les pages
+    // lues ou modifiées occupent de la mémoire
+    size_t metadata_size = (size_t)sb.total_blocks * sb.block_size;
+    void* metadata = mmap(NULL, metadata_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_NORESERVE, partition_fd, 0);
+    if (metadata == MAP_FAILED) {
+        perror("Erreur lors de la projection des métadonnées");
+        return NULL;
+    }
+    // Les compteurs de chaque thread occupent leurs propres lignes de cache
+    Partition* partition = aligned_alloc(_Alignof(Partition), sizeof(Partition));
+    if (partition == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour la partition.");
+        munmap(metadata, metadata_size);
+        return NULL;
+    }
+    memset(partition, 0, sizeof(Partition));
+
+    partition->metadata = metadata;
+    partition->metadata_size = metadata_size;
+    partition->superBlock = (SuperBlock*)metadata;
+    partition->inode_map = (uint64_t*)((char*)metadata + (size_t)sb.inode_map_start * sb.block_size);
+    partition->bitmap = (uint64_t*)((char*)metadata + (size_t)sb.bitmap_start * sb.block_size);
+    partition->full_summary = (uint64_t*)((char*)metadata + (size_t)sb.summary_start * sb.block_size);
+    partition->checksums = (uint32_t*)((char*)metadata + (size_t)sb.checksum_start * sb.block_size);
+    partition->shares = (uint16_t*)((char*)metadata + (size_t)sb.shares_start * sb.block_size);
+    partition->num_inodes = sb.num_inodes;
+    partition->taille_partition = sb.total_blocks * sb.block_size;
+    partition->block_size = sb.block_size;
+    partition->block_shift = __builtin_ctz(sb.block_size);
+    partition->inode_chunk_blocks = (uint32_t)blocksFor(INODE_CHUNK_SIZE, sb.block_size);
+    partition->max_file_size = (int64_t)MAX_FILE_BLOCKS << partition->block_shift;
+    partition->cluster_blocks = validCompression(CODEC_LZ4, sb.block_size) ? COMPRESS_CLUSTER_SIZE >> partition->block_shift : 0;
+    partition->fileDescriptor = partition_fd;
+    partition->num_chunks = inodeChunks(sb.num_inodes);
+    pthread_mutex_init(&partition->alloc_lock, NULL);
+    pthread_mutex_init(&partition->checksum_lock, NULL);
+    pthread_mutex_init(&partition->namespace_lock, NULL);
+    statsInit(&partition->stats);
+
+    partition->chunks = calloc(partition->num_chunks, sizeof(InodeChunk*));
+    int status = 0;
+    if (partition->chunks == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour les inodes.");
+        status = -1;
+    }
+    if (status == 0) {
+        status = dcacheInit(&partition->dentries, DCACHE_SLOTS);
+    }
+    if (status == 0) {
+        status = cacheInit(&partition->cache, partition, CACHE_MEMORY, sb.block_size);
+    }
+    if (status == 0 && journalInit(&partition->journal, partition, (off_t)sb.journal_start * sb.block_size,
+                                   journal_blocks, sequence) == -1) {
+        cacheDestroy(&partition->cache);
+        status = -1;
+    }
+    if (status == 0 && asyncInit(&partition->async, partition, ASYNC_DEPTH, ASYNC_BACKEND_AUTO) == -1) {
+        journalDestroy(&partition->journal);
+        cacheDestroy(&partition->cache);
+        status = -1;
+    }
+    // Le répertoire racine est le premier inode : il est créé au premier
+    // montage, et de nouveau si une interruption a suivi le formatage
+    if (status == 0 && partition->superBlock->next_inode == ROOT_INODE && createRoot(partition) == -1) {
+        printf("Erreur : La partition n'a pas la place de son répertoire racine.\n");
+        asyncDestroy(&partition->async);
+        journalDestroy(&partition->journal);
+        cacheDestroy(&partition->cache);
+        status = -1;
+    }
+    if (status == -1) {
+        freePartition(partition);
+        return NULL;
+    }
+
+    return partition;
+}
+
+/**
+ * @brief Fonction pour calculer l'empreinte d'un nom de fichier (FNV-1a 32 bits).
+ * @param name Le nom du fichier.
+ * @return L'empreinte du nom.
+ */
+uint32_t hashName(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* c = (const unsigned char*)name; *c != '\0'; ++c) {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Lit des octets à une position donnée de la partition.
+ * 
+ * Utilise pread : le curseur du descripteur de la partition n'est ni lu ni
+ * modifié, plusieurs lectures peuvent donc avoir lieu en parallèle.
+ * 
+ * @param partition La partition.
+ * @param buffer Le tampon de destination.
+ * @param nBytes Le nombre d'octets à lire.
+ * @param offset La position dans la partition.
+ * @return Le nombre d'octets lus, -1 en cas d'erreur.
+ */
+ssize_t partitionRead(Partition* partition, void* buffer, size_t nBytes, off_t offset) {
+    size_t done = 0;
+    while (done < nBytes) {
+        ssize_t n = pread(partition->fileDescriptor, (char*)buffer + done, nBytes - done, offset + done);
+        statsAdd(&partition->stats, STATS_SYSCALLS, 1);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n == 0 ? (ssize_t)done : -1;
+        }
+        done += n;
+    }
+    return done;
+}
+
+/**
+ * @brief Écrit des octets à une position donnée de la partition.
+ * @param partition La partition.
+ * @param buffer Le tampon contenant les données.
+ * @param nBytes Le nombre d'octets à écrire.
+ * @param offset La position dans la partition.
+ * @return Le nombre d'octets écrits, -1 en cas d'erreur.
+ */
+ssize_t partitionWrite(Partition* partition, const void* buffer, size_t nBytes, off_t offset) {
+    size_t done = 0;
+    while (done < nBytes) {
+        ssize_t n = pwrite(partition->fileDescriptor, (const char*)buffer + done, nBytes - done, offset + done);
+        statsAdd(&partition->stats, STATS_SYSCALLS, 1);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        done += n;
+    }
+    return done;
+}
+
+/**
+ * @brief Transfère un vecteur de tampons à une position donnée de la partition.
+ * 
+ * Les transferts partiels sont repris là où ils se sont arrêtés ; le tableau
+ * iov est modifié en conséquence.
+ * 
+ * @param partition La partition.
+ * @param write_mode 1 pour écrire (pwritev), 0 pour lire (preadv).
+ * @param iov Les tampons.
+ * @param count Le nombre de tampons.
+ * @param offset La position dans la partition.
+ * @return Le nombre d'octets transférés, -1 en cas d'erreur.
+ */
+static ssize_t partitionTransferv(Partition* partition, int write_mode, struct iovec* iov, int count, off_t offset) {
+    size_t done = 0;
+    while (count > 0) {
+        ssize_t n = write_mode ? pwritev(partition->fileDescriptor, iov, count, offset + done)
+                               : preadv(partition->fileDescriptor, iov, count, offset + done);
+        statsAdd(&partition->stats, STATS_SYSCALLS, 1);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return (n == 0 && !write_mode) ? (ssize_t)done : -1;
+        }
+        done += n;
+
+        // Passer les tampons complets puis avancer dans le tampon entamé
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return done;
+}
+
+/**
+ * @brief Lit une position de la partition dans plusieurs tampons (preadv).
+ * @param partition La partition.
+ * @param iov Les tampons de destination, modifiés en cas de lecture partielle.
+ * @param count Le nombre de tampons.
+ * @param offset La position dans la partition.
+ * @return Le nombre d'octets lus, -1 en cas d'erreur.
+ */
+ssize_t partitionReadv(Partition* partition, struct iovec* iov, int count, off_t offset) {
+    return partitionTransferv(partition, 0, iov, count, offset);
+}
+
+/**
+ * @brief Écrit plusieurs tampons à une position de la partition (pwritev).
+ * @param partition La partition.
+ * @param iov Les tampons contenant les données, modifiés en cas d'écriture partielle.
+ * @param count Le nombre de tampons.
+ * @param offset La position dans la partition.
+ * @return Le nombre d'octets écrits, -1 en cas d'erreur.
+ */
+ssize_t partitionWritev(Partition* partition, struct iovec* iov, int count, off_t offset) {
+    return partitionTransferv(partition, 1, iov, count, offset);
+}
+
+/**
+ * @brief Calcule le code de contrôle d'un nœud d'arbre, son champ checksum compté comme nul.
+ * @param data Le nœud (TREE_NODE_SIZE octets) ; le champ checksum est à la même place dans ExtentNode et DirNode.
+ * @return Le CRC32C du nœud.
+ */
+static uint32_t treeNodeChecksum(const char* data) {
+    const uint32_t zero = 0;
+    size_t field = offsetof(ExtentNode, checksum);
+    uint32_t checksum = crc32c(0, data, field);
+    checksum = crc32c(checksum, &zero, sizeof(zero));
+    return crc32c(checksum, data + field + sizeof(zero), TREE_NODE_SIZE - field - sizeof(zero));
+}
+
+/**
+ * @brief Fonction pour lire un nœud d'un arbre d'extents ou de répertoire.
+ * @param partition La partition.
+ * @param block Le bloc de données contenant le nœud.
+ * @param node Le nœud à remplir.
+ * @param size La taille du nœud, au plus TREE_NODE_SIZE.
+ * @return 0 en cas de succès, -1 en cas d'erreur (errno vaut EBADMSG si le nœud ne correspond pas à son code de contrôle).
+ */
+int readTreeNode(Partition* partition, uint64_t block, void* node, size_t size) {
+    // Un nœud modifié reste dans le journal jusqu'à son écriture à sa place
+    char data[TREE_NODE_SIZE];
+    if (journalReadBlock(&partition->journal, block, data)) {
+        memcpy(node, data, size);
+        return 0;
+    }
+
+    Buffer* buffer = cacheGet(&partition->cache, block, CACHE_READ);
+    if (buffer == NULL) {
+        return -1;
+    }
+    uint32_t checksum;
+    memcpy(&checksum, buffer->data + offsetof(ExtentNode, checksum), sizeof(checksum));
+    int corrupted = checksum != treeNodeChecksum(buffer->data);
+    memcpy(node, buffer->data, size);
+    cacheRelease(&partition->cache, buffer, 0);
+    if (corrupted) {
+        statsAdd(&partition->stats, STATS_CHECKSUM_ERRORS, 1);
+        errno = EBADMSG;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Écrit un nœud d'un arbre d'extents ou de répertoire.
+ * 
+ * Le nœud est journalisé comme les autres métadonnées : il n'est écrit à sa
+ * place qu'après sa transaction, et son ancienne copie est retirée du cache.
+ * 
+ * @param partition La partition.
+ * @param block Le bloc de données destiné au nœud.
+ * @param node Le nœud à écrire.
+ * @param size La taille du nœud, au plus TREE_NODE_SIZE.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int writeTreeNode(Partition* partition, uint64_t block, const void* node, size_t size) {
+    char data[TREE_NODE_SIZE];
+    memset(data, 0, TREE_NODE_SIZE);
+    memcpy(data, node, size);
+    uint32_t checksum = treeNodeChecksum(data);
+    memcpy(data + offsetof(ExtentNode, checksum), &checksum, sizeof(checksum));
+    if (journalLogBlock(&partition->journal, block, data) == -1) {
+        return -1;
+    }
+    cacheInvalidate(&partition->cache, block);
+    return 0;
+}
+
+/**
+ * @brief Premier bloc logique couvert par un nœud de l'arbre d'extents.
+ * @param node Le nœud, contenant au moins une entrée.
+ * @return Le premier bloc logique du nœud.
+ */
+static uint32_t extentNodeStart(const ExtentNode* node) {
+    return node->depth == 0 ? node->extents[0].logical : node->index[0].logical;
+}
+
+/**
+ * @brief Recherche l'extent contenant un bloc logique dans un tableau trié.
+ * @param extents Les extents, triés par bloc logique.
+ * @param count Le nombre d'extents.
+ * @param logical Le bloc logique recherché.
+ * @return L'indice de l'extent, -1 si aucun ne contient ce bloc.
+ */
+static int searchExtent(const Extent* extents, int count, uint32_t logical) {
+    int low = 0, high = count - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (logical < extents[middle].logical) {
+            high = middle - 1;
+        } else if (logical >= extents[middle].logical + extents[middle].length) {
+            low = middle + 1;
+        } else {
+            return middle;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Recherche le fils d'un nœud interne couvrant un bloc logique.
+ * @param node Le nœud interne.
+ * @param logical Le bloc logique recherché.
+ * @return L'indice de la dernière entrée dont le premier bloc logique est inférieur ou égal à logical.
+ */
+static int searchExtentIndex(const ExtentNode* node, uint32_t logical) {
+    int low = 0, high = node->count - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (node->index[middle].logical <= logical) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Recherche l'extent d'un fichier contenant un bloc logique.
+ * 
+ * Les extents directs sont examinés en premier, puis l'arbre d'extents est
+ * parcouru de la racine vers une feuille par recherche dichotomique.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param logical Le bloc logique recherché.
+ * @param extent L'extent trouvé.
+ * @return 0 si l'extent est trouvé, -1 sinon.
+ */
+static int findExtent(Partition* partition, const inode* inode_of_file, uint32_t logical, Extent* extent) {
+    if (logical >= inode_of_file->block_count) {
+        return -1;
+    }
+
+    int found = searchExtent(inode_of_file->extents, inode_of_file->num_extents, logical);
+    if (found != -1) {
+        *extent = inode_of_file->extents[found];
+        return 0;
+    }
+    if (inode_of_file->extent_tree == NO_BLOCK) {
+        return -1;
+    }
+
+    ExtentNode node;
+    uint64_t block = inode_of_file->extent_tree;
+    for (int level = 0; level < EXTENT_TREE_MAX_DEPTH; ++level) {
+        if (readTreeNode(partition, block, &node, sizeof(ExtentNode)) == -1 || node.count == 0) {
+            return -1;
+        }
+        if (node.depth == 0) {
+            found = searchExtent(node.extents, node.count, logical);
+            if (found == -1) {
+                return -1;
+            }
+            *extent = node.extents[found];
+            return 0;
+        }
+        block = node.index[searchExtentIndex(&node, logical)].child;
+    }
+    return -1;
+}
+
+/**
+ * @brief Nombre de blocs des groupes d'un fichier compressé.
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @return Le nombre de blocs d'un groupe, 0 si le fichier n'est pas compressé.
+ */
+static uint32_t clusterBlocks(Partition* partition, const inode* inode_of_file) {
+    return (inode_of_file->flags >> INODE_CODEC_SHIFT) != CODEC_NONE ? partition->cluster_blocks : 0;
+}
+
+/**
+ * @brief Ajoute un extent à la fin de l'arbre d'extents d'un inode.
+ * 
+ * Le chemin le plus à droite est parcouru jusqu'à la dernière feuille. Si
+ * elle est pleine, une nouvelle feuille est créée et référencée par les
+ * nœuds parents, qui sont eux-mêmes dédoublés au besoin ; l'arbre gagne un
+ * niveau lorsque la racine est pleine. Les blocs des nouveaux nœuds sont
+ * réservés avant toute modification.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param extent L'extent à ajouter, situé après tous ceux du fichier.
+ * @return 0 en cas de succès, -1 si la partition est pleine ou en cas d'erreur.
+ */
+static int appendToExtentTree(Partition* partition, inode* inode_of_file, const Extent* extent) {
+    ExtentNode path[EXTENT_TREE_MAX_DEPTH];
+    uint64_t path_blocks[EXTENT_TREE_MAX_DEPTH];
+
+    if (inode_of_file->extent_tree == NO_BLOCK) {
+        int64_t root = allocateBlock(partition);
+        if (root == NO_BLOCK) {
+            return -1;
+        }
+        memset(&path[0], 0, sizeof(ExtentNode));
+        path[0].count = 1;
+        path[0].extents[0] = *extent;
+        if (writeTreeNode(partition, root, &path[0], sizeof(ExtentNode)) == -1) {
+            freeRun(partition, root, 1);
+            return -1;
+        }
+        inode_of_file->extent_tree = root;
+        return 0;
+    }
+
+    // Descendre jusqu'à la dernière feuille
+    int level = 0;
+    path_blocks[0] = inode_of_file->extent_tree;
+    while (1) {
+        if (readTreeNode(partition, path_blocks[level], &path[level], sizeof(ExtentNode)) == -1) {
+            return -1;
+        }
+        if (path[level].depth == 0) {
+            break;
+        }
+        if (level + 1 >= EXTENT_TREE_MAX_DEPTH) {
+            return -1;
+        }
+        path_blocks[level + 1] = path[level].index[path[level].count - 1].child;
+        level++;
+    }
+
+    // Prolonger le dernier extent ou l'ajouter à la feuille s'il reste de la place ; un groupe compressé garde son extent
+    ExtentNode* leaf = &path[level];
+    Extent* last = &leaf->extents[leaf->count - 1];
+    if (last->logical + last->length == extent->logical && last->physical + last->length == extent->physical
+        && clusterBlocks(partition, inode_of_file) == 0) {
+        last->length += extent->length;
+        return writeTreeNode(partition, path_blocks[level], leaf, sizeof(ExtentNode));
+    }
+    if (leaf->count < EXTENT_LEAF_MAX) {
+        leaf->extents[leaf->count++] = *extent;
+        return writeTreeNode(partition, path_blocks[level], leaf, sizeof(ExtentNode));
+    }
+
+    // Réserver un bloc par niveau plein sur le chemin, plus un pour une nouvelle racine
+    int full_levels = 1;
+    while (full_levels <= level && path[level - full_levels].count == EXTENT_INDEX_MAX) {
+        full_levels++;
+    }
+    int needed = full_levels + (full_levels > level ? 1 : 0);
+    if (level + needed > EXTENT_TREE_MAX_DEPTH + 1) {
+        return -1;
+    }
+    int64_t new_blocks[EXTENT_TREE_MAX_DEPTH + 1];
+    for (int i = 0; i < needed; ++i) {
+        new_blocks[i] = allocateBlock(partition);
+        if (new_blocks[i] == NO_BLOCK) {
+            while (i-- > 0) {
+                freeRun(partition, new_blocks[i], 1);
+            }
+            return -1;
+        }
+    }
+
+    // Nouvelle feuille contenant l'extent
+    ExtentNode node;
+    memset(&node, 0, sizeof(node));
+    node.count = 1;
+    node.extents[0] = *extent;
+    if (writeTreeNode(partition, new_blocks[0], &node, sizeof(ExtentNode)) == -1) {
+        return -1;
+    }
+
+    // Remonter le chemin : chaque nœud plein est doublé par un nouveau nœud frère
+    uint64_t child = new_blocks[0];
+    for (int l = level - 1, used = 1; l >= 0; --l) {
+        if (path[l].count < EXTENT_INDEX_MAX) {
+            path[l].index[path[l].count].logical = extent->logical;
+            path[l].index[path[l].count].child = child;
+            path[l].count++;
+            return writeTreeNode(partition, path_blocks[l], &path[l], sizeof(ExtentNode));
+        }
+        memset(&node, 0, sizeof(node));
+        node.depth = path[l].depth;
+        node.count = 1;
+        node.index[0].logical = extent->logical;
+        node.index[0].child = child;
+        child = new_blocks[used++];
+        if (writeTreeNode(partition, child, &node, sizeof(ExtentNode)) == -1) {
+            return -1;
+        }
+    }
+
+    // La racine était pleine : l'arbre gagne un niveau
+    memset(&node, 0, sizeof(node));
+    node.depth = path[0].depth + 1;
+    node.count = 2;
+    node.index[0].logical = extentNodeStart(&path[0]);
+    node.index[0].child = path_blocks[0];
+    node.index[1].logical = extent->logical;
+    node.index[1].child = child;
+    int64_t root = new_blocks[needed - 1];
+    if (writeTreeNode(partition, root, &node, sizeof(ExtentNode)) == -1) {
+        return -1;
+    }
+    inode_of_file->extent_tree = root;
+    return 0;
+}
+
+/**
+ * @brief Donne la place que l'ajout ou le remplacement d'un extent peut occuper dans la transaction.
+ * @return Le nombre d'octets : une branche de l'arbre d'extents et ses nœuds dédoublés.
+ */
+static size_t remapJournalBytes() {
+    return (size_t)2 * (EXTENT_TREE_MAX_DEPTH + 1) * (JOURNAL_IMAGE_SIZE + JOURNAL_BLOCK_SIZE);
+}
+
+/**
+ * @brief Ajoute une suite de blocs physiques consécutifs à la fin d'un fichier.
+ * 
+ * L'extent est fusionné avec le dernier extent direct lorsqu'il le prolonge,
+ * rangé dans l'inode s'il reste de la place, et sinon dans l'arbre d'extents.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param physical Le premier bloc physique.
+ * @param length Le nombre de blocs.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int appendExtent(Partition* partition, inode* inode_of_file, uint64_t physical, uint32_t length) {
+    Extent extent = { inode_of_file->block_count, length, physical };
+
+    if (inode_of_file->extent_tree == NO_BLOCK) {
+        if (inode_of_file->num_extents > 0) {
+            Extent* last = &inode_of_file->extents[inode_of_file->num_extents - 1];
+            if (last->physical + last->length == physical) {
+                last->length += length;
+                inode_of_file->block_count += length;
+                return 0;
+            }
+        }
+        if (inode_of_file->num_extents < NUM_DIRECT_EXTENTS) {
+            inode_of_file->extents[inode_of_file->num_extents++] = extent;
+            inode_of_file->block_count += length;
+            return 0;
+        }
+    }
+
+    if (appendToExtentTree(partition, inode_of_file, &extent) == -1) {
+        return -1;
+    }
+    inode_of_file->block_count += length;
+    return 0;
+}
+
+/**
+ * @brief Associe au fichier les blocs nécessaires pour atteindre une taille donnée.
+ * 
+ * Sur une partition fragmentée, chaque extent ajouté modifie l'arbre
+ * d'extents : après le premier, les ajouts s'arrêtent avant que la
+ * transaction en cours ne remplisse le journal.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param blocks Le nombre de blocs logiques souhaité.
+ * @return Le nombre de blocs logiques associés au fichier, inférieur à blocks si la partition est pleine
+ *         ou si le journal ne peut plus recevoir d'extent.
+ */
+static uint32_t growFile(Partition* partition, inode* inode_of_file, uint32_t blocks) {
+    uint32_t initial = inode_of_file->block_count;
+    while (inode_of_file->block_count < blocks) {
+        if (inode_of_file->block_count > initial && journalRoom(&partition->journal) < remapJournalBytes()) {
+            break;
+        }
+        // Demander en une fois tous les blocs manquants pour obtenir un seul extent
+        uint32_t length;
+        int64_t start = allocRun(partition, blocks - inode_of_file->block_count, &length);
+        if (start == NO_BLOCK) {
+            break;
+        }
+        journalDirty(&partition->journal, inode_of_file, sizeof(inode));
+        if (appendExtent(partition, inode_of_file, start, length) == -1) {
+            freeRun(partition, start, length);
+            break;
+        }
+    }
+    return inode_of_file->block_count;
+}
+
+/**
+ * @brief Recherche le bloc physique associé à un bloc logique d'un fichier.
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param logical Le bloc logique (rang du bloc dans le fichier).
+ * @param run Si non NULL, reçoit le nombre de blocs physiques consécutifs à partir de ce bloc.
+ * @return Le bloc physique, NO_BLOCK si aucun bloc ne correspond.
+ */
+static int64_t mapFileBlock(Partition* partition, const inode* inode_of_file, uint32_t logical, uint32_t* run) {
+    Extent extent;
+    if (findExtent(partition, inode_of_file, logical, &extent) == -1) {
+        return NO_BLOCK;
+    }
+    if (run != NULL) {
+        *run = extent.logical + extent.length - logical;
+    }
+    return extent.physical + (logical - extent.logical);
+}
+
+/**
+ * @brief Charge dans le cache les blocs d'un fichier avant leur lecture.
+ * 
+ * Les blocs demandés sont toujours chargés ensemble, un appel système par
+ * extent. Lorsque la lecture prolonge la précédente, l'accès est considéré
+ * séquentiel : la fenêtre de lecture anticipée double (jusqu'à
+ * READAHEAD_MAX_BLOCKS) et les blocs suivants sont chargés avant d'être
+ * demandés, dès que la moitié de la fenêtre précédente a été consommée.
+ * 
+ * @param f Le fichier ouvert, qui conserve l'état de la lecture anticipée.
+ * @param inode_of_file L'inode du fichier.
+ * @param first Le premier bloc logique lu.
+ * @param last Le dernier bloc logique lu.
+ */
+static void readAhead(file* f, const inode* inode_of_file, uint32_t first, uint32_t last) {
+    Partition* partition = f->partition;
+    uint32_t end = last + 1;
+
+    // La lecture prolonge la précédente, éventuellement dans son dernier bloc
+    int sequential = first == f->readaheadNext || first + 1 == f->readaheadNext;
+    f->readaheadNext = end;
+
+    if (sequential) {
+        f->readaheadWindow = f->readaheadWindow == 0 ? READAHEAD_MIN_BLOCKS : f->readaheadWindow * 2;
+        if (f->readaheadWindow > READAHEAD_MAX_BLOCKS) {
+            f->readaheadWindow = READAHEAD_MAX_BLOCKS;
+        }
+        if (f->readaheadEnd >= end + f->readaheadWindow / 2) {
+            return; // Les blocs à venir sont déjà chargés
+        }
+        if (f->readaheadEnd > first) {
+            first = f->readaheadEnd;
+        }
+        end += f->readaheadWindow;
+    } else {
+        f->readaheadWindow = 0;
+        if (first == last) {
+            f->readaheadEnd = end;
+            return; // Un seul bloc demandé : cacheGet suffit
+        }
+    }
+
+    // Ne pas dépasser la fin du fichier
+    uint32_t file_blocks = (inode_of_file->fileSize + partition->block_size - 1) >> partition->block_shift;
+    if (end > file_blocks) {
+        end = file_blocks;
+    }
+
+    // Un chargement par suite de blocs physiques consécutifs
+    uint32_t logical = first;
+    while (logical < end) {
+        uint32_t run;
+        int64_t physical = mapFileBlock(partition, inode_of_file, logical, &run);
+        if (physical == NO_BLOCK) {
+            break;
+        }
+        if (run > end - logical) {
+            run = end - logical;
+        }
+        if (cachePrefetch(&partition->cache, physical, run) == -1) {
+            break;
+        }
+        logical += run;
+    }
+    f->readaheadEnd = logical;
+}
+
+/**
+ * @brief Rend à la table d'allocation les blocs d'un extent.
+ * 
+ * Un bloc partagé perd seulement une référence : il n'est libéré que par
+ * la dernière.
+ * 
+ * @param partition La partition.
+ * @param extent L'extent à libérer.
+ */
+static void freeExtent(Partition* partition, const Extent* extent) {
+    SuperBlock* sb = partition->superBlock;
+    uint64_t block = extent->physical, end = extent->physical + extent->length;
+    while (block < end) {
+        pthread_mutex_lock(&partition->alloc_lock);
+        while (block < end && partition->shares[block] > 0) {
+            // Les copies sur écriture lisent les compteurs sans prendre alloc_lock
+            uint16_t shares = partition->shares[block] - 1;
+            __atomic_store_n(&partition->shares[block], shares, __ATOMIC_RELAXED);
+            if (shares == 0) {
+                __atomic_store_n(&sb->shared_blocks, sb->shared_blocks - 1, __ATOMIC_RELAXED);
+                journalDirty(&partition->journal, &sb->shared_blocks, sizeof(sb->shared_blocks));
+                // Le dernier propriétaire n'est pas forcément celui de la table des empreintes
+                dedupForget(&partition->dedup, block, 1);
+            }
+            journalDirty(&partition->journal, &partition->shares[block], sizeof(uint16_t));
+            block++;
+        }
+        // Les blocs suivants n'appartiennent qu'à ce fichier, dont l'inode est verrouillé
+        uint64_t first = block;
+        while (block < end && partition->shares[block] == 0) {
+            block++;
+        }
+        pthread_mutex_unlock(&partition->alloc_lock);
+        if (block > first) {
+            freeRun(partition, first, (uint32_t)(block - first));
+        }
+    }
+}
+
+/**
+ * @brief Libère un sous-arbre d'extents et les blocs de données qu'il référence.
+ * @param partition La partition.
+ * @param block Le bloc contenant la racine du sous-arbre.
+ */
+static void freeExtentTree(Partition* partition, uint64_t block) {
+    ExtentNode node;
+    if (readTreeNode(partition, block, &node, sizeof(ExtentNode)) == 0) {
+        for (int i = 0; i < node.count; ++i) {
+            if (node.depth == 0) {
+                freeExtent(partition, &node.extents[i]);
+            } else {
+                freeExtentTree(partition, node.index[i].child);
+            }
+        }
+    }
+    // Le bloc peut recevoir des données : ses images journalisées ne doivent plus l'écraser
+    journalRevokeBlock(&partition->journal, block);
+    freeRun(partition, block, 1);
+}
+
+/**
+ * @brief Descend l'arbre d'extents d'un fichier jusqu'à la feuille couvrant un bloc logique.
+ * @param partition La partition.
+ * @param root Le bloc de la racine de l'arbre.
+ * @param logical Le bloc logique recherché.
+ * @param path Les nœuds traversés, de la racine à la feuille.
+ * @param path_blocks Les blocs de ces nœuds.
+ * @param slots L'indice du fils suivi dans chaque nœud interne traversé.
+ * @return Le niveau de la feuille dans path (0 si la racine est une feuille), -1 en cas d'erreur.
+ */
+static int descendExtentTree(Partition* partition, uint64_t root, uint32_t logical, ExtentNode* path, uint64_t* path_blocks, int* slots) {
+    path_blocks[0] = root;
+    for (int level = 0; level < EXTENT_TREE_MAX_DEPTH; ++level) {
+        if (readTreeNode(partition, path_blocks[level], &path[level], sizeof(ExtentNode)) == -1 || path[level].count == 0) {
+            return -1;
+        }
+        if (path[level].depth == 0) {
+            return level;
+        }
+        if (level + 1 == EXTENT_TREE_MAX_DEPTH) {
+            return -1;
+        }
+        slots[level] = searchExtentIndex(&path[level], logical);
+        path_blocks[level + 1] = path[level].index[slots[level]].child;
+    }
+    return -1;
+}
+
+/**
+ * @brief Remplace une partie d'un extent d'un tableau par une suite de blocs physiques.
+ * 
+ * L'extent est coupé en au plus trois extents, et la partie remplacée est
+ * fusionnée avec l'extent voisin qu'elle prolonge.
+ * 
+ * @param result Le tableau résultat, d'au moins count + 2 places.
+ * @param extents Les extents, triés par bloc logique.
+ * @param count Le nombre d'extents.
+ * @param index L'indice de l'extent contenant la partie remplacée.
+ * @param logical Le premier bloc logique remplacé.
+ * @param length Le nombre de blocs remplacés, sans dépasser la fin de l'extent.
+ * @param physical Le premier bloc physique de remplacement.
+ * @return Le nombre d'extents de result.
+ */
+static int spliceExtent(Extent* result, const Extent* extents, int count, int index, uint32_t logical, uint32_t length, uint64_t physical) {
+    const Extent* old = &extents[index];
+    int n = 0;
+    for (int i = 0; i < index; ++i) {
+        result[n++] = extents[i];
+    }
+    if (logical > old->logical) {
+        result[n++] = (Extent){ old->logical, logical - old->logical, old->physical };
+    }
+    Extent* previous = n > 0 ? &result[n - 1] : NULL;
+    if (previous != NULL && previous->logical + previous->length == logical && previous->physical + previous->length == physical) {
+        previous->length += length;
+    } else {
+        result[n++] = (Extent){ logical, length, physical };
+    }
+
+    uint32_t end = logical + length, old_end = old->logical + old->length;
+    int next = index + 1;
+    if (end < old_end) {
+        result[n++] = (Extent){ end, old_end - end, old->physical + (end - old->logical) };
+    } else if (next < count && extents[next].physical == physical + length) {
+        result[n - 1].length += extents[next++].length;
+    }
+    while (next < count) {
+        result[n++] = extents[next++];
+    }
+    return n;
+}
+
+/**
+ * @brief Reporte dans les nœuds parents le nouveau premier bloc logique d'un nœud.
+ * @param partition La partition.
+ * @param path Les nœuds traversés, de la racine au nœud modifié.
+ * @param path_blocks Les blocs de ces nœuds.
+ * @param slots L'indice du fils suivi dans chaque nœud interne traversé.
+ * @param level Le niveau du nœud modifié dans path.
+ * @param first Son premier bloc logique.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int updateExtentKeys(Partition* partition, ExtentNode* path, const uint64_t* path_blocks, const int* slots, int level, uint32_t first) {
+    for (int l = level - 1; l >= 0; --l) {
+        ExtentIndex* entry = &path[l].index[slots[l]];
+        if (entry->logical == first) {
+            return 0;
+        }
+        entry->logical = first;
+        if (writeTreeNode(partition, path_blocks[l], &path[l], sizeof(ExtentNode)) == -1) {
+            return -1;
+        }
+        // Seul le premier fils d'un nœud en donne le premier bloc logique
+        if (slots[l] != 0) {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Réécrit une feuille de l'arbre d'extents avec de nouveaux extents, en la dédoublant s'ils n'y tiennent plus.
+ * 
+ * Comme pour appendToExtentTree, chaque nœud plein du chemin est dédoublé,
+ * l'arbre gagne un niveau lorsque la racine est pleine, et les blocs des
+ * nouveaux nœuds sont réservés avant toute modification.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param path Les nœuds traversés, de la racine à la feuille.
+ * @param path_blocks Les blocs de ces nœuds.
+ * @param slots L'indice du fils suivi dans chaque nœud interne traversé.
+ * @param level Le niveau de la feuille dans path.
+ * @param extents Les nouveaux extents de la feuille, triés par bloc logique.
+ * @param count Leur nombre, au plus EXTENT_LEAF_MAX + 2.
+ * @return 0 en cas de succès, -1 si la partition est pleine ou en cas d'erreur.
+ */
+static int storeExtentLeaf(Partition* partition, inode* inode_of_file, ExtentNode* path, uint64_t* path_blocks, int* slots, int level, const Extent* extents, int count) {
+    ExtentNode* leaf = &path[level];
+    if (count <= (int)EXTENT_LEAF_MAX) {
+        memset(leaf->extents, 0, sizeof(leaf->extents));
+        memcpy(leaf->extents, extents, count * sizeof(Extent));
+        leaf->count = count;
+        if (writeTreeNode(partition, path_blocks[level], leaf, sizeof(ExtentNode)) == -1) {
+            return -1;
+        }
+        return updateExtentKeys(partition, path, path_blocks, slots, level, extents[0].logical);
+    }
+
+    // Réserver un bloc par niveau plein sur le chemin, plus un pour une nouvelle racine
+    int full_levels = 1;
+    while (full_levels <= level && path[level - full_levels].count == EXTENT_INDEX_MAX) {
+        full_levels++;
+    }
+    int needed = full_levels + (full_levels > level ? 1 : 0);
+    if (level + needed > EXTENT_TREE_MAX_DEPTH + 1) {
+        return -1;
+    }
+    int64_t new_blocks[EXTENT_TREE_MAX_DEPTH + 1];
+    for (int i = 0; i < needed; ++i) {
+        new_blocks[i] = allocateBlock(partition);
+        if (new_blocks[i] == NO_BLOCK) {
+            while (i-- > 0) {
+                freeRun(partition, new_blocks[i], 1);
+            }
+            return -1;
+        }
+    }
+
+    // Partager les extents entre la feuille et une nouvelle feuille sœur
+    int half = count / 2;
+    ExtentNode node;
+    memset(leaf->extents, 0, sizeof(leaf->extents));
+    memcpy(leaf->extents, extents, half * sizeof(Extent));
+    leaf->count = half;
+    memset(&node, 0, sizeof(node));
+    memcpy(node.extents, extents + half, (count - half) * sizeof(Extent));
+    node.count = count - half;
+    if (writeTreeNode(partition, path_blocks[level], leaf, sizeof(ExtentNode)) == -1 ||
+        writeTreeNode(partition, new_blocks[0], &node, sizeof(ExtentNode)) == -1 ||
+        updateExtentKeys(partition, path, path_blocks, slots, level, extents[0].logical) == -1) {
+        return -1;
+    }
+
+    // Insérer le nouveau nœud après son frère, en dédoublant les parents pleins
+    ExtentIndex sibling;
+    memset(&sibling, 0, sizeof(sibling));
+    sibling.logical = extents[half].logical;
+    sibling.child = new_blocks[0];
+    for (int l = level - 1, used = 1; l >= 0; --l) {
+        ExtentIndex entries[EXTENT_INDEX_MAX + 1];
+        int n = path[l].count, slot = slots[l] + 1;
+        memcpy(entries, path[l].index, slot * sizeof(ExtentIndex));
+        entries[slot] = sibling;
+        memcpy(entries + slot + 1, path[l].index + slot, (n - slot) * sizeof(ExtentIndex));
+        n++;
+        if (n <= (int)EXTENT_INDEX_MAX) {
+            memcpy(path[l].index, entries, n * sizeof(ExtentIndex));
+            path[l].count = n;
+            return writeTreeNode(partition, path_blocks[l], &path[l], sizeof(ExtentNode));
+        }
+        half = n / 2;
+        memset(path[l].index, 0, sizeof(path[l].index));
+        memcpy(path[l].index, entries, half * sizeof(ExtentIndex));
+        path[l].count = half;
+        memset(&node, 0, sizeof(node));
+        node.depth = path[l].depth;
+        memcpy(node.index, entries + half, (n - half) * sizeof(ExtentIndex));
+        node.count = n - half;
+        sibling.logical = entries[half].logical;
+        sibling.child = new_blocks[used++];
+        if (writeTreeNode(partition, path_blocks[l], &path[l], sizeof(ExtentNode)) == -1 ||
+            writeTreeNode(partition, sibling.child, &node, sizeof(ExtentNode)) == -1) {
+            return -1;
+        }
+    }
+
+    // La racine a été dédoublée : l'arbre gagne un niveau
+    memset(&node, 0, sizeof(node));
+    node.depth = path[0].depth + 1;
+    node.count = 2;
+    node.index[0].logical = extentNodeStart(&path[0]);
+    node.index[0].child = path_blocks[0];
+    node.index[1] = sibling;
+    int64_t root = new_blocks[needed - 1];
+    if (writeTreeNode(partition, root, &node, sizeof(ExtentNode)) == -1) {
+        return -1;
+    }
+    journalDirty(&partition->journal, &inode_of_file->extent_tree, sizeof(inode_of_file->extent_tree));
+    inode_of_file->extent_tree = root;
+    return 0;
+}
+
+/**
+ * @brief Ajoute au début de l'arbre d'extents d'un fichier des extents qui précèdent tous les siens.
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param extents Les extents, triés par bloc logique.
+ * @param count Leur nombre, au plus 2.
+ * @return 0 en cas de succès, -1 si la partition est pleine ou en cas d'erreur.
+ */
+static int prependToExtentTree(Partition* partition, inode* inode_of_file, const Extent* extents, int count) {
+    if (inode_of_file->extent_tree == NO_BLOCK) {
+        journalDirty(&partition->journal, &inode_of_file->extent_tree, sizeof(inode_of_file->extent_tree));
+        for (int i = 0; i < count; ++i) {
+            if (appendToExtentTree(partition, inode_of_file, &extents[i]) == -1) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    ExtentNode path[EXTENT_TREE_MAX_DEPTH];
+    uint64_t path_blocks[EXTENT_TREE_MAX_DEPTH];
+    int slots[EXTENT_TREE_MAX_DEPTH];
+    int level = descendExtentTree(partition, inode_of_file->extent_tree, extents[0].logical, path, path_blocks, slots);
+    if (level == -1) {
+        return -1;
+    }
+    Extent merged[EXTENT_LEAF_MAX + 2];
+    memcpy(merged, extents, count * sizeof(Extent));
+    memcpy(merged + count, path[level].extents, path[level].count * sizeof(Extent));
+    return storeExtentLeaf(partition, inode_of_file, path, path_blocks, slots, level, merged, count + path[level].count);
+}
+
+/**
+ * @brief Associe une partie d'un extent d'un fichier à d'autres blocs physiques (verrou en écriture de l'inode pris).
+ * 
+ * Seul le conteneur de l'extent est réécrit : l'inode pour un extent direct,
+ * sa feuille sinon. Les extents directs qui ne tiennent plus dans l'inode
+ * passent au début de l'arbre d'extents, avant que l'inode ne soit modifié.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param logical Le premier bloc logique.
+ * @param length Le nombre de blocs, dans un même extent.
+ * @param physical Le premier bloc physique de remplacement.
+ * @return 0 en cas de succès, -1 si la partition est pleine ou en cas d'erreur.
+ */
+static int remapExtent(Partition* partition, inode* inode_of_file, uint32_t logical, uint32_t length, uint64_t physical) {
+    int found = searchExtent(inode_of_file->extents, inode_of_file->num_extents, logical);
+    if (found != -1) {
+        Extent extents[NUM_DIRECT_EXTENTS + 2];
+        int count = spliceExtent(extents, inode_of_file->extents, inode_of_file->num_extents, found, logical, length, physical);
+        int direct = count < NUM_DIRECT_EXTENTS ? count : NUM_DIRECT_EXTENTS;
+        if (count > direct && prependToExtentTree(partition, inode_of_file, extents + direct, count - direct) == -1) {
+            return -1;
+        }
+        journalDirty(&partition->journal, inode_of_file, sizeof(inode));
+        memcpy(inode_of_file->extents, extents, direct * sizeof(Extent));
+        inode_of_file->num_extents = direct;
+        return 0;
+    }
+    if (inode_of_file->extent_tree == NO_BLOCK) {
+        return -1;
+    }
+
+    ExtentNode path[EXTENT_TREE_MAX_DEPTH];
+    uint64_t path_blocks[EXTENT_TREE_MAX_DEPTH];
+    int slots[EXTENT_TREE_MAX_DEPTH];
+    int level = descendExtentTree(partition, inode_of_file->extent_tree, logical, path, path_blocks, slots);
+    found = level == -1 ? -1 : searchExtent(path[level].extents, path[level].count, logical);
+    if (found == -1) {
+        return -1;
+    }
+    Extent extents[EXTENT_LEAF_MAX + 2];
+    int count = spliceExtent(extents, path[level].extents, path[level].count, found, logical, length, physical);
+    return storeExtentLeaf(partition, inode_of_file, path, path_blocks, slots, level, extents, count);
+}
+
+/**
+ * @brief Remplace des blocs partagés d'un fichier par des copies qui lui sont propres (verrou en écriture de l'inode pris).
+ * 
+ * Le contenu des blocs est relu sur la partition, sauf s'ils vont être
+ * entièrement écrasés : un bloc partagé n'est jamais modifié dans le cache.
+ * Les codes de contrôle suivent les blocs copiés, et les anciens blocs
+ * perdent une référence. Chaque suite de copies modifie l'arbre d'extents :
+ * sauf pour la première si first vaut 1, la copie s'arrête avant que la
+ * transaction en cours ne remplisse le journal.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param logical Le premier bloc logique.
+ * @param physical Le bloc physique correspondant.
+ * @param length Le nombre de blocs, dans un même extent.
+ * @param copy_data 1 pour recopier le contenu des blocs, 0 s'ils vont être écrasés.
+ * @param first 1 si aucune copie n'a encore été faite pendant l'opération.
+ * @return Le nombre de blocs copiés, inférieur à length si le journal est presque plein ou si
+ *         la partition se remplit après une première copie, -1 si aucun bloc n'a pu être copié.
+ */
+static int64_t copySharedRun(Partition* partition, inode* inode_of_file, uint32_t logical, uint64_t physical, uint32_t length, int copy_data, int first) {
+    char* data = NULL;
+    if (copy_data) {
+        size_t size = (size_t)length << partition->block_shift;
+        data = malloc(size);
+        if (data == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour la copie de blocs partagés");
+            return -1;
+        }
+        if (partitionRead(partition, data, size, dataBlockOffset(partition, physical)) != (ssize_t)size) {
+            free(data);
+            return -1;
+        }
+    }
+
+    int status = 0;
+    uint32_t done = 0;
+    while (done < length) {
+        if ((done > 0 || !first) && journalRoom(&partition->journal) < remapJournalBytes()) {
+            break;
+        }
+        uint32_t copied;
+        int64_t start = allocRun(partition, length - done, &copied);
+        if (start == NO_BLOCK) {
+            status = -1;
+            break;
+        }
+        size_t bytes = (size_t)copied << partition->block_shift;
+        if (data != NULL && partitionWrite(partition, data + ((size_t)done << partition->block_shift), bytes, dataBlockOffset(partition, start)) != (ssize_t)bytes) {
+            freeRun(partition, start, copied);
+            status = -1;
+            break;
+        }
+        for (uint32_t i = 0; i < copied; ++i) {
+            uint32_t checksum = data != NULL ? __atomic_load_n(&partition->checksums[physical + done + i], __ATOMIC_RELAXED) : 0;
+            __atomic_store_n(&partition->checksums[start + i], checksum, __ATOMIC_RELAXED);
+        }
+        dirtyBlockChecksums(partition, start, copied);
+        if (remapExtent(partition, inode_of_file, logical + done, copied, start) == -1) {
+            freeRun(partition, start, copied);
+            status = -1;
+            break;
+        }
+        Extent old = { logical + done, copied, physical + done };
+        freeExtent(partition, &old);
+        statsAdd(&partition->stats, STATS_BLOCKS_COPIED, copied);
+        done += copied;
+    }
+    free(data);
+    // Les blocs déjà copiés appartiennent au fichier : l'écriture doit pouvoir les recouvrir
+    return status == 0 || done > 0 ? (int64_t)done : -1;
+}
+
+/**
+ * @brief Copie les blocs partagés d'une partie d'un fichier avant son écriture (verrou en écriture de l'inode pris).
+ * 
+ * Les blocs sont copiés par groupes alignés de COW_GROUP_BLOCKS blocs, afin
+ * que des écritures voisines ne découpent pas les extents du fichier bloc
+ * par bloc. Seuls les blocs que l'écriture ne recouvre pas entièrement sont
+ * relus. Après la première suite copiée, la copie s'arrête avant que la
+ * transaction en cours ne remplisse le journal, ou lorsque la partition est
+ * pleine : l'écriture doit alors se limiter à la partie déjà copiée, dont
+ * les blocs non relus n'ont pas encore de contenu.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier, dont les blocs couvrent déjà la partie écrite.
+ * @param offset La position du premier octet écrit.
+ * @param end La position qui suit le dernier octet écrit.
+ * @return La position, entre offset et end, jusqu'à laquelle la partie écrite n'a plus de bloc partagé,
+ *         -1 si aucun bloc n'a pu être copié.
+ */
+static int64_t unshareBlocks(Partition* partition, inode* inode_of_file, int64_t offset, int64_t end) {
+    // Aucun bloc partagé sur la partition : rien à examiner
+    if (offset >= end || __atomic_load_n(&partition->superBlock->shared_blocks, __ATOMIC_RELAXED) == 0) {
+        return end;
+    }
+
+    uint32_t mask = partition->block_size - 1;
+    // Blocs entièrement écrasés : l'écriture atteint la fin du fichier ou la fin du bloc
+    uint64_t full_first = ((uint64_t)offset + mask) >> partition->block_shift;
+    uint64_t full_end = (uint64_t)(end >= inode_of_file->fileSize ? end + mask : end) >> partition->block_shift;
+    uint64_t logical = ((uint64_t)offset >> partition->block_shift) & ~(uint64_t)(COW_GROUP_BLOCKS - 1);
+    uint64_t last = (((uint64_t)(end - 1) >> partition->block_shift) | (COW_GROUP_BLOCKS - 1)) + 1;
+    if (last > inode_of_file->block_count) {
+        last = inode_of_file->block_count;
+    }
+
+    int copied_any = 0;
+    while (logical < last) {
+        uint32_t run;
+        int64_t physical = mapFileBlock(partition, inode_of_file, logical, &run);
+        if (physical == NO_BLOCK) {
+            return -1;
+        }
+        // Ne pas mêler blocs relus et blocs écrasés
+        uint64_t limit = logical < full_first ? full_first : logical < full_end ? full_end : last;
+        if (limit > last) {
+            limit = last;
+        }
+        if (run > limit - logical) {
+            run = limit - logical;
+        }
+        int copy_data = logical < full_first || logical >= full_end;
+
+        uint32_t i = 0;
+        while (i < run) {
+            uint32_t first = i;
+            while (i < run && __atomic_load_n(&partition->shares[physical + i], __ATOMIC_RELAXED) > 0) {
+                i++;
+            }
+            if (i > first) {
+                int64_t copied = copySharedRun(partition, inode_of_file, logical + first, physical + first, i - first, copy_data, !copied_any);
+                if (copied == -1 && !copied_any) {
+                    return -1;
+                }
+                copied_any = 1;
+                if (copied < i - first) {
+                    // Journal presque plein ou partition pleine : seuls les blocs qui précèdent sont propres
+                    // au fichier, et ceux qui n'ont pas été relus doivent être écrasés par l'écriture
+                    copied = copied > 0 ? copied : 0;
+                    int64_t stop = (int64_t)(logical + first + copied) << partition->block_shift;
+                    return stop < offset ? offset : stop < end ? stop : end;
+                }
+            }
+            while (i < run && __atomic_load_n(&partition->shares[physical + i], __ATOMIC_RELAXED) == 0) {
+                i++;
+            }
+        }
+        logical += run;
+    }
+    return end;
+}
+
+/**
+ * @brief Ajoute une référence à un bloc de même contenu qu'un bloc à écrire (verrou en écriture de l'inode pris).
+ * 
+ * Un bloc déjà partagé ne change plus : il gagne une référence sans autre
+ * verrou. Un bloc qui ne l'est pas encore peut être modifié par son
+ * propriétaire, dont le verrou en lecture est pris pendant la comparaison ;
+ * s'il n'est pas libre tout de suite, le bloc n'est pas partagé, pour
+ * respecter l'ordre des verrous. Ce bloc est alors écrit sur la partition,
+ * car les copies sur écriture y relisent les blocs partagés. Le contenu
+ * n'est comparé qu'après l'ajout de la référence, qui est rendue s'il
+ * diffère.
+ * 
+ * @param partition La partition.
+ * @param inode_number L'inode du fichier écrit.
+ * @param block Le bloc trouvé d'après l'empreinte des octets.
+ * @param owner L'inode propriétaire du bloc selon la table des empreintes.
+ * @param data Les octets à écrire, un bloc entier.
+ * @return 0 si le bloc a le contenu voulu et une référence de plus, -1 sinon.
+ */
+static int shareIdentical(Partition* partition, uint32_t inode_number, uint64_t block, uint32_t owner, const char* data) {
+    SuperBlock* sb = partition->superBlock;
+    pthread_rwlock_t* owner_lock = NULL;
+    if (owner != inode_number && __atomic_load_n(&partition->shares[block], __ATOMIC_RELAXED) == 0) {
+        owner_lock = inodeLock(partition, owner);
+        if (pthread_rwlock_tryrdlock(owner_lock) != 0) {
+            return -1;
+        }
+    }
+
+    // Le propriétaire relu sous alloc_lock ne peut plus libérer le bloc
+    int status = -1;
+    pthread_mutex_lock(&partition->alloc_lock);
+    uint16_t shares = partition->shares[block];
+    if (shares < MAX_SHARES && dedupOwner(&partition->dedup, block) == owner && (shares > 0 || owner_lock != NULL || owner == inode_number)) {
+        if (shares == 0) {
+            __atomic_store_n(&sb->shared_blocks, sb->shared_blocks + 1, __ATOMIC_RELAXED);
+            journalDirty(&partition->journal, &sb->shared_blocks, sizeof(sb->shared_blocks));
+        }
+        __atomic_store_n(&partition->shares[block], shares + 1, __ATOMIC_RELAXED);
+        journalDirty(&partition->journal, &partition->shares[block], sizeof(uint16_t));
+        status = 0;
+    }
+    pthread_mutex_unlock(&partition->alloc_lock);
+
+    if (status == 0) {
+        Buffer* block_buffer = cacheGet(&partition->cache, block, CACHE_READ);
+        if (block_buffer == NULL || memcmp(block_buffer->data, data, partition->block_size) != 0) {
+            status = -1;
+        } else if (shares == 0) {
+            if (partitionWrite(partition, data, partition->block_size, dataBlockOffset(partition, block)) != (ssize_t)partition->block_size) {
+                status = -1;
+            } else {
+                setBlockChecksum(partition, block, data);
+                dirtyBlockChecksums(partition, block, 1);
+            }
+        }
+        if (block_buffer != NULL) {
+            cacheRelease(&partition->cache, block_buffer, 0);
+        }
+        if (status == -1) {
+            Extent added = { 0, 1, block };
+            freeExtent(partition, &added);
+        }
+    }
+    if (owner_lock != NULL) {
+        pthread_rwlock_unlock(owner_lock);
+    }
+    return status;
+}
+
+/**
+ * @brief Partage un bloc entier à écrire avec un bloc déjà écrit de même contenu (verrou en écriture de l'inode pris).
+ * 
+ * L'empreinte des octets est cherchée dans la table des empreintes. Si un
+ * bloc identique est trouvé, le bloc logique le désigne et son ancien bloc
+ * est libéré ; sinon, l'empreinte est rangée pour le bloc du fichier, que
+ * l'appelant écrit. Rien n'est partagé lorsque la transaction en cours
+ * laisse trop peu de place pour modifier l'arbre d'extents.
+ * 
+ * @param partition La partition.
+ * @param inode_number L'inode du fichier.
+ * @param inode_of_file Son contenu.
+ * @param logical Le bloc logique écrit.
+ * @param physical Le bloc physique qui lui est associé, propre au fichier.
+ * @param data Les octets à écrire, un bloc entier.
+ * @return 1 si le bloc logique désigne désormais un bloc identique, 0 s'il reste à écrire.
+ */
+static int dedupBlock(Partition* partition, uint32_t inode_number, inode* inode_of_file, uint32_t logical, uint64_t physical, const char* data) {
+    uint64_t start = statsNow();
+    uint64_t fingerprint = dedupFingerprint(data, partition->block_size);
+    uint32_t owner = NO_INODE;
+    int64_t found = journalRoom(&partition->journal) >= remapJournalBytes() ? dedupLookup(&partition->dedup, fingerprint, &owner) : NO_BLOCK;
+    int shared = found != NO_BLOCK && (uint64_t)found != physical && shareIdentical(partition, inode_number, found, owner, data) == 0;
+    if (shared) {
+        Extent old = { logical, 1, physical }, added = { logical, 1, found };
+        if (remapExtent(partition, inode_of_file, logical, 1, found) == 0) {
+            freeExtent(partition, &old);
+            statsAdd(&partition->stats, STATS_DEDUP_BLOCKS, 1);
+        } else {
+            freeExtent(partition, &added);
+            shared = 0;
+        }
+    }
+    if (!shared) {
+        dedupInsert(&partition->dedup, fingerprint, physical, inode_number);
+    }
+    statsAdd(&partition->stats, STATS_DEDUP_HASHED, 1);
+    statsAdd(&partition->stats, STATS_DEDUP_NANOSECONDS, statsNow() - start);
+    return shared;
+}
+
+/**
+ * @brief Rend à la table d'allocation les blocs de données et les nœuds de l'arbre d'extents d'un fichier.
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ */
+static void freeFileBlocks(Partition* partition, const inode* inode_of_file) {
+    if (inode_of_file->flags & INODE_INLINE) {
+        return;
+    }
+    for (uint32_t e = 0; e < inode_of_file->num_extents; ++e) {
+        freeExtent(partition, &inode_of_file->extents[e]);
+    }
+    if (inode_of_file->extent_tree != NO_BLOCK) {
+        freeExtentTree(partition, inode_of_file->extent_tree);
+    }
+}
+
+/**
+ * @brief Lit une partie d'un groupe de blocs d'un fichier compressé (verrou de l'inode pris).
+ * 
+ * Un groupe stocké tel quel n'est lu que sur les blocs demandés. Un groupe
+ * compressé est lu entier, vérifié, puis décompressé seulement jusqu'au
+ * dernier octet demandé, directement dans le tampon de destination
+ * lorsque la lecture commence au début du groupe.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param logical Le premier bloc logique du groupe.
+ * @param offset La position dans le groupe.
+ * @param data Le tampon de destination.
+ * @param length Le nombre d'octets, sans dépasser la fin du groupe.
+ * @param scratch Un tampon de travail de 2 * COMPRESS_CLUSTER_SIZE octets.
+ * @return 0 en cas de succès, -1 en cas d'erreur (errno vaut EBADMSG si un bloc ou le groupe est corrompu).
+ */
+static int readCluster(Partition* partition, const inode* inode_of_file, uint32_t logical, uint32_t offset, char* data, uint32_t length, char* scratch) {
+    Extent extent;
+    if (findExtent(partition, inode_of_file, logical, &extent) == -1 || extent.logical != logical) {
+        return -1;
+    }
+    unsigned shift = partition->block_shift;
+    uint32_t span = inode_of_file->block_count - logical;
+    if (span > partition->cluster_blocks) {
+        span = partition->cluster_blocks;
+    }
+
+    // Stocké tel quel : seuls les blocs touchés sont lus
+    uint32_t first = extent.length == span ? offset >> shift : 0;
+    uint32_t count = extent.length == span ? ((offset + length - 1) >> shift) + 1 - first : extent.length;
+    size_t bytes = (size_t)count << shift;
+    if (partitionRead(partition, scratch, bytes, dataBlockOffset(partition, extent.physical + first)) != (ssize_t)bytes) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        if (verifyBlockChecksum(partition, extent.physical + first + i, scratch + ((size_t)i << shift)) == -1) {
+            return -1;
+        }
+    }
+    if (extent.length == span) {
+        memcpy(data, scratch + (offset & (partition->block_size - 1)), length);
+        return 0;
+    }
+
+    ClusterHeader header;
+    memcpy(&header, scratch, sizeof(header));
+    const Codec* codec = codecGet(header.codec);
+    if (codec == NULL || header.size > bytes - sizeof(header)) {
+        errno = EBADMSG;
+        return -1;
+    }
+    char* raw = offset == 0 ? data : scratch + COMPRESS_CLUSTER_SIZE;
+    if (codec->decompress(scratch + sizeof(header), header.size, raw, offset + length) != offset + length) {
+        errno = EBADMSG;
+        return -1;
+    }
+    if (raw != data) {
+        memcpy(data, raw + offset, length);
+    }
+    return 0;
+}
+
+/**
+ * @brief Remplace ou ajoute l'extent d'un groupe de blocs d'un fichier compressé (verrou en écriture de l'inode pris).
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param extent Le nouvel extent du groupe.
+ * @return 0 en cas de succès, -1 si la partition est pleine ou en cas d'erreur.
+ */
+static int setClusterExtent(Partition* partition, inode* inode_of_file, const Extent* extent) {
+    // Un groupe au-delà des blocs du fichier suit tous les autres
+    if (extent->logical >= inode_of_file->block_count) {
+        journalDirty(&partition->journal, inode_of_file, sizeof(inode));
+        if (inode_of_file->extent_tree == NO_BLOCK && inode_of_file->num_extents < NUM_DIRECT_EXTENTS) {
+            inode_of_file->extents[inode_of_file->num_extents++] = *extent;
+            return 0;
+        }
+        return appendToExtentTree(partition, inode_of_file, extent);
+    }
+
+    // Le premier bloc logique du groupe ne change pas : les clés de l'arbre non plus
+    int found = searchExtent(inode_of_file->extents, inode_of_file->num_extents, extent->logical);
+    if (found != -1) {
+        journalDirty(&partition->journal, &inode_of_file->extents[found], sizeof(Extent));
+        inode_of_file->extents[found] = *extent;
+        return 0;
+    }
+    if (inode_of_file->extent_tree == NO_BLOCK) {
+        return -1;
+    }
+    ExtentNode path[EXTENT_TREE_MAX_DEPTH];
+    uint64_t path_blocks[EXTENT_TREE_MAX_DEPTH];
+    int slots[EXTENT_TREE_MAX_DEPTH];
+    int level = descendExtentTree(partition, inode_of_file->extent_tree, extent->logical, path, path_blocks, slots);
+    found = level == -1 ? -1 : searchExtent(path[level].extents, path[level].count, extent->logical);
+    if (found == -1) {
+        return -1;
+    }
+    path[level].extents[found] = *extent;
+    return writeTreeNode(partition, path_blocks[level], &path[level], sizeof(ExtentNode));
+}
+
+/**
+ * @brief Stocke un groupe de blocs d'un fichier compressé dans de nouveaux blocs (verrou en écriture de l'inode pris).
+ * 
+ * Le groupe est compressé s'il occupe alors au moins un bloc de moins,
+ * et stocké tel quel sinon. Il est écrit directement dans des blocs
+ * consécutifs nouvellement alloués, avec leurs codes de contrôle, puis son
+ * extent est remplacé : les anciens blocs, peut-être partagés avec une
+ * copie du fichier, ne sont jamais réécrits.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param logical Le premier bloc logique du groupe.
+ * @param raw Les octets du groupe.
+ * @param length Le nombre d'octets, au plus COMPRESS_CLUSTER_SIZE.
+ * @param scratch Un tampon de travail de COMPRESS_CLUSTER_SIZE octets.
+ * @return 0 en cas de succès, -1 si la partition est pleine (errno vaut ENOSPC) ou en cas d'erreur.
+ */
+static int storeCluster(Partition* partition, inode* inode_of_file, uint32_t logical, const char* raw, uint32_t length, char* scratch) {
+    unsigned shift = partition->block_shift;
+    uint32_t block_size = partition->block_size;
+    uint32_t span = (uint32_t)blocksFor(length, block_size);
+    const Codec* codec = codecGet(inode_of_file->flags >> INODE_CODEC_SHIFT);
+
+    // Compresser seulement si un bloc au moins est gagné
+    int64_t compressed = -1;
+    if (span > 1) {
+        compressed = codec->compress(raw, length, scratch + sizeof(ClusterHeader), ((size_t)(span - 1) << shift) - sizeof(ClusterHeader));
+    }
+    uint32_t stored = span;
+    const char* data = raw;
+    if (compressed != -1) {
+        ClusterHeader header = { (uint32_t)compressed, (uint16_t)(inode_of_file->flags >> INODE_CODEC_SHIFT), 0 };
+        memcpy(scratch, &header, sizeof(header));
+        stored = (uint32_t)blocksFor(sizeof(header) + compressed, block_size);
+        memset(scratch + sizeof(header) + compressed, 0, ((size_t)stored << shift) - sizeof(header) - compressed);
+        data = scratch;
+    } else if (length & (block_size - 1)) {
+        memcpy(scratch, raw, length);
+        memset(scratch + length, 0, ((size_t)span << shift) - length);
+        data = scratch;
+    }
+
+    // Un groupe tient dans un seul extent
+    uint32_t allocated;
+    int64_t start = allocRun(partition, stored, &allocated);
+    if (start == NO_BLOCK || allocated < stored) {
+        if (start != NO_BLOCK) {
+            freeRun(partition, start, allocated);
+        }
+        errno = ENOSPC;
+        return -1;
+    }
+    size_t bytes = (size_t)stored << shift;
+    if (partitionWrite(partition, data, bytes, dataBlockOffset(partition, start)) != (ssize_t)bytes) {
+        freeRun(partition, start, stored);
+        return -1;
+    }
+    for (uint32_t i = 0; i < stored; ++i) {
+        setBlockChecksum(partition, start + i, data + ((size_t)i << shift));
+    }
+    dirtyBlockChecksums(partition, start, stored);
+
+    Extent old;
+    int replaced = logical < inode_of_file->block_count && findExtent(partition, inode_of_file, logical, &old) == 0;
+    Extent extent = { logical, stored, (uint64_t)start };
+    if (setClusterExtent(partition, inode_of_file, &extent) == -1) {
+        freeRun(partition, start, stored);
+        return -1;
+    }
+    if (replaced) {
+        freeExtent(partition, &old);
+    }
+    if (logical + span > inode_of_file->block_count) {
+        inode_of_file->block_count = logical + span;
+        journalDirty(&partition->journal, &inode_of_file->block_count, sizeof(uint32_t));
+    }
+    statsAdd(&partition->stats, STATS_COMPRESS_INPUT, length);
+    statsAdd(&partition->stats, STATS_COMPRESS_OUTPUT, bytes);
+    return 0;
+}
+
+/**
+ * @brief Lit des octets d'un fichier compressé (verrou de l'inode pris).
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier, qui n'est pas rangé dans son inode.
+ * @param position La position dans le fichier.
+ * @param data Le tampon de destination.
+ * @param length Le nombre d'octets, sans dépasser la fin du fichier.
+ * @return 0 en cas de succès, -1 en cas d'erreur (errno vaut EBADMSG si un bloc ou un groupe est corrompu).
+ */
+static int readCompressed(Partition* partition, const inode* inode_of_file, int64_t position, char* data, int64_t length) {
+    char* scratch = malloc(2 * COMPRESS_CLUSTER_SIZE);
+    if (scratch == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour la décompression");
+        return -1;
+    }
+    unsigned shift = partition->block_shift;
+    int status = 0;
+    while (length > 0 && status == 0) {
+        uint32_t logical = (uint32_t)(position >> shift) & ~(partition->cluster_blocks - 1);
+        uint32_t offset = (uint32_t)(position - ((int64_t)logical << shift));
+        uint32_t count = COMPRESS_CLUSTER_SIZE - offset;
+        if (count > length) {
+            count = (uint32_t)length;
+        }
+        status = readCluster(partition, inode_of_file, logical, offset, data, count, scratch);
+        position += count;
+        data += count;
+        length -= count;
+    }
+    free(scratch);
+    return status;
+}
+
+/**
+ * @brief Écrit des octets dans un fichier compressé (verrou en écriture de l'inode pris).
+ * 
+ * Chaque groupe touché est relu s'il n'est pas entièrement réécrit, puis
+ * stocké de nouveau. La taille du fichier suit chaque groupe écrit.
+ * L'écriture s'arrête avant que la transaction en cours ne remplisse le
+ * journal.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier, qui n'est pas rangé dans son inode.
+ * @param position La position dans le fichier, au plus sa taille.
+ * @param data Les octets à écrire.
+ * @param length Le nombre d'octets, sans dépasser la taille maximale d'un fichier.
+ * @return Le nombre d'octets écrits, inférieur à length si la partition est pleine, -1 en cas d'erreur.
+ */
+static int64_t writeCompressed(Partition* partition, inode* inode_of_file, int64_t position, const char* data, int64_t length) {
+    char* scratch = malloc(3 * COMPRESS_CLUSTER_SIZE);
+    if (scratch == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour la compression");
+        return -1;
+    }
+    char* raw = scratch + 2 * COMPRESS_CLUSTER_SIZE;
+    unsigned shift = partition->block_shift;
+    int64_t written = 0;
+    while (length > 0) {
+        if (written > 0 && journalRoom(&partition->journal) < remapJournalBytes()) {
+            break;
+        }
+        uint32_t logical = (uint32_t)(position >> shift) & ~(partition->cluster_blocks - 1);
+        int64_t cluster_start = (int64_t)logical << shift;
+        uint32_t offset = (uint32_t)(position - cluster_start);
+        uint32_t count = COMPRESS_CLUSTER_SIZE - offset;
+        if (count > length) {
+            count = (uint32_t)length;
+        }
+        int64_t old_size = inode_of_file->fileSize - cluster_start;
+        uint32_t old_length = logical < inode_of_file->block_count ? (uint32_t)(old_size < COMPRESS_CLUSTER_SIZE ? old_size : COMPRESS_CLUSTER_SIZE) : 0;
+        uint32_t new_length = offset + count > old_length ? offset + count : old_length;
+
+        // Un groupe entièrement réécrit est compressé depuis le tampon de l'écriture
+        const char* source = data;
+        if (offset > 0 || count < old_length) {
+            if (readCluster(partition, inode_of_file, logical, 0, raw, old_length, scratch) == -1) {
+                break;
+            }
+            memcpy(raw + offset, data, count);
+            source = raw;
+        }
+        if (storeCluster(partition, inode_of_file, logical, source, new_length, scratch) == -1) {
+            break;
+        }
+        if (cluster_start + new_length > inode_of_file->fileSize) {
+            inode_of_file->fileSize = cluster_start + new_length;
+            journalDirty(&partition->journal, &inode_of_file->fileSize, sizeof(int64_t));
+        }
+        position += count;
+        data += count;
+        length -= count;
+        written += count;
+    }
+    free(scratch);
+    return written > 0 || length == 0 || errno == ENOSPC ? written : -1;
+}
+
+/**
+ * @brief Copie des octets d'un fichier rangé dans son inode (verrou de l'inode pris, en écriture pour une écriture).
+ * 
+ * Une écriture est journalisée avec l'inode et prolonge le fichier si
+ * besoin : aucun bloc de données n'est lu ni écrit.
+ * 
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier, marqué INODE_INLINE.
+ * @param position La position dans le fichier, au plus sa taille.
+ * @param data Le tampon source ou destination.
+ * @param length Le nombre d'octets, qui ne dépasse pas la fin du fichier pour une lecture, ni INLINE_DATA_MAX pour une écriture.
+ * @param write_mode 1 pour écrire, 0 pour lire.
+ */
+static void transferInline(Partition* partition, inode* inode_of_file, int64_t position, void* data, int64_t length, int write_mode) {
+    if (!write_mode) {
+        memcpy(data, inode_of_file->inline_data + position, length);
+        return;
+    }
+    memcpy(inode_of_file->inline_data + position, data, length);
+    journalDirty(&partition->journal, inode_of_file->inline_data + position, length);
+    if (position + length > inode_of_file->fileSize) {
+        inode_of_file->fileSize = position + length;
+        journalDirty(&partition->journal, &inode_of_file->fileSize, sizeof(int64_t));
+    }
+}
+
+/**
+ * @brief Range dans un bloc de données les octets d'un fichier qui ne tient plus dans son inode (verrou en écriture de l'inode pris).
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier, marqué INODE_INLINE.
+ * @return 0 en cas de succès, -1 si la partition est pleine ou en cas d'erreur, le fichier restant alors dans son inode.
+ */
+static int moveInlineData(Partition* partition, inode* inode_of_file) {
+    char data[INLINE_DATA_MAX];
+    memcpy(data, inode_of_file->inline_data, sizeof(data));
+    journalDirty(&partition->journal, inode_of_file, sizeof(inode));
+    memset(inode_of_file->inline_data, 0, sizeof(data));
+    inode_of_file->flags &= ~INODE_INLINE;
+    inode_of_file->extent_tree = NO_BLOCK;
+    if (inode_of_file->fileSize == 0) {
+        return 0;
+    }
+
+    // Le premier groupe d'un fichier compressé est stocké directement
+    if (clusterBlocks(partition, inode_of_file) != 0) {
+        if (writeCompressed(partition, inode_of_file, 0, data, inode_of_file->fileSize) == inode_of_file->fileSize) {
+            return 0;
+        }
+        inode_of_file->flags |= INODE_INLINE;
+        memcpy(inode_of_file->inline_data, data, sizeof(data));
+        return -1;
+    }
+
+    // Le premier bloc est écrit à travers le cache comme une écriture ordinaire
+    Buffer* block_buffer = NULL;
+    if (growFile(partition, inode_of_file, 1) == 1) {
+        block_buffer = cacheGet(&partition->cache, inode_of_file->extents[0].physical, CACHE_OVERWRITE);
+        if (block_buffer == NULL) {
+            freeExtent(partition, &inode_of_file->extents[0]);
+        }
+    }
+    if (block_buffer == NULL) {
+        inode_of_file->num_extents = 0;
+        inode_of_file->block_count = 0;
+        inode_of_file->flags |= INODE_INLINE;
+        memcpy(inode_of_file->inline_data, data, sizeof(data));
+        return -1;
+    }
+    memset(block_buffer->data, 0, partition->block_size);
+    memcpy(block_buffer->data, data, inode_of_file->fileSize);
+    cacheRelease(&partition->cache, block_buffer, 1);
+    return 0;
+}
+
+/**
+ * @brief Recherche le fils d'un nœud interne de l'arbre d'un répertoire où commencent les entrées d'une empreinte.
+ * 
+ * Des entrées de même empreinte peuvent terminer le fils qui précède celui
+ * dont la première empreinte est égale : la recherche s'arrête au dernier
+ * fils dont l'empreinte est strictement inférieure.
+ * 
+ * @param node Le nœud interne.
+ * @param hash L'empreinte recherchée.
+ * @return L'indice de la dernière entrée dont l'empreinte est inférieure à hash, 0 s'il n'y en a pas.
+ */
+static int searchDirIndex(const DirNode* node, uint32_t hash) {
+    int low = 0, high = node->count - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (node->index[middle].hash < hash) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Recherche la première entrée d'une feuille dont l'empreinte est au moins égale à une empreinte donnée.
+ * @param leaf La feuille.
+ * @param hash L'empreinte recherchée.
+ * @return L'indice de cette entrée, le nombre d'entrées de la feuille s'il n'y en a pas.
+ */
+static int searchDirEntry(const DirNode* leaf, uint32_t hash) {
+    int low = 0, high = leaf->count;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (leaf->entries[middle].hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Descend l'arbre d'un répertoire jusqu'à la feuille où commencent les entrées d'une empreinte.
+ * @param partition La partition.
+ * @param root Le bloc de la racine de l'arbre.
+ * @param hash L'empreinte recherchée.
+ * @param path Les nœuds traversés, de la racine à la feuille.
+ * @param path_blocks Les blocs de ces nœuds.
+ * @param slots L'indice du fils suivi dans chaque nœud interne traversé.
+ * @return Le niveau de la feuille dans path (0 si la racine est une feuille), -1 en cas d'erreur.
+ */
+static int descendDirTree(Partition* partition, uint64_t root, uint32_t hash, DirNode* path, uint64_t* path_blocks, int* slots) {
+    path_blocks[0] = root;
+    for (int level = 0; level < DIR_TREE_MAX_DEPTH; ++level) {
+        if (readTreeNode(partition, path_blocks[level], &path[level], sizeof(DirNode)) == -1) {
+            return -1;
+        }
+        if (path[level].depth == 0) {
+            return level;
+        }
+        if (path[level].count == 0 || level + 1 == DIR_TREE_MAX_DEPTH) {
+            return -1;
+        }
+        slots[level] = searchDirIndex(&path[level], hash);
+        path_blocks[level + 1] = path[level].index[slots[level]].child;
+    }
+    return -1;
+}
+
+/**
+ * @brief Recherche une entrée dans l'arbre d'un répertoire (verrou du répertoire pris).
+ * 
+ * Les entrées de même empreinte sont comparées au nom de l'inode qu'elles
+ * désignent, en suivant au besoin les feuilles suivantes.
+ * 
+ * @param partition La partition.
+ * @param directory L'inode du répertoire.
+ * @param name Le nom recherché.
+ * @param hash L'empreinte du nom.
+ * @return Le numéro de l'inode désigné, NO_INODE si le nom est absent ou en cas d'erreur.
+ */
+static uint32_t dirLookup(Partition* partition, const inode* directory, const char* name, uint32_t hash) {
+    if (directory->dir_tree == NO_BLOCK) {
+        return NO_INODE;
+    }
+    DirNode path[DIR_TREE_MAX_DEPTH];
+    uint64_t path_blocks[DIR_TREE_MAX_DEPTH];
+    int slots[DIR_TREE_MAX_DEPTH];
+    int level = descendDirTree(partition, directory->dir_tree, hash, path, path_blocks, slots);
+    if (level == -1) {
+        return NO_INODE;
+    }
+
+    DirNode* leaf = &path[level];
+    int i = searchDirEntry(leaf, hash);
+    while (1) {
+        for (; i < leaf->count; ++i) {
+            if (leaf->entries[i].hash != hash) {
+                return NO_INODE;
+            }
+            if (strcmp(inodeAt(partition, leaf->entries[i].inode)->name, name) == 0) {
+                return leaf->entries[i].inode;
+            }
+        }
+        if (leaf->next == NO_BLOCK || readTreeNode(partition, leaf->next, leaf, sizeof(DirNode)) == -1) {
+            return NO_INODE;
+        }
+        i = 0;
+    }
+}
+
+/**
+ * @brief Ajoute une entrée à l'arbre d'un répertoire (namespace_lock et verrou en écriture du répertoire pris).
+ * 
+ * L'entrée est rangée après celles de même empreinte. Une feuille pleine
+ * est partagée en deux moitiés, et la nouvelle feuille référencée par son
+ * parent, lui-même partagé au besoin ; l'arbre gagne un niveau lorsque la
+ * racine est pleine. Les blocs des nouveaux nœuds sont réservés avant toute
+ * modification.
+ * 
+ * @param partition La partition.
+ * @param directory L'inode du répertoire, dont le nombre d'entrées est mis à jour.
+ * @param hash L'empreinte du nom de l'entrée.
+ * @param inode_number L'inode désigné, dont le nom est déjà renseigné.
+ * @return 0 en cas de succès, -1 si la partition est pleine ou en cas d'erreur.
+ */
+static int dirInsert(Partition* partition, inode* directory, uint32_t hash, uint32_t inode_number) {
+    DirEntry entry = { hash, inode_number };
+    DirNode path[DIR_TREE_MAX_DEPTH];
+    uint64_t path_blocks[DIR_TREE_MAX_DEPTH];
+    int slots[DIR_TREE_MAX_DEPTH];
+
+    if (directory->dir_tree == NO_BLOCK) {
+        int64_t root = allocateBlock(partition);
+        if (root == NO_BLOCK) {
+            return -1;
+        }
+        memset(&path[0], 0, sizeof(DirNode));
+        path[0].count = 1;
+        path[0].next = NO_BLOCK;
+        path[0].entries[0] = entry;
+        if (writeTreeNode(partition, root, &path[0], sizeof(DirNode)) == -1) {
+            freeRun(partition, root, 1);
+            return -1;
+        }
+        directory->dir_tree = root;
+        directory->fileSize = 1;
+        journalDirty(&partition->journal, directory, sizeof(inode));
+        return 0;
+    }
+
+    int level = descendDirTree(partition, directory->dir_tree, hash, path, path_blocks, slots);
+    if (level == -1) {
+        return -1;
+    }
+    DirNode* leaf = &path[level];
+    int position = searchDirEntry(leaf, hash);
+    while (position < leaf->count && leaf->entries[position].hash == hash) {
+        position++;
+    }
+    if (leaf->count < DIR_LEAF_MAX) {
+        memmove(&leaf->entries[position + 1], &leaf->entries[position], (leaf->count - position) * sizeof(DirEntry));
+        leaf->entries[position] = entry;
+        leaf->count++;
+        if (writeTreeNode(partition, path_blocks[level], leaf, sizeof(DirNode)) == -1) {
+            return -1;
+        }
+        directory->fileSize++;
+        journalDirty(&partition->journal, directory, sizeof(inode));
+        return 0;
+    }
+
+    // Réserver un bloc par niveau plein sur le chemin, plus un pour une nouvelle racine
+    int full_levels = 1;
+    while (full_levels <= level && path[level - full_levels].count == DIR_INDEX_MAX) {
+        full_levels++;
+    }
+    int needed = full_levels + (full_levels > level ? 1 : 0);
+    if (full_levels > level && level + 1 >= DIR_TREE_MAX_DEPTH) {
+        return -1;
+    }
+    int64_t new_blocks[DIR_TREE_MAX_DEPTH + 1];
+    for (int i = 0; i < needed; ++i) {
+        new_blocks[i] = allocateBlock(partition);
+        if (new_blocks[i] == NO_BLOCK) {
+            while (i-- > 0) {
+                freeRun(partition, new_blocks[i], 1);
+            }
+            return -1;
+        }
+    }
+
+    // Partager la feuille : la seconde moitié passe dans une nouvelle feuille chaînée après elle
+    DirEntry entries[DIR_LEAF_MAX + 1];
+    memcpy(entries, leaf->entries, position * sizeof(DirEntry));
+    entries[position] = entry;
+    memcpy(&entries[position + 1], &leaf->entries[position], (leaf->count - position) * sizeof(DirEntry));
+    DirNode node;
+    memset(&node, 0, sizeof(node));
+    node.count = DIR_LEAF_MAX + 1 - (DIR_LEAF_MAX + 1) / 2;
+    node.next = leaf->next;
+    memcpy(node.entries, &entries[(DIR_LEAF_MAX + 1) / 2], node.count * sizeof(DirEntry));
+    leaf->count = (DIR_LEAF_MAX + 1) / 2;
+    memcpy(leaf->entries, entries, leaf->count * sizeof(DirEntry));
+    leaf->next = new_blocks[0];
+    if (writeTreeNode(partition, new_blocks[0], &node, sizeof(DirNode)) == -1
+        || writeTreeNode(partition, path_blocks[level], leaf, sizeof(DirNode)) == -1) {
+        return -1;
+    }
+    directory->fileSize++;
+    journalDirty(&partition->journal, directory, sizeof(inode));
+
+    // Remonter le chemin : la nouvelle moitié est référencée juste après l'ancienne
+    DirIndex index = { node.entries[0].hash, 0, (uint64_t)new_blocks[0] };
+    for (int l = level - 1, used = 1; l >= 0; --l) {
+        DirNode* parent = &path[l];
+        int at = slots[l] + 1;
+        if (parent->count < DIR_INDEX_MAX) {
+            memmove(&parent->index[at + 1], &parent->index[at], (parent->count - at) * sizeof(DirIndex));
+            parent->index[at] = index;
+            parent->count++;
+            return writeTreeNode(partition, path_blocks[l], parent, sizeof(DirNode));
+        }
+        DirIndex children[DIR_INDEX_MAX + 1];
+        memcpy(children, parent->index, at * sizeof(DirIndex));
+        children[at] = index;
+        memcpy(&children[at + 1], &parent->index[at], (parent->count - at) * sizeof(DirIndex));
+        memset(&node, 0, sizeof(node));
+        node.depth = parent->depth;
+        node.count = DIR_INDEX_MAX + 1 - (DIR_INDEX_MAX + 1) / 2;
+        node.next = NO_BLOCK;
+        memcpy(node.index, &children[(DIR_INDEX_MAX + 1) / 2], node.count * sizeof(DirIndex));
+        parent->count = (DIR_INDEX_MAX + 1) / 2;
+        memcpy(parent->index, children, parent->count * sizeof(DirIndex));
+        index.hash = node.index[0].hash;
+        index.child = new_blocks[used++];
+        if (writeTreeNode(partition, index.child, &node, sizeof(DirNode)) == -1
+            || writeTreeNode(partition, path_blocks[l], parent, sizeof(DirNode)) == -1) {
+            return -1;
+        }
+    }
+
+    // La racine était pleine : l'arbre gagne un niveau
+    memset(&node, 0, sizeof(node));
+    node.depth = path[0].depth + 1;
+    node.count = 2;
+    node.next = NO_BLOCK;
+    node.index[0].child = path_blocks[0];
+    node.index[1] = index;
+    int64_t root = new_blocks[needed - 1];
+    if (writeTreeNode(partition, root, &node, sizeof(DirNode)) == -1) {
+        return -1;
+    }
+    directory->dir_tree = root;
+    return 0;
+}
+
+/**
+ * @brief Libère un sous-arbre de répertoire.
+ * @param partition La partition.
+ * @param block Le bloc contenant la racine du sous-arbre.
+ */
+static void freeDirTree(Partition* partition, uint64_t block) {
+    DirNode node;
+    if (readTreeNode(partition, block, &node, sizeof(DirNode)) == 0 && node.depth > 0) {
+        for (int i = 0; i < node.count; ++i) {
+            freeDirTree(partition, node.index[i].child);
+        }
+    }
+    journalRevokeBlock(&partition->journal, block);
+    freeRun(partition, block, 1);
+}
+
+/**
+ * @brief Retire une entrée de l'arbre d'un répertoire (namespace_lock et verrou en écriture du répertoire pris).
+ * 
+ * Les feuilles ne sont pas fusionnées : une feuille vidée reste chaînée
+ * aux autres. L'arbre entier est libéré lorsque le répertoire devient vide.
+ * 
+ * @param partition La partition.
+ * @param directory L'inode du répertoire, dont le nombre d'entrées est mis à jour.
+ * @param hash L'empreinte du nom de l'entrée.
+ * @param inode_number L'inode désigné par l'entrée.
+ * @return 0 en cas de succès, -1 si l'entrée est absente ou en cas d'erreur.
+ */
+static int dirRemove(Partition* partition, inode* directory, uint32_t hash, uint32_t inode_number) {
+    if (directory->dir_tree == NO_BLOCK) {
+        return -1;
+    }
+    DirNode path[DIR_TREE_MAX_DEPTH];
+    uint64_t path_blocks[DIR_TREE_MAX_DEPTH];
+    int slots[DIR_TREE_MAX_DEPTH];
+    int level = descendDirTree(partition, directory->dir_tree, hash, path, path_blocks, slots);
+    if (level == -1) {
+        return -1;
+    }
+
+    DirNode* leaf = &path[level];
+    uint64_t block = path_blocks[level];
+    int i = searchDirEntry(leaf, hash);
+    while (i == leaf->count || leaf->entries[i].inode != inode_number) {
+        if (i < leaf->count && leaf->entries[i].hash == hash) {
+            i++;
+            continue;
+        }
+        if (i < leaf->count || leaf->next == NO_BLOCK) {
+            return -1;
+        }
+        block = leaf->next;
+        if (readTreeNode(partition, block, leaf, sizeof(DirNode)) == -1) {
+            return -1;
+        }
+        i = 0;
+    }
+    if (leaf->entries[i].hash != hash) {
+        return -1;
+    }
+
+    if (--directory->fileSize == 0) {
+        freeDirTree(partition, directory->dir_tree);
+        directory->dir_tree = NO_BLOCK;
+    } else {
+        memmove(&leaf->entries[i], &leaf->entries[i + 1], (leaf->count - i - 1) * sizeof(DirEntry));
+        leaf->count--;
+        if (writeTreeNode(partition, block, leaf, sizeof(DirNode)) == -1) {
+            directory->fileSize++;
+            return -1;
+        }
+    }
+    journalDirty(&partition->journal, directory, sizeof(inode));
+    return 0;
+}
+
+/**
+ * @brief Extrait le nom suivant d'un chemin.
+ * @param path La position dans le chemin, avancée après le nom extrait.
+ * @param name Le nom extrait, terminé par '\0'.
+ * @return 1 si un nom est extrait, 0 à la fin du chemin, -1 si le nom dépasse MAX_FILE_NAME - 1 caractères
+ *         ou vaut "." ou "..".
+ */
+static int nextName(const char** path, char* name) {
+    const char* start = *path;
+    while (*start == PATH_SEPARATOR) {
+        start++;
+    }
+    size_t length = 0;
+    while (start[length] != '\0' && start[length] != PATH_SEPARATOR) {
+        length++;
+    }
+    *path = start + length;
+    if (length == 0) {
+        return 0;
+    }
+    if (length >= MAX_FILE_NAME || strncmp(start, ".", length) == 0 || strncmp(start, "..", length) == 0) {
+        return -1;
+    }
+    memcpy(name, start, length);
+    name[length] = '\0';
+    return 1;
+}
+
+/**
+ * @brief Donne le type d'un inode trouvé pendant une résolution de chemin.
+ * @param partition La partition.
+ * @param inode_number Le numéro de l'inode.
+ * @return INODE_FILE ou INODE_DIRECTORY.
+ */
+static uint32_t inodeType(Partition* partition, uint32_t inode_number) {
+    // Un inode trouvé sans verrou a pu être supprimé depuis : son type est alors sans objet
+    return __atomic_load_n(&inodeAt(partition, inode_number)->type, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Recherche une entrée d'un répertoire, d'abord dans le cache des entrées.
+ * 
+ * Une entrée absente du cache est cherchée dans l'arbre du répertoire sous
+ * son verrou en lecture, puis ajoutée au cache avant de rendre le verrou :
+ * une suppression, qui prend le verrou en écriture, la retire après.
+ * 
+ * @param partition La partition.
+ * @param directory L'inode du répertoire.
+ * @param name Le nom recherché.
+ * @param hash L'empreinte du nom.
+ * @return Le numéro de l'inode désigné, NO_INODE si le nom est absent ou en cas d'erreur.
+ */
+static uint32_t lookupEntry(Partition* partition, uint32_t directory, const char* name, uint32_t hash) {
+    uint32_t found = dcacheLookup(&partition->dentries, directory, name, hash);
+    if (found != NO_INODE) {
+        statsAdd(&partition->stats, STATS_DENTRY_HITS, 1);
+        return found;
+    }
+    statsAdd(&partition->stats, STATS_DENTRY_MISSES, 1);
+
+    InodeChunk* chunk = createInodeChunk(partition, directory);
+    if (chunk == NULL) {
+        return NO_INODE;
+    }
+    pthread_rwlock_t* lock = &chunk->locks[directory % INODES_PER_CHUNK];
+    pthread_rwlock_rdlock(lock);
+    const inode* searched = inodeAt(partition, directory);
+    found = searched->type == INODE_DIRECTORY ? dirLookup(partition, searched, name, hash) : NO_INODE;
+    if (found != NO_INODE) {
+        dcacheInsert(&partition->dentries, directory, name, hash, found);
+    }
+    pthread_rwlock_unlock(lock);
+    return found;
+}
+
+/**
+ * @brief Résout les répertoires d'un chemin jusqu'à son dernier nom.
+ * 
+ * Les noms sont cherchés un par un depuis le répertoire racine ; les
+ * séparateurs répétés ou finaux sont ignorés.
+ * 
+ * @param partition La partition.
+ * @param path Le chemin.
+ * @param name Le dernier nom du chemin, chaîne vide si le chemin désigne la racine.
+ * @return L'inode du répertoire contenant le dernier nom, NO_INODE si un répertoire du chemin
+ *         n'existe pas ou si un nom est invalide.
+ */
+static uint32_t resolveParent(Partition* partition, const char* path, char* name) {
+    uint32_t directory = ROOT_INODE;
+    int found = nextName(&path, name);
+    if (found <= 0) {
+        name[0] = '\0';
+        return found == 0 ? ROOT_INODE : NO_INODE;
+    }
+    char next[MAX_FILE_NAME];
+    while ((found = nextName(&path, next)) == 1) {
+        directory = lookupEntry(partition, directory, name, hashName(name));
+        if (directory == NO_INODE || inodeType(partition, directory) != INODE_DIRECTORY) {
+            return NO_INODE;
+        }
+        memcpy(name, next, MAX_FILE_NAME);
+    }
+    return found == 0 ? directory : NO_INODE;
+}
+
+/**
+ * @brief Résout un chemin complet.
+ * @param partition La partition.
+ * @param path Le chemin.
+ * @return L'inode désigné par le chemin, NO_INODE s'il n'existe pas.
+ */
+static uint32_t resolvePath(Partition* partition, const char* path) {
+    char name[MAX_FILE_NAME];
+    uint32_t directory = resolveParent(partition, path, name);
+    if (directory == NO_INODE || name[0] == '\0') {
+        return directory;
+    }
+    return lookupEntry(partition, directory, name, hashName(name));
+}
+
+/**
+ * @brief Vérifie qu'un chemin peut désigner un fichier : aucun nom vide après le séparateur initial.
+ * @param path Le chemin.
+ * @return 1 si le chemin n'est ni vide, ni terminé par PATH_SEPARATOR, ni ne contient deux séparateurs consécutifs, 0 sinon.
+ */
+static int filePathValid(const char* path) {
+    const char* name = path[0] == PATH_SEPARATOR ? path + 1 : path;
+    if (*name == '\0') {
+        return 0;
+    }
+    for (; *name != '\0'; ++name) {
+        if (name[0] == PATH_SEPARATOR && (name[1] == PATH_SEPARATOR || name[1] == '\0')) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Crée un fichier ou un répertoire et l'ajoute à son répertoire (namespace_lock doit être pris).
+ * 
+ * Un fichier commence vide, rangé dans son inode : il ne reçoit de bloc de
+ * données qu'en dépassant INLINE_DATA_MAX octets. Une copie reprend le
+ * contenu d'un inode préparé par l'appelant, qui en garde les blocs en cas
+ * d'échec. L'entrée n'est visible qu'une fois l'inode entièrement renseigné.
+ * 
+ * @param partition La partition.
+ * @param directory L'inode du répertoire, où le nom est absent.
+ * @param name Le nom de la nouvelle entrée.
+ * @param hash L'empreinte du nom.
+ * @param type INODE_FILE ou INODE_DIRECTORY.
+ * @param content L'inode dont le nouveau reprend tout sauf le nom, NULL pour une entrée vide.
+ * @return Le numéro du nouvel inode, NO_INODE en cas d'erreur.
+ */
+static uint32_t createEntry(Partition* partition, uint32_t directory, const char* name, uint32_t hash, uint32_t type, const inode* content) {
+    uint32_t inode_number = allocInode(partition);
+    if (inode_number == NO_INODE) {
+        printf("Erreur : Aucun inode disponible pour créer '%s'.\n", name);
+        return NO_INODE;
+    }
+    InodeChunk* chunk = createInodeChunk(partition, directory);
+    InodeChunk* created_chunk = chunk != NULL ? createInodeChunk(partition, inode_number) : NULL;
+    if (created_chunk == NULL) {
+        freeInode(partition, inode_number);
+        return NO_INODE;
+    }
+
+    // Une résolution sans verrou peut encore lire l'ancien contenu d'un inode réutilisé
+    pthread_rwlock_t* created_lock = &created_chunk->locks[inode_number % INODES_PER_CHUNK];
+    pthread_rwlock_wrlock(created_lock);
+    inode* created = inodeAt(partition, inode_number);
+    if (content != NULL) {
+        *created = *content;
+        memset(created->name, 0, MAX_FILE_NAME);
+    } else {
+        memset(created, 0, sizeof(inode));
+        if (type == INODE_FILE) {
+            created->flags = INODE_INLINE | partition->superBlock->compression << INODE_CODEC_SHIFT;
+        } else {
+            created->dir_tree = NO_BLOCK;
+        }
+    }
+    strcpy(created->name, name);
+    created->type = type;
+    journalDirty(&partition->journal, created, sizeof(inode));
+    pthread_rwlock_unlock(created_lock);
+
+    pthread_rwlock_t* lock = &chunk->locks[directory % INODES_PER_CHUNK];
+    pthread_rwlock_wrlock(lock);
+    errno = 0;
+    int status = dirInsert(partition, inodeAt(partition, directory), hash, inode_number);
+    if (status == 0) {
+        dcacheInsert(&partition->dentries, directory, name, hash, inode_number);
+    }
+    pthread_rwlock_unlock(lock);
+    if (status == -1) {
+        if (errno == EBADMSG) {
+            printf("Erreur : Le répertoire de '%s' est corrompu.\n", name);
+        } else {
+            printf("Erreur : Aucun bloc de données disponible pour créer '%s'.\n", name);
+        }
+        pthread_rwlock_wrlock(created_lock);
+        memset(created, 0, sizeof(inode));
+        created->extent_tree = NO_BLOCK;
+        journalDirty(&partition->journal, created, sizeof(inode));
+        freeInode(partition, inode_number);
+        pthread_rwlock_unlock(created_lock);
+        return NO_INODE;
+    }
+    return inode_number;
+}
+
+/**
+ * @brief Indique si un répertoire peut recevoir une nouvelle entrée.
+ * @param partition La partition.
+ * @param directory L'inode du répertoire.
+ * @param path Le chemin de l'entrée, pour le message d'erreur.
+ * @return 1 si le répertoire n'appartient pas à un instantané, 0 sinon.
+ */
+static int writableDirectory(Partition* partition, uint32_t directory, const char* path) {
+    if (inodeAt(partition, directory)->flags & INODE_READONLY) {
+        printf("Erreur : Le répertoire de '%s' appartient à un instantané.\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Calcule la géométrie d'une partition d'après les options de formatage.
+ * 
+ * Sans nombre de blocs, la zone de données est réduite jusqu'à ce que la
+ * partition, métadonnées comprises, tienne dans la taille demandée. Sans
+ * taille de bloc, DEFAULT_BLOCK_SIZE est utilisée. Le codec demandé doit
+ * pouvoir compresser des blocs de cette taille.
+ * 
+ * @param sb Le superbloc à remplir.
+ * @param options Les options de formatage.
+ * @return 0 en cas de succès, -1 si la géométrie demandée est impossible.
+ */
+static int layoutFor(SuperBlock* sb, const FormatOptions* options) {
+    uint32_t block_size = options->block_size != 0 ? options->block_size : DEFAULT_BLOCK_SIZE;
+    if (!validBlockSize(block_size) || !validCompression(options->compression, block_size)) {
+        return -1;
+    }
+    uint64_t num_blocks = options->num_blocks;
+    uint64_t available = options->size / block_size;
+    if (num_blocks == 0) {
+        num_blocks = options->size == 0 ? DEFAULT_NUM_BLOCKS : available;
+    }
+
+    // Il faut au moins la place d'un groupe d'inodes pour créer la racine
+    while (num_blocks >= blocksFor(INODE_CHUNK_SIZE, block_size) && num_blocks <= MAX_PARTITION_BLOCKS) {
+        uint64_t num_inodes = options->num_inodes;
+        if (num_inodes == 0) {
+            num_inodes = num_blocks / BLOCKS_PER_INODE > 0 ? num_blocks / BLOCKS_PER_INODE : 1;
+        }
+        if (num_inodes > MAX_INODES) {
+            if (options->num_inodes != 0) {
+                return -1;
+            }
+            num_inodes = MAX_INODES;
+        }
+        computeLayout(sb, num_blocks, (uint32_t)num_inodes, block_size);
+        sb->compression = options->compression;
+        if (options->num_blocks != 0 || options->size == 0 || sb->total_blocks <= available) {
+            return 0;
+        }
+        // Retirer de la zone de données la place prise par les métadonnées
+        num_blocks -= sb->total_blocks - available;
+    }
+    return -1;
+}
+
+/**
+ * @brief Fonction pour formater une partition de géométrie choisie.
+ * @param partitionName Le nom de la partition à formater.
+ * @param options La géométrie voulue, NULL pour celle de myFormat.
+ * @return La partition formatée et montée, NULL en cas d'erreur.
+ */
+Partition* myFormatWith(char* partitionName, const FormatOptions* options) {
+    FormatOptions defaults = { 0, DEFAULT_NUM_BLOCKS, DEFAULT_NUM_INODES, DEFAULT_BLOCK_SIZE, CODEC_NONE };
+    SuperBlock sb;
+    if (layoutFor(&sb, options != NULL ? options : &defaults) == -1) {
+        printf("Erreur : Géométrie de partition impossible.\n");
+        return NULL;
+    }
+
+    int partition_fd = open(partitionName, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (partition_fd == -1) {
+        perror("Erreur: Impossible de créer la partition.\n");
+        return NULL;
+    }
+
+    // Des métadonnées vides sont nulles : seuls le superbloc, le dernier mot
+    // de la table d'allocation et l'en-tête du journal sont écrits, le reste
+    // de la partition est un trou. Les tables d'inodes et d'allocation sont
+    // remplies à leur première utilisation
+    int status = ftruncate(partition_fd, (off_t)(sb.total_blocks * sb.block_size));
+    if (status == 0) {
+        // Le journal, réécrit à chaque mySync, est réservé d'avance sans être
+        // écrit, si le système de fichiers hôte le permet
+        int error = posix_fallocate(partition_fd, (off_t)sb.journal_start * sb.block_size,
+                                    (off_t)sb.journal_blocks * sb.block_size);
+        if (error != 0 && error != EINVAL && error != EOPNOTSUPP) {
+            errno = error;
+            status = -1;
+        }
+    }
+    if (status == 0 && pwrite(partition_fd, &sb, sizeof(sb), 0) != (ssize_t)sizeof(sb)) {
+        status = -1;
+    }
+    if (status == 0 && sb.num_blocks % 64 != 0) {
+        // Les bits au-delà du dernier bloc sont marqués occupés pour n'être jamais alloués
+        uint64_t tail = ~0ULL << (sb.num_blocks % 64);
+        off_t offset = (off_t)(sb.bitmap_start * sb.block_size + sb.num_blocks / 64 * sizeof(uint64_t));
+        if (pwrite(partition_fd, &tail, sizeof(tail), offset) != (ssize_t)sizeof(tail)) {
+            status = -1;
+        }
+    }
+    if (status == -1 || journalFormat(partition_fd, (off_t)sb.journal_start * sb.block_size) == -1) {
+        perror("Erreur lors de l'écriture des métadonnées de la partition");
+        close(partition_fd);
+        return NULL;
+    }
+
+    Partition* partition = mapMetadata(partition_fd);
+    if (partition == NULL) {
+        close(partition_fd);
+        return NULL;
+    }
+
+    printf("Partition '%s' formatée avec succès.\n", partitionName);
+
+    return partition;
+}
+
 /**
  * @brief Fonction pour formater une partition.
  * @param partitionName Le nom de la partition à formater.
- * @return 0 si la partition est formatée avec succès, -1 en cas d'erreur.
+ * @return La partition formatée et montée, NULL en cas d'erreur.
+ * @author Lauriane
+ */
+Partition* myFormat(char* partitionName) {
+    return myFormatWith(partitionName, NULL);
+}
+
+/**
+ * @brief Fonction pour monter une partition déjà formatée.
+ * @param partitionName Le nom de la partition à monter.
+ * @return La partition montée, NULL en cas d'erreur.
+ */
+Partition* myMount(char* partitionName) {
+    int partition_fd = open(partitionName, O_RDWR);
+    if (partition_fd == -1) {
+        return NULL;
+    }
+
+    Partition* partition = mapMetadata(partition_fd);
+    if (partition == NULL) {
+        close(partition_fd);
+        return NULL;
+    }
+
+    printf("Partition '%s' montée avec succès.\n", partitionName);
+
+    return partition;
+}
+
+/**
+ * @brief Libère la structure d'un fichier ouvert.
+ * @param f Le fichier.
+ */
+static void closeFile(file* f) {
+    pthread_mutex_destroy(&f->lock);
+    free(f->name);
+    free(f);
+}
+
+/**
+ * @brief Libère les fichiers ouverts, ferme la partition puis libère sa structure.
+ * @param partition La partition.
+ * @return 0 en cas de succès, -1 si la fermeture du descripteur échoue.
+ */
+static int releasePartition(Partition* partition) {
+    for (uint32_t c = 0; c < partition->chunks_used; ++c) {
+        InodeChunk* chunk = partition->chunks[c];
+        for (int i = 0; chunk != NULL && i < INODES_PER_CHUNK; ++i) {
+            if (chunk->open_files[i] != NULL) {
+                closeFile(chunk->open_files[i]);
+            }
+        }
+    }
+    // Les requêtes asynchrones se terminent avant la libération du cache
+    asyncDestroy(&partition->async);
+    cacheDestroy(&partition->cache);
+    journalDestroy(&partition->journal);
+    int status = close(partition->fileDescriptor);
+    if (status == -1) {
+        perror("Erreur lors de la fermeture du descripteur de fichier de la partition");
+    }
+    freePartition(partition);
+    return status;
+}
+
+/**
+ * @brief Fonction pour écrire sur la partition les données et métadonnées modifiées.
+ * @param partition La partition.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int mySync(Partition* partition) {
+    if (partition == NULL) {
+        return -1;
+    }
+
+    // Les écritures asynchrones en cours, les blocs de données du cache et
+    // leurs codes de contrôle, puis les métadonnées qui les référencent, dans
+    // une transaction du journal
+    int status = 0;
+    if (asyncReap(&partition->async, INT_MAX) == -1) {
+        status = -1;
+    }
+    if (cacheFlush(&partition->cache) == -1) {
+        perror("Erreur lors de l'écriture des blocs modifiés");
+        status = -1;
+    }
+    if (flushBlockChecksums(partition) == -1) {
+        status = -1;
+    }
+    if (journalCommit(&partition->journal) == -1) {
+        status = -1;
+    }
+    return status;
+}
+
+/**
+ * @brief Fonction pour obtenir les compteurs d'activité de la partition.
+ * @param partition La partition.
+ * @param stats Les compteurs à remplir.
+ * @return 0 en cas de succès, -1 si un paramètre est NULL.
+ */
+int myStats(Partition* partition, Stats* stats) {
+    if (partition == NULL || stats == NULL) {
+        return -1;
+    }
+    statsMerge(&partition->stats, stats);
+
+    // Le cache compte déjà ses succès et défauts sous le verrou de chaque partie
+    CacheStats cache_stats;
+    cacheGetStats(&partition->cache, &cache_stats);
+    stats->counters[STATS_CACHE_HITS] = cache_stats.hits;
+    stats->counters[STATS_CACHE_MISSES] = cache_stats.misses;
+    return 0;
+}
+
+/**
+ * @brief Fonction pour démonter une partition.
+ * @param partition La partition.
+ * @return 0 si la partition est démontée avec succès, -1 en cas d'erreur.
+ */
+int myUnmount(Partition* partition) {
+    if (partition == NULL) {
+        return -1;
+    }
+
+    // Écrire les données et métadonnées modifiées, puis vider le journal : le
+    // prochain montage n'aura rien à rejouer
+    int status = mySync(partition);
+    if (status == 0) {
+        status = journalCheckpoint(&partition->journal);
+    }
+    if (releasePartition(partition) == -1) {
+        status = -1;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Ouvre un fichier, en créant son inode s'il n'existe pas (namespace_lock doit être pris).
+ * @param partition La partition.
+ * @param fileName Le chemin du fichier à ouvrir.
+ * @return Un pointeur vers la structure de fichier ouvert, NULL en cas d'erreur.
+ */
+static file* openFileLocked(Partition* partition, char* fileName) {
+    char name[MAX_FILE_NAME];
+    uint32_t directory = resolveParent(partition, fileName, name);
+    if (directory == NO_INODE || name[0] == '\0') {
+        printf("Erreur : Le chemin '%s' est invalide ou l'un de ses répertoires n'existe pas.\n", fileName);
+        return NULL;
+    }
+
+    // Un autre thread a pu créer ou ouvrir le fichier depuis la première recherche
+    uint32_t hash = hashName(name);
+    uint32_t inode_index = lookupEntry(partition, directory, name, hash);
+    if (inode_index != NO_INODE) {
+        if (inodeAt(partition, inode_index)->type == INODE_DIRECTORY) {
+            printf("Erreur : '%s' est un répertoire.\n", fileName);
+            return NULL;
+        }
+        InodeChunk* chunk = createInodeChunk(partition, inode_index);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        if (chunk->open_files[inode_index % INODES_PER_CHUNK] != NULL) {
+            return chunk->open_files[inode_index % INODES_PER_CHUNK];
+        }
+    }
+
+    // Si aucun inode associé au fichier n'est trouvé, en créer un, vide
+    if (inode_index == NO_INODE) {
+        if (!writableDirectory(partition, directory, fileName)) {
+            return NULL;
+        }
+        inode_index = createEntry(partition, directory, name, hash, INODE_FILE, NULL);
+        if (inode_index == NO_INODE) {
+            return NULL;
+        }
+    }
+
+    // Créer la structure de fichier ouvert et l'associer à l'inode
+    file* newFile = (file*)malloc(sizeof(file));
+    if (newFile == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour le fichier.");
+        return NULL;
+    }
+    newFile->name = strdup(fileName);
+    if (newFile->name == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour le nom de fichier.");
+        free(newFile);
+        return NULL;
+    }
+    newFile->partition = partition;
+    pthread_mutex_init(&newFile->lock, NULL);
+    newFile->fileSize = inodeAt(partition, inode_index)->fileSize;
+    newFile->currentPosition = 0; // Initialiser la position actuelle à 0
+    newFile->inodeNumber = inode_index;
+    newFile->readaheadNext = 0;
+    newFile->readaheadWindow = 0;
+    newFile->readaheadEnd = 0;
+    __atomic_store_n(&inodeChunk(partition, inode_index)->open_files[inode_index % INODES_PER_CHUNK], newFile, __ATOMIC_RELEASE);
+
+    return newFile;
+}
+
+/**
+ * @brief Fonction pour ouvrir un fichier.
+ * @param partition La partition.
+ * @param fileName Le chemin du fichier à ouvrir.
+ * @return Un pointeur vers la structure de fichier ouvert, NULL en cas d'erreur.
+ * @author Lauriane
+ */
+file* myOpen(Partition* partition, char* fileName) {
+    if (partition == NULL) {
+        return NULL;
+    }
+    uint64_t start = statsStart(STATS_OPEN);
+    if (fileName == NULL || fileName[0] == '\0') {
+        statsRecord(&partition->stats, STATS_OPEN, start, -1);
+        return NULL;
+    }
+    if (!filePathValid(fileName)) {
+        printf("Erreur : Le chemin '%s' est invalide ou l'un de ses répertoires n'existe pas.\n", fileName);
+        statsRecord(&partition->stats, STATS_OPEN, start, -1);
+        return NULL;
+    }
+
+    // Un fichier déjà ouvert est trouvé dans le cache des entrées sans prendre de verrou
+    char name[MAX_FILE_NAME];
+    uint32_t directory = resolveParent(partition, fileName, name);
+    uint32_t inode_index = directory != NO_INODE && name[0] != '\0' ? lookupEntry(partition, directory, name, hashName(name)) : NO_INODE;
+    InodeChunk* chunk = inode_index != NO_INODE ? inodeChunk(partition, inode_index) : NULL;
+    if (chunk != NULL) {
+        file* opened = __atomic_load_n(&chunk->open_files[inode_index % INODES_PER_CHUNK], __ATOMIC_ACQUIRE);
+        if (opened != NULL) {
+            statsRecord(&partition->stats, STATS_OPEN, start, 0);
+            return opened;
+        }
+    }
+
+    // Les créations d'inodes et de fichiers ouverts sont sérialisées
+    journalStart(&partition->journal);
+    pthread_mutex_lock(&partition->namespace_lock);
+    file* newFile = openFileLocked(partition, fileName);
+    pthread_mutex_unlock(&partition->namespace_lock);
+    journalStop(&partition->journal);
+    statsRecord(&partition->stats, STATS_OPEN, start, newFile != NULL ? 0 : -1);
+    return newFile;
+}
+
+/**
+ * @brief Fonction pour créer un répertoire vide.
+ * @param partition La partition.
+ * @param path Le chemin du répertoire, dont les répertoires parents existent déjà.
+ * @return 0 si le répertoire est créé, -1 s'il existe déjà, si le chemin est invalide ou en cas d'erreur.
+ */
+int myMkdir(Partition* partition, char* path) {
+    if (partition == NULL || path == NULL) {
+        return -1;
+    }
+    journalStart(&partition->journal);
+    pthread_mutex_lock(&partition->namespace_lock);
+    char name[MAX_FILE_NAME];
+    uint32_t directory = resolveParent(partition, path, name);
+    int status = -1;
+    if (directory == NO_INODE || name[0] == '\0') {
+        printf("Erreur : Le chemin '%s' est invalide ou l'un de ses répertoires n'existe pas.\n", path);
+    } else if (lookupEntry(partition, directory, name, hashName(name)) != NO_INODE) {
+        printf("Erreur : '%s' existe déjà.\n", path);
+    } else if (writableDirectory(partition, directory, path) && createEntry(partition, directory, name, hashName(name), INODE_DIRECTORY, NULL) != NO_INODE) {
+        status = 0;
+    }
+    pthread_mutex_unlock(&partition->namespace_lock);
+    journalStop(&partition->journal);
+    return status;
+}
+
+/**
+ * @brief Écrit dans un fichier à sa position actuelle (verrou du fichier et verrou en écriture de l'inode pris).
+ * 
+ * Les extents ajoutés ou copiés sont journalisés avec l'opération :
+ * l'écriture s'arrête avant que la transaction en cours ne remplisse le
+ * journal, et la suite doit être écrite dans une autre transaction.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param buffer Le tampon contenant les données à écrire.
+ * @param nBytes Le nombre d'octets à écrire.
+ * @param split Reçoit 1 si l'écriture s'est arrêtée pour laisser écrire la transaction, 0 sinon.
+ * @return Le nombre total d'octets écrits, -1 en cas d'erreur.
+ */
+static int64_t writeLocked(file* f, void* buffer, int64_t nBytes, int* split) {
+    Partition* partition = f->partition;
+    *split = 0;
+
+    // Le fichier ouvert connaît son inode : aucune recherche par nom
+    inode* inode_of_file = inodeAt(partition, f->inodeNumber);
+
+    // Un fichier d'instantané ne change plus
+    if (inode_of_file->flags & INODE_READONLY) {
+        errno = EROFS;
+        return -1;
+    }
+
+    // Un petit fichier reste dans son inode tant que l'écriture y tient
+    if (inode_of_file->flags & INODE_INLINE) {
+        if (nBytes <= (int64_t)INLINE_DATA_MAX - f->currentPosition) {
+            transferInline(partition, inode_of_file, f->currentPosition, buffer, nBytes, 1);
+            f->currentPosition += nBytes;
+            f->fileSize = inode_of_file->fileSize;
+            return nBytes;
+        }
+        if (moveInlineData(partition, inode_of_file) == -1) {
+            return -1;
+        }
+    }
+
+    // Les blocs logiques d'un fichier sont numérotés sur 32 bits
+    if (nBytes > partition->max_file_size - f->currentPosition) {
+        nBytes = partition->max_file_size - f->currentPosition;
+    }
+
+    // Un fichier compressé est écrit par groupes de blocs, sans passer par le cache
+    if (clusterBlocks(partition, inode_of_file) != 0) {
+        int64_t written = writeCompressed(partition, inode_of_file, f->currentPosition, buffer, nBytes);
+        if (written > 0) {
+            f->currentPosition += written;
+            f->fileSize = inode_of_file->fileSize;
+            *split = written < nBytes && journalRoom(&partition->journal) < remapJournalBytes();
+        }
+        return written;
+    }
+
+    int64_t bytes_written = 0;
+    // La taille de bloc est une puissance de 2 : décalage et masque remplacent les divisions
+    unsigned shift = partition->block_shift;
+    int64_t block_size = partition->block_size, mask = block_size - 1;
+
+    // Associer au fichier tous les blocs nécessaires, puis limiter l'écriture à ceux obtenus
+    uint32_t blocks_needed = (f->currentPosition + nBytes + mask) >> shift;
+    int64_t capacity = (int64_t)growFile(partition, inode_of_file, blocks_needed) << shift;
+    if (nBytes > capacity - f->currentPosition) {
+        // Partition pleine ou journal presque plein : écrire ce qui peut l'être
+        nBytes = capacity - f->currentPosition;
+        *split = journalRoom(&partition->journal) < remapJournalBytes();
+    }
+
+    // Les blocs partagés avec des copies du fichier sont d'abord copiés
+    int64_t unshared = unshareBlocks(partition, inode_of_file, f->currentPosition, f->currentPosition + nBytes);
+    if (unshared == -1) {
+        return -1;
+    }
+    if (unshared < f->currentPosition + nBytes) {
+        nBytes = unshared - f->currentPosition;
+        *split = 1;
+    }
+
+    // Écrire dans les blocs de données liés au fichier, à travers le cache
+    int dedup = partition->dedup.entries != NULL;
+    while (nBytes > 0) {
+        uint32_t logical = f->currentPosition >> shift;
+        int position_in_block = f->currentPosition & mask;
+        int64_t physical = mapFileBlock(partition, inode_of_file, logical, NULL);
+        if (physical == NO_BLOCK) {
+            return -1;
+        }
+
+        // Ne pas dépasser la fin du bloc de données courant
+        int64_t bytes_to_write = block_size - position_in_block;
+        if (bytes_to_write > nBytes) {
+            bytes_to_write = nBytes;
+        }
+
+        // Un bloc déjà écrit de ce fichier, partagé par la déduplication d'un bloc précédent, est copié à son tour
+        if (dedup && __atomic_load_n(&partition->shares[physical], __ATOMIC_RELAXED) > 0) {
+            unshared = unshareBlocks(partition, inode_of_file, f->currentPosition, f->currentPosition + bytes_to_write);
+            if (unshared == -1) {
+                return -1;
+            }
+            if (unshared < f->currentPosition + bytes_to_write) {
+                *split = 1;
+                break;
+            }
+            physical = mapFileBlock(partition, inode_of_file, logical, NULL);
+            if (physical == NO_BLOCK) {
+                return -1;
+            }
+        }
+
+        // Un bloc entièrement réécrit, ou situé au-delà de la fin du fichier, n'est pas lu
+        int overwrite = bytes_to_write == block_size || ((int64_t)logical << shift) >= inode_of_file->fileSize;
+        if (!dedup || bytes_to_write < block_size || !dedupBlock(partition, f->inodeNumber, inode_of_file, logical, physical, buffer)) {
+            Buffer* block_buffer = cacheGet(&partition->cache, physical, overwrite ? CACHE_OVERWRITE : CACHE_READ);
+            if (block_buffer == NULL) {
+                return -1; // Erreur lors de la lecture du bloc
+            }
+            if (overwrite && bytes_to_write < block_size) {
+                memset(block_buffer->data, 0, block_size);
+            }
+            memcpy(block_buffer->data + position_in_block, buffer, bytes_to_write);
+            cacheRelease(&partition->cache, block_buffer, 1);
+        }
+        
+        // Mettre à jour la position actuelle et le nombre d'octets écrits
+        f->currentPosition += bytes_to_write;
+        bytes_written += bytes_to_write;
+        buffer += bytes_to_write;
+        nBytes -= bytes_to_write;
+    }
+
+    // Mettre à jour la taille du fichier si nécessaire
+    if (f->currentPosition > f->fileSize) {
+        f->fileSize = f->currentPosition;
+        inode_of_file->fileSize = f->fileSize;
+        journalDirty(&partition->journal, &inode_of_file->fileSize, sizeof(int64_t));
+    }
+
+    return bytes_written;
+}
+
+/**
+ * @brief Fonction pour écrire dans un fichier.
+ * @param f Le pointeur vers la structure de fichier.
+ * @param buffer Le tampon contenant les données à écrire.
+ * @param nBytes Le nombre d'octets à écrire.
+ * @return Le nombre total d'octets écrits, -1 en cas d'erreur.
+ * @author Lauriane
+ */
+int64_t myWrite(file* f, void* buffer, int64_t nBytes) {
+    if (f == NULL || buffer == NULL || nBytes <= 0) {
+        return -1; // Erreur de paramètres
+    }
+
+    // Seuls les accès au même fichier sont sérialisés
+    uint64_t start = statsStart(STATS_WRITE);
+    pthread_rwlock_t* inode_lock = inodeLock(f->partition, f->inodeNumber);
+    int64_t bytes_written = 0;
+    int split;
+    do {
+        // Une écriture dont les extents ne tiennent pas dans le journal continue après l'écriture de la transaction
+        journalStart(&f->partition->journal);
+        pthread_mutex_lock(&f->lock);
+        pthread_rwlock_wrlock(inode_lock);
+        int64_t written = writeLocked(f, (char*)buffer + bytes_written, nBytes - bytes_written, &split);
+        pthread_rwlock_unlock(inode_lock);
+        pthread_mutex_unlock(&f->lock);
+        journalStop(&f->partition->journal);
+        if (written == -1) {
+            bytes_written = bytes_written > 0 ? bytes_written : -1;
+            break;
+        }
+        bytes_written += written;
+    } while (split && bytes_written < nBytes);
+    statsRecord(&f->partition->stats, STATS_WRITE, start, bytes_written);
+    return bytes_written;
+}
+
+/**
+ * @brief Déplace la position de lecture/écriture dans un fichier.
+ * @param f Le pointeur vers la structure de fichier.
+ * @param offset Le décalage par rapport à la position de départ.
+ * @param base La base à utiliser pour le décalage (SEEK_SET, SEEK_CUR ou SEEK_END).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ * @author Boyan
+ */
+void mySeek(file* f, int64_t offset, int base) {
+    if (f == NULL) {
+        printf("Erreur : fichier NULL.\n");
+        return;
+    }
+
+    int64_t origin;
+    uint64_t start = statsStart(STATS_SEEK);
+
+    // La taille peut être modifiée par une écriture groupée ou asynchrone
+    pthread_rwlock_t* inode_lock = inodeLock(f->partition, f->inodeNumber);
+    pthread_mutex_lock(&f->lock);
+    pthread_rwlock_rdlock(inode_lock);
+    int64_t fileSize = f->fileSize;
+    pthread_rwlock_unlock(inode_lock);
+
+    switch (base) {
+        case SEEK_SET:
+            origin = 0;
+            break;
+        case SEEK_CUR:
+            origin = f->currentPosition;
+            break;
+        case SEEK_END:
+            origin = fileSize;
+            break;
+        default:
+            printf("Erreur : base de déplacement incorrecte.\n");
+            pthread_mutex_unlock(&f->lock);
+            statsRecord(&f->partition->stats, STATS_SEEK, start, -1);
+            return;
+    }
+
+    // Vérifier si la nouvelle position est dans les limites du fichier, sans débordement
+    if (offset < -origin || offset > fileSize - origin) {
+        printf("Erreur : déplacement en dehors des limites du fichier.\n");
+        pthread_mutex_unlock(&f->lock);
+        statsRecord(&f->partition->stats, STATS_SEEK, start, -1);
+        return;
+    }
+
+    // La position est propre au fichier : la partition est lue et écrite par pread/pwrite
+    f->currentPosition = origin + offset;
+    pthread_mutex_unlock(&f->lock);
+    statsRecord(&f->partition->stats, STATS_SEEK, start, 0);
+}
+
+/**
+ * @brief Donne le code d'erreur d'une lecture qui a échoué.
+ * @return ERROR_CHECKSUM si un bloc lu ne correspond pas à son code de contrôle, -1 sinon.
+ */
+static int64_t readError() {
+    return errno == EBADMSG ? ERROR_CHECKSUM : -1;
+}
+
+/**
+ * @brief Lit depuis un fichier à sa position actuelle (verrou du fichier et verrou en lecture de l'inode pris).
+ * @param f Le pointeur vers la structure de fichier.
+ * @param buffer Le tampon pour stocker les données lues.
+ * @param nBytes Le nombre d'octets à lire.
+ * @return Le nombre total d'octets lus, -1 en cas d'erreur, ERROR_CHECKSUM si un bloc est corrompu.
+ */
+static int64_t readLocked(file* f, void* buffer, int64_t nBytes) {
+    Partition* partition = f->partition;
+    int64_t bytes_read = 0;
+    errno = 0;
+
+    // Le fichier ouvert connaît son inode : aucune recherche par nom
+    inode* inode_of_file = inodeAt(partition, f->inodeNumber);
+
+    // Ne pas lire au-delà de la fin du fichier
+    if (nBytes > inode_of_file->fileSize - f->currentPosition) {
+        nBytes = inode_of_file->fileSize - f->currentPosition;
+    }
+
+    // Un petit fichier est lu dans son inode, sans accès à un bloc de données
+    if (inode_of_file->flags & INODE_INLINE) {
+        if (nBytes > 0) {
+            transferInline(partition, inode_of_file, f->currentPosition, buffer, nBytes, 0);
+            f->currentPosition += nBytes;
+        }
+        return nBytes > 0 ? nBytes : 0;
+    }
+
+    // Un fichier compressé ne décompresse que les groupes lus
+    if (clusterBlocks(partition, inode_of_file) != 0) {
+        if (nBytes <= 0) {
+            return 0;
+        }
+        if (readCompressed(partition, inode_of_file, f->currentPosition, buffer, nBytes) == -1) {
+            return readError();
+        }
+        f->currentPosition += nBytes;
+        return nBytes;
+    }
+
+    // Charger en une fois les blocs à lire, et les suivants si l'accès est séquentiel
+    unsigned shift = partition->block_shift;
+    int64_t block_size = partition->block_size, mask = block_size - 1;
+    if (nBytes > 0) {
+        readAhead(f, inode_of_file, f->currentPosition >> shift, (f->currentPosition + nBytes - 1) >> shift);
+    }
+
+    // Lire à partir des blocs de données liés à l'inode, depuis la position actuelle
+    while (nBytes > 0) {
+        uint32_t logical = f->currentPosition >> shift;
+        int position_in_block = f->currentPosition & mask;
+        int64_t physical = mapFileBlock(partition, inode_of_file, logical, NULL);
+        if (physical == NO_BLOCK) {
+            return readError();
+        }
+
+        // Lire les données jusqu'à la fin du bloc de données courant, à travers le cache
+        int64_t bytes_to_read = block_size - position_in_block;
+        if (bytes_to_read > nBytes) {
+            bytes_to_read = nBytes;
+        }
+        Buffer* block_buffer = cacheGet(&partition->cache, physical, CACHE_READ);
+        if (block_buffer == NULL) {
+            // Gérer l'erreur de lecture, ou le bloc corrompu
+            return readError();
+        }
+        memcpy(buffer, block_buffer->data + position_in_block, bytes_to_read);
+        cacheRelease(&partition->cache, block_buffer, 0);
+
+        f->currentPosition += bytes_to_read;
+        bytes_read += bytes_to_read;
+        nBytes -= bytes_to_read;
+        buffer += bytes_to_read;
+    }
+
+    return bytes_read;
+}
+
+/**
+ * @brief Fonction pour lire depuis un fichier.
+ * @param f Le pointeur vers la structure de fichier.
+ * @param buffer Le tampon pour stocker les données lues.
+ * @param nBytes Le nombre d'octets à lire.
+ * @return Le nombre total d'octets lus, -1 en cas d'erreur, ERROR_CHECKSUM si un bloc est corrompu.
+ * @author Boyan
+ */
+int64_t myRead(file* f, void* buffer, int64_t nBytes) {
+    if (f == NULL || buffer == NULL || nBytes <= 0) {
+        return -1; // Erreur : Paramètres invalides
+    }
+
+    // Le verrou en lecture laisse les lectures groupées ou asynchrones du fichier se poursuivre
+    uint64_t start = statsStart(STATS_READ);
+    pthread_rwlock_t* inode_lock = inodeLock(f->partition, f->inodeNumber);
+    pthread_mutex_lock(&f->lock);
+    pthread_rwlock_rdlock(inode_lock);
+    int64_t bytes_read = readLocked(f, buffer, nBytes);
+    pthread_rwlock_unlock(inode_lock);
+    pthread_mutex_unlock(&f->lock);
+    statsRecord(&f->partition->stats, STATS_READ, start, bytes_read);
+    return bytes_read;
+}
+
+/**
+ * @brief Donne la projection partagée en lecture seule de la partition, créée au premier appel.
+ * 
+ * Contrairement à la projection privée des métadonnées, dont les pages
+ * modifiées ne suivent plus la partition, elle montre toujours les octets
+ * écrits sur la partition.
+ * 
+ * @param partition La partition.
+ * @return La projection, NULL en cas d'erreur.
+ */
+static char* dataView(Partition* partition) {
+    char* view = __atomic_load_n(&partition->data_view, __ATOMIC_ACQUIRE);
+    if (view != NULL) {
+        return view;
+    }
+    void* mapped = mmap(NULL, partition->metadata_size, PROT_READ, MAP_SHARED | MAP_NORESERVE, partition->fileDescriptor, 0);
+    if (mapped == MAP_FAILED) {
+        perror("Erreur lors de la projection de la partition");
+        return NULL;
+    }
+    // Deux threads ont pu projeter la partition en même temps : une seule projection est gardée
+    if (!__atomic_compare_exchange_n(&partition->data_view, &view, mapped, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        munmap(mapped, partition->metadata_size);
+        return view;
+    }
+    return mapped;
+}
+
+/**
+ * @brief Ajoute des octets à une vue, en prolongeant le dernier morceau s'ils le suivent.
+ * @param view La vue.
+ * @param data Les octets.
+ * @param length Le nombre d'octets.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+static int addSpan(ReadView* view, char* data, size_t length) {
+    if (view->count > 0) {
+        struct iovec* last = &view->spans[view->count - 1];
+        if ((char*)last->iov_base + last->iov_len == data) {
+            last->iov_len += length;
+            view->length += length;
+            return 0;
+        }
+    }
+    if (view->count == view->capacity) {
+        int capacity = view->capacity > 0 ? view->capacity * 2 : 8;
+        struct iovec* spans = realloc(view->spans, capacity * sizeof(struct iovec));
+        if (spans == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour la vue");
+            return -1;
+        }
+        view->spans = spans;
+        view->capacity = capacity;
+    }
+    view->spans[view->count].iov_base = data;
+    view->spans[view->count].iov_len = length;
+    view->count++;
+    view->length += length;
+    return 0;
+}
+
+/**
+ * @brief Remplit une vue des blocs de données d'un fichier (verrou en lecture de l'inode pris).
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier, qui n'est pas rangé dans son inode.
+ * @param offset La position dans le fichier.
+ * @param nBytes Le nombre d'octets, sans dépasser la fin du fichier.
+ * @param view La vue.
+ * @return 0 en cas de succès, -1 en cas d'erreur, ERROR_CHECKSUM si un bloc est corrompu.
+ */
+static int64_t viewBlocks(Partition* partition, const inode* inode_of_file, int64_t offset, int64_t nBytes, ReadView* view) {
+    char* mapped = dataView(partition);
+    if (mapped == NULL) {
+        return -1;
+    }
+    unsigned shift = partition->block_shift;
+    int64_t mask = partition->block_size - 1;
+    while (nBytes > 0) {
+        uint32_t logical = offset >> shift;
+        uint32_t run;
+        int64_t physical = mapFileBlock(partition, inode_of_file, logical, &run);
+        if (physical == NO_BLOCK) {
+            return readError();
+        }
+        int64_t position_in_run = offset & mask;
+        int64_t length = ((int64_t)run << shift) - position_in_run;
+        if (length > nBytes) {
+            length = nBytes;
+        }
+
+        // La projection partagée ne voit que les blocs écrits sur la partition
+        uint32_t touched = (uint32_t)((position_in_run + length - 1) >> shift) + 1;
+        if (cacheFlushRange(&partition->cache, physical, touched) == -1) {
+            return -1;
+        }
+
+        // Chaque bloc touché par la vue est comparé à son code de contrôle, sans copie
+        char* blocks = mapped + dataBlockOffset(partition, physical);
+        for (uint32_t i = 0; i < touched; ++i) {
+            if (verifyBlockChecksum(partition, physical + i, blocks + ((size_t)i << shift)) == -1) {
+                return ERROR_CHECKSUM;
+            }
+        }
+        if (addSpan(view, blocks + position_in_run, length) == -1) {
+            return -1;
+        }
+        offset += length;
+        nBytes -= length;
+    }
+    return 0;
+}
+
+/**
+ * @brief Fonction pour obtenir une vue d'une partie d'un fichier, sans copie.
+ * @param f Pointeur vers la structure de fichier.
+ * @param offset Position dans le fichier.
+ * @param nBytes Nombre d'octets demandés.
+ * @param view La vue à remplir, à rendre avec myReleaseView.
+ * @return Nombre d'octets de la vue, -1 en cas d'erreur, ERROR_CHECKSUM si un bloc est corrompu.
+ */
+int64_t myReadView(file* f, int64_t offset, int64_t nBytes, ReadView* view) {
+    if (view == NULL) {
+        return -1;
+    }
+    memset(view, 0, sizeof(ReadView));
+    if (f == NULL || offset < 0 || nBytes < 0) {
+        return -1; // Erreur : Paramètres invalides
+    }
+
+    uint64_t start = statsStart(STATS_READ);
+    Partition* partition = f->partition;
+    pthread_rwlock_t* inode_lock = inodeLock(partition, f->inodeNumber);
+    pthread_rwlock_rdlock(inode_lock);
+    inode* inode_of_file = inodeAt(partition, f->inodeNumber);
+    if (nBytes > inode_of_file->fileSize - offset) {
+        nBytes = inode_of_file->fileSize - offset;
+    }
+
+    int64_t result = 0;
+    errno = 0;
+    if (nBytes > 0 && (inode_of_file->flags & INODE_INLINE)) {
+        // Un petit fichier est désigné dans son inode, qui ne change pas tant que le verrou est pris
+        result = addSpan(view, inode_of_file->inline_data + offset, nBytes);
+    } else if (nBytes > 0 && clusterBlocks(partition, inode_of_file) != 0) {
+        // Les blocs d'un fichier compressé ne contiennent pas ses octets : la vue désigne une copie décompressée
+        view->copy = malloc(nBytes);
+        if (view->copy == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour la vue.");
+            result = -1;
+        } else if (readCompressed(partition, inode_of_file, offset, view->copy, nBytes) == -1) {
+            result = readError();
+        } else {
+            result = addSpan(view, view->copy, nBytes);
+        }
+    } else if (nBytes > 0) {
+        result = viewBlocks(partition, inode_of_file, offset, nBytes, view);
+    }
+    if (result == 0 && view->length > 0) {
+        // L'inode reste verrouillé en lecture jusqu'à myReleaseView
+        view->f = f;
+        result = view->length;
+    } else {
+        pthread_rwlock_unlock(inode_lock);
+        free(view->spans);
+        free(view->copy);
+        memset(view, 0, sizeof(ReadView));
+    }
+    statsRecord(&partition->stats, STATS_READ, start, result);
+    return result;
+}
+
+/**
+ * @brief Fonction pour rendre une vue obtenue par myReadView.
+ * @param view La vue.
+ */
+void myReleaseView(ReadView* view) {
+    if (view == NULL) {
+        return;
+    }
+    if (view->f != NULL) {
+        pthread_rwlock_unlock(inodeLock(view->f->partition, view->f->inodeNumber));
+    }
+    free(view->spans);
+    free(view->copy);
+    memset(view, 0, sizeof(ReadView));
+}
+
+/**
+ * @struct IoSegment
+ * @brief Morceau d'une requête groupée transféré directement avec la partition.
+ */
+typedef struct {
+    off_t offset; /**< Position dans la partition. */
+    char* data; /**< Emplacement correspondant dans le tampon de la requête. */
+    size_t length; /**< Nombre d'octets. */
+    int order; /**< Rang de création, qui départage les morceaux de même position. */
+} IoSegment;
+
+/**
+ * @struct IoSegmentList
+ * @brief Liste extensible des morceaux d'un lot de requêtes.
+ */
+typedef struct {
+    IoSegment* segments; /**< Morceaux. */
+    int count; /**< Nombre de morceaux. */
+    int capacity; /**< Nombre de morceaux alloués. */
+} IoSegmentList;
+
+/**
+ * @brief Ajoute un morceau à la liste, en prolongeant le dernier s'il est contigu.
+ * @param list La liste.
+ * @param offset La position dans la partition.
+ * @param data L'emplacement dans le tampon de la requête.
+ * @param length Le nombre d'octets.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+static int addSegment(IoSegmentList* list, off_t offset, char* data, size_t length) {
+    if (list->count > 0) {
+        IoSegment* last = &list->segments[list->count - 1];
+        if (last->offset + (off_t)last->length == offset && last->data + last->length == data) {
+            last->length += length;
+            return 0;
+        }
+    }
+    if (list->count == list->capacity) {
+        int capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+        IoSegment* segments = realloc(list->segments, capacity * sizeof(IoSegment));
+        if (segments == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour les requêtes groupées.");
+            return -1;
+        }
+        list->segments = segments;
+        list->capacity = capacity;
+    }
+    IoSegment* segment = &list->segments[list->count];
+    segment->offset = offset;
+    segment->data = data;
+    segment->length = length;
+    segment->order = list->count++;
+    return 0;
+}
+
+/**
+ * @brief Compare deux morceaux selon leur position dans la partition (pour qsort).
+ * @param a Pointeur vers le premier morceau.
+ * @param b Pointeur vers le second morceau.
+ * @return Un entier négatif, nul ou positif.
+ */
+static int compareSegments(const void* a, const void* b) {
+    const IoSegment* segment_a = a;
+    const IoSegment* segment_b = b;
+    if (segment_a->offset != segment_b->offset) {
+        return segment_a->offset < segment_b->offset ? -1 : 1;
+    }
+    return segment_a->order - segment_b->order;
+}
+
+/**
+ * @brief Compare deux morceaux selon leur rang de création (pour qsort).
+ * @param a Pointeur vers le premier morceau.
+ * @param b Pointeur vers le second morceau.
+ * @return Un entier négatif, nul ou positif.
+ */
+static int compareSegmentOrder(const void* a, const void* b) {
+    return ((const IoSegment*)a)->order - ((const IoSegment*)b)->order;
+}
+
+/**
+ * @brief Transforme une requête en morceaux de partition.
+ * 
+ * Les blocs présents dans le cache sont copiés immédiatement depuis ou vers
+ * leur tampon, pour rester cohérents avec les données modifiées qui n'ont
+ * pas encore été écrites. Les autres deviennent des morceaux à transférer
+ * directement, sauf les blocs lus en partie, chargés dans le cache pour
+ * être vérifiés entiers.
+ * 
+ * @param partition La partition.
+ * @param request La requête, dont la longueur a déjà été limitée au fichier.
+ * @param inode_of_file L'inode du fichier.
+ * @param write_mode 1 pour une écriture, 0 pour une lecture.
+ * @param list La liste recevant les morceaux.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int resolveRequest(Partition* partition, const IoRequest* request, const inode* inode_of_file, int write_mode, IoSegmentList* list) {
+    int64_t position = request->offset;
+    char* data = request->iov.iov_base;
+    size_t remaining = request->result;
+    unsigned shift = partition->block_shift;
+    int64_t mask = partition->block_size - 1;
+
+    while (remaining > 0) {
+        uint32_t logical = position >> shift;
+        int position_in_block = position & mask;
+        int64_t physical = mapFileBlock(partition, inode_of_file, logical, NULL);
+        if (physical == NO_BLOCK) {
+            return -1;
+        }
+        size_t length = partition->block_size - position_in_block;
+        if (length > remaining) {
+            length = remaining;
+        }
+
+        // Un bloc lu en partie ne peut être vérifié qu'entier : il passe par le cache
+        int mode = write_mode || length == partition->block_size ? CACHE_LOOKUP : CACHE_READ;
+        Buffer* block_buffer = cacheGet(&partition->cache, physical, mode);
+        if (block_buffer == NULL && mode == CACHE_READ) {
+            return -1;
+        }
+        // Le bloc peut être écrit après que le verrou de l'inode a été rendu
+        if (write_mode) {
+            dedupForget(&partition->dedup, physical, 1);
+        }
+        if (block_buffer != NULL) {
+            if (write_mode) {
+                memcpy(block_buffer->data + position_in_block, data, length);
+            } else {
+                memcpy(data, block_buffer->data + position_in_block, length);
+            }
+            cacheRelease(&partition->cache, block_buffer, write_mode);
+        } else if (addSegment(list, dataBlockOffset(partition, physical) + position_in_block, data, length) == -1) {
+            return -1;
+        }
+
+        position += length;
+        data += length;
+        remaining -= length;
+    }
+    return 0;
+}
+
+/**
+ * @brief Vérifie ou note les codes de contrôle des blocs d'une suite de morceaux contigus.
+ * 
+ * En lecture, les morceaux ne couvrent que des blocs entiers, vérifiés
+ * depuis le tampon des requêtes. En écriture, les codes des blocs
+ * sont effacés avant le transfert, pour qu'une lecture asynchrone en cours ne
+ * compare pas les nouveaux octets à l'ancien code, puis recalculés après
+ * lui : depuis le tampon pour un bloc entier, en relisant le bloc sinon.
+ * 
+ * @param partition La partition.
+ * @param segments Les morceaux, contigus dans la partition.
+ * @param count Le nombre de morceaux.
+ * @param mode 2 pour effacer les codes avant une écriture, 1 pour les noter après, 0 pour vérifier une lecture.
+ * @return 0 en cas de succès, -1 si un bloc est corrompu ou en cas d'erreur.
+ */
+static int checkSegments(Partition* partition, const IoSegment* segments, int count, int mode) {
+    off_t data_start = dataBlockOffset(partition, 0);
+    uint64_t first = (uint64_t)(segments[0].offset - data_start) >> partition->block_shift;
+    uint64_t last = first;
+    for (int i = 0; i < count; ++i) {
+        off_t offset = segments[i].offset;
+        const char* data = segments[i].data;
+        size_t remaining = segments[i].length;
+        while (remaining > 0) {
+            uint64_t block = (uint64_t)(offset - data_start) >> partition->block_shift;
+            size_t length = partition->block_size - ((offset - data_start) & (partition->block_size - 1));
+            if (length > remaining) {
+                length = remaining;
+            }
+            if (mode == 2) {
+                __atomic_store_n(&partition->checksums[block], 0, __ATOMIC_RELAXED);
+            } else if (mode) {
+                if (updateBlockChecksum(partition, offset, data, length) == NO_BLOCK) {
+                    return -1;
+                }
+            } else if (verifyBlockChecksum(partition, block, data) == -1) {
+                return -1;
+            }
+            last = block;
+            offset += length;
+            data += length;
+            remaining -= length;
+        }
+    }
+    return mode == 1 ? dirtyBlockChecksums(partition, first, last - first + 1) : 0;
+}
+
+/**
+ * @brief Transfère les morceaux d'un lot, triés par position, en regroupant les morceaux contigus.
+ * 
+ * Si des morceaux se chevauchent, ils sont transférés dans l'ordre des
+ * requêtes afin que la dernière écriture l'emporte.
+ * 
+ * @param partition La partition.
+ * @param list Les morceaux.
+ * @param write_mode 1 pour écrire (pwritev), 0 pour lire (preadv).
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int submitSegments(Partition* partition, IoSegmentList* list, int write_mode) {
+    if (list->count == 0) {
+        return 0; // Tout a été servi par le cache
+    }
+    qsort(list->segments, list->count, sizeof(IoSegment), compareSegments);
+    for (int i = 1; i < list->count; ++i) {
+        if (list->segments[i].offset < list->segments[i - 1].offset + (off_t)list->segments[i - 1].length) {
+            // Chevauchement : revenir à l'ordre des requêtes
+            qsort(list->segments, list->count, sizeof(IoSegment), compareSegmentOrder);
+            break;
+        }
+    }
+
+    struct iovec iov[BATCH_IOV_MAX];
+    int start = 0;
+    while (start < list->count) {
+        // Regrouper les morceaux qui se suivent dans la partition
+        int end = start;
+        size_t total = 0;
+        while (end < list->count && end - start < BATCH_IOV_MAX
+               && (end == start || list->segments[end].offset == list->segments[end - 1].offset + (off_t)list->segments[end - 1].length)) {
+            iov[end - start].iov_base = list->segments[end].data;
+            iov[end - start].iov_len = list->segments[end].length;
+            total += list->segments[end].length;
+            end++;
+        }
+
+        if (write_mode) {
+            checkSegments(partition, &list->segments[start], end - start, 2);
+        }
+        ssize_t done = write_mode ? partitionWritev(partition, iov, end - start, list->segments[start].offset)
+                                  : partitionReadv(partition, iov, end - start, list->segments[start].offset);
+        if (done != (ssize_t)total || checkSegments(partition, &list->segments[start], end - start, write_mode) == -1) {
+            return -1;
+        }
+        start = end;
+    }
+    return 0;
+}
+
+/**
+ * @brief Prépare une requête positionnée : vérification, association des blocs et découpage en morceaux.
+ * 
+ * Pour une écriture, les blocs nécessaires sont associés au fichier, ses
+ * blocs partagés sont copiés et sa taille est mise à jour. Le champ result reçoit le nombre d'octets à
+ * transférer, ou -1 si la requête est invalide. Un fichier rangé dans son
+ * inode ou compressé est transféré sur-le-champ. Le verrou de l'inode du
+ * fichier doit être pris, en écriture pour une écriture.
+ * 
+ * @param partition La partition.
+ * @param request La requête.
+ * @param write_mode 1 pour une écriture, 0 pour une lecture.
+ * @param list La liste recevant les morceaux à transférer directement.
+ * @return 0 en cas de succès (requête valide ou non), -1 en cas d'erreur.
+ */
+static int prepareRequest(Partition* partition, IoRequest* request, int write_mode, IoSegmentList* list) {
+    request->result = -1;
+    if (request->f == NULL || request->f->partition != partition || request->offset < 0
+        || (request->iov.iov_base == NULL && request->iov.iov_len > 0)) {
+        return 0;
+    }
+    inode* inode_of_file = inodeAt(partition, request->f->inodeNumber);
+    if (request->offset > inode_of_file->fileSize) {
+        return 0; // Les fichiers n'ont pas de trous
+    }
+    if (write_mode && (inode_of_file->flags & INODE_READONLY)) {
+        return 0; // Un fichier d'instantané ne change plus
+    }
+
+    // Les blocs logiques d'un fichier sont numérotés sur 32 bits
+    int64_t end = partition->max_file_size;
+    if (request->iov.iov_len < (uint64_t)(partition->max_file_size - request->offset)) {
+        end = request->offset + (int64_t)request->iov.iov_len;
+    }
+
+    // Un petit fichier est servi depuis son inode, sans morceau à transférer
+    if (inode_of_file->flags & INODE_INLINE) {
+        if (!write_mode || end <= (int64_t)INLINE_DATA_MAX) {
+            if (!write_mode && end > inode_of_file->fileSize) {
+                end = inode_of_file->fileSize;
+            }
+            request->result = end - request->offset;
+            if (request->result > 0) {
+                transferInline(partition, inode_of_file, request->offset, request->iov.iov_base, request->result, write_mode);
+            }
+            request->f->fileSize = inode_of_file->fileSize;
+            return 0;
+        }
+        if (moveInlineData(partition, inode_of_file) == -1) {
+            return -1;
+        }
+    }
+
+    // Un fichier compressé est servi par groupes de blocs, lui aussi sans morceau à transférer
+    if (clusterBlocks(partition, inode_of_file) != 0) {
+        if (!write_mode && end > inode_of_file->fileSize) {
+            end = inode_of_file->fileSize;
+        }
+        int64_t length = end > request->offset ? end - request->offset : 0;
+        if (length > 0 && write_mode) {
+            length = writeCompressed(partition, inode_of_file, request->offset, request->iov.iov_base, length);
+        } else if (length > 0 && readCompressed(partition, inode_of_file, request->offset, request->iov.iov_base, length) == -1) {
+            length = -1;
+        }
+        if (length == -1) {
+            return -1;
+        }
+        request->result = length;
+        request->f->fileSize = inode_of_file->fileSize;
+        return 0;
+    }
+    if (write_mode) {
+        // Associer les blocs nécessaires, limités par la place disponible
+        uint32_t blocks_needed = (end + partition->block_size - 1) >> partition->block_shift;
+        int64_t capacity = (int64_t)growFile(partition, inode_of_file, blocks_needed) << partition->block_shift;
+        if (end > capacity) {
+            end = capacity;
+        }
+        end = unshareBlocks(partition, inode_of_file, request->offset, end);
+        if (end == -1) {
+            return -1;
+        }
+    } else if (end > inode_of_file->fileSize) {
+        end = inode_of_file->fileSize;
+    }
+    request->result = end > request->offset ? end - request->offset : 0;
+
+    if (resolveRequest(partition, request, inode_of_file, write_mode, list) == -1) {
+        return -1;
+    }
+    if (write_mode && end > inode_of_file->fileSize) {
+        inode_of_file->fileSize = end;
+        request->f->fileSize = end;
+        journalDirty(&partition->journal, &inode_of_file->fileSize, sizeof(int64_t));
+    }
+    return 0;
+}
+
+/**
+ * @brief Compare deux numéros d'inodes (pour qsort).
+ * @param a Pointeur vers le premier numéro.
+ * @param b Pointeur vers le second numéro.
+ * @return Un entier négatif, nul ou positif.
+ */
+static int compareInodeNumbers(const void* a, const void* b) {
+    uint32_t number_a = *(const uint32_t*)a, number_b = *(const uint32_t*)b;
+    return number_a < number_b ? -1 : number_a > number_b;
+}
+
+/**
+ * @brief Exécute un lot de requêtes de lecture ou d'écriture.
+ * @param partition La partition.
+ * @param requests Les requêtes.
+ * @param count Le nombre de requêtes.
+ * @param write_mode 1 pour écrire, 0 pour lire.
+ * @return Le nombre total d'octets transférés, -1 en cas d'erreur.
+ */
+static int64_t transferBatch(Partition* partition, IoRequest* requests, int count, int write_mode) {
+    if (partition == NULL || requests == NULL || count < 0) {
+        return -1;
+    }
+
+    // Les inodes concernés, sans doublon, sont verrouillés par numéro croissant pour tout le lot
+    uint32_t* locked = malloc((count > 0 ? count : 1) * sizeof(uint32_t));
+    if (locked == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour les requêtes groupées.");
+        return -1;
+    }
+    int num_locked = 0;
+    for (int i = 0; i < count; ++i) {
+        if (requests[i].f != NULL && requests[i].f->partition == partition) {
+            locked[num_locked++] = requests[i].f->inodeNumber;
+        }
+    }
+    qsort(locked, num_locked, sizeof(uint32_t), compareInodeNumbers);
+    int distinct = 0;
+    for (int i = 0; i < num_locked; ++i) {
+        if (distinct == 0 || locked[distinct - 1] != locked[i]) {
+            locked[distinct++] = locked[i];
+        }
+    }
+    num_locked = distinct;
+
+    if (write_mode) {
+        journalStart(&partition->journal);
+    }
+    for (int i = 0; i < num_locked; ++i) {
+        if (write_mode) {
+            pthread_rwlock_wrlock(inodeLock(partition, locked[i]));
+        } else {
+            pthread_rwlock_rdlock(inodeLock(partition, locked[i]));
+        }
+    }
+
+    IoSegmentList list = { NULL, 0, 0 };
+    int64_t total = 0;
+    errno = 0;
+
+    // Résoudre toutes les correspondances de blocs avant le moindre transfert
+    int status = 0;
+    for (int i = 0; i < count && status == 0; ++i) {
+        status = prepareRequest(partition, &requests[i], write_mode, &list);
+        if (requests[i].result > 0) {
+            total += requests[i].result;
+        }
+    }
+    if (status == 0) {
+        status = submitSegments(partition, &list, write_mode);
+    }
+    free(list.segments);
+
+    for (int i = num_locked - 1; i >= 0; --i) {
+        pthread_rwlock_unlock(inodeLock(partition, locked[i]));
+    }
+    free(locked);
+    if (write_mode) {
+        journalStop(&partition->journal);
+        return status == -1 ? -1 : total;
+    }
+    return status == -1 ? readError() : total;
+}
+
+/**
+ * @brief Fonction pour lire un lot de requêtes positionnées.
+ * @param partition La partition.
+ * @param requests Les requêtes.
+ * @param count Le nombre de requêtes.
+ * @return Le nombre total d'octets lus, -1 en cas d'erreur, ERROR_CHECKSUM si un bloc est corrompu.
+ */
+int64_t myReadv(Partition* partition, IoRequest* requests, int count) {
+    return transferBatch(partition, requests, count, 0);
+}
+
+/**
+ * @brief Fonction pour écrire un lot de requêtes positionnées.
+ * @param partition La partition.
+ * @param requests Les requêtes.
+ * @param count Le nombre de requêtes.
+ * @return Le nombre total d'octets écrits, -1 en cas d'erreur.
+ */
+int64_t myWritev(Partition* partition, IoRequest* requests, int count) {
+    return transferBatch(partition, requests, count, 1);
+}
+
+/**
+ * @brief Prépare une requête asynchrone et la confie au moteur.
+ * @param f Le fichier.
+ * @param offset La position dans le fichier.
+ * @param buffer Le tampon.
+ * @param nBytes Le nombre d'octets.
+ * @param write_mode 1 pour écrire, 0 pour lire.
+ * @param callback La fonction appelée à la fin de la requête.
+ * @param arg L'argument de la fonction.
+ * @return Le nombre d'octets qui seront transférés, -1 si la requête est refusée.
+ */
+static int64_t transferAsync(file* f, int64_t offset, void* buffer, int64_t nBytes, int write_mode, AsyncCallback callback, void* arg) {
+    if (f == NULL || f->partition->async.backend == 0 || nBytes < 0) {
+        return -1;
+    }
+    Partition* partition = f->partition;
+
+    // L'inode n'est verrouillé que pendant la résolution des blocs, pas pendant le transfert
+    IoRequest request = { f, offset, { buffer, nBytes }, -1 };
+    IoSegmentList list = { NULL, 0, 0 };
+    pthread_rwlock_t* inode_lock = inodeLock(partition, f->inodeNumber);
+    if (write_mode) {
+        journalStart(&partition->journal);
+        pthread_rwlock_wrlock(inode_lock);
+    } else {
+        pthread_rwlock_rdlock(inode_lock);
+    }
+    errno = 0;
+    int status = prepareRequest(partition, &request, write_mode, &list);
+    if (write_mode && status == 0 && list.count > 0) {
+        // Les codes sont recalculés à la fin de chaque transfert
+        checkSegments(partition, list.segments, list.count, 2);
+    }
+    pthread_rwlock_unlock(inode_lock);
+    if (write_mode) {
+        journalStop(&partition->journal);
+    }
+    if (status == -1 || request.result == -1) {
+        free(list.segments);
+        return write_mode || status == 0 ? -1 : readError();
+    }
+
+    AsyncRequest* async_request = malloc(sizeof(AsyncRequest) + list.count * sizeof(AsyncOp));
+    if (async_request == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour la requête asynchrone.");
+        free(list.segments);
+        return -1;
+    }
+    async_request->callback = callback;
+    async_request->arg = arg;
+    async_request->result = request.result;
+    async_request->num_ops = list.count;
+    for (int i = 0; i < list.count; ++i) {
+        AsyncOp* op = &async_request->ops[i];
+        op->offset = list.segments[i].offset;
+        op->iov.iov_base = list.segments[i].data;
+        op->iov.iov_len = list.segments[i].length;
+        op->write_mode = write_mode;
+    }
+    free(list.segments);
+
+    asyncQueue(&partition->async, async_request);
+    return request.result;
+}
+
+/**
+ * @brief Fonction pour lancer une lecture asynchrone positionnée.
+ * @param f Le fichier.
+ * @param offset La position dans le fichier.
+ * @param buffer Le tampon de destination.
+ * @param nBytes Le nombre d'octets à lire.
+ * @param callback La fonction appelée à la fin de la lecture.
+ * @param arg L'argument de la fonction.
+ * @return Le nombre d'octets qui seront lus, -1 si la requête est refusée.
+ */
+int64_t myReadAsync(file* f, int64_t offset, void* buffer, int64_t nBytes, AsyncCallback callback, void* arg) {
+    return transferAsync(f, offset, buffer, nBytes, 0, callback, arg);
+}
+
+/**
+ * @brief Fonction pour lancer une écriture asynchrone positionnée.
+ * @param f Le fichier.
+ * @param offset La position dans le fichier.
+ * @param buffer Le tampon contenant les données.
+ * @param nBytes Le nombre d'octets à écrire.
+ * @param callback La fonction appelée à la fin de l'écriture.
+ * @param arg L'argument de la fonction.
+ * @return Le nombre d'octets qui seront écrits, -1 si la requête est refusée.
+ */
+int64_t myWriteAsync(file* f, int64_t offset, void* buffer, int64_t nBytes, AsyncCallback callback, void* arg) {
+    return transferAsync(f, offset, buffer, nBytes, 1, callback, arg);
+}
+
+/**
+ * @brief Fonction pour transmettre à la partition les requêtes asynchrones en attente.
+ * @param partition La partition.
+ * @return Le nombre de transferts transmis, -1 en cas d'erreur.
+ */
+int myAsyncSubmit(Partition* partition) {
+    return asyncSubmit(&partition->async);
+}
+
+/**
+ * @brief Fonction pour traiter les requêtes asynchrones terminées, sans attendre.
+ * @param partition La partition.
+ * @return Le nombre de requêtes terminées, -1 en cas d'erreur.
+ */
+int myAsyncPoll(Partition* partition) {
+    return asyncReap(&partition->async, 0);
+}
+
+/**
+ * @brief Fonction pour attendre la fin de requêtes asynchrones.
+ * @param partition La partition.
+ * @param minCompletions Le nombre de requêtes terminées à attendre.
+ * @return Le nombre de requêtes terminées, -1 en cas d'erreur.
+ */
+int myAsyncWait(Partition* partition, int minCompletions) {
+    return asyncReap(&partition->async, minCompletions);
+}
+
+/**
+ * @brief Fonction pour reconfigurer le moteur asynchrone.
+ * @param partition La partition.
+ * @param depth Le nombre maximal de transferts en cours.
+ * @param backend Le moteur souhaité.
+ * @return Le moteur utilisé, -1 en cas d'erreur.
+ */
+int myAsyncSetup(Partition* partition, unsigned depth, int backend) {
+    if (partition == NULL) {
+        return -1;
+    }
+    asyncDestroy(&partition->async);
+    if (asyncInit(&partition->async, partition, depth, backend) == -1) {
+        // Conserver un moteur utilisable pour les requêtes suivantes
+        asyncInit(&partition->async, partition, ASYNC_DEPTH, ASYNC_BACKEND_AUTO);
+        return -1;
+    }
+    return partition->async.backend;
+}
+
+/**
+ * @brief Ajoute un nom à une liste de noms terminée par NULL, en l'agrandissant au besoin.
+ * @param files La liste, remplacée si elle est agrandie.
+ * @param num_files Le nombre de noms de la liste, incrémenté.
+ * @param max_files La capacité de la liste, NULL final compris.
+ * @param name Le nom à ajouter.
+ * @param suffix Chaîne ajoutée à la fin du nom.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+static int appendName(char*** files, size_t* num_files, size_t* max_files, const char* name, const char* suffix) {
+    // Garder une place pour le NULL final
+    if (*num_files + 1 == *max_files) {
+        char** larger = realloc(*files, *max_files * 2 * sizeof(char*));
+        if (larger == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour la liste des fichiers.");
+            return -1;
+        }
+        *files = larger;
+        *max_files *= 2;
+    }
+    char* copy = malloc(strlen(name) + strlen(suffix) + 1);
+    if (copy == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour le nom de fichier.");
+        return -1;
+    }
+    strcpy(copy, name);
+    strcat(copy, suffix);
+    (*files)[(*num_files)++] = copy;
+    return 0;
+}
+
+/**
+ * @brief Liste le contenu d'un répertoire de la partition.
+ * @param partition La partition.
+ * @param path Le chemin du répertoire, "/" pour la racine.
+ * @return Un tableau de chaînes de caractères terminé par NULL contenant les noms des entrées, suivis de
+ *         PATH_SEPARATOR pour les répertoires, NULL si le répertoire n'existe pas ou en cas d'erreur.
+ *         Les noms sont dans l'ordre de leurs empreintes ; le tableau et les noms sont alloués
+ *         dynamiquement et doivent être libérés par l'appelant.
+ */
+char** listDirectory(Partition* partition, char* path) {
+    uint32_t directory = partition != NULL && path != NULL ? resolvePath(partition, path) : NO_INODE;
+    InodeChunk* chunk = directory != NO_INODE ? createInodeChunk(partition, directory) : NULL;
+    if (chunk == NULL) {
+        return NULL;
+    }
+
+    // Le tableau grandit avec le nombre d'entrées trouvées
+    size_t max_files = 64;
+    size_t num_files = 0;
+    char** files = (char**)malloc(max_files * sizeof(char*));
+    if (files == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour la liste des fichiers.");
+        return NULL;
+    }
+
+    // Parcourir les feuilles chaînées de l'arbre, sans création ni suppression concurrente dans le répertoire
+    pthread_rwlock_t* lock = &chunk->locks[directory % INODES_PER_CHUNK];
+    pthread_rwlock_rdlock(lock);
+    const inode* listed = inodeAt(partition, directory);
+    int status = listed->type == INODE_DIRECTORY ? 0 : -1;
+    if (status == 0 && listed->dir_tree != NO_BLOCK) {
+        DirNode path_nodes[DIR_TREE_MAX_DEPTH];
+        uint64_t path_blocks[DIR_TREE_MAX_DEPTH];
+        int slots[DIR_TREE_MAX_DEPTH];
+        int level = descendDirTree(partition, listed->dir_tree, 0, path_nodes, path_blocks, slots);
+        DirNode* leaf = level >= 0 ? &path_nodes[level] : NULL;
+        status = leaf != NULL ? 0 : -1;
+        while (status == 0) {
+            for (int i = 0; i < leaf->count && status == 0; ++i) {
+                const inode* entry = inodeAt(partition, leaf->entries[i].inode);
+                status = appendName(&files, &num_files, &max_files, entry->name,
+                                    entry->type == INODE_DIRECTORY ? "/" : "");
+            }
+            if (status == -1 || leaf->next == NO_BLOCK) {
+                break;
+            }
+            status = readTreeNode(partition, leaf->next, leaf, sizeof(DirNode));
+        }
+    }
+    pthread_rwlock_unlock(lock);
+
+    if (status == -1) {
+        for (size_t j = 0; j < num_files; ++j) {
+            free(files[j]);
+        }
+        free(files);
+        return NULL;
+    }
+
+    // Terminer la liste des noms de fichiers avec NULL
+    files[num_files] = NULL;
+
+    return files;
+}
+
+/**
+ * @brief Liste les fichiers et répertoires du répertoire racine de la partition.
+ * @param partition La partition.
+ * @return Un tableau de chaînes de caractères contenant les noms de fichiers, NULL en cas d'erreur.
+ *         Les fichiers retournés sont alloués dynamiquement, et il est de la responsabilité de l'appelant
+ *         de libérer la mémoire une fois qu'ils ne sont plus nécessaires en appelant freeFiles().
  * @author Lauriane
  */
-int myFormat(char* partitionName) {
-    int partition_fd = open(partitionName, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
-    if (partition_fd == -1) {
-        perror("Erreur: Impossible de créer la partition.\n");
+char** listFiles(Partition* partition) {
+    return listDirectory(partition, "/");
+}
+
+/**
+ * @brief Compte le nombre de fichiers dans un tableau de chaînes de caractères.
+ * @param files Le tableau de chaînes de caractères contenant les noms de fichiers.
+ * @return Le nombre de fichiers dans le tableau.
+ * @author Boyan
+ */
+int numFiles(char** files) {
+    int count = 0; /**< Compteur du nombre de fichiers */
+    
+    // Parcours du tableau de chaînes de caractères jusqu'à ce que NULL soit rencontré
+    while (files[count] != NULL) {
+        count++; /**< Incrémente le compteur */
+    }
+    
+    return count; /**< Retourne le nombre total de fichiers */
+}
+
+/**
+ * @brief Fonction pour supprimer un fichier ou un répertoire vide de la partition.
+ * @param partition La partition.
+ * @param fileName Le chemin du fichier ou du répertoire à supprimer.
+ * @return 0 si le fichier est supprimé avec succès, -1 en cas d'erreur.
+ * @author Boyan
+ */
+int deleteFileFromPartition(Partition* partition, char* fileName) {
+    // Recherche de l'inode associé au chemin donné, sans création ni suppression concurrente
+    uint64_t start = statsStart(STATS_DELETE);
+    journalStart(&partition->journal);
+    pthread_mutex_lock(&partition->namespace_lock);
+    char name[MAX_FILE_NAME];
+    uint32_t directory = fileName != NULL ? resolveParent(partition, fileName, name) : NO_INODE;
+    uint32_t hash = 0;
+    uint32_t i = NO_INODE;
+    if (directory != NO_INODE && name[0] != '\0') {
+        hash = hashName(name);
+        i = lookupEntry(partition, directory, name, hash);
+    }
+    InodeChunk* chunk = i != NO_INODE ? createInodeChunk(partition, i) : NULL;
+    InodeChunk* directory_chunk = chunk != NULL ? createInodeChunk(partition, directory) : NULL;
+    if (directory_chunk == NULL) {
+        pthread_mutex_unlock(&partition->namespace_lock);
+        journalStop(&partition->journal);
+        printf("Erreur : Le fichier '%s' n'a pas été trouvé dans la partition.\n", fileName);
+        statsRecord(&partition->stats, STATS_DELETE, start, -1);
+        return -1; // Fichier non trouvé
+    }
+
+    // Les verrous du répertoire et de l'inode sont pris dans l'ordre de leurs numéros
+    pthread_rwlock_t* inode_lock = &chunk->locks[i % INODES_PER_CHUNK];
+    pthread_rwlock_t* directory_lock = &directory_chunk->locks[directory % INODES_PER_CHUNK];
+    pthread_rwlock_wrlock(directory < i ? directory_lock : inode_lock);
+    pthread_rwlock_wrlock(directory < i ? inode_lock : directory_lock);
+
+    inode* inode_of_file = inodeAt(partition, i);
+    if (inode_of_file->type == INODE_DIRECTORY && inode_of_file->fileSize > 0) {
+        pthread_rwlock_unlock(inode_lock);
+        pthread_rwlock_unlock(directory_lock);
+        pthread_mutex_unlock(&partition->namespace_lock);
+        journalStop(&partition->journal);
+        printf("Erreur : Le répertoire '%s' n'est pas vide.\n", fileName);
+        statsRecord(&partition->stats, STATS_DELETE, start, -1);
         return -1;
     }
 
-    // Initialisation des informations de la partition
-    super_file_data.num_inodes = NUM_INODES;
-    super_file_data.taille_partition = 32768;
-    super_file_data.fileDescriptor = partition_fd;
+    // Retirer l'entrée du répertoire, du cache et le fichier ouvert : le chemin n'est plus trouvé par myOpen
+    if (dirRemove(partition, inodeAt(partition, directory), hash, i) == -1) {
+        pthread_rwlock_unlock(inode_lock);
+        pthread_rwlock_unlock(directory_lock);
+        pthread_mutex_unlock(&partition->namespace_lock);
+        journalStop(&partition->journal);
+        printf("Erreur : Le répertoire contenant '%s' est endommagé.\n", fileName);
+        statsRecord(&partition->stats, STATS_DELETE, start, -1);
+        return -1;
+    }
+    dcacheRemove(&partition->dentries, directory, name, hash);
+    file* opened = chunk->open_files[i % INODES_PER_CHUNK];
+    __atomic_store_n(&chunk->open_files[i % INODES_PER_CHUNK], NULL, __ATOMIC_RELEASE);
 
-    // Initialisation des blocs de données comme libres
-    for (int i = 0; i < MAX_NUM_BLOCKS; ++i) {
-        super_file_data.blocks[i].occ_block = BLOCK_FREE;
+    // Rendre à la table d'allocation les blocs de données du fichier, puis libérer l'inode
+    if (inode_of_file->type == INODE_FILE) {
+        freeFileBlocks(partition, inode_of_file);
     }
+    memset(inode_of_file, 0, sizeof(inode));
+    inode_of_file->extent_tree = NO_BLOCK;
+    journalDirty(&partition->journal, inode_of_file, sizeof(inode));
+    freeInode(partition, i);
 
-    printf("Partition '%s' formatée avec succès.\n", partitionName);
+    pthread_rwlock_unlock(inode_lock);
+    pthread_rwlock_unlock(directory_lock);
+    pthread_mutex_unlock(&partition->namespace_lock);
+    journalStop(&partition->journal);
+
+    // Libérer la mémoire du pointeur de fichier
+    if (opened != NULL) {
+        closeFile(opened);
+    }
+
+    statsRecord(&partition->stats, STATS_DELETE, start, 0);
+    return 0; // Succès
+}
+
+/**
+ * @struct CloneTree
+ * @brief Copie en mémoire des extents et de l'arbre d'extents d'un fichier à partager.
+ */
+typedef struct {
+    ExtentNode* nodes; /**< Nœuds de l'arbre dans l'ordre d'un parcours en profondeur, la racine en premier ; un fils y est désigné par son rang. */
+    int num_nodes; /**< Nombre de nœuds. */
+    int node_capacity; /**< Nombre de nœuds alloués. */
+    Extent* extents; /**< Extents directs et extents des feuilles, triés par bloc physique. */
+    size_t num_extents; /**< Nombre d'extents. */
+    size_t extent_capacity; /**< Nombre d'extents alloués. */
+    uint64_t blocks; /**< Nombre de blocs de données. */
+    uint64_t share_chunks; /**< Nombre de morceaux de la table des partages modifiés par le partage, pour le journal. */
+} CloneTree;
+
+/**
+ * @brief Ajoute des extents à la copie d'un fichier.
+ * @param partition La partition.
+ * @param tree La copie.
+ * @param extents Les extents.
+ * @param count Leur nombre.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int addCloneExtents(Partition* partition, CloneTree* tree, const Extent* extents, int count) {
+    if (tree->num_extents + count > tree->extent_capacity) {
+        size_t capacity = tree->extent_capacity == 0 ? 64 : tree->extent_capacity * 2;
+        while (capacity < tree->num_extents + count) {
+            capacity *= 2;
+        }
+        Extent* grown = realloc(tree->extents, capacity * sizeof(Extent));
+        if (grown == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour la copie d'un fichier");
+            return -1;
+        }
+        tree->extents = grown;
+        tree->extent_capacity = capacity;
+    }
+    for (int i = 0; i < count; ++i) {
+        const Extent* extent = &extents[i];
+        if (extent->length == 0 || extent->physical + extent->length > partition->superBlock->num_blocks) {
+            errno = EBADMSG;
+            return -1;
+        }
+        tree->extents[tree->num_extents++] = *extent;
+        tree->blocks += extent->length;
+    }
+    return 0;
+}
+
+/**
+ * @brief Compare deux extents selon leur premier bloc physique (pour qsort).
+ * @param a Pointeur vers le premier extent.
+ * @param b Pointeur vers le second extent.
+ * @return Un entier négatif, nul ou positif.
+ */
+static int compareExtentBlocks(const void* a, const void* b) {
+    uint64_t block_a = ((const Extent*)a)->physical, block_b = ((const Extent*)b)->physical;
+    return block_a < block_b ? -1 : block_a > block_b;
+}
+
+/**
+ * @brief Compte les morceaux de la table des partages que modifie le partage des extents d'une copie.
+ * 
+ * Les extents sont triés par bloc physique : les extents voisins d'un
+ * fichier fragmenté partagent souvent leurs morceaux.
+ * 
+ * @param tree La copie.
+ */
+static void countShareChunks(CloneTree* tree) {
+    tree->share_chunks = 0;
+    // Fichier sans extent : aucun tableau à trier
+    if (tree->num_extents == 0) {
+        return;
+    }
+    qsort(tree->extents, tree->num_extents, sizeof(Extent), compareExtentBlocks);
+    uint64_t counted = 0;
+    for (size_t i = 0; i < tree->num_extents; ++i) {
+        const Extent* extent = &tree->extents[i];
+        uint64_t first = extent->physical * sizeof(uint16_t) / JOURNAL_CHUNK;
+        uint64_t last = (extent->physical + extent->length - 1) * sizeof(uint16_t) / JOURNAL_CHUNK;
+        // Les morceaux jusqu'à counted (exclu) sont déjà comptés
+        if (first < counted) {
+            first = counted;
+        }
+        if (last >= first) {
+            tree->share_chunks += last - first + 1;
+            counted = last + 1;
+        }
+    }
+}
+
+/**
+ * @brief Copie en mémoire un sous-arbre d'extents.
+ * @param partition La partition.
+ * @param block Le bloc de la racine du sous-arbre.
+ * @param depth La profondeur de ce nœud dans l'arbre.
+ * @param tree La copie.
+ * @return Le rang du nœud dans la copie, -1 en cas d'erreur.
+ */
+static int gatherExtentTree(Partition* partition, uint64_t block, int depth, CloneTree* tree) {
+    if (depth >= EXTENT_TREE_MAX_DEPTH) {
+        errno = EBADMSG;
+        return -1;
+    }
+    ExtentNode node;
+    if (readTreeNode(partition, block, &node, sizeof(ExtentNode)) == -1) {
+        return -1;
+    }
+    if (tree->num_nodes == tree->node_capacity) {
+        int capacity = tree->node_capacity == 0 ? 8 : tree->node_capacity * 2;
+        ExtentNode* grown = realloc(tree->nodes, capacity * sizeof(ExtentNode));
+        if (grown == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour la copie d'un fichier");
+            return -1;
+        }
+        tree->nodes = grown;
+        tree->node_capacity = capacity;
+    }
+    int rank = tree->num_nodes++;
+    if (node.depth == 0) {
+        if (addCloneExtents(partition, tree, node.extents, node.count) == -1) {
+            return -1;
+        }
+    } else {
+        for (int i = 0; i < node.count; ++i) {
+            int child = gatherExtentTree(partition, node.index[i].child, depth + 1, tree);
+            if (child == -1) {
+                return -1;
+            }
+            node.index[i].child = child;
+        }
+    }
+    tree->nodes[rank] = node;
+    return rank;
+}
+
+/**
+ * @brief Copie en mémoire les extents d'un fichier et son arbre d'extents (verrou de l'inode pris).
+ * @param partition La partition.
+ * @param inode_of_file L'inode du fichier.
+ * @param tree La copie, vide.
+ * @return 0 en cas de succès, -1 en cas d'erreur (la copie est à libérer dans tous les cas).
+ */
+static int gatherFile(Partition* partition, const inode* inode_of_file, CloneTree* tree) {
+    memset(tree, 0, sizeof(CloneTree));
+    if (inode_of_file->flags & INODE_INLINE) {
+        return 0;
+    }
+    if (addCloneExtents(partition, tree, inode_of_file->extents, inode_of_file->num_extents) == -1) {
+        return -1;
+    }
+    if (inode_of_file->extent_tree != NO_BLOCK && gatherExtentTree(partition, inode_of_file->extent_tree, 0, tree) == -1) {
+        return -1;
+    }
+    countShareChunks(tree);
+    return 0;
+}
+
+/**
+ * @brief Libère la copie en mémoire d'un fichier.
+ * @param tree La copie.
+ */
+static void freeCloneTree(CloneTree* tree) {
+    free(tree->nodes);
+    free(tree->extents);
+}
+
+/**
+ * @brief Estime la place occupée dans le journal par des copies de fichiers et de répertoires.
+ * @param share_chunks Le nombre de morceaux de la table des partages modifiés.
+ * @param nodes Le nombre de nœuds d'arbres d'extents copiés.
+ * @param entries Le nombre d'entrées créées.
+ * @return Le nombre d'octets.
+ */
+static size_t cloneJournalBytes(uint64_t share_chunks, uint64_t nodes, uint64_t entries) {
+    // Une entrée modifie son inode, son groupe d'inodes, la table d'allocation
+    // et le superbloc, et réécrit un chemin de l'arbre de son répertoire
+    size_t chunk = sizeof(JournalRecord) + JOURNAL_CHUNK, image = sizeof(JournalRecord) + JOURNAL_IMAGE_SIZE;
+    return share_chunks * chunk + nodes * (image + chunk) + entries * (8 * chunk + 3 * image);
+}
+
+/**
+ * @brief Ajoute une référence à chaque bloc de données d'une suite d'extents.
+ * @param partition La partition.
+ * @param extents Les extents.
+ * @param count Leur nombre.
+ * @return 0 en cas de succès, -1 si l'un des blocs a déjà MAX_SHARES références supplémentaires (aucun n'est alors modifié).
+ */
+static int addShares(Partition* partition, const Extent* extents, size_t count) {
+    SuperBlock* sb = partition->superBlock;
+    pthread_mutex_lock(&partition->alloc_lock);
+    for (size_t e = 0; e < count; ++e) {
+        for (uint64_t block = extents[e].physical; block < extents[e].physical + extents[e].length; ++block) {
+            if (partition->shares[block] == MAX_SHARES) {
+                pthread_mutex_unlock(&partition->alloc_lock);
+                errno = EMLINK;
+                return -1;
+            }
+        }
+    }
+    uint64_t shared_blocks = sb->shared_blocks;
+    for (size_t e = 0; e < count; ++e) {
+        for (uint64_t block = extents[e].physical; block < extents[e].physical + extents[e].length; ++block) {
+            // Les copies sur écriture lisent les compteurs sans prendre alloc_lock
+            if (partition->shares[block] == 0) {
+                shared_blocks++;
+            }
+            __atomic_store_n(&partition->shares[block], partition->shares[block] + 1, __ATOMIC_RELAXED);
+        }
+        journalDirty(&partition->journal, &partition->shares[extents[e].physical], extents[e].length * sizeof(uint16_t));
+    }
+    __atomic_store_n(&sb->shared_blocks, shared_blocks, __ATOMIC_RELAXED);
+    journalDirty(&partition->journal, &sb->shared_blocks, sizeof(sb->shared_blocks));
+    pthread_mutex_unlock(&partition->alloc_lock);
+    return 0;
+}
+
+/**
+ * @brief Prépare l'inode d'une copie d'un fichier qui partage ses blocs de données.
+ * 
+ * Chaque bloc de données gagne une référence, et les nœuds de l'arbre
+ * d'extents sont écrits dans des blocs réservés avant toute modification :
+ * la copie a son propre arbre, que ses écritures modifient sans toucher au
+ * fichier d'origine. Un fichier rangé dans son inode est simplement recopié.
+ * 
+ * @param partition La partition.
+ * @param source L'inode du fichier, verrouillé jusqu'à la fin de la copie.
+ * @param tree La copie en mémoire de ses extents.
+ * @param copy L'inode de la copie, à donner à createEntry.
+ * @return 0 en cas de succès, -1 si la partition est pleine ou en cas d'erreur.
+ */
+static int shareFile(Partition* partition, const inode* source, const CloneTree* tree, inode* copy) {
+    *copy = *source;
+    copy->flags &= ~INODE_READONLY;
+    if (source->flags & INODE_INLINE) {
+        return 0;
+    }
+
+    int64_t* blocks = NULL;
+    if (tree->num_nodes > 0) {
+        blocks = malloc(tree->num_nodes * sizeof(int64_t));
+        if (blocks == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour la copie d'un fichier");
+            return -1;
+        }
+    }
+    for (int i = 0; i < tree->num_nodes; ++i) {
+        blocks[i] = allocateBlock(partition);
+        if (blocks[i] == NO_BLOCK) {
+            while (i-- > 0) {
+                freeRun(partition, blocks[i], 1);
+            }
+            free(blocks);
+            return -1;
+        }
+    }
+    if (addShares(partition, tree->extents, tree->num_extents) == -1) {
+        for (int i = 0; i < tree->num_nodes; ++i) {
+            freeRun(partition, blocks[i], 1);
+        }
+        free(blocks);
+        return -1;
+    }
 
+    for (int i = 0; i < tree->num_nodes; ++i) {
+        ExtentNode node = tree->nodes[i];
+        if (node.depth > 0) {
+            for (int c = 0; c < node.count; ++c) {
+                node.index[c].child = blocks[node.index[c].child];
+            }
+        }
+        if (writeTreeNode(partition, blocks[i], &node, sizeof(ExtentNode)) == -1) {
+            // Rendre les références et les nœuds, y compris ceux déjà écrits
+            for (size_t e = 0; e < tree->num_extents; ++e) {
+                freeExtent(partition, &tree->extents[e]);
+            }
+            for (int n = 0; n < tree->num_nodes; ++n) {
+                journalRevokeBlock(&partition->journal, blocks[n]);
+                freeRun(partition, blocks[n], 1);
+            }
+            free(blocks);
+            return -1;
+        }
+    }
+    copy->extent_tree = tree->num_nodes > 0 ? blocks[0] : NO_BLOCK;
+    free(blocks);
+    statsAdd(&partition->stats, STATS_BLOCKS_SHARED, tree->blocks);
     return 0;
 }
 
 /**
- * @brief Fonction pour ouvrir un fichier.
- * @param fileName Le nom du fichier à ouvrir.
- * @return Un pointeur vers la structure de fichier ouvert, NULL en cas d'erreur.
- * @author Lauriane
+ * @brief Copie un fichier en partageant ses blocs de données, dans une opération du journal.
+ * @param partition La partition.
+ * @param source Le chemin du fichier.
+ * @param destination Le chemin de la copie.
+ * @param too_big Reçoit 1 si les métadonnées modifiées ne tiennent pas dans la place libre du journal.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int cloneFile(Partition* partition, const char* source, const char* destination, int* too_big) {
+    *too_big = 0;
+    journalStart(&partition->journal);
+    pthread_mutex_lock(&partition->namespace_lock);
+    char name[MAX_FILE_NAME];
+    uint32_t source_inode = resolvePath(partition, source);
+    uint32_t directory = resolveParent(partition, destination, name);
+    InodeChunk* chunk = source_inode != NO_INODE ? createInodeChunk(partition, source_inode) : NULL;
+    int status = -1;
+    if (chunk == NULL || inodeType(partition, source_inode) != INODE_FILE) {
+        printf("Erreur : Le fichier '%s' n'existe pas.\n", source);
+    } else if (directory == NO_INODE || name[0] == '\0' || !filePathValid(destination)) {
+        printf("Erreur : Le chemin '%s' est invalide ou l'un de ses répertoires n'existe pas.\n", destination);
+    } else if (lookupEntry(partition, directory, name, hashName(name)) != NO_INODE) {
+        printf("Erreur : '%s' existe déjà.\n", destination);
+    } else if (writableDirectory(partition, directory, destination)) {
+        status = 0;
+    }
+
+    if (status == 0) {
+        // Aucune écriture du fichier pendant la copie, et aucun de ses blocs modifié dans le cache
+        pthread_rwlock_t* lock = &chunk->locks[source_inode % INODES_PER_CHUNK];
+        pthread_rwlock_rdlock(lock);
+        const inode* original = inodeAt(partition, source_inode);
+        CloneTree tree;
+        memset(&tree, 0, sizeof(tree));
+        inode copy;
+        if (cacheFlush(&partition->cache) == -1) {
+            perror("Erreur lors de l'écriture des blocs modifiés");
+            status = -1;
+        }
+        if (status == 0 && gatherFile(partition, original, &tree) == -1) {
+            printf("Erreur : Les extents de '%s' sont illisibles.\n", source);
+            status = -1;
+        }
+        // Le partage tient dans une seule transaction
+        if (status == 0 && cloneJournalBytes(tree.share_chunks, tree.num_nodes, 1) > journalRoom(&partition->journal) / 2) {
+            *too_big = 1;
+            status = -1;
+        }
+        if (status == 0 && shareFile(partition, original, &tree, &copy) == -1) {
+            printf("Erreur : Pas assez de place pour copier '%s'.\n", source);
+            status = -1;
+        }
+        pthread_rwlock_unlock(lock);
+        freeCloneTree(&tree);
+        if (status == 0 && createEntry(partition, directory, name, hashName(name), INODE_FILE, &copy) == NO_INODE) {
+            freeFileBlocks(partition, &copy);
+            status = -1;
+        }
+    }
+    pthread_mutex_unlock(&partition->namespace_lock);
+    journalStop(&partition->journal);
+    return status;
+}
+
+/**
+ * @brief Fonction pour copier un fichier sans copier ses données.
+ * 
+ * La copie partage les blocs de données du fichier : seules ses métadonnées
+ * sont écrites, et un bloc partagé n'est copié qu'à sa première écriture par
+ * l'un des deux fichiers. Si le journal est trop occupé pour le partage, la
+ * transaction en cours est écrite et la copie est réessayée.
+ * 
+ * @param partition La partition.
+ * @param source Le chemin du fichier.
+ * @param destination Le chemin de la copie, qui n'existe pas encore.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int myClone(Partition* partition, char* source, char* destination) {
+    if (partition == NULL || source == NULL || destination == NULL) {
+        return -1;
+    }
+    // Les écritures asynchrones en cours atteignent leurs blocs avant le partage
+    asyncReap(&partition->async, INT_MAX);
+    int too_big;
+    int status = cloneFile(partition, source, destination, &too_big);
+    if (too_big && journalCommit(&partition->journal) == 0) {
+        status = cloneFile(partition, source, destination, &too_big);
+    }
+    if (too_big) {
+        printf("Erreur : La copie de '%s' modifie trop de métadonnées pour le journal.\n", source);
+    }
+    return status;
+}
+
+/**
+ * @struct SnapshotCost
+ * @brief Ce que coûte un instantané : entrées créées, nœuds copiés et place dans le journal.
+ */
+typedef struct {
+    uint64_t files; /**< Nombre de fichiers copiés. */
+    uint64_t directories; /**< Nombre de répertoires copiés. */
+    uint64_t nodes; /**< Nombre de nœuds d'arbres d'extents copiés. */
+    size_t entry_bytes; /**< Place maximale occupée dans le journal par la copie d'une entrée. */
+} SnapshotCost;
+
+/**
+ * @brief Lit toutes les entrées d'un répertoire.
+ * @param partition La partition.
+ * @param directory L'inode du répertoire.
+ * @param entries Reçoit le tableau des entrées, à libérer par l'appelant.
+ * @param count Reçoit le nombre d'entrées.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
  */
-file* myOpen(char* fileName) {
-    // Recherche de l'inode associé au nom de fichier donné
-    for (int i = 0; i < super_file_data.num_inodes; ++i) {
-        if (super_file_data.inodes[i].name != NULL && strcmp(super_file_data.inodes[i].name, fileName) == 0) {
-            // Vérifier si un descripteur de fichier est déjà ouvert pour ce fichier
-            if (super_file_data.inodes[i].file_pointer != NULL) {
-                return super_file_data.inodes[i].file_pointer;
+static int collectEntries(Partition* partition, const inode* directory, DirEntry** entries, size_t* count) {
+    *entries = NULL;
+    *count = 0;
+    if (directory->dir_tree == NO_BLOCK) {
+        return 0;
+    }
+    DirNode path_nodes[DIR_TREE_MAX_DEPTH];
+    uint64_t path_blocks[DIR_TREE_MAX_DEPTH];
+    int slots[DIR_TREE_MAX_DEPTH];
+    int level = descendDirTree(partition, directory->dir_tree, 0, path_nodes, path_blocks, slots);
+    if (level == -1) {
+        return -1;
+    }
+    DirNode* leaf = &path_nodes[level];
+    size_t capacity = 0;
+    while (1) {
+        if (*count + leaf->count > capacity) {
+            capacity = capacity == 0 ? DIR_LEAF_MAX * 4 : capacity * 2;
+            DirEntry* grown = realloc(*entries, capacity * sizeof(DirEntry));
+            if (grown == NULL) {
+                perror("Erreur lors de l'allocation de mémoire pour les entrées d'un répertoire");
+                return -1;
             }
+            *entries = grown;
+        }
+        memcpy(*entries + *count, leaf->entries, leaf->count * sizeof(DirEntry));
+        *count += leaf->count;
+        if (leaf->next == NO_BLOCK) {
+            return 0;
+        }
+        if (readTreeNode(partition, leaf->next, leaf, sizeof(DirNode)) == -1) {
+            return -1;
         }
     }
+}
 
-    // Si aucun inode associé au fichier n'est trouvé, rechercher un inode libre
-    for (int i = 0; i < super_file_data.num_inodes; ++i) {
-        if (super_file_data.inodes[i].name == NULL) {
-            // Recherche d'un bloc de données libre
-            int free_block_index = -1;
-            for (int j = 0; j < MAX_NUM_BLOCKS; ++j) {
-                if (super_file_data.blocks[j].occ_block == BLOCK_FREE) {
-                    free_block_index = j;
-                    super_file_data.blocks[j].occ_block = BLOCK_OCCUPIED; // Marquer le bloc comme occupé
-                    break;
-                }
-            }
-            if (free_block_index == -1) {
-                printf("Erreur : Aucun bloc de données disponible pour créer un nouveau fichier.\n");
-                return NULL;
-            }
-
-            // Créer un nouveau fichier et l'associer à l'inode libre
-            file* newFile = (file*)malloc(sizeof(file));
-            if (newFile == NULL) {
-                perror("Erreur lors de l'allocation de mémoire pour le fichier.");
-                return NULL;
-            }
-            newFile->name = strdup(fileName);
-            if (newFile->name == NULL) {
-                perror("Erreur lors de l'allocation de mémoire pour le nom de fichier.");
-                free(newFile);
-                return NULL;
-            }
-            newFile->fileSize = 0;  // Initialiser la taille du fichier à 0
-            newFile->currentPosition = 0; // Initialiser la position actuelle à 0
-
-            // Associer le fichier à l'inode libre
-            super_file_data.inodes[i].name = strdup(fileName);
-            if (super_file_data.inodes[i].name == NULL) {
-                perror("Erreur lors de l'allocation de mémoire pour le nom de fichier.");
-                free(newFile->name);
-                free(newFile);
-                return NULL;
+/**
+ * @brief Évalue le coût de la copie d'un sous-arbre de répertoires, sans les instantanés qu'il contient.
+ * @param partition La partition.
+ * @param directory L'inode du répertoire.
+ * @param cost Le coût, complété.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int measureSnapshot(Partition* partition, uint32_t directory, SnapshotCost* cost) {
+    DirEntry* entries;
+    size_t count;
+    if (collectEntries(partition, inodeAt(partition, directory), &entries, &count) == -1) {
+        return -1;
+    }
+    int status = 0;
+    for (size_t i = 0; i < count && status == 0; ++i) {
+        const inode* entry = inodeAt(partition, entries[i].inode);
+        if (entry->flags & INODE_READONLY) {
+            continue;
+        }
+        if (entry->type == INODE_DIRECTORY) {
+            cost->directories++;
+            status = measureSnapshot(partition, entries[i].inode, cost);
+        } else {
+            CloneTree tree;
+            status = gatherFile(partition, entry, &tree);
+            size_t bytes = cloneJournalBytes(tree.share_chunks, tree.num_nodes, 1);
+            cost->files++;
+            cost->nodes += tree.num_nodes;
+            if (bytes > cost->entry_bytes) {
+                cost->entry_bytes = bytes;
             }
-            super_file_data.inodes[i].file_pointer = newFile;
-            super_file_data.inodes[i].firstDataBlock = &super_file_data.blocks[free_block_index]; // Mise à jour du premier bloc de données dans l'inode
-            super_file_data.inodes[i].firstDataBlock->next = NULL;
-
-            return newFile;
+            freeCloneTree(&tree);
         }
     }
-
-    printf("Erreur : Aucun inode disponible pour créer un nouveau fichier.\n");
-    return NULL;
+    free(entries);
+    return status;
 }
 
 /**
- * @brief Fonction pour écrire dans un fichier.
- * @param f Le pointeur vers la structure de fichier.
- * @param buffer Le tampon contenant les données à écrire.
- * @param nBytes Le nombre d'octets à écrire.
- * @return Le nombre total d'octets écrits, -1 en cas d'erreur.
- * @author Lauriane
+ * @brief Copie un sous-arbre de répertoires dans un instantané, sans les instantanés qu'il contient.
+ * 
+ * Chaque entrée est copiée dans la transaction en cours, qui est d'abord
+ * écrite si elle laisse trop peu de place dans le journal.
+ * 
+ * @param partition La partition.
+ * @param directory L'inode du répertoire copié.
+ * @param copy L'inode de sa copie.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
  */
-int myWrite(file* f, void* buffer, int nBytes) {
-    if (f == NULL || buffer == NULL || nBytes <= 0) {
-        return -1; // Erreur de paramètres
+static int copySnapshot(Partition* partition, uint32_t directory, uint32_t copy) {
+    DirEntry* entries;
+    size_t count;
+    if (collectEntries(partition, inodeAt(partition, directory), &entries, &count) == -1) {
+        return -1;
     }
-
-    int bytes_written = 0;
-
-    // Écrire dans les blocs de données liés au fichier
-    while (nBytes > 0) {
-        // Calculer la position actuelle dans le bloc de données
-        int position_in_block = f->currentPosition % BLOCK_SIZE;
-
-        // Trouver le bloc de données correspondant à la position actuelle
-        DataBlock* current_block = NULL;
-        for (int i = 0; i < super_file_data.num_inodes; ++i) {
-        	if (super_file_data.inodes[i].name != NULL && strcmp(super_file_data.inodes[i].name, f->name) == 0) {
-        		DataBlock* current_block = super_file_data.inodes[i].firstDataBlock;
-        		break;
-        	}
-        }
-        while (position_in_block >= BLOCK_SIZE) {
-            if (current_block->next == NULL) {
-                // Allouer un nouveau bloc si nécessaire
-                current_block->next = (DataBlock*)malloc(sizeof(DataBlock));
-                if (current_block->next == NULL) {
-                    return bytes_written; // Retourner le nombre d'octets écrits jusqu'à présent
-                }
-                memset(current_block->next, 0, sizeof(DataBlock));
-            }
-            current_block = current_block->next;
-            position_in_block -= BLOCK_SIZE;
+    int status = 0;
+    for (size_t i = 0; i < count && status == 0; ++i) {
+        const inode* entry = inodeAt(partition, entries[i].inode);
+        if (entry->flags & INODE_READONLY) {
+            continue;
         }
-
-        // Écrire les données depuis le tampon vers le bloc de données en utilisant write
-        int bytes_to_write = BLOCK_SIZE - position_in_block;
-        if (bytes_to_write > nBytes) {
-            bytes_to_write = nBytes;
+        inode content;
+        CloneTree tree;
+        memset(&tree, 0, sizeof(tree));
+        if (entry->type == INODE_FILE) {
+            status = gatherFile(partition, entry, &tree);
         }
-        
-        int bytes_written_this_time = write(super_file_data.fileDescriptor, buffer, bytes_to_write); 
-        if (bytes_written_this_time < 0) {
-            return bytes_written_this_time; // Erreur lors de l'écriture
+        if (status == 0 && cloneJournalBytes(tree.share_chunks, tree.num_nodes, 1) > journalRoom(&partition->journal) / 2) {
+            status = journalCommitExclusive(&partition->journal);
+        }
+        if (status == 0 && entry->type == INODE_DIRECTORY) {
+            memset(&content, 0, sizeof(content));
+            content.dir_tree = NO_BLOCK;
+        } else if (status == 0) {
+            status = shareFile(partition, entry, &tree, &content);
+        }
+        freeCloneTree(&tree);
+        if (status == -1) {
+            break;
+        }
+        content.flags |= INODE_READONLY;
+        uint32_t created = createEntry(partition, copy, entry->name, entries[i].hash, entry->type, &content);
+        if (created == NO_INODE) {
+            freeFileBlocks(partition, &content);
+            status = -1;
+        } else if (entry->type == INODE_DIRECTORY) {
+            status = copySnapshot(partition, entries[i].inode, created);
         }
-        
-        // Mettre à jour la position actuelle et le nombre d'octets écrits
-        f->currentPosition += bytes_written_this_time;
-        bytes_written += bytes_written_this_time;
-        buffer += bytes_written_this_time;
-        nBytes -= bytes_written_this_time;
     }
+    free(entries);
+    return status;
+}
 
-    // Mettre à jour la taille du fichier si nécessaire
-    if (f->currentPosition > f->fileSize) {
-        f->fileSize = f->currentPosition;
+/**
+ * @brief Compte les inodes qui peuvent encore être attribués (namespace_lock doit être pris).
+ * @param partition La partition.
+ * @return Le nombre d'inodes libres.
+ */
+static uint64_t countFreeInodes(Partition* partition) {
+    SuperBlock* sb = partition->superBlock;
+    uint64_t count = (uint64_t)sb->num_inodes + 1 - sb->next_inode;
+    for (uint32_t i = sb->free_inode; i != NO_INODE && count <= sb->num_inodes; i = inodeAt(partition, i)->next_free) {
+        count++;
     }
-
-    return bytes_written;
+    return count;
 }
+
 /**
- * @brief Déplace la position de lecture/écriture dans un fichier.
- * @param f Le pointeur vers la structure de fichier.
- * @param offset Le décalage par rapport à la position de départ.
- * @param base La base à utiliser pour le décalage (SEEK_SET, SEEK_CUR ou SEEK_END).
- * @return 0 en cas de succès, -1 en cas d'erreur.
- * @author Boyan
+ * @brief Fonction pour prendre un instantané de la partition.
+ * 
+ * L'instantané est un nouveau répertoire qui contient une copie de toute
+ * l'arborescence, sauf les instantanés précédents. Ses fichiers partagent
+ * leurs blocs de données avec les originaux, comme ceux de myClone, et ses
+ * entrées sont en lecture seule : elles ne peuvent qu'être supprimées.
+ * Aucune autre opération ne modifie la partition pendant l'instantané, qui
+ * écrit ses propres transactions à mesure que le journal se remplit. Une
+ * écriture asynchrone soumise pendant sa préparation peut encore atteindre
+ * des blocs partagés.
+ * 
+ * @param partition La partition.
+ * @param path Le chemin du répertoire de l'instantané, qui n'existe pas encore.
+ * @return 0 en cas de succès, -1 en cas d'erreur (un instantané interrompu reste partiel et peut être supprimé).
  */
-void mySeek(file* f, int offset, int base) {
-    if (f == NULL) {
-        printf("Erreur : fichier NULL.\n");
-        return;
+int mySnapshot(Partition* partition, char* path) {
+    if (partition == NULL || path == NULL) {
+        return -1;
     }
+    // Les écritures en cours atteignent leurs blocs, et l'instantané commence avec un journal vide
+    asyncReap(&partition->async, INT_MAX);
+    journalStartExclusive(&partition->journal);
+    int committed = journalCommitExclusive(&partition->journal);
+    pthread_mutex_lock(&partition->namespace_lock);
 
-    off_t newPosition;
-
-    switch (base) {
-        case SEEK_SET:
-            newPosition = offset;
-            break;
-        case SEEK_CUR:
-            newPosition = f->currentPosition + offset;
-            break;
-        case SEEK_END:
-            newPosition = f->fileSize + offset;
-            break;
-        default:
-            printf("Erreur : base de déplacement incorrecte.\n");
-            return;
+    char name[MAX_FILE_NAME];
+    uint32_t directory = resolveParent(partition, path, name);
+    int status = -1;
+    SnapshotCost cost;
+    memset(&cost, 0, sizeof(cost));
+    if (directory == NO_INODE || name[0] == '\0') {
+        printf("Erreur : Le chemin '%s' est invalide ou l'un de ses répertoires n'existe pas.\n", path);
+    } else if (lookupEntry(partition, directory, name, hashName(name)) != NO_INODE) {
+        printf("Erreur : '%s' existe déjà.\n", path);
+    } else if (!writableDirectory(partition, directory, path)) {
+        // Message déjà affiché
+    } else if (committed == -1 || cacheFlush(&partition->cache) == -1) {
+        perror("Erreur lors de l'écriture des blocs modifiés");
+    } else if (measureSnapshot(partition, ROOT_INODE, &cost) == -1) {
+        printf("Erreur : L'arborescence est illisible.\n");
+    } else if (cost.entry_bytes > journalRoom(&partition->journal) / 2) {
+        printf("Erreur : L'un des fichiers modifie trop de métadonnées pour le journal.\n");
+    } else if (cost.files + cost.directories + 1 > countFreeInodes(partition)) {
+        printf("Erreur : Pas assez d'inodes libres pour l'instantané.\n");
+    } else if (cost.nodes + cost.directories + 1 > partition->superBlock->free_blocks) {
+        printf("Erreur : Pas assez de blocs libres pour l'instantané.\n");
+    } else {
+        status = 0;
     }
 
-    // Vérifier si la nouvelle position est dans les limites du fichier
-    if (newPosition < 0 || newPosition > f->fileSize) {
-        printf("Erreur : déplacement en dehors des limites du fichier.\n");
-        return;
+    if (status == 0) {
+        inode content;
+        memset(&content, 0, sizeof(content));
+        content.dir_tree = NO_BLOCK;
+        content.flags = INODE_READONLY;
+        uint32_t snapshot = createEntry(partition, directory, name, hashName(name), INODE_DIRECTORY, &content);
+        if (snapshot == NO_INODE || copySnapshot(partition, ROOT_INODE, snapshot) == -1) {
+            printf("Erreur : L'instantané '%s' est incomplet.\n", path);
+            status = -1;
+        }
     }
+    pthread_mutex_unlock(&partition->namespace_lock);
+    journalStopExclusive(&partition->journal);
+    return status;
+}
 
-    // Utiliser lseek pour déplacer le pointeur de fichier à la nouvelle position
-    off_t result = lseek(super_file_data.fileDescriptor, newPosition, SEEK_SET);
-    if (result == -1) {
-        perror("Erreur lors du déplacement du pointeur de fichier");
-        return;
+/**
+ * @brief Fonction pour choisir le codec d'un fichier vide.
+ * @param f Pointeur vers la structure de fichier, qui n'a encore aucun bloc de données.
+ * @param codec Le codec, CODEC_NONE pour ne pas compresser.
+ * @return 0 en cas de succès, -1 en cas d'erreur (errno vaut EBUSY, EINVAL ou EROFS).
+ */
+int mySetCompression(file* f, uint32_t codec) {
+    if (f == NULL) {
+        return -1;
+    }
+    Partition* partition = f->partition;
+    if (!validCompression(codec, partition->block_size)) {
+        errno = EINVAL;
+        return -1;
     }
 
+    pthread_rwlock_t* inode_lock = inodeLock(partition, f->inodeNumber);
+    journalStart(&partition->journal);
+    pthread_rwlock_wrlock(inode_lock);
+    inode* inode_of_file = inodeAt(partition, f->inodeNumber);
+    int status = -1;
+    if (inode_of_file->flags & INODE_READONLY) {
+        errno = EROFS;
+    } else if (inode_of_file->block_count != 0) {
+        errno = EBUSY; // Les groupes déjà stockés ne changent pas de format
+    } else {
+        // Les octets d'un fichier rangé dans son inode seront compressés en le quittant
+        inode_of_file->flags = (inode_of_file->flags & ((1 << INODE_CODEC_SHIFT) - 1)) | codec << INODE_CODEC_SHIFT;
+        journalDirty(&partition->journal, &inode_of_file->flags, sizeof(inode_of_file->flags));
+        status = 0;
+    }
+    pthread_rwlock_unlock(inode_lock);
+    journalStop(&partition->journal);
+    return status;
 }
 
 /**
- * @brief Fonction pour lire depuis un fichier.
- * @param f Le pointeur vers la structure de fichier.
- * @param buffer Le tampon pour stocker les données lues.
- * @param nBytes Le nombre d'octets à lire.
- * @return Le nombre total d'octets lus, -1 en cas d'erreur.
- * @author Boyan
+ * @brief Fonction pour activer ou désactiver la déduplication des écritures.
+ * @param partition La partition, qu'aucun autre thread n'utilise.
+ * @param enabled 1 pour activer la déduplication, 0 pour la désactiver.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
  */
-nt myRead(file* f, void* buffer, int nBytes) {
-    if (f == NULL || buffer == NULL || nBytes <= 0) {
-        return -1; // Erreur : Paramètres invalides
+int myDedupSetup(Partition* partition, int enabled) {
+    if (partition == NULL) {
+        return -1;
     }
+    // Une table réactivée repart vide : les propriétaires notés ont pu changer entre-temps
+    dedupDestroy(&partition->dedup);
+    if (enabled && dedupInit(&partition->dedup, partition->superBlock->num_blocks) == -1) {
+        return -1;
+    }
+    return 0;
+}
 
-    int bytes_read = 0;
+/**
+ * @struct DedupRef
+ * @brief Référence d'un bloc de données par un bloc logique d'un fichier.
+ */
+typedef struct {
+    uint64_t physical; /**< Bloc de données. */
+    uint32_t inode; /**< Inode du fichier. */
+    uint32_t logical; /**< Bloc logique du fichier qui désigne le bloc de données. */
+} DedupRef;
 
-    // Recherche de l'inode correspondant au fichier
-    inode* inode_of_file = NULL;
-    for (int i = 0; i < super_file_data.num_inodes; ++i) {
-        if (super_file_data.inodes[i].name != NULL && strcmp(super_file_data.inodes[i].name, f->name) == 0) {
-            inode_of_file = &super_file_data.inodes[i];
-            break;
+/**
+ * @struct DedupRefList
+ * @brief Références des blocs entiers de tous les fichiers à dédupliquer.
+ */
+typedef struct {
+    DedupRef* refs; /**< Références. */
+    size_t count; /**< Nombre de références. */
+    size_t capacity; /**< Nombre de références allouées. */
+} DedupRefList;
+
+/**
+ * @brief Ajoute les références des blocs entiers d'un extent.
+ * @param list La liste des références.
+ * @param inode_number L'inode du fichier.
+ * @param extent L'extent.
+ * @param full_blocks Le nombre de blocs entiers du fichier : le dernier bloc, rempli en partie, n'est pas dédupliqué.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+static int addDedupRefs(DedupRefList* list, uint32_t inode_number, const Extent* extent, uint64_t full_blocks) {
+    for (uint32_t i = 0; i < extent->length && extent->logical + i < full_blocks; ++i) {
+        if (list->count == list->capacity) {
+            size_t capacity = list->capacity == 0 ? 1024 : list->capacity * 2;
+            DedupRef* grown = realloc(list->refs, capacity * sizeof(DedupRef));
+            if (grown == NULL) {
+                perror("Erreur lors de l'allocation de mémoire pour la déduplication");
+                return -1;
+            }
+            list->refs = grown;
+            list->capacity = capacity;
         }
+        DedupRef* ref = &list->refs[list->count++];
+        ref->physical = extent->physical + i;
+        ref->inode = inode_number;
+        ref->logical = extent->logical + i;
     }
+    return 0;
+}
 
-    if (inode_of_file == NULL || inode_of_file->firstDataBlock == NULL) {
-        // Gérer l'erreur : fichier non trouvé ou aucun bloc de données associé
+/**
+ * @brief Note les références des blocs entiers des fichiers non compressés d'un sous-arbre de répertoires.
+ * @param partition La partition.
+ * @param directory L'inode du répertoire.
+ * @param list La liste des références, complétée.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int gatherDedupRefs(Partition* partition, uint32_t directory, DedupRefList* list) {
+    DirEntry* entries;
+    size_t count;
+    if (collectEntries(partition, inodeAt(partition, directory), &entries, &count) == -1) {
         return -1;
     }
-
-    // Positionner la tête de lecture au bon endroit dans la partition
-    mySeek(f, 0, SEEK_SET);
-
-    // Lire à partir des blocs de données liés à l'inode
-    DataBlock* current_block = inode_of_file->firstDataBlock;
-    while (current_block != NULL && nBytes > 0) {
-        // Lire les données à partir du bloc de données
-        int bytes_to_read = (nBytes > BLOCK_SIZE) ? BLOCK_SIZE : nBytes;
-        int bytes_read_current = read(super_file_data.fileDescriptor, buffer, bytes_to_read);
-        if (bytes_read_current == -1) {
-            // Gérer l'erreur de lecture
-            return -1;
+    int status = 0;
+    for (size_t i = 0; i < count && status == 0; ++i) {
+        const inode* entry = inodeAt(partition, entries[i].inode);
+        if (entry->type == INODE_DIRECTORY) {
+            status = gatherDedupRefs(partition, entries[i].inode, list);
+        } else if (!(entry->flags & INODE_INLINE) && clusterBlocks(partition, entry) == 0) {
+            // Les groupes d'un fichier compressé n'ont pas de contenu comparable d'un fichier à l'autre
+            CloneTree tree;
+            status = gatherFile(partition, entry, &tree);
+            uint64_t full_blocks = (uint64_t)entry->fileSize >> partition->block_shift;
+            for (size_t e = 0; e < tree.num_extents && status == 0; ++e) {
+                status = addDedupRefs(list, entries[i].inode, &tree.extents[e], full_blocks);
+            }
+            freeCloneTree(&tree);
         }
-        bytes_read += bytes_read_current;
-        nBytes -= bytes_read_current;
-        buffer += bytes_read_current;
+    }
+    free(entries);
+    return status;
+}
 
-        // Passer au bloc de données suivant
-        current_block = current_block->next;
+/**
+ * @brief Compare deux références par bloc de données, puis par fichier et bloc logique.
+ * @param a La première référence (DedupRef*).
+ * @param b La seconde référence (DedupRef*).
+ * @return Un entier négatif, nul ou positif selon l'ordre des références.
+ */
+static int compareDedupRefs(const void* a, const void* b) {
+    const DedupRef* x = a;
+    const DedupRef* y = b;
+    if (x->physical != y->physical) {
+        return x->physical < y->physical ? -1 : 1;
     }
+    if (x->inode != y->inode) {
+        return x->inode < y->inode ? -1 : 1;
+    }
+    return (x->logical > y->logical) - (x->logical < y->logical);
+}
 
-    return bytes_read;
+/**
+ * @brief Compare deux blocs par empreinte, puis par numéro.
+ * @param a La première empreinte (DedupEntry*).
+ * @param b La seconde empreinte (DedupEntry*).
+ * @return Un entier négatif, nul ou positif selon l'ordre des blocs.
+ */
+static int compareFingerprints(const void* a, const void* b) {
+    const DedupEntry* x = a;
+    const DedupEntry* y = b;
+    if (x->fingerprint != y->fingerprint) {
+        return x->fingerprint < y->fingerprint ? -1 : 1;
+    }
+    return (x->block > y->block) - (x->block < y->block);
 }
 
 /**
- * @brief Fonction pour afficher l'aide.
- * @author Boyan
+ * @brief Cherche la première référence d'un bloc de données.
+ * @param list La liste des références, triée par bloc de données.
+ * @param physical Le bloc.
+ * @return L'indice de sa première référence.
  */
-void printHelp() {
-    printf("Utilisation :\n");
-    printf("Choix 1 : Ouvre un fichier texte existant. : <nom_fichier.txt>\n");
-    printf("Choix 2 : Ecrit des données dans un fichier texte spécifié. : <nom_fichier.txt> <donnees>\n");
-    printf("Choix 3 : Lit les données depuis un fichier texte existant. : <nom_fichier.txt>\n");
-    printf("Choix 4 : Supprime le fichier voulu\n");
-    printf("Choix 5 : Affiche les fichiers existants\n");
+static size_t firstDedupRef(const DedupRefList* list, uint64_t physical) {
+    size_t low = 0, high = list->count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (list->refs[middle].physical < physical) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
 }
 
+/**
+ * @brief Remplace toutes les références d'une copie par des références au bloc identique conservé.
+ * 
+ * Chaque fichier est modifié sous son verrou en écriture, dans la
+ * transaction en cours, écrite d'abord si elle laisse trop peu de place.
+ * La copie est libérée avec sa dernière référence.
+ * 
+ * @param partition La partition, dont l'opération exclusive du journal est en cours.
+ * @param kept Le bloc conservé.
+ * @param refs Les références de la copie.
+ * @param count Leur nombre.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+static int mergeCopy(Partition* partition, uint64_t kept, const DedupRef* refs, size_t count) {
+    for (size_t r = 0; r < count; ++r) {
+        if (journalRoom(&partition->journal) < remapJournalBytes() && journalCommitExclusive(&partition->journal) == -1) {
+            return -1;
+        }
+        InodeChunk* chunk = createInodeChunk(partition, refs[r].inode);
+        if (chunk == NULL) {
+            return -1;
+        }
+        pthread_rwlock_t* lock = &chunk->locks[refs[r].inode % INODES_PER_CHUNK];
+        pthread_rwlock_wrlock(lock);
+        inode* inode_of_file = inodeAt(partition, refs[r].inode);
+        Extent added = { refs[r].logical, 1, kept }, old = { refs[r].logical, 1, refs[r].physical };
+        int status = addShares(partition, &added, 1);
+        if (status == 0 && remapExtent(partition, inode_of_file, refs[r].logical, 1, kept) == -1) {
+            freeExtent(partition, &added);
+            status = -1;
+        }
+        if (status == 0) {
+            freeExtent(partition, &old);
+        }
+        pthread_rwlock_unlock(lock);
+        if (status == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
 
 /**
- * @brief Liste tous les fichiers présents dans la partition.
- * @return Un tableau de chaînes de caractères contenant les noms de fichiers, NULL en cas d'erreur.
- *         Les fichiers retournés sont alloués dynamiquement, et il est de la responsabilité de l'appelant
- *         de libérer la mémoire une fois qu'ils ne sont plus nécessaires en appelant freeFiles().
- * @author Lauriane
+ * @brief Fusionne les blocs d'un groupe de même empreinte qui ont le même contenu que le premier.
+ * @param partition La partition.
+ * @param group Les blocs, par numéro croissant.
+ * @param count Leur nombre, au moins 2.
+ * @param list Les références de tous les blocs, triées par bloc de données.
+ * @param data Un tampon de deux blocs.
+ * @param saved Le nombre de blocs libérés, augmenté.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
  */
-char** listFiles() {
-    // Nombre maximum de fichiers dans la partition
-    int max_files = 100;
-    char** files = (char**)malloc(max_files * sizeof(char*));
-    if (files == NULL) {
-        perror("Erreur lors de l'allocation de mémoire pour la liste des fichiers.");
-        return NULL;
+static int mergeGroup(Partition* partition, const DedupEntry* group, size_t count, const DedupRefList* list, char* data, int64_t* saved) {
+    size_t block_size = partition->block_size;
+    uint64_t kept = group[0].block;
+    if (partitionRead(partition, data, block_size, dataBlockOffset(partition, kept)) != (ssize_t)block_size) {
+        return 0;
+    }
+    for (size_t k = 1; k < count; ++k) {
+        uint64_t copy = group[k].block;
+        size_t first = firstDedupRef(list, copy), end = first;
+        while (end < list->count && list->refs[end].physical == copy) {
+            end++;
+        }
+        // Une copie référencée par un bloc non examiné, comme la fin d'un fichier, reste en place
+        if (partition->shares[copy] + 1u != end - first || partition->shares[kept] + (end - first) > MAX_SHARES) {
+            continue;
+        }
+        if (partitionRead(partition, data + block_size, block_size, dataBlockOffset(partition, copy)) != (ssize_t)block_size
+            || memcmp(data, data + block_size, block_size) != 0) {
+            continue;
+        }
+        if (mergeCopy(partition, kept, list->refs + first, end - first) == -1) {
+            return -1;
+        }
+        (*saved)++;
+        statsAdd(&partition->stats, STATS_DEDUP_BLOCKS, 1);
     }
+    return 0;
+}
 
-    int num_files = 0;
+/**
+ * @brief Fonction pour dédupliquer les blocs de données de tous les fichiers.
+ * @param partition La partition.
+ * @param threads Le nombre de threads du calcul des empreintes, 0 pour un par processeur.
+ * @return Le nombre de blocs libérés, -1 en cas d'erreur.
+ */
+int64_t myDedup(Partition* partition, int threads) {
+    if (partition == NULL) {
+        return -1;
+    }
+    // Les écritures en cours atteignent leurs blocs, qui sont ensuite relus sur la partition
+    asyncReap(&partition->async, INT_MAX);
+    journalStartExclusive(&partition->journal);
+    pthread_mutex_lock(&partition->namespace_lock);
 
-    // Parcourir tous les inodes pour trouver les noms de fichiers
-    for (int i = 0; i < super_file_data.num_inodes; ++i) {
-        if (super_file_data.inodes[i].name != NULL) {
-            // Allouer de la mémoire pour le nom de fichier
-            files[num_files] = strdup(super_file_data.inodes[i].name);
-            if (files[num_files] == NULL) {
-                perror("Erreur lors de l'allocation de mémoire pour le nom de fichier.");
-                // Libérer la mémoire allouée pour les noms de fichiers précédents
-                for (int j = 0; j < num_files; ++j) {
-                    free(files[j]);
+    DedupRefList list;
+    memset(&list, 0, sizeof(list));
+    DedupEntry* blocks = NULL;
+    size_t num_blocks = 0;
+    int64_t saved = 0;
+    int status = -1;
+    char* data = malloc(2 * (size_t)partition->block_size);
+    if (data == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour la déduplication");
+    } else if (cacheFlush(&partition->cache) == -1) {
+        perror("Erreur lors de l'écriture des blocs modifiés");
+    } else if (gatherDedupRefs(partition, ROOT_INODE, &list) == -1) {
+        printf("Erreur : L'arborescence est illisible.\n");
+    } else if (list.count == 0) {
+        status = 0; // Aucun bloc entier à fusionner
+    } else {
+        // Un bloc partagé n'est empreinté qu'une fois, quel que soit son nombre de références
+        qsort(list.refs, list.count, sizeof(DedupRef), compareDedupRefs);
+        blocks = malloc(list.count * sizeof(DedupEntry));
+        if (blocks == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour la déduplication");
+        } else {
+            for (size_t r = 0; r < list.count; ++r) {
+                if (num_blocks == 0 || blocks[num_blocks - 1].block != list.refs[r].physical) {
+                    blocks[num_blocks].fingerprint = 0;
+                    blocks[num_blocks++].block = list.refs[r].physical;
                 }
-                free(files);
-                return NULL;
             }
-            num_files++;
+            status = dedupHashBlocks(partition, blocks, num_blocks, threads);
         }
     }
 
-    // Terminer la liste des noms de fichiers avec NULL
-    files[num_files] = NULL;
-
-    return files;
+    // dedupHashBlocks donne le nombre de threads utilisés
+    if (status > 0) {
+        status = 0;
+        qsort(blocks, num_blocks, sizeof(DedupEntry), compareFingerprints);
+        size_t first = 0;
+        while (first < num_blocks && status == 0) {
+            size_t end = first + 1;
+            while (end < num_blocks && blocks[end].fingerprint == blocks[first].fingerprint) {
+                end++;
+            }
+            // L'empreinte 0 marque les blocs illisibles
+            if (end - first > 1 && blocks[first].fingerprint != 0) {
+                status = mergeGroup(partition, blocks + first, end - first, &list, data, &saved);
+            }
+            first = end;
+        }
+    }
+    pthread_mutex_unlock(&partition->namespace_lock);
+    journalStopExclusive(&partition->journal);
+    free(blocks);
+    free(list.refs);
+    free(data);
+    return status == 0 ? saved : -1;
 }
 
 /**
- * @brief Compte le nombre de fichiers dans un tableau de chaînes de caractères.
- * @param files Le tableau de chaînes de caractères contenant les noms de fichiers.
- * @return Le nombre de fichiers dans le tableau.
- * @author Boyan
+ * @brief Indique l'état d'un bloc dans la table d'allocation (alloc_lock doit être pris).
+ * @param partition La partition.
+ * @param block Le bloc.
+ * @return BLOCK_FREE ou BLOCK_OCCUPIED.
  */
-int numFiles(char** files) {
-    int count = 0; /**< Compteur du nombre de fichiers */
-    
-    // Parcours du tableau de chaînes de caractères jusqu'à ce que NULL soit rencontré
-    while (files[count] != NULL) {
-        count++; /**< Incrémente le compteur */
-    }
-    
-    return count; /**< Retourne le nombre total de fichiers */
+static int blockState(Partition* partition, uint64_t block) {
+    return (partition->bitmap[block / 64] >> (block % 64)) & 1 ? BLOCK_OCCUPIED : BLOCK_FREE;
 }
 
 /**
- * @brief Fonction pour supprimer un fichier de la partition.
- * @param fileName Le nom du fichier à supprimer.
- * @return 0 si le fichier est supprimé avec succès, -1 en cas d'erreur.
- * @author Boyan
+ * @brief Fonction pour remettre dans l'état voulu des blocs que la table d'allocation marque à tort.
+ * @param partition La partition.
+ * @param start Le premier bloc de la suite.
+ * @param length Le nombre de blocs.
+ * @param state BLOCK_FREE pour des blocs qu'aucun inode ne référence, BLOCK_OCCUPIED pour des blocs référencés.
+ * @return Le nombre de blocs dont l'état a changé.
  */
-int deleteFileFromPartition(char* fileName) {
-    // Recherche de l'inode associé au nom de fichier donné
-    for (int i = 0; i < super_file_data.num_inodes; ++i) {
-        if (super_file_data.inodes[i].name != NULL && strcmp(super_file_data.inodes[i].name, fileName) == 0) {
-            // Libérer la mémoire des données réelles stockées dans les blocs de données
-            DataBlock* current_block = super_file_data.inodes[i].firstDataBlock;
-	    while (current_block != NULL) {
-		DataBlock* temp = malloc(sizeof(DataBlock)); // Allouer de la mémoire pour une nouvelle structure DataBlock
-		if (temp == NULL) {
-		    // Gérer l'erreur d'allocation de mémoire
-	       	    return -1;
-	        }
-	        memcpy(temp, current_block, sizeof(DataBlock)); // Copier les données de current_block dans temp
-		current_block = current_block->next;
-	        for(int j = 0; j < BLOCK_SIZE; j++) {
-		    temp->data[j] = '\0';
-	        }
-	        free(temp);       // Libérer le bloc de données lui-même
-	    }
-
-            // Marquer les blocs de données comme libres après les avoir libérés
-            super_file_data.inodes[i].firstDataBlock = NULL;
-
-            // Libérer la mémoire du nom de fichier dans l'inode
-            if (super_file_data.inodes[i].name != NULL) {
-                free(super_file_data.inodes[i].name);
-                super_file_data.inodes[i].name = NULL;
+uint64_t repairBlocks(Partition* partition, uint64_t start, uint64_t length, int state) {
+    uint64_t changed = 0;
+    uint64_t block = start, end = start + length;
+    while (block < end) {
+        uint64_t stop = end - block > REPAIR_RUN_BLOCKS ? block + REPAIR_RUN_BLOCKS : end;
+        journalStart(&partition->journal);
+        while (block < stop) {
+            // Suite suivante de blocs qui ne sont pas dans l'état voulu
+            pthread_mutex_lock(&partition->alloc_lock);
+            while (block < stop && blockState(partition, block) == state) {
+                block++;
             }
-
-            // Libérer la mémoire du pointeur de fichier
-            if (super_file_data.inodes[i].file_pointer != NULL) {
-                free(super_file_data.inodes[i].file_pointer);
-                super_file_data.inodes[i].file_pointer = NULL;
+            uint64_t first = block;
+            while (block < stop && blockState(partition, block) != state) {
+                block++;
             }
-
-            printf("Le fichier '%s' a été supprimé avec succès.\n", fileName);
-            return 0; // Succès
+            if (block > first && state == BLOCK_OCCUPIED) {
+                setRunState(partition, first, (uint32_t)(block - first), BLOCK_OCCUPIED);
+            }
+            pthread_mutex_unlock(&partition->alloc_lock);
+            // Aucun inode ne référence ces blocs : ils ne peuvent pas changer d'état entre-temps
+            if (block > first && state == BLOCK_FREE) {
+                freeRun(partition, first, (uint32_t)(block - first));
+            }
+            changed += block - first;
         }
+        journalStop(&partition->journal);
     }
+    return changed;
+}
 
-    printf("Erreur : Le fichier '%s' n'a pas été trouvé dans la partition.\n", fileName);
-    return -1; // Fichier non trouvé
+/**
+ * @brief Fonction pour corriger le compteur de partage d'un bloc.
+ * @param partition La partition.
+ * @param block Le bloc.
+ * @param found Le compteur lu par la vérification.
+ * @param shares Le nombre de références du bloc en plus de la première.
+ * @return 1 si le compteur a été corrigé, 0 s'il a changé depuis la vérification.
+ */
+int repairShares(Partition* partition, uint64_t block, uint16_t found, uint16_t shares) {
+    SuperBlock* sb = partition->superBlock;
+    journalStart(&partition->journal);
+    pthread_mutex_lock(&partition->alloc_lock);
+    int repaired = partition->shares[block] == found;
+    if (repaired) {
+        __atomic_store_n(&partition->shares[block], shares, __ATOMIC_RELAXED);
+        journalDirty(&partition->journal, &partition->shares[block], sizeof(uint16_t));
+        if ((found == 0) != (shares == 0)) {
+            __atomic_store_n(&sb->shared_blocks, shares == 0 ? sb->shared_blocks - 1 : sb->shared_blocks + 1, __ATOMIC_RELAXED);
+            journalDirty(&partition->journal, &sb->shared_blocks, sizeof(sb->shared_blocks));
+        }
+        dedupForget(&partition->dedup, block, 1);
+    }
+    pthread_mutex_unlock(&partition->alloc_lock);
+    journalStop(&partition->journal);
+    return repaired;
 }
 
 /**
- * @brief Fonction pour supprimer un fichier.
- * @author Boyan
+ * @brief Fonction pour ramener la taille d'un fichier à la place dont il dispose.
+ * @param partition La partition.
+ * @param inode_number Le numéro de l'inode du fichier.
+ * @return 1 si la taille a été corrigée, 0 si elle était valide, -1 en cas d'erreur d'allocation mémoire.
  */
-void deleteFile() {
-    // Affichage de la liste des fichiers
-    printf("Liste des fichiers :\n");
-    char** files = listFiles();
-    if (files == NULL) {
-        printf("Erreur lors de la récupération des noms de fichiers.\n");
-        return;
+int repairFileSize(Partition* partition, uint32_t inode_number) {
+    journalStart(&partition->journal);
+    InodeChunk* chunk = createInodeChunk(partition, inode_number);
+    if (chunk == NULL) {
+        journalStop(&partition->journal);
+        return -1;
     }
-    for (int i = 0; files[i] != NULL; ++i) {
-        printf("%d. %s\n", i + 1, files[i]);
+    pthread_rwlock_t* inode_lock = &chunk->locks[inode_number % INODES_PER_CHUNK];
+    pthread_rwlock_wrlock(inode_lock);
+    inode* inode_of_file = inodeAt(partition, inode_number);
+    int64_t limit = (inode_of_file->flags & INODE_INLINE) ? (int64_t)INLINE_DATA_MAX
+                                                           : (int64_t)inode_of_file->block_count << partition->block_shift;
+    int repaired = 0;
+    if (inode_of_file->name[0] != '\0' && inode_of_file->type == INODE_FILE
+        && (inode_of_file->fileSize < 0 || inode_of_file->fileSize > limit)) {
+        inode_of_file->fileSize = inode_of_file->fileSize < 0 ? 0 : limit;
+        journalDirty(&partition->journal, &inode_of_file->fileSize, sizeof(int64_t));
+        // Le fichier ouvert garde une copie de la taille, mise à jour sous le verrou de l'inode
+        file* opened = __atomic_load_n(&chunk->open_files[inode_number % INODES_PER_CHUNK], __ATOMIC_ACQUIRE);
+        if (opened != NULL) {
+            opened->fileSize = inode_of_file->fileSize;
+        }
+        repaired = 1;
     }
+    pthread_rwlock_unlock(inode_lock);
+    journalStop(&partition->journal);
+    return repaired;
+}
 
-    // Demande à l'utilisateur de choisir le numéro du fichier à supprimer
-    int choix;
-    printf("Entrez le numéro du fichier à supprimer : ");
-    scanf("%d", &choix);
-
-    // Vérification de la validité du choix
-    if (choix < 1 || choix > numFiles(files)) {
-        printf("Numéro de fichier invalide.\n");
-        return;
+/**
+ * @brief Fonction pour recalculer le résumé de la table d'allocation, le nombre de blocs libres et celui des blocs partagés.
+ * @param partition La partition.
+ * @return Le nombre de valeurs corrigées.
+ */
+uint64_t repairAllocationCounters(Partition* partition) {
+    SuperBlock* sb = partition->superBlock;
+    uint64_t words = bitmapWords(sb->num_blocks);
+    uint64_t tail = sb->num_blocks % 64 != 0 ? ~0ULL << (sb->num_blocks % 64) : 0;
+    uint64_t corrected = 0;
+    for (uint64_t first = 0; first < words; first += REPAIR_RUN_BLOCKS / 64) {
+        uint64_t end = words - first > REPAIR_RUN_BLOCKS / 64 ? first + REPAIR_RUN_BLOCKS / 64 : words;
+        journalStart(&partition->journal);
+        pthread_mutex_lock(&partition->alloc_lock);
+        for (uint64_t word = first; word < end; ++word) {
+            if (word == words - 1 && (partition->bitmap[word] & tail) != tail) {
+                partition->bitmap[word] |= tail;
+                journalDirty(&partition->journal, &partition->bitmap[word], sizeof(uint64_t));
+                corrected++;
+            }
+            uint64_t summary = partition->full_summary[word / 64];
+            updateFullSummary(partition, word);
+            if (partition->full_summary[word / 64] != summary) {
+                corrected++;
+            }
+        }
+        pthread_mutex_unlock(&partition->alloc_lock);
+        journalStop(&partition->journal);
     }
 
-    // Suppression du fichier correspondant au choix de l'utilisateur
-    char* fileName = files[choix - 1];
-    deleteFileFromPartition(fileName);
-
-    // Libération de la mémoire allouée pour la liste des fichiers
-    for (int i = 0; files[i] != NULL; ++i) {
-        free(files[i]);
+    // Les blocs libres et partagés sont comptés d'un seul tenant, sans allocation concurrente
+    journalStart(&partition->journal);
+    pthread_mutex_lock(&partition->alloc_lock);
+    uint64_t occupied = 0;
+    for (uint64_t word = 0; word < words; ++word) {
+        occupied += __builtin_popcountll(partition->bitmap[word]);
+    }
+    occupied -= __builtin_popcountll(tail);
+    if (sb->free_blocks != sb->num_blocks - occupied) {
+        sb->free_blocks = sb->num_blocks - occupied;
+        journalDirty(&partition->journal, &sb->free_blocks, sizeof(sb->free_blocks));
+        corrected++;
+    }
+    uint64_t shared = 0;
+    for (uint64_t block = 0; block < sb->num_blocks; ++block) {
+        shared += partition->shares[block] != 0;
     }
-    free(files);
+    if (sb->shared_blocks != shared) {
+        __atomic_store_n(&sb->shared_blocks, shared, __ATOMIC_RELAXED);
+        journalDirty(&partition->journal, &sb->shared_blocks, sizeof(sb->shared_blocks));
+        corrected++;
+    }
+    pthread_mutex_unlock(&partition->alloc_lock);
+    journalStop(&partition->journal);
+    return corrected;
 }
 
 /**
  * @brief Fonction pour supprimer entièrement la partition.
+ * @param partition La partition.
  * @param partitionName Le nom de la partition à supprimer.
  * @return 0 si la partition est supprimée avec succès, -1 en cas d'erreur.
  * @author Lauriane
  */
-void deletePartition(char* partitionName) {
-    // Fermer le descripteur de fichier de la partition
-    if (close(super_file_data.fileDescriptor) == -1) {
-        perror("Erreur lors de la fermeture du descripteur de fichier de la partition");
+void deletePartition(Partition* partition, char* partitionName) {
+    // Libérer les fichiers ouverts, fermer la partition et libérer sa structure
+    if (releasePartition(partition) == -1) {
         return;
     }
 
-    // Libérer les ressources allouées pour chaque fichier
-    for (int i = 0; i < super_file_data.num_inodes; ++i) {
-        if (super_file_data.inodes[i].name != NULL) {
-            // Libérer la mémoire du nom de fichier dans l'inode
-            free(super_file_data.inodes[i].name);
-            // Libérer la mémoire du pointeur de fichier
-            if (super_file_data.inodes[i].file_pointer != NULL) {
-                free(super_file_data.inodes[i].file_pointer);
-            }
-        }
-    }
-
-    // Libérer les ressources allouées pour chaque bloc de données
-    for (int i = 0; i < MAX_NUM_BLOCKS; ++i) {
-        // Libérer les données réelles stockées dans les blocs de données
-        DataBlock* current_block = super_file_data.blocks[i].next;
-        while (current_block != NULL) {
-            DataBlock* temp = current_block;
-            current_block = current_block->next;
-            free(temp);
-        }
-    }
-
-    // Réinitialiser les informations de la partition
-    super_file_data.num_inodes = 0;
-    super_file_data.taille_partition = 0;
-    super_file_data.fileDescriptor = -1;
-
     // Supprimer le fichier de partition
     if (remove(partitionName) == -1) {
         perror("Erreur lors de la suppression du fichier de partition");
@@ -477,132 +5806,3 @@ void deletePartition(char* partitionName) {
 
     printf("Partition '%s' supprimée avec succès.\n", partitionName);
 }
-
-/**
- * @brief Fonction principale du programme.
- * @return 0 si le programme s'exécute avec succès, 1 en cas d'erreur.
- * @author Boyan & Lauriane
- */
-int main() {
-
-    char* nom_partition = "ma_partition";
-    if (myFormat(nom_partition) == -1) {
-        printf("Erreur lors du formatage de la partition.\n");
-        return 1;
-    }
-    char choix;
-
-    // Affichage du menu tant que l'utilisateur ne choisit pas de quitter
-    do {
-	printf("\nMenu :\n");
-        printf("1. Ouvrir un fichier \n");
-        printf("2. Ecrire dans un fichier \n");
-        printf("3. Lire depuis un fichier \n");
-        printf("4. Supprime le fichier choisi\n");
-        printf("5. Afficher les fichiers existants \n");
-        printf("6. Afficher l'aide\n");
-        printf("7. Quitter\n");
-        printf("Entrez votre choix : ");
-
-        // Lecture du choix de l'utilisateur
-        scanf(" %[^\n]", &choix);
-
-        // Traitement du choix de l'utilisateur
-        switch (choix) {
-	    case '1':
-                // Appel à la fonction myOpen avec le nom du fichier
-                char nom_fichier[100];
-                printf("Entrez le nom du fichier à ouvrir : ");
-                scanf("%s", nom_fichier);
-                file* monFichier = myOpen(nom_fichier);
-                if (monFichier == NULL) {
-                    printf("Erreur lors de l'ouverture du fichier.\n");
-                } else {
-                    printf("Fichier '%s' ouvert avec succès.\n", nom_fichier);
-                }
-                break;
-                
-            case '2':
-                // Appel à la fonction myWrite avec le nom du fichier et les données
-                char nom_fichier_ecriture[100];
-                char donnees_ecriture[1000];
-                
-                printf("Entrez le nom du fichier : ");
-		scanf(" %[^\n]", nom_fichier_ecriture); // Lire jusqu'au saut de ligne
-		
-		printf("Entrez les données à écrire : ");
-		scanf(" %[^\n]", donnees_ecriture); // Lire jusqu'au saut de ligne
-
-                file* fichier_ecriture = myOpen(nom_fichier_ecriture);
-                if (fichier_ecriture == NULL) {
-                    printf("Erreur lors de l'ouverture du fichier.\n");
-                    return ERROR_FILE_OPEN;
-                } else {
-                    int bytes_ecrits = myWrite(fichier_ecriture, donnees_ecriture, strlen(donnees_ecriture));
-                    if (bytes_ecrits == -1) {
-                        printf("Erreur lors de l'écriture dans le fichier.\n");
-                    } else {
-                        printf("Nombre total d'octets écrits : %d\n", bytes_ecrits);
-                    }
-                }
-                break;
-                
-            case '3':
-                    // Appel à la fonction myRead avec le nom du fichier
-    		char nom_fichier_lecture[100];
-    		char donnees_lecture[1000];
-    		printf("Entrez le nom du fichier : ");
-    		scanf(" %[^\n]", nom_fichier_lecture);
-    		file* fichier_lecture = myOpen(nom_fichier_lecture);
-   		if (fichier_lecture == NULL) {
-        		printf("Erreur lors de l'ouverture du fichier.\n");
-   		} else {
-      			int bytes_lues = myRead(fichier_lecture, donnees_lecture, sizeof(donnees_lecture));
-        		if (bytes_lues == -1) {
-            			printf("Erreur lors de la lecture dans le fichier.\n");
-        		} else {
-            			// Afficher les données lues
-            			printf("Données lues depuis le fichier :\n%s\n", donnees_lecture);
-            			printf("Nombre total d'octets lus : %d\n", bytes_lues);
-        		}
-    		}
-    		break;
-
-            case '4':
-            	//Appel à la fonction de suppression de fichier deleteFiles
-            	deleteFile();	
-		break;
-
-            case '5':
-                // Appel à la fonction listeFiles
-    	        char** files = listFiles();
-	        if (files == NULL) {
-		    printf("Erreur lors de la récupération des noms de fichiers.\n");
-		}
-		    printf("Liste des fichiers :\n");
-		for (int i = 0; files[i] != NULL; ++i) {
-        		printf("%s\n", files[i]);
-		}
-            	break;
-            	
-            case '6':
-                // Affichage de l'aide
-                printHelp();
-                break;
-
-            case '7':
-                // Sortie du programme  
-                printf("Au revoir !\n");
-                break;
-
-            default:
-                printf("Choix invalide. Veuillez réessayer.\n");
-                break;
-        }
-    } while (choix != '7');
-    
-    deletePartition("ma_partition");
-    
-    return 0;
-}
-
@@ -7,12 +7,28 @@
 #define PROJET_H_
 
 #include <stdio.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "cache.h"
+#include "async.h"
+#include "journal.h"
+#include "stats.h"
+#include "dcache.h"
+#include "crc32c.h"
+#include "compress.h"
+#include "dedup.h"
 
 /**
  * @def ERROR_FILE_OPEN
@@ -21,136 +37,894 @@
 #define ERROR_FILE_OPEN -4
 
 /**
- * @def BLOCK_SIZE
- * @brief Taille d'un bloc de données en octets.
+ * @def ERROR_CHECKSUM
+ * @brief Code d'erreur d'une lecture dont un bloc ne correspond pas à son code de contrôle.
+ */
+#define ERROR_CHECKSUM -5
+
+/**
+ * @def DEFAULT_BLOCK_SIZE
+ * @brief Taille d'un bloc en octets d'une partition formatée sans taille de bloc.
+ */
+#define DEFAULT_BLOCK_SIZE 512
+
+/**
+ * @def MIN_BLOCK_SIZE
+ * @brief Plus petite taille de bloc acceptée au formatage.
+ */
+#define MIN_BLOCK_SIZE 512
+
+/**
+ * @def MAX_BLOCK_SIZE
+ * @brief Plus grande taille de bloc acceptée au formatage.
+ */
+#define MAX_BLOCK_SIZE (1024 * 1024)
+
+/**
+ * @def TREE_NODE_SIZE
+ * @brief Taille d'un nœud d'arbre d'extents ou de répertoire, rangé au début de son bloc quelle que soit la taille de bloc.
+ */
+#define TREE_NODE_SIZE JOURNAL_IMAGE_SIZE
+
+/**
+ * @def DEFAULT_NUM_BLOCKS
+ * @brief Nombre de blocs de données d'une partition formatée par myFormat.
+ */
+#define DEFAULT_NUM_BLOCKS 100
+
+/**
+ * @def DEFAULT_NUM_INODES
+ * @brief Nombre d'inodes d'une partition formatée par myFormat.
+ */
+#define DEFAULT_NUM_INODES 16
+
+/**
+ * @def BLOCKS_PER_INODE
+ * @brief Nombre de blocs de données par inode lorsque myFormatWith ne reçoit pas de nombre d'inodes.
  */
-#define BLOCK_SIZE 512
+#define BLOCKS_PER_INODE 4
 
 /**
- * @def MAX_NUM_BLOCKS
- * @brief Nombre maximal de blocs de données dans le système de fichiers.
+ * @def MAX_INODES
+ * @brief Nombre maximal d'inodes d'une partition.
  */
-#define MAX_NUM_BLOCKS 100
+#define MAX_INODES (1u << 30)
 
 /**
- * @def NUM_INODES
- * @brief Nombre d'inodes dans le système de fichiers.
+ * @def MAX_PARTITION_BLOCKS
+ * @brief Nombre maximal de blocs de données d'une partition.
  */
-#define NUM_INODES 16
+#define MAX_PARTITION_BLOCKS (1ULL << 48)
+
+/**
+ * @def NO_INODE
+ * @brief Numéro d'inode réservé, qui ne désigne jamais un fichier : les inodes sont numérotés à partir de 1.
+ */
+#define NO_INODE 0
 
 /**
  * @def BLOCK_FREE
- * @brief Constante représentant un bloc de données libre.
+ * @brief Valeur du bit de la table d'allocation pour un bloc de données libre.
  */
 #define BLOCK_FREE 0
 
 /**
  * @def BLOCK_OCCUPIED
- * @brief Constante représentant un bloc de données occupé.
+ * @brief Valeur du bit de la table d'allocation pour un bloc de données occupé.
  */
 #define BLOCK_OCCUPIED 1
 
 /**
- * @struct DataBlock
- * @brief Structure représentant un bloc de données.
+ * @def NO_BLOCK
+ * @brief Indice utilisé pour indiquer l'absence de bloc de données.
+ */
+#define NO_BLOCK -1
+
+/**
+ * @def MAX_FILE_NAME
+ * @brief Taille maximale d'un nom de fichier ou de répertoire (une composante d'un chemin) stocké dans un inode, '\0' compris.
+ */
+#define MAX_FILE_NAME 52
+
+/**
+ * @def ROOT_INODE
+ * @brief Numéro de l'inode du répertoire racine, premier inode attribué sur une partition.
+ */
+#define ROOT_INODE 1
+
+/**
+ * @def INODE_FILE
+ * @brief Type d'un inode de fichier.
+ */
+#define INODE_FILE 1
+
+/**
+ * @def INODE_DIRECTORY
+ * @brief Type d'un inode de répertoire.
+ */
+#define INODE_DIRECTORY 2
+
+/**
+ * @def INODE_INLINE
+ * @brief Drapeau d'un fichier dont les octets sont rangés dans l'inode, à la place de ses extents.
+ */
+#define INODE_INLINE 1
+
+/**
+ * @def INODE_READONLY
+ * @brief Drapeau d'un fichier ou d'un répertoire d'un instantané : il ne peut plus être écrit ni recevoir d'entrée, seulement être supprimé.
+ */
+#define INODE_READONLY 2
+
+/**
+ * @def INODE_CODEC_SHIFT
+ * @brief Les bits des drapeaux d'un inode à partir de ce rang donnent le codec de ses données, CODEC_NONE s'il n'est pas compressé.
+ */
+#define INODE_CODEC_SHIFT 8
+
+/**
+ * @def PATH_SEPARATOR
+ * @brief Séparateur des noms d'un chemin.
+ */
+#define PATH_SEPARATOR '/'
+
+/**
+ * @def READAHEAD_MIN_BLOCKS
+ * @brief Taille initiale de la fenêtre de lecture anticipée d'un fichier lu séquentiellement, en blocs.
+ */
+#define READAHEAD_MIN_BLOCKS 4
+
+/**
+ * @def READAHEAD_MAX_BLOCKS
+ * @brief Taille maximale de la fenêtre de lecture anticipée, en blocs.
+ */
+#define READAHEAD_MAX_BLOCKS 32
+
+/**
+ * @def CHECKSUM_PAGE_SIZE
+ * @brief Taille en octets des pages de la table des codes de contrôle, unité de leur écriture.
+ */
+#define CHECKSUM_PAGE_SIZE 4096
+
+/**
+ * @def CHECKSUM_DIRTY_MAX
+ * @brief Nombre de pages modifiées de la table des codes de contrôle au-delà duquel elles sont écrites sans attendre mySync.
+ */
+#define CHECKSUM_DIRTY_MAX 256
+
+/**
+ * @def REPAIR_RUN_BLOCKS
+ * @brief Nombre maximal de blocs dont repairBlocks change l'état dans une même opération du journal.
+ */
+#define REPAIR_RUN_BLOCKS 16384
+
+/**
+ * @def COW_GROUP_BLOCKS
+ * @brief Taille en blocs des groupes alignés dans lesquels les blocs partagés d'un fichier sont copiés avant d'être écrits.
+ */
+#define COW_GROUP_BLOCKS 16
+
+/**
+ * @def COMPRESS_CLUSTER_SIZE
+ * @brief Taille en octets des groupes de blocs compressés d'un seul tenant ; la compression demande des blocs d'au plus la moitié.
  */
-typedef struct DataBlock {
-    char data[BLOCK_SIZE]; /**< Données stockées dans le bloc. */
-    int occ_block; /**< État du bloc (libre ou occupé). */
-    struct DataBlock* next; /**< Pointeur vers le bloc de données suivant. */
-} DataBlock;
+#define COMPRESS_CLUSTER_SIZE (32 * 1024)
+
+/**
+ * @def MAX_SHARES
+ * @brief Nombre maximal de références supplémentaires d'un bloc de données partagé.
+ */
+#define MAX_SHARES UINT16_MAX
+
+/**
+ * @def PARTITION_MAGIC
+ * @brief Nombre magique identifiant une partition formatée ("GFSP").
+ */
+#define PARTITION_MAGIC 0x50534647
+
+/**
+ * @def PARTITION_VERSION
+ * @brief Version du format sur disque. Une partition d'une autre version est refusée au montage.
+ */
+#define PARTITION_VERSION 11
+
+/**
+ * @struct FormatOptions
+ * @brief Géométrie demandée à myFormatWith ; un champ nul prend sa valeur par défaut.
+ */
+typedef struct {
+    uint64_t size; /**< Taille totale de la partition en octets, utilisée lorsque num_blocks est nul. */
+    uint64_t num_blocks; /**< Nombre de blocs de données, DEFAULT_NUM_BLOCKS si size est aussi nul. */
+    uint32_t num_inodes; /**< Nombre maximal de fichiers, un inode pour BLOCKS_PER_INODE blocs de données par défaut. */
+    uint32_t block_size; /**< Taille d'un bloc en octets, puissance de 2 entre MIN_BLOCK_SIZE et MAX_BLOCK_SIZE, DEFAULT_BLOCK_SIZE par défaut. */
+    uint32_t compression; /**< Codec des fichiers créés sur la partition, CODEC_NONE par défaut. */
+} FormatOptions;
+
+/**
+ * @struct SuperBlock
+ * @brief Superbloc stocké dans le bloc 0 de la partition.
+ *
+ * Décrit la géométrie de la partition, choisie au formatage. Les zones de
+ * taille fixe sont placées à des positions exprimées en numéros de blocs de
+ * block_size octets : superbloc, carte de la table des inodes, table
+ * d'allocation (bitmap) et son résumé, table des codes de contrôle, table
+ * des partages, journal des métadonnées puis zone de données. La table des
+ * inodes elle-même est rangée dans des groupes de blocs de données alloués à
+ * mesure que des fichiers sont créés, et les entrées des répertoires dans
+ * des arbres de blocs de données.
+ * Les derniers champs changent avec le contenu de la partition et sont
+ * journalisés comme les autres métadonnées.
+ */
+typedef struct {
+    uint32_t magic; /**< Nombre magique (PARTITION_MAGIC). */
+    uint32_t version; /**< Version du format sur disque (PARTITION_VERSION). */
+    uint32_t block_size; /**< Taille d'un bloc en octets, puissance de 2 entre MIN_BLOCK_SIZE et MAX_BLOCK_SIZE. */
+    uint32_t num_inodes; /**< Nombre maximal d'inodes, numérotés de 1 à num_inodes. */
+    uint64_t num_blocks; /**< Nombre de blocs de la zone de données. */
+    uint64_t inode_map_start; /**< Premier bloc de la carte de la table des inodes : premier bloc de données de chaque groupe d'inodes. */
+    uint64_t bitmap_start; /**< Premier bloc de la table d'allocation des blocs. */
+    uint64_t summary_start; /**< Premier bloc du résumé de la table d'allocation. */
+    uint64_t checksum_start; /**< Premier bloc de la table des codes de contrôle des blocs de données. */
+    uint64_t shares_start; /**< Premier bloc de la table des partages des blocs de données. */
+    uint64_t journal_start; /**< Premier bloc du journal des métadonnées (son en-tête). */
+    uint64_t data_start; /**< Premier bloc de la zone de données. */
+    uint64_t total_blocks; /**< Nombre total de blocs de la partition. */
+    uint32_t journal_blocks; /**< Nombre de blocs du journal, en-tête compris. */
+    uint32_t next_inode; /**< Plus petit numéro d'inode jamais attribué : la table des inodes s'arrête au groupe qui le précède. */
+    uint32_t free_inode; /**< Premier inode de la liste des inodes libérés, NO_INODE si elle est vide. */
+    uint32_t compression; /**< Codec des fichiers créés sur la partition, CODEC_NONE pour ne pas les compresser. */
+    uint64_t free_blocks; /**< Nombre de blocs de données libres. */
+    uint64_t shared_blocks; /**< Nombre de blocs de données partagés (compteur non nul dans la table des partages). */
+} SuperBlock;
+
+struct Partition;
 
 /**
  * @struct file
  * @brief Structure représentant un fichier.
+ *
+ * Un seul fichier ouvert existe par inode : tous les myOpen d'un même chemin
+ * renvoient la même structure, dont la position est protégée par lock.
  */
 typedef struct {
-    char* name; /**< Nom du fichier. */
-    int fileSize; /**< Taille du fichier en octets. */
-    int currentPosition; /**< Position actuelle dans le fichier. */
+    struct Partition* partition; /**< Partition contenant le fichier. */
+    pthread_mutex_t lock; /**< Protège la position et l'état de la lecture anticipée. */
+    char* name; /**< Chemin du fichier, tel que passé à myOpen. */
+    int64_t fileSize; /**< Taille du fichier en octets. */
+    int64_t currentPosition; /**< Position actuelle dans le fichier. */
+    uint32_t inodeNumber; /**< Numéro de l'inode du fichier. */
+    uint32_t readaheadNext; /**< Bloc logique attendu par la prochaine lecture séquentielle. */
+    uint32_t readaheadWindow; /**< Taille actuelle de la fenêtre de lecture anticipée, en blocs. */
+    uint32_t readaheadEnd; /**< Premier bloc logique non encore chargé par la lecture anticipée. */
 } file;
 
+/**
+ * @struct Extent
+ * @brief Suite de blocs logiques consécutifs d'un fichier stockée dans des blocs physiques consécutifs.
+ */
+typedef struct {
+    uint32_t logical; /**< Premier bloc logique (rang dans le fichier) couvert par l'extent. */
+    uint32_t length; /**< Nombre de blocs de l'extent. */
+    uint64_t physical; /**< Premier bloc physique (indice dans la zone de données). */
+} Extent;
+
+/**
+ * @struct ClusterHeader
+ * @brief En-tête d'un groupe de blocs compressé, au début de son premier bloc.
+ *
+ * Un fichier compressé range ses blocs logiques par groupes de
+ * COMPRESS_CLUSTER_SIZE octets, chacun décrit par un seul extent dont le
+ * premier bloc logique est celui du groupe et la longueur le nombre de
+ * blocs physiques qui le stockent. Un groupe stocké dans moins de blocs
+ * qu'il n'en couvre commence par cet en-tête ; les autres sont stockés
+ * tels quels.
+ */
+typedef struct {
+    uint32_t size; /**< Nombre d'octets compressés qui suivent l'en-tête. */
+    uint16_t codec; /**< Codec qui les a compressés. */
+    uint16_t reserved; /**< Réservé. */
+} ClusterHeader;
+
+/**
+ * @struct ExtentIndex
+ * @brief Entrée d'un nœud interne de l'arbre d'extents.
+ */
+typedef struct {
+    uint32_t logical; /**< Premier bloc logique couvert par le sous-arbre. */
+    uint32_t reserved; /**< Réservé. */
+    uint64_t child; /**< Bloc de données contenant le nœud fils. */
+} ExtentIndex;
+
+/**
+ * @def EXTENT_LEAF_MAX
+ * @brief Nombre d'extents contenus dans une feuille de l'arbre d'extents.
+ */
+#define EXTENT_LEAF_MAX ((TREE_NODE_SIZE - sizeof(uint64_t)) / sizeof(Extent))
+
+/**
+ * @def EXTENT_INDEX_MAX
+ * @brief Nombre d'entrées contenues dans un nœud interne de l'arbre d'extents.
+ */
+#define EXTENT_INDEX_MAX ((TREE_NODE_SIZE - sizeof(uint64_t)) / sizeof(ExtentIndex))
+
+/**
+ * @def EXTENT_TREE_MAX_DEPTH
+ * @brief Profondeur maximale de l'arbre d'extents.
+ */
+#define EXTENT_TREE_MAX_DEPTH 8
+
+/**
+ * @struct ExtentNode
+ * @brief Nœud de l'arbre d'extents, stocké dans un bloc de données.
+ *
+ * Les feuilles (profondeur 0) contiennent des extents, les nœuds internes
+ * des références vers leurs fils. Les entrées sont triées par bloc logique.
+ */
+typedef struct {
+    uint16_t depth; /**< Profondeur du nœud, 0 pour une feuille. */
+    uint16_t count; /**< Nombre d'entrées utilisées. */
+    uint32_t checksum; /**< CRC32C des TREE_NODE_SIZE octets du nœud, calculé avec ce champ nul. */
+    union {
+        Extent extents[EXTENT_LEAF_MAX]; /**< Entrées d'une feuille. */
+        ExtentIndex index[EXTENT_INDEX_MAX]; /**< Entrées d'un nœud interne. */
+    };
+} ExtentNode;
+
+/**
+ * @struct DirEntry
+ * @brief Entrée d'une feuille de l'arbre d'un répertoire : le nom est celui de l'inode désigné.
+ */
+typedef struct {
+    uint32_t hash; /**< Empreinte du nom de l'entrée. */
+    uint32_t inode; /**< Numéro de l'inode désigné par l'entrée. */
+} DirEntry;
+
+/**
+ * @struct DirIndex
+ * @brief Entrée d'un nœud interne de l'arbre d'un répertoire.
+ */
+typedef struct {
+    uint32_t hash; /**< Empreinte au plus égale à celles du sous-arbre, et au moins égale à celles des sous-arbres précédents. */
+    uint32_t reserved; /**< Réservé. */
+    uint64_t child; /**< Bloc de données contenant le nœud fils. */
+} DirIndex;
+
+/**
+ * @def DIR_LEAF_MAX
+ * @brief Nombre d'entrées contenues dans une feuille de l'arbre d'un répertoire.
+ */
+#define DIR_LEAF_MAX ((TREE_NODE_SIZE - 2 * sizeof(uint64_t)) / sizeof(DirEntry))
+
+/**
+ * @def DIR_INDEX_MAX
+ * @brief Nombre d'entrées contenues dans un nœud interne de l'arbre d'un répertoire.
+ */
+#define DIR_INDEX_MAX ((TREE_NODE_SIZE - 2 * sizeof(uint64_t)) / sizeof(DirIndex))
+
+/**
+ * @def DIR_TREE_MAX_DEPTH
+ * @brief Profondeur maximale de l'arbre d'un répertoire.
+ */
+#define DIR_TREE_MAX_DEPTH 8
+
+/**
+ * @struct DirNode
+ * @brief Nœud de l'arbre B+ des entrées d'un répertoire, stocké dans un bloc de données.
+ *
+ * Les entrées sont triées par empreinte du nom ; des noms de même empreinte
+ * se suivent et peuvent s'étendre sur plusieurs feuilles. Les feuilles sont
+ * chaînées dans cet ordre pour parcourir le répertoire sans remonter l'arbre.
+ */
+typedef struct {
+    uint16_t depth; /**< Profondeur du nœud, 0 pour une feuille. */
+    uint16_t count; /**< Nombre d'entrées utilisées. */
+    uint32_t checksum; /**< CRC32C des TREE_NODE_SIZE octets du nœud, calculé avec ce champ nul. */
+    int64_t next; /**< Feuille suivante, NO_BLOCK pour la dernière feuille et les nœuds internes. */
+    union {
+        DirEntry entries[DIR_LEAF_MAX]; /**< Entrées d'une feuille. */
+        DirIndex index[DIR_INDEX_MAX]; /**< Entrées d'un nœud interne. */
+    };
+} DirNode;
+
+/**
+ * @def NUM_DIRECT_EXTENTS
+ * @brief Nombre d'extents stockés directement dans l'inode.
+ */
+#define NUM_DIRECT_EXTENTS 3
+
+/**
+ * @def INLINE_DATA_MAX
+ * @brief Taille maximale d'un fichier rangé dans son inode : la place de ses extents et de la racine de son arbre d'extents.
+ */
+#define INLINE_DATA_MAX (sizeof(int64_t) + NUM_DIRECT_EXTENTS * sizeof(Extent))
+
+/**
+ * @def MAX_FILE_BLOCKS
+ * @brief Nombre maximal de blocs d'un fichier : ses blocs logiques sont numérotés sur 32 bits.
+ */
+#define MAX_FILE_BLOCKS UINT32_MAX
+
+/**
+ * @def BATCH_IOV_MAX
+ * @brief Nombre maximal de tampons passés à un même preadv/pwritev par myReadv et myWritev (IOV_MAX sous Linux).
+ */
+#define BATCH_IOV_MAX 1024
+
+/**
+ * @struct IoRequest
+ * @brief Requête d'un lot de lectures ou d'écritures (myReadv, myWritev).
+ */
+typedef struct {
+    file* f; /**< Fichier concerné. */
+    int64_t offset; /**< Position dans le fichier, indépendante de la position actuelle. */
+    struct iovec iov; /**< Tampon et nombre d'octets à transférer. */
+    int64_t result; /**< Nombre d'octets transférés, -1 si la requête est invalide. */
+} IoRequest;
+
+/**
+ * @struct ReadView
+ * @brief Vue d'une partie d'un fichier renvoyée par myReadView, rendue par myReleaseView.
+ *
+ * Chaque morceau désigne des octets consécutifs du fichier, directement dans
+ * la projection de la partition ou dans l'inode d'un petit fichier : aucun
+ * octet n'est copié, sauf ceux d'un fichier compressé, décompressés dans
+ * copy. Les morceaux se suivent dans l'ordre du fichier.
+ */
+typedef struct {
+    file* f; /**< Fichier dont l'inode reste verrouillé en lecture, NULL si la vue est vide. */
+    struct iovec* spans; /**< Morceaux de la vue, en lecture seule. */
+    int count; /**< Nombre de morceaux. */
+    int capacity; /**< Nombre de morceaux alloués. */
+    int64_t length; /**< Nombre total d'octets de la vue. */
+    char* copy; /**< Octets décompressés d'un fichier compressé, désignés par la vue à la place de ses blocs, NULL sinon. */
+} ReadView;
+
 /**
  * @struct inode
- * @brief Structure représentant un inode.
+ * @brief Structure représentant un inode, telle qu'elle est stockée sur disque.
+ *
+ * Les premiers extents d'un fichier sont stockés dans l'inode. Les suivants
+ * sont rangés dans un arbre d'extents indirect dont la racine est extent_tree.
+ * Un fichier d'au plus INLINE_DATA_MAX octets n'a pas de bloc de données :
+ * marqué INODE_INLINE, il range ses octets dans inline_data, à la place de
+ * ses extents, jusqu'à ce qu'il grandisse. Un répertoire n'a pas d'extent :
+ * ses entrées sont rangées dans un arbre B+ dont la racine est dir_tree.
+ * Les blocs de données d'un fichier peuvent être partagés avec ses copies
+ * (myClone, mySnapshot) ; les nœuds de son arbre d'extents lui sont propres.
+ * Les extents d'un fichier compressé décrivent chacun un groupe de blocs
+ * (voir ClusterHeader).
  */
 typedef struct {
-    char* name; /**< Nom du fichier associé à l'inode. */
-    file* file_pointer; /**< Pointeur vers la structure de fichier associée. */
-    DataBlock* firstDataBlock; /**< Pointeur vers le premier bloc de données du fichier. */
+    char name[MAX_FILE_NAME]; /**< Nom de l'entrée associée à l'inode dans son répertoire, chaîne vide si l'inode est libre. */
+    union {
+        uint32_t type; /**< INODE_FILE ou INODE_DIRECTORY, lorsque l'inode est utilisé. */
+        uint32_t next_free; /**< Inode libéré suivant de la liste des inodes libres, lorsque l'inode est libre. */
+    };
+    int64_t fileSize; /**< Taille du fichier en octets, nombre d'entrées d'un répertoire. */
+    uint32_t block_count; /**< Nombre de blocs logiques associés au fichier. */
+    uint16_t num_extents; /**< Nombre d'extents directs utilisés. */
+    uint16_t flags; /**< INODE_INLINE si les octets du fichier sont rangés dans l'inode, INODE_READONLY pour un inode d'instantané, et le codec d'un fichier compressé à partir de INODE_CODEC_SHIFT. */
+    union {
+        struct {
+            union {
+                int64_t extent_tree; /**< Racine de l'arbre d'extents indirect d'un fichier, NO_BLOCK si aucun. */
+                int64_t dir_tree; /**< Racine de l'arbre des entrées d'un répertoire, NO_BLOCK s'il est vide. */
+            };
+            Extent extents[NUM_DIRECT_EXTENTS]; /**< Extents directs du fichier. */
+        };
+        char inline_data[INLINE_DATA_MAX]; /**< Octets d'un fichier marqué INODE_INLINE. */
+    };
 } inode;
 
 /**
- * @struct SuperFileData
- * @brief Structure représentant les données du super fichier.
+ * @def INODES_PER_CHUNK
+ * @brief Nombre d'inodes d'un groupe : l'inode n appartient au groupe n / INODES_PER_CHUNK.
+ */
+#define INODES_PER_CHUNK 32
+
+/**
+ * @def INODE_CHUNK_SIZE
+ * @brief Taille en octets d'un groupe d'inodes, rangé dans des blocs de données contigus.
+ */
+#define INODE_CHUNK_SIZE (INODES_PER_CHUNK * sizeof(inode))
+
+/**
+ * @struct InodeChunk
+ * @brief État en mémoire d'un groupe d'inodes, créé à la première ouverture ou suppression de l'un d'eux.
  */
 typedef struct {
-    int num_inodes; /**< Nombre d'inodes dans le système de fichiers. */
-    int taille_partition; /**< Taille de la partition. */
-    inode inodes[NUM_INODES]; /**< Tableau des inodes. */
+    pthread_rwlock_t locks[INODES_PER_CHUNK]; /**< Verrou lecteurs/rédacteur du contenu de chaque inode. */
+    file* open_files[INODES_PER_CHUNK]; /**< Fichier ouvert associé à chaque inode, NULL si aucun. */
+} InodeChunk;
+
+/**
+ * @struct Partition
+ * @brief Structure représentant une partition montée, renvoyée par myFormat et myMount.
+ *
+ * La partition entière est projetée en mémoire par un mmap privé, dont
+ * seules les métadonnées sont lues : superbloc, carte des inodes, bitmap et
+ * son résumé, et groupes d'inodes rangés dans la zone de données. Leurs
+ * modifications n'atteignent la partition qu'après avoir été écrites dans le
+ * journal, si bien qu'une interruption laisse toujours des métadonnées
+ * cohérentes. Les nœuds des arbres d'extents et des arbres de répertoires
+ * sont journalisés de la même façon, chacun avec son propre code de
+ * contrôle. La table des codes de contrôle des blocs de données fait
+ * exception : ses pages modifiées sont écrites directement, par mySync ou
+ * lorsqu'elles sont trop nombreuses, si bien qu'un bloc réécrit depuis le
+ * dernier mySync peut être signalé corrompu après une interruption.
+ * La table des partages compte, pour chaque bloc de données, les fichiers
+ * qui le possèdent en plus du premier : un bloc partagé n'est libéré que
+ * par son dernier propriétaire, et il est copié avant d'être écrit.
+ * La table des empreintes, en mémoire seulement, n'existe que si la
+ * déduplication des écritures est activée par myDedupSetup.
+ *
+ * Plusieurs threads peuvent utiliser la même partition. La table d'allocation
+ * est protégée par alloc_lock, le contenu de chaque inode par un verrou
+ * lecteurs/rédacteur, et les créations et suppressions de fichiers et de
+ * répertoires sont sérialisées par namespace_lock. Un répertoire est
+ * parcouru sous son verrou en lecture et modifié sous son verrou en
+ * écriture ; un nom déjà résolu est retrouvé sans verrou dans le cache des
+ * entrées de répertoires.
+ * Les verrous sont toujours pris dans l'ordre : opération du journal,
+ * fichier ouvert, namespace_lock, inode (par numéro croissant), alloc_lock,
+ * cache, checksum_lock. Les verrous de la table des empreintes sont pris
+ * seuls, sous le verrou d'un inode au plus ; l'inode propriétaire d'un bloc
+ * déjà écrit n'est verrouillé que s'il est libre sur-le-champ.
+ */
+typedef struct Partition {
+    uint32_t num_inodes; /**< Nombre maximal d'inodes dans le système de fichiers. */
+    uint64_t taille_partition; /**< Taille de la partition en octets. */
+    uint32_t block_size; /**< Taille d'un bloc en octets, lue dans le superbloc. */
+    unsigned block_shift; /**< Logarithme de block_size : positions et tailles sont converties en blocs par décalage. */
+    uint32_t inode_chunk_blocks; /**< Nombre de blocs de données d'un groupe d'inodes. */
+    int64_t max_file_size; /**< Taille maximale d'un fichier en octets, MAX_FILE_BLOCKS blocs. */
+    uint32_t cluster_blocks; /**< Nombre de blocs d'un groupe de blocs compressé, 0 si les blocs sont trop grands pour être compressés. */
     int fileDescriptor; /**< Descripteur de fichier de la partition. */
-    int currentPosition; /**< Position actuelle dans la partition. */
-    DataBlock blocks[MAX_NUM_BLOCKS]; /**< Tableau des blocs de données. */
-} SuperFileData;
+    void* metadata; /**< Projection mémoire de la partition. */
+    size_t metadata_size; /**< Taille en octets de la projection. */
+    char* data_view; /**< Projection partagée en lecture seule de la partition, de même taille, créée par le premier myReadView. */
+    SuperBlock* superBlock; /**< Superbloc de la partition. */
+    uint64_t* inode_map; /**< Carte de la table des inodes : premier bloc de données de chaque groupe d'inodes. */
+    uint64_t* bitmap; /**< Table d'allocation des blocs de données, un bit par bloc, examinée 64 bits à la fois. */
+    uint64_t* full_summary; /**< Résumé de la table d'allocation : un bit par mot dont tous les blocs sont occupés. */
+    uint32_t* checksums; /**< Code de contrôle de chaque bloc de données, 0 pour un bloc qui n'est pas vérifié. */
+    uint16_t* shares; /**< Nombre de références de chaque bloc de données en plus de la première, modifié sous alloc_lock. */
+    pthread_mutex_t checksum_lock; /**< Protège checksum_pages et num_checksum_pages. */
+    uint64_t checksum_pages[CHECKSUM_DIRTY_MAX]; /**< Pages de la table des codes de contrôle modifiées depuis leur dernière écriture. */
+    int num_checksum_pages; /**< Nombre d'entrées de checksum_pages. */
+    uint64_t alloc_hint; /**< Bloc à partir duquel commence la prochaine recherche de blocs libres. */
+    pthread_mutex_t alloc_lock; /**< Protège la table d'allocation, son résumé, la table des partages, free_blocks, shared_blocks et alloc_hint. */
+    pthread_mutex_t namespace_lock; /**< Sérialise les créations et suppressions de fichiers et de répertoires et l'allocation des inodes. */
+    InodeChunk** chunks; /**< État en mémoire de chaque groupe d'inodes, NULL tant qu'il n'a pas servi. */
+    uint32_t num_chunks; /**< Nombre d'entrées de chunks. */
+    uint32_t chunks_used; /**< Borne des entrées de chunks déjà utilisées : toutes les suivantes sont NULL. */
+    DentryCache dentries; /**< Cache des entrées de répertoires déjà résolues. */
+    DedupTable dedup; /**< Table des empreintes des blocs écrits, vide si la déduplication des écritures est désactivée. */
+    BufferCache cache; /**< Cache des blocs de données. */
+    AsyncEngine async; /**< Moteur des entrées/sorties asynchrones. */
+    Journal journal; /**< Journal des métadonnées. */
+    StatsTable stats; /**< Compteurs d'activité et histogrammes de latence, tenus par thread. */
+} Partition;
 
 /**
- * @brief Structure contenant les données du super fichier.
+ * @brief Fonction pour formater une partition.
  * 
- * Contient des informations sur le système de fichiers en cours d'utilisation.
+ * Crée (ou remet à zéro) le fichier de partition, y écrit le superbloc et
+ * des métadonnées vides, puis monte la partition. La partition compte
+ * DEFAULT_NUM_BLOCKS blocs de données de DEFAULT_BLOCK_SIZE octets et
+ * DEFAULT_NUM_INODES inodes.
+ * 
+ * @param partitionName Nom de la partition à formater.
+ * @return La partition montée, NULL en cas d'erreur.
+ * @author Lauriane
  */
-SuperFileData super_file_data;
+Partition* myFormat(char* partitionName);
 
 /**
- * @brief Fonction pour formater une partition.
+ * @brief Fonction pour formater une partition de géométrie choisie.
+ * 
+ * Le fichier de partition est créé à sa taille finale sans écrire ses
+ * métadonnées vides, qui restent des trous du fichier : le formatage ne
+ * dépend pas de la taille de la partition. Le journal et la zone de
+ * données sont dimensionnés d'après le nombre de blocs.
+ * 
+ * La taille de bloc est l'unité d'allocation et de transfert des données :
+ * de grands blocs réduisent le nombre d'allocations et d'appels système des
+ * gros fichiers, au prix de la place perdue à la fin de chaque fichier.
+ * Avec un codec, les fichiers créés sont compressés par groupes de blocs,
+ * ce qui demande des blocs d'au plus COMPRESS_CLUSTER_SIZE / 2 octets.
  * 
  * @param partitionName Nom de la partition à formater.
+ * @param options La géométrie voulue, NULL pour celle de myFormat.
+ * @return La partition montée, NULL en cas d'erreur, si la taille demandée ne suffit pas ou si le codec est refusé.
+ */
+Partition* myFormatWith(char* partitionName, const FormatOptions* options);
+
+/**
+ * @brief Fonction pour monter une partition déjà formatée.
+ * 
+ * Vérifie le superbloc, rejoue les transactions du journal laissées par une
+ * interruption, puis projette l'ensemble des métadonnées en mémoire avec un
+ * seul mmap : le temps de montage ne dépend pas du contenu de la partition.
+ * Une même partition ne doit pas être montée deux fois.
+ * 
+ * @param partitionName Nom de la partition à monter.
+ * @return La partition montée, NULL si la partition est absente, invalide ou d'une autre version.
+ */
+Partition* myMount(char* partitionName);
+
+/**
+ * @brief Fonction pour écrire sur la partition les données et métadonnées modifiées.
+ * 
+ * Les écritures de myWrite sont conservées dans le cache de blocs ; elles
+ * atteignent la partition lors d'une éviction, d'un appel à mySync ou du
+ * démontage. Les requêtes asynchrones en cours sont attendues, puis les
+ * codes de contrôle des blocs écrits sont écrits à leur tour. Les
+ * modifications de métadonnées de toutes les opérations terminées sont
+ * ensuite ajoutées au journal en une seule écriture, suivie d'un seul
+ * fdatasync : des threads appelant mySync en même temps partagent cette
+ * écriture. Au retour, les opérations terminées avant l'appel survivent à
+ * une interruption.
+ * 
+ * @param partition La partition.
+ * @return 0 en cas de succès, -1 en cas d'erreur.
+ */
+int mySync(Partition* partition);
+
+/**
+ * @brief Fonction pour démonter une partition.
+ * 
+ * Écrit les métadonnées modifiées sur disque, vide le journal, libère les
+ * fichiers ouverts et ferme la partition. Son contenu est conservé pour un prochain montage.
+ * Aucun autre thread ne doit utiliser la partition pendant l'appel ; elle
+ * est libérée, même en cas d'erreur.
+ * 
+ * @param partition La partition.
  * @return 0 en cas de succès, -1 en cas d'erreur.
- * @author Lauriane
  */
-int myFormat(char* partitionName);
+int myUnmount(Partition* partition);
+
+/**
+ * @brief Fonction pour obtenir les compteurs d'activité de la partition.
+ * 
+ * myOpen, myRead, myWrite, mySeek et deleteFileFromPartition comptent leurs
+ * appels, leurs erreurs et les octets transférés, et classent la durée
+ * d'un appel sur STATS_SAMPLE_PERIOD dans un histogramme à cases de
+ * largeur croissante (puissances de 2 en nanosecondes). S'y ajoutent les
+ * appels système d'entrée/sortie sur la partition, les blocs alloués et libérés, et les succès et défauts du
+ * cache. Chaque thread tient ses propres compteurs sans verrou ; ils sont
+ * additionnés par cet appel, qui peut être fait pendant que d'autres
+ * threads utilisent la partition. Les compteurs partent de zéro au montage.
+ * 
+ * @param partition La partition.
+ * @param stats Les compteurs à remplir.
+ * @return 0 en cas de succès, -1 si un paramètre est NULL.
+ */
+int myStats(Partition* partition, Stats* stats);
 
 /**
  * @brief Fonction pour ouvrir un fichier.
  * 
- * @param fileName Nom du fichier à ouvrir.
+ * Le chemin est résolu nom par nom depuis le répertoire racine, les noms
+ * étant séparés par PATH_SEPARATOR ; ni "." ni ".." ne sont interprétés.
+ * Un chemin terminé par PATH_SEPARATOR ou contenant un nom vide est refusé.
+ * Les répertoires du chemin doivent exister, le fichier est créé s'il
+ * n'existe pas. Un fichier déjà ouvert dont les noms sont dans le cache des
+ * entrées de répertoires est trouvé sans prendre de verrou.
+ * 
+ * @param partition La partition.
+ * @param fileName Chemin du fichier à ouvrir, par exemple "docs/notes.txt".
  * @return Pointeur vers la structure de fichier ou NULL en cas d'erreur.
  * @author Lauriane
  */
-file* myOpen(char* fileName);
+file* myOpen(Partition* partition, char* fileName);
 
 /**
  * @brief Fonction pour écrire dans un fichier.
  * 
+ * L'écriture s'arrête à MAX_FILE_BLOCKS blocs ou lorsque la partition est pleine.
+ * Un fichier compressé est écrit par groupes de COMPRESS_CLUSTER_SIZE octets,
+ * compressés chacun dans de nouveaux blocs. Une écriture dont les extents
+ * ajoutés ou copiés ne tiennent pas dans la place libre du journal est
+ * découpée : chaque partie est rendue durable dans sa propre transaction
+ * avant la suivante, si bien qu'une interruption peut n'en laisser que les
+ * premières parties. Lorsque la
+ * déduplication est activée, un bloc entièrement réécrit d'un fichier non
+ * compressé qui a le contenu d'un bloc récemment écrit partage ce bloc au
+ * lieu d'être écrit.
+ * 
  * @param f Pointeur vers la structure de fichier.
  * @param buffer Tampon contenant les données à écrire.
  * @param nBytes Nombre d'octets à écrire.
  * @return Nombre d'octets écrits en cas de succès, -1 en cas d'erreur.
  * @author Lauriane
  */
-int myWrite(file* f, void* buffer, int nBytes);
+int64_t myWrite(file* f, void* buffer, int64_t nBytes);
 
 /**
  * @brief Fonction pour lire depuis un fichier.
  * 
+ * La lecture commence à la position actuelle du fichier, s'arrête à la fin
+ * du fichier et avance la position du nombre d'octets lus. Chaque bloc lu
+ * sur la partition est comparé à son code de contrôle (CRC32C).
+ * 
  * @param f Pointeur vers la structure de fichier.
  * @param buffer Tampon pour stocker les données lues.
  * @param nBytes Nombre d'octets à lire.
- * @return Nombre d'octets lus en cas de succès, -1 en cas d'erreur.
+ * @return Nombre d'octets lus en cas de succès, -1 en cas d'erreur,
+ *         ERROR_CHECKSUM si un bloc ne correspond pas à son code de contrôle.
  * @author Boyan
  */
-int myRead(file* f, void* buffer, int nBytes);
+int64_t myRead(file* f, void* buffer, int64_t nBytes);
+
+/**
+ * @brief Fonction pour obtenir une vue d'une partie d'un fichier, sans copie.
+ * 
+ * Les octets sont désignés dans une projection partagée en lecture seule de
+ * la partition, créée au premier appel, ou dans l'inode d'un petit fichier :
+ * un gros fichier peut être envoyé ou haché sans être copié. Ceux des blocs
+ * de la vue qui sont modifiés dans le cache sont d'abord écrits, et chaque
+ * bloc de la vue est comparé à son code de contrôle. Un fichier compressé est décompressé
+ * dans une copie, libérée par myReleaseView. La position actuelle du fichier
+ * n'est ni utilisée ni modifiée.
+ * 
+ * L'inode reste verrouillé en lecture jusqu'à myReleaseView, appelée par le
+ * même thread : les octets de la vue ne changent pas, mais les écritures et
+ * la suppression du fichier attendent. Le thread ne doit donc ni écrire
+ * dans le fichier ni le supprimer avant d'avoir rendu la vue.
+ * 
+ * @param f Pointeur vers la structure de fichier.
+ * @param offset Position dans le fichier.
+ * @param nBytes Nombre d'octets demandés.
+ * @param view La vue à remplir, à rendre avec myReleaseView même si elle est vide.
+ * @return Nombre d'octets de la vue (limité à la fin du fichier, 0 au-delà), -1 en cas d'erreur,
+ *         ERROR_CHECKSUM si un bloc ne correspond pas à son code de contrôle : la vue est alors vide.
+ */
+int64_t myReadView(file* f, int64_t offset, int64_t nBytes, ReadView* view);
+
+/**
+ * @brief Fonction pour rendre une vue obtenue par myReadView.
+ * 
+ * Déverrouille l'inode du fichier et libère les morceaux ; leurs pointeurs
+ * ne doivent plus être utilisés.
+ * 
+ * @param view La vue.
+ */
+void myReleaseView(ReadView* view);
+
+/**
+ * @brief Fonction pour lire un lot de requêtes positionnées, sur un ou plusieurs fichiers.
+ * 
+ * Toutes les correspondances de blocs sont résolues d'abord. Les blocs
+ * présents dans le cache, ou dont seule une partie est lue, sont copiés
+ * depuis celui-ci ; les autres transferts sont triés par position dans la
+ * partition, les morceaux contigus sont lus ensemble avec preadv, puis
+ * chaque bloc est comparé à son code de contrôle. Les positions des fichiers
+ * ne sont pas modifiées.
+ * 
+ * @param partition La partition des fichiers lus.
+ * @param requests Les requêtes. Le champ result de chacune reçoit le nombre d'octets lus
+ *        (limité à la fin du fichier), ou -1 si elle est invalide.
+ * @param count Le nombre de requêtes.
+ * @return Le nombre total d'octets lus, -1 en cas d'erreur, ERROR_CHECKSUM si un bloc
+ *         ne correspond pas à son code de contrôle.
+ */
+int64_t myReadv(Partition* partition, IoRequest* requests, int count);
+
+/**
+ * @brief Fonction pour écrire un lot de requêtes positionnées, sur un ou plusieurs fichiers.
+ * 
+ * Les blocs nécessaires sont associés aux fichiers avant le moindre
+ * transfert, puis les écritures sont triées par position et regroupées en
+ * pwritev. Un bloc dont seule une partie est écrite est modifié dans le
+ * cache, pour que son code de contrôle porte sur tout son contenu. Une requête ne peut pas commencer au-delà de la fin du fichier
+ * (en tenant compte des requêtes précédentes du lot).
+ * 
+ * @param partition La partition des fichiers écrits.
+ * @param requests Les requêtes. Le champ result de chacune reçoit le nombre d'octets écrits,
+ *        ou -1 si elle est invalide.
+ * @param count Le nombre de requêtes.
+ * @return Le nombre total d'octets écrits, -1 en cas d'erreur.
+ */
+int64_t myWritev(Partition* partition, IoRequest* requests, int count);
+
+/**
+ * @brief Fonction pour lancer une lecture asynchrone positionnée.
+ * 
+ * Les blocs présents dans le cache, ou dont seule une partie est lue, sont
+ * copiés immédiatement ; les autres sont lus directement depuis la partition
+ * et comparés à leur code de contrôle par le moteur asynchrone
+ * (io_uring, ou un groupe de threads s'il n'est pas disponible). Les
+ * transferts sont transmis par myAsyncSubmit, myAsyncPoll ou myAsyncWait, et
+ * la fonction callback est appelée par l'un de ces deux derniers, dans le
+ * thread appelant. Le tampon doit rester valide jusqu'à cet appel.
+ * 
+ * @param f Pointeur vers la structure de fichier.
+ * @param offset Position dans le fichier (la position actuelle n'est ni utilisée ni modifiée).
+ * @param buffer Tampon pour stocker les données lues.
+ * @param nBytes Nombre d'octets à lire.
+ * @param callback Fonction appelée à la fin de la lecture avec le nombre d'octets lus, -1,
+ *        ou ERROR_CHECKSUM si un bloc ne correspond pas à son code de contrôle. Peut être NULL.
+ * @param arg Argument transmis à callback.
+ * @return Nombre d'octets qui seront lus (limité à la fin du fichier), -1 si la requête est refusée :
+ *         callback n'est alors pas appelée.
+ */
+int64_t myReadAsync(file* f, int64_t offset, void* buffer, int64_t nBytes, AsyncCallback callback, void* arg);
+
+/**
+ * @brief Fonction pour lancer une écriture asynchrone positionnée.
+ * 
+ * Les blocs sont associés au fichier et sa taille est mise à jour
+ * immédiatement. Les blocs présents dans le cache ou écrits en partie y sont
+ * modifiés, les autres sont écrits directement sur la partition par le
+ * moteur asynchrone. Aucun ordre n'est garanti entre des requêtes en cours
+ * sur les mêmes octets, et une zone en cours d'écriture ne doit pas être lue
+ * ni écrite avant l'appel de callback.
+ * 
+ * @param f Pointeur vers la structure de fichier.
+ * @param offset Position dans le fichier, au plus égale à sa taille.
+ * @param buffer Tampon contenant les données à écrire.
+ * @param nBytes Nombre d'octets à écrire.
+ * @param callback Fonction appelée à la fin de l'écriture avec le nombre d'octets écrits, ou -1. Peut être NULL.
+ * @param arg Argument transmis à callback.
+ * @return Nombre d'octets qui seront écrits (limité par la place disponible), -1 si la requête est refusée.
+ */
+int64_t myWriteAsync(file* f, int64_t offset, void* buffer, int64_t nBytes, AsyncCallback callback, void* arg);
+
+/**
+ * @brief Fonction pour transmettre à la partition les requêtes asynchrones en attente.
+ * 
+ * Au plus la profondeur de file du moteur est en cours à la fois ; le reste
+ * est transmis à mesure que des transferts se terminent.
+ * 
+ * @param partition La partition.
+ * @return Le nombre de transferts transmis, -1 en cas d'erreur.
+ */
+int myAsyncSubmit(Partition* partition);
+
+/**
+ * @brief Fonction pour traiter les requêtes asynchrones terminées, sans attendre.
+ * 
+ * @param partition La partition.
+ * @return Le nombre de requêtes terminées (dont la fonction a été appelée), -1 en cas d'erreur.
+ */
+int myAsyncPoll(Partition* partition);
+
+/**
+ * @brief Fonction pour attendre la fin de requêtes asynchrones.
+ * 
+ * @param partition La partition.
+ * @param minCompletions Le nombre de requêtes terminées à attendre. L'attente s'arrête
+ *        plus tôt s'il n'y a plus de requête en cours.
+ * @return Le nombre de requêtes terminées, -1 en cas d'erreur.
+ */
+int myAsyncWait(Partition* partition, int minCompletions);
+
+/**
+ * @brief Fonction pour reconfigurer le moteur asynchrone d'une partition.
+ * 
+ * Les requêtes en cours sont d'abord terminées. Aucun autre thread ne doit
+ * utiliser le moteur pendant l'appel.
+ * 
+ * @param partition La partition.
+ * @param depth Le nombre maximal de transferts en cours (ASYNC_DEPTH au montage).
+ * @param backend ASYNC_BACKEND_AUTO, ASYNC_BACKEND_URING ou ASYNC_BACKEND_THREADS.
+ * @return Le moteur utilisé (ASYNC_BACKEND_URING ou ASYNC_BACKEND_THREADS), -1 en cas d'erreur.
+ */
+int myAsyncSetup(Partition* partition, unsigned depth, int backend);
 
 /**
  * @brief Fonction pour déplacer la position de lecture/écriture dans un fichier.
  * 
  * Cette fonction déplace la position de lecture/écriture dans un fichier ouvert.
+ * Elle ne modifie que la position du fichier : aucun appel système n'est effectué.
  * 
  * @param f Pointeur vers la structure de fichier.
  * @param offset Décalage par rapport à la position de départ.
  * @param base La base à utiliser pour le décalage (SEEK_SET, SEEK_CUR ou SEEK_END).
  * @author Boyan
  */
-void mySeek(file* f, int offset, int base);
+void mySeek(file* f, int64_t offset, int base);
 
 /**
  * @brief Fonction pour afficher l'aide.
@@ -160,32 +934,159 @@ void printHelp();
 
 /**
  * @brief Fonction pour supprimer un fichier.
+ * 
+ * @param partition La partition.
  * @author Boyan
  */
-void deleteFile();
+void deleteFile(Partition* partition);
+
+/**
+ * @brief Fonction pour afficher les compteurs d'activité de la partition.
+ * @param partition La partition.
+ */
+void printStats(Partition* partition);
+
+/**
+ * @brief Fonction pour créer un répertoire.
+ * 
+ * Les répertoires du chemin qui précèdent le dernier nom doivent exister.
+ * Seules les erreurs sont affichées.
+ * 
+ * @param partition La partition.
+ * @param path Le chemin du répertoire à créer.
+ * @return 0 si le répertoire est créé, -1 s'il existe déjà ou en cas d'erreur.
+ */
+int myMkdir(Partition* partition, char* path);
 
 /**
- * @brief Fonction pour supprimer un fichier de la partition.
+ * @brief Fonction pour supprimer un fichier ou un répertoire vide de la partition.
  * 
- * @param fileName Le nom du fichier à supprimer.
+ * Le fichier ouvert correspondant est libéré : aucun autre thread ne doit
+ * l'utiliser pendant ou après la suppression. Seules les erreurs sont
+ * affichées.
+ * 
+ * @param partition La partition.
+ * @param fileName Le chemin du fichier ou du répertoire à supprimer.
  * @return 0 si le fichier est supprimé avec succès, -1 en cas d'erreur.
  * @author Boyan
  */
-int deleteFileFromPartition(char* fileName);
+int deleteFileFromPartition(Partition* partition, char* fileName);
+
+/**
+ * @brief Fonction pour copier un fichier sans copier ses données.
+ * 
+ * La copie partage les blocs de données du fichier, qui gagnent une
+ * référence dans la table des partages : seuls l'inode et l'arbre d'extents
+ * sont écrits, en une transaction dont le coût croît avec le nombre de blocs
+ * et non avec leur taille. Chaque fichier copie un groupe de COW_GROUP_BLOCKS
+ * blocs partagés avant de l'écrire. Seules les erreurs sont affichées.
+ * 
+ * @param partition La partition.
+ * @param source Le chemin du fichier à copier.
+ * @param destination Le chemin de la copie, qui ne doit pas exister.
+ * @return 0 si la copie est créée, -1 en cas d'erreur.
+ */
+int myClone(Partition* partition, char* source, char* destination);
+
+/**
+ * @brief Fonction pour prendre un instantané de la partition.
+ * 
+ * Le répertoire créé contient une copie de toute l'arborescence, sauf les
+ * instantanés précédents, dont les fichiers partagent leurs blocs comme ceux
+ * de myClone. Ses fichiers et répertoires sont marqués INODE_READONLY : ils
+ * ne peuvent être ni écrits ni complétés, seulement lus, copiés et
+ * supprimés. Aucune autre opération ne modifie la partition pendant
+ * l'instantané, qui écrit ses propres transactions à mesure que le journal
+ * se remplit ; il est refusé si les inodes ou les blocs libres n'y
+ * suffisent pas, ou si la copie d'un seul fichier dépasse la moitié du
+ * journal. Après une interruption, un instantané partiel se supprime comme
+ * un autre. Seules les erreurs sont affichées.
+ * 
+ * @param partition La partition.
+ * @param path Le chemin du répertoire de l'instantané, qui ne doit pas exister.
+ * @return 0 si l'instantané est pris, -1 en cas d'erreur.
+ */
+int mySnapshot(Partition* partition, char* path);
+
+/**
+ * @brief Fonction pour choisir le codec d'un fichier vide.
+ * 
+ * Un fichier créé reçoit le codec de la partition. Ses données sont ensuite
+ * compressées par groupes de COMPRESS_CLUSTER_SIZE octets, chacun
+ * décompressé seul à la lecture, ou écrites telles quelles avec CODEC_NONE.
+ * 
+ * @param f Pointeur vers la structure de fichier, qui n'a encore aucun bloc de données.
+ * @param codec Le codec, CODEC_NONE pour ne pas compresser.
+ * @return 0 en cas de succès, -1 en cas d'erreur (errno vaut EBUSY si le
+ *         fichier a déjà des blocs, EINVAL si le codec est inconnu ou si les
+ *         blocs de la partition sont trop grands, EROFS pour un fichier d'instantané).
+ */
+int mySetCompression(file* f, uint32_t codec);
+
+/**
+ * @brief Fonction pour activer ou désactiver la déduplication des écritures.
+ * 
+ * Activée, myWrite calcule l'empreinte de chaque bloc entier qu'il écrit
+ * dans un fichier non compressé et la cherche dans une table en mémoire :
+ * un bloc déjà écrit de même contenu est partagé, comme par myClone, et le
+ * bloc du fichier est libéré. La table ne retient que les blocs écrits
+ * depuis l'activation, au plus un par bloc de la partition et au plus
+ * DEDUP_MAX_SETS * DEDUP_WAYS en tout (24 octets chacun), et disparaît au
+ * démontage. Les écritures par lots et asynchrones ne sont pas
+ * dédupliquées. Aucun autre thread ne doit utiliser la partition pendant
+ * l'appel.
+ * 
+ * @param partition La partition.
+ * @param enabled 1 pour activer la déduplication, 0 pour la désactiver et libérer la table.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire (la déduplication est alors désactivée).
+ */
+int myDedupSetup(Partition* partition, int enabled);
+
+/**
+ * @brief Fonction pour dédupliquer les blocs de données de tous les fichiers.
+ * 
+ * Les empreintes des blocs entiers des fichiers non compressés sont
+ * calculées en parallèle, puis les blocs de même contenu sont fusionnés :
+ * chaque fichier qui référence une copie désigne ensuite le premier bloc
+ * identique, qui gagne une référence, et la copie est libérée. Aucune autre
+ * opération ne modifie la partition pendant la déduplication, qui écrit ses
+ * propres transactions à mesure que le journal se remplit ; les lectures
+ * continuent, sauf celles du fichier modifié. Un bloc illisible ou corrompu
+ * n'est jamais fusionné.
+ * 
+ * @param partition La partition.
+ * @param threads Le nombre de threads du calcul des empreintes, 0 pour un par processeur (au plus DEDUP_MAX_THREADS).
+ * @return Le nombre de blocs libérés, -1 en cas d'erreur (les blocs déjà fusionnés le restent).
+ */
+int64_t myDedup(Partition* partition, int threads);
 
 /**
- * @brief Fonction pour lister tous les fichiers présents dans la partition.
+ * @brief Fonction pour lister les entrées d'un répertoire.
  * 
- * Cette fonction parcourt tous les inodes du système de fichiers pour extraire les noms
- * des fichiers présents.
+ * Les feuilles de l'arbre du répertoire sont parcourues dans l'ordre des
+ * empreintes des noms, sous le verrou en lecture du répertoire. Le nom d'un
+ * répertoire est suivi de PATH_SEPARATOR.
  * 
+ * @param partition La partition.
+ * @param path Le chemin du répertoire, "/" pour la racine.
+ * @return Un tableau de noms terminé par NULL, NULL si le répertoire n'existe pas ou en cas d'erreur.
+ *         Le tableau et chacun des noms sont à libérer par l'appelant avec free().
+ */
+char** listDirectory(Partition* partition, char* path);
+
+/**
+ * @brief Fonction pour lister les fichiers et répertoires du répertoire racine de la partition.
+ * 
+ * Équivaut à listDirectory(partition, "/").
+ * 
+ * @param partition La partition.
  * @return Un tableau de chaînes de caractères contenant les noms de fichiers, NULL en cas d'erreur.
  *         Les fichiers retournés sont alloués dynamiquement, et il est de la responsabilité de l'appelant
  *         de libérer la mémoire une fois qu'ils ne sont plus nécessaires en appelant free() sur chaque
  *         élément du tableau, puis sur le tableau lui-même.
  * @author Lauriane
  */
-char** listFiles();
+char** listFiles(Partition* partition);
 
 /**
  * @brief Fonction pour obtenir le nombre de fichiers présents dans la partition.
@@ -196,13 +1097,228 @@ char** listFiles();
  */
 int numFiles(char** files);
 
+/**
+ * @brief Fonction pour calculer la position dans la partition d'un bloc de données.
+ * 
+ * @param partition La partition.
+ * @param block L'indice du bloc dans la zone de données.
+ * @return La position en octets du début du bloc dans la partition.
+ */
+off_t dataBlockOffset(Partition* partition, uint64_t block);
+
+/**
+ * @brief Fonction pour calculer le code de contrôle d'un bloc de données.
+ * 
+ * @param partition La partition.
+ * @param data Le contenu du bloc (block_size octets).
+ * @return Le CRC32C du bloc, 1 à la place de 0 qui désigne un bloc non vérifié.
+ */
+uint32_t blockChecksum(Partition* partition, const void* data);
+
+/**
+ * @brief Fonction pour calculer et noter le code de contrôle d'un bloc de données.
+ * 
+ * Le code n'atteint la partition qu'une fois noté par dirtyBlockChecksums,
+ * appelée une fois le bloc écrit.
+ * 
+ * @param partition La partition.
+ * @param block L'indice du bloc dans la zone de données.
+ * @param data Le contenu du bloc (block_size octets).
+ */
+void setBlockChecksum(Partition* partition, uint64_t block, const void* data);
+
+/**
+ * @brief Fonction pour noter que les codes de contrôle d'une suite de blocs consécutifs sont à écrire.
+ * 
+ * Les pages de la table modifiées sont écrites ensemble par mySync, ou dès
+ * que CHECKSUM_DIRTY_MAX pages attendent.
+ * 
+ * @param partition La partition.
+ * @param block Le premier bloc de la suite.
+ * @param count Le nombre de blocs.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int dirtyBlockChecksums(Partition* partition, uint64_t block, uint64_t count);
+
+/**
+ * @brief Fonction pour écrire sur la partition les codes de contrôle notés par dirtyBlockChecksums.
+ * 
+ * Les pages sont triées et les pages consécutives écrites en une fois.
+ * 
+ * @param partition La partition.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'écriture.
+ */
+int flushBlockChecksums(Partition* partition);
+
+/**
+ * @brief Fonction pour vérifier un bloc de données lu sur la partition.
+ * 
+ * Un bloc dont le code de contrôle est nul (jamais écrit, nœud d'arbre ou
+ * groupe d'inodes) n'est pas vérifié.
+ * 
+ * @param partition La partition.
+ * @param block L'indice du bloc dans la zone de données.
+ * @param data Le contenu lu (block_size octets).
+ * @return 0 si le bloc correspond à son code, -1 sinon (errno vaut alors EBADMSG).
+ */
+int verifyBlockChecksum(Partition* partition, uint64_t block, const void* data);
+
+/**
+ * @brief Fonction pour noter le code de contrôle d'un bloc après une écriture directe d'une partie de ses octets.
+ * 
+ * Le bloc n'est relu que si l'écriture ne l'a pas entièrement couvert. Le
+ * code est ensuite noté par dirtyBlockChecksums.
+ * 
+ * @param partition La partition.
+ * @param offset La position de l'écriture dans la partition.
+ * @param data Les octets écrits.
+ * @param length Le nombre d'octets écrits, sans dépasser la fin du bloc.
+ * @return Le bloc de données écrit, NO_BLOCK si sa relecture a échoué.
+ */
+int64_t updateBlockChecksum(Partition* partition, off_t offset, const void* data, size_t length);
+
+/**
+ * @brief Fonction pour obtenir l'adresse d'un inode dans la projection de la partition.
+ * 
+ * @param partition La partition.
+ * @param inode_number Le numéro de l'inode, dont le groupe est déjà alloué.
+ * @return L'inode.
+ */
+inode* inodeAt(Partition* partition, uint32_t inode_number);
+
+/**
+ * @brief Fonction pour calculer l'empreinte d'un nom de fichier (FNV-1a 32 bits).
+ * 
+ * @param name Le nom du fichier.
+ * @return L'empreinte du nom, qui range son entrée dans l'arbre de son répertoire.
+ */
+uint32_t hashName(const char* name);
+
+/**
+ * @brief Fonction pour lire un nœud d'un arbre d'extents ou de répertoire.
+ * 
+ * Un nœud journalisé qui n'est pas encore à sa place est lu dans le
+ * journal ; sinon il est lu à travers le cache et comparé au code de
+ * contrôle qu'il contient.
+ * 
+ * @param partition La partition.
+ * @param block Le bloc de données contenant le nœud.
+ * @param node Le nœud à remplir.
+ * @param size La taille du nœud, au plus TREE_NODE_SIZE.
+ * @return 0 en cas de succès, -1 en cas d'erreur (errno vaut EBADMSG si le nœud ne correspond pas à son code de contrôle).
+ */
+int readTreeNode(Partition* partition, uint64_t block, void* node, size_t size);
+
+/**
+ * @brief Fonction pour remettre dans l'état voulu des blocs que la table d'allocation marque à tort.
+ * 
+ * Seuls les blocs qui ne sont pas déjà dans cet état changent, par morceaux
+ * d'au plus REPAIR_RUN_BLOCKS blocs formant chacun une opération du
+ * journal : une longue suite ne dépasse pas la taille du journal. Un bloc
+ * libéré quitte le cache et perd son code de contrôle, comme ceux d'un
+ * fichier supprimé.
+ * 
+ * @param partition La partition.
+ * @param start Le premier bloc de la suite.
+ * @param length Le nombre de blocs.
+ * @param state BLOCK_FREE pour des blocs qu'aucun inode ne référence, BLOCK_OCCUPIED pour des blocs référencés.
+ * @return Le nombre de blocs dont l'état a changé.
+ */
+uint64_t repairBlocks(Partition* partition, uint64_t start, uint64_t length, int state);
+
+/**
+ * @brief Fonction pour corriger le compteur de partage d'un bloc.
+ * 
+ * Le compteur n'est modifié que s'il vaut encore ce qu'a lu la vérification :
+ * un bloc partagé ou copié depuis n'est pas touché. Le nombre de blocs
+ * partagés du superbloc suit la correction.
+ * 
+ * @param partition La partition.
+ * @param block Le bloc.
+ * @param found Le compteur lu par la vérification.
+ * @param shares Le nombre de références du bloc en plus de la première.
+ * @return 1 si le compteur a été corrigé, 0 s'il a changé depuis la vérification.
+ */
+int repairShares(Partition* partition, uint64_t block, uint16_t found, uint16_t shares);
+
+/**
+ * @brief Fonction pour ramener la taille d'un fichier à la place dont il dispose.
+ * 
+ * La taille est vérifiée de nouveau sous le verrou de l'inode : un fichier
+ * agrandi ou supprimé depuis la vérification n'est pas modifié. La copie
+ * de la taille gardée par le fichier ouvert est mise à jour.
+ * 
+ * @param partition La partition.
+ * @param inode_number Le numéro de l'inode du fichier.
+ * @return 1 si la taille a été corrigée, 0 si elle était valide, -1 en cas d'erreur d'allocation mémoire.
+ */
+int repairFileSize(Partition* partition, uint32_t inode_number);
+
+/**
+ * @brief Fonction pour recalculer le résumé de la table d'allocation, le nombre de blocs libres et celui des blocs partagés.
+ * 
+ * Les bits au-delà du dernier bloc sont de nouveau marqués occupés. Le
+ * résumé est corrigé par groupes de mots de la table, chacun dans une
+ * opération du journal, puis les blocs libres et partagés sont comptés en
+ * une fois sous alloc_lock.
+ * 
+ * @param partition La partition.
+ * @return Le nombre de valeurs corrigées.
+ */
+uint64_t repairAllocationCounters(Partition* partition);
+
+/**
+ * @brief Fonction pour lire des octets à une position donnée de la partition (pread).
+ * 
+ * @param partition La partition.
+ * @param buffer Le tampon de destination.
+ * @param nBytes Le nombre d'octets à lire.
+ * @param offset La position dans la partition.
+ * @return Le nombre d'octets lus, -1 en cas d'erreur.
+ */
+ssize_t partitionRead(Partition* partition, void* buffer, size_t nBytes, off_t offset);
+
+/**
+ * @brief Fonction pour écrire des octets à une position donnée de la partition (pwrite).
+ * 
+ * @param partition La partition.
+ * @param buffer Le tampon contenant les données.
+ * @param nBytes Le nombre d'octets à écrire.
+ * @param offset La position dans la partition.
+ * @return Le nombre d'octets écrits, -1 en cas d'erreur.
+ */
+ssize_t partitionWrite(Partition* partition, const void* buffer, size_t nBytes, off_t offset);
+
+/**
+ * @brief Fonction pour lire une position de la partition dans plusieurs tampons (preadv).
+ * 
+ * @param partition La partition.
+ * @param iov Les tampons de destination, modifiés en cas de lecture partielle.
+ * @param count Le nombre de tampons.
+ * @param offset La position dans la partition.
+ * @return Le nombre d'octets lus, -1 en cas d'erreur.
+ */
+ssize_t partitionReadv(Partition* partition, struct iovec* iov, int count, off_t offset);
+
+/**
+ * @brief Fonction pour écrire plusieurs tampons à une position de la partition (pwritev).
+ * 
+ * @param partition La partition.
+ * @param iov Les tampons contenant les données, modifiés en cas d'écriture partielle.
+ * @param count Le nombre de tampons.
+ * @param offset La position dans la partition.
+ * @return Le nombre d'octets écrits, -1 en cas d'erreur.
+ */
+ssize_t partitionWritev(Partition* partition, struct iovec* iov, int count, off_t offset);
+
 /**
  * @brief Fonction pour supprimer la partition lorsque l'utilisateur quitte le programme
  * 
+ * @param partition la partition, libérée par l'appel
  * @param partitionName le nom de la partition
  * @author Boyan
  */
-void deletePartition(char* partitionName);
+void deletePartition(Partition* partition, char* partitionName);
 
 #endif /* PROJET_H_ */
 
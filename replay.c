@@ -0,0 +1,493 @@
+/**
+ * @file replay.c
+ * @brief Ce fichier contient le rejeu d'une trace d'opérations (ouvertures, lectures, écritures, déplacements, suppressions) avec mesure du débit et des latences.
+ */
+
+#include <time.h>
+
+#include "projet.h"
+#include "replay.h"
+
+/**
+ * @def REPLAY_OPEN
+ * @brief Indice des ouvertures dans les résultats du rejeu.
+ */
+#define REPLAY_OPEN 0
+
+/**
+ * @def REPLAY_WRITE
+ * @brief Indice des écritures dans les résultats du rejeu.
+ */
+#define REPLAY_WRITE 1
+
+/**
+ * @def REPLAY_READ
+ * @brief Indice des lectures dans les résultats du rejeu.
+ */
+#define REPLAY_READ 2
+
+/**
+ * @def REPLAY_SEEK
+ * @brief Indice des déplacements dans les résultats du rejeu.
+ */
+#define REPLAY_SEEK 3
+
+/**
+ * @def REPLAY_DELETE
+ * @brief Indice des suppressions dans les résultats du rejeu.
+ */
+#define REPLAY_DELETE 4
+
+/**
+ * @def REPLAY_SYNC
+ * @brief Indice des mySync dans les résultats du rejeu.
+ */
+#define REPLAY_SYNC 5
+
+/**
+ * @def REPLAY_MKDIR
+ * @brief Indice des créations de répertoires dans les résultats du rejeu.
+ */
+#define REPLAY_MKDIR 6
+
+/**
+ * @def REPLAY_NUM_OPS
+ * @brief Nombre de types d'opérations de la trace.
+ */
+#define REPLAY_NUM_OPS 7
+
+/**
+ * @brief Noms des opérations dans la trace, indexés par REPLAY_OPEN à REPLAY_MKDIR.
+ */
+static const char* op_names[REPLAY_NUM_OPS] = { "open", "write", "read", "seek", "delete", "sync", "mkdir" };
+
+/**
+ * @struct ReplayOp
+ * @brief Résultats d'un type d'opération.
+ */
+typedef struct {
+    uint64_t* latencies; /**< Latence de chaque opération, en nanosecondes. */
+    size_t count; /**< Nombre d'opérations. */
+    size_t capacity; /**< Nombre de latences que peut contenir le tableau. */
+    unsigned long bytes; /**< Octets lus ou écrits. */
+    int errors; /**< Opérations en erreur. */
+} ReplayOp;
+
+/**
+ * @struct ReplayFile
+ * @brief Fichier ouvert par la trace.
+ */
+typedef struct {
+    char name[REPLAY_MAX_LINE]; /**< Chemin normalisé du fichier (voir normalizePath), chaîne vide si l'entrée est libre. */
+    file* f; /**< Fichier ouvert. */
+} ReplayFile;
+
+/**
+ * @struct Replay
+ * @brief État d'un rejeu.
+ */
+typedef struct {
+    Partition* partition; /**< Partition sur laquelle la trace est rejouée. */
+    ReplayFile* files; /**< Fichiers ouverts par la trace. */
+    size_t num_files; /**< Nombre d'entrées utilisées de files, libres comprises. */
+    size_t files_capacity; /**< Nombre d'entrées allouées de files. */
+    char* buffer; /**< Tampon des lectures et écritures. */
+    size_t buffer_size; /**< Taille du tampon. */
+    ReplayOp ops[REPLAY_NUM_OPS]; /**< Résultats de chaque type d'opération. */
+} Replay;
+
+/**
+ * @brief Renvoie l'heure de l'horloge monotone.
+ * @return L'heure en nanosecondes.
+ */
+static uint64_t nowNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @brief Attend un instant de l'horloge monotone.
+ * @param target L'instant, en nanosecondes.
+ */
+static void sleepUntil(uint64_t target) {
+    struct timespec until = { (time_t)(target / 1000000000ull), (long)(target % 1000000000ull) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {
+    }
+}
+
+/**
+ * @brief Compare deux latences pour qsort.
+ * @param a La première latence.
+ * @param b La seconde latence.
+ * @return Un entier négatif, nul ou positif selon l'ordre des latences.
+ */
+static int compareLatencies(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Renvoie un centile de latences triées, au rang le plus proche.
+ * @param sorted Les latences triées, en nanosecondes.
+ * @param count Le nombre de latences, au moins 1.
+ * @param per_mille Le centile, en millièmes.
+ * @return Le centile, en microsecondes.
+ */
+static double percentile(const uint64_t* sorted, size_t count, unsigned per_mille) {
+    size_t rank = (count * per_mille + 999) / 1000;
+    return sorted[rank > 0 ? rank - 1 : 0] / 1000.0;
+}
+
+/**
+ * @brief Enregistre le résultat d'une opération.
+ * @param op Les résultats du type d'opération.
+ * @param latency La latence de l'opération, en nanosecondes.
+ * @param result Le nombre d'octets transférés, négatif si l'opération a échoué.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+static int recordOp(ReplayOp* op, uint64_t latency, long result) {
+    if (op->count == op->capacity) {
+        size_t capacity = op->capacity == 0 ? 1024 : op->capacity * 2;
+        uint64_t* latencies = realloc(op->latencies, capacity * sizeof(uint64_t));
+        if (latencies == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour les latences");
+            return -1;
+        }
+        op->latencies = latencies;
+        op->capacity = capacity;
+    }
+    op->latencies[op->count++] = latency;
+    if (result < 0) {
+        op->errors++;
+    } else {
+        op->bytes += result;
+    }
+    return 0;
+}
+
+/**
+ * @brief Normalise un chemin de la trace : la partition ignore les séparateurs en tête, en fin ou répétés.
+ * @param path Le chemin.
+ * @param normalized Reçoit le chemin sans séparateur en tête ni en fin, ses noms séparés par un seul PATH_SEPARATOR (REPLAY_MAX_LINE octets).
+ */
+static void normalizePath(const char* path, char* normalized) {
+    size_t length = 0;
+    for (; *path != '\0' && length + 1 < REPLAY_MAX_LINE; ++path) {
+        if (*path != PATH_SEPARATOR || (length > 0 && normalized[length - 1] != PATH_SEPARATOR)) {
+            normalized[length++] = *path;
+        }
+    }
+    if (length > 0 && normalized[length - 1] == PATH_SEPARATOR) {
+        length--;
+    }
+    normalized[length] = '\0';
+}
+
+/**
+ * @brief Recherche un fichier ouvert par la trace.
+ * 
+ * Les chemins sont comparés une fois normalisés : "a" et "/a" désignent le
+ * même fichier, et donc la même entrée.
+ * 
+ * @param replay Le rejeu.
+ * @param name Le nom du fichier.
+ * @return L'entrée du fichier, NULL s'il n'est pas ouvert.
+ */
+static ReplayFile* findFile(Replay* replay, const char* name) {
+    char normalized[REPLAY_MAX_LINE];
+    normalizePath(name, normalized);
+    for (size_t i = 0; i < replay->num_files; ++i) {
+        if (replay->files[i].name[0] != '\0' && strcmp(replay->files[i].name, normalized) == 0) {
+            return &replay->files[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Ouvre un fichier de la trace et le retient.
+ * @param replay Le rejeu.
+ * @param name Le nom du fichier.
+ * @return Le fichier ouvert, NULL en cas d'erreur.
+ */
+static file* openFile(Replay* replay, char* name) {
+    file* f = myOpen(replay->partition, name);
+    if (f == NULL) {
+        return NULL;
+    }
+    // Un même nom ouvert deux fois renvoie le même fichier : une seule entrée suffit
+    if (findFile(replay, name) != NULL) {
+        return f;
+    }
+    size_t i = 0;
+    while (i < replay->num_files && replay->files[i].name[0] != '\0') {
+        i++;
+    }
+    if (i == replay->files_capacity) {
+        size_t capacity = replay->files_capacity == 0 ? 16 : replay->files_capacity * 2;
+        ReplayFile* files = realloc(replay->files, capacity * sizeof(ReplayFile));
+        if (files == NULL) {
+            perror("Erreur lors de l'allocation de mémoire pour les fichiers du rejeu");
+            return NULL;
+        }
+        replay->files = files;
+        replay->files_capacity = capacity;
+    }
+    if (i == replay->num_files) {
+        replay->num_files++;
+    }
+    normalizePath(name, replay->files[i].name);
+    replay->files[i].f = f;
+    return f;
+}
+
+/**
+ * @brief Renvoie un fichier de la trace, en l'ouvrant s'il ne l'est pas encore.
+ * @param replay Le rejeu.
+ * @param name Le nom du fichier.
+ * @return Le fichier ouvert, NULL en cas d'erreur.
+ */
+static file* fileOf(Replay* replay, char* name) {
+    ReplayFile* entry = findFile(replay, name);
+    return entry != NULL ? entry->f : openFile(replay, name);
+}
+
+/**
+ * @brief Agrandit si besoin le tampon des lectures et écritures.
+ * @param replay Le rejeu.
+ * @param size La taille nécessaire.
+ * @return 0 en cas de succès, -1 en cas d'erreur d'allocation mémoire.
+ */
+static int reserveBuffer(Replay* replay, size_t size) {
+    if (size <= replay->buffer_size) {
+        return 0;
+    }
+    char* buffer = realloc(replay->buffer, size);
+    if (buffer == NULL) {
+        perror("Erreur lors de l'allocation du tampon de rejeu");
+        return -1;
+    }
+    memset(buffer + replay->buffer_size, 'r', size - replay->buffer_size);
+    replay->buffer = buffer;
+    replay->buffer_size = size;
+    return 0;
+}
+
+/**
+ * @brief Analyse puis exécute une ligne de la trace.
+ * @param replay Le rejeu.
+ * @param line La ligne, sans l'instant.
+ * @param line_number Le numéro de la ligne, pour les messages d'erreur.
+ * @return 0 en cas de succès, -1 si la ligne est invalide ou en cas d'erreur d'allocation mémoire.
+ */
+static int runLine(Replay* replay, const char* line, int line_number) {
+    char op_name[16], name[REPLAY_MAX_LINE], whence[8];
+    long long value = 0;
+    int fields = sscanf(line, "%15s %511s %lld %7s", op_name, name, &value, whence);
+    int op = 0;
+    while (op < REPLAY_NUM_OPS && (fields < 1 || strcmp(op_name, op_names[op]) != 0)) {
+        op++;
+    }
+    int needed[REPLAY_NUM_OPS] = { 2, 3, 3, 4, 2, 1, 2 };
+    if (op == REPLAY_NUM_OPS || fields < needed[op]) {
+        printf("Erreur : ligne %d de la trace invalide.\n", line_number);
+        return -1;
+    }
+    if ((op == REPLAY_WRITE || op == REPLAY_READ) && (value <= 0 || value > REPLAY_MAX_IO)) {
+        printf("Erreur : ligne %d de la trace, taille comprise entre 1 et %d octets attendue.\n",
+               line_number, REPLAY_MAX_IO);
+        return -1;
+    }
+    int base = SEEK_SET;
+    if (op == REPLAY_SEEK) {
+        if (strcmp(whence, "cur") == 0) {
+            base = SEEK_CUR;
+        } else if (strcmp(whence, "end") == 0) {
+            base = SEEK_END;
+        } else if (strcmp(whence, "set") != 0) {
+            printf("Erreur : ligne %d de la trace, déplacement invalide.\n", line_number);
+            return -1;
+        }
+    }
+    if ((op == REPLAY_WRITE || op == REPLAY_READ) && reserveBuffer(replay, value) == -1) {
+        return -1;
+    }
+
+    // L'ouverture implicite d'un fichier n'est pas comptée dans la latence de l'opération
+    file* f = NULL;
+    if (op == REPLAY_WRITE || op == REPLAY_READ || op == REPLAY_SEEK) {
+        f = fileOf(replay, name);
+        if (f == NULL) {
+            return recordOp(&replay->ops[op], 0, -1);
+        }
+    }
+    if (op == REPLAY_DELETE) {
+        ReplayFile* entry = findFile(replay, name);
+        if (entry != NULL) {
+            entry->name[0] = '\0'; // Le fichier ouvert est libéré par la suppression
+        }
+    }
+
+    long result = 0;
+    uint64_t start = nowNs();
+    switch (op) {
+        case REPLAY_OPEN:
+            result = openFile(replay, name) != NULL ? 0 : -1;
+            break;
+        case REPLAY_WRITE:
+            result = myWrite(f, replay->buffer, value);
+            break;
+        case REPLAY_READ:
+            result = myRead(f, replay->buffer, value);
+            break;
+        case REPLAY_SEEK:
+            mySeek(f, value, base);
+            break;
+        case REPLAY_DELETE:
+            result = deleteFileFromPartition(replay->partition, name);
+            break;
+        case REPLAY_SYNC:
+            result = mySync(replay->partition);
+            break;
+        default:
+            result = myMkdir(replay->partition, name);
+            break;
+    }
+    return recordOp(&replay->ops[op], nowNs() - start, result);
+}
+
+/**
+ * @brief Affiche les résultats du rejeu et les écrit au format CSV si demandé.
+ * @param replay Le rejeu.
+ * @param seconds La durée totale du rejeu.
+ * @param max_lag Le plus grand retard sur les instants de la trace, en nanosecondes, 0 à pleine vitesse.
+ * @param csv_path Le chemin du fichier CSV à créer, NULL si aucun.
+ * @return 0 en cas de succès, -1 si le fichier CSV ne peut pas être écrit.
+ */
+static int report(Replay* replay, double seconds, uint64_t max_lag, const char* csv_path) {
+    FILE* csv = NULL;
+    if (csv_path != NULL) {
+        csv = fopen(csv_path, "w");
+        if (csv == NULL) {
+            perror("Erreur lors de la création du fichier CSV");
+            return -1;
+        }
+        fprintf(csv, "op,calls,errors,bytes,seconds,ops_per_s,mb_per_s,mean_us,p50_us,p99_us,p999_us\n");
+    }
+
+    printf("%-8s %10s %8s %12s %12s %10s %10s %10s %10s\n", "op", "appels", "erreurs", "op/s (op)",
+           "Mo/s (op)", "moy. (us)", "p50 (us)", "p99 (us)", "p999 (us)");
+    size_t total_ops = 0;
+    unsigned long total_bytes = 0;
+    for (int i = 0; i < REPLAY_NUM_OPS; ++i) {
+        ReplayOp* op = &replay->ops[i];
+        if (op->count == 0) {
+            continue;
+        }
+        total_ops += op->count;
+        total_bytes += op->bytes;
+        qsort(op->latencies, op->count, sizeof(uint64_t), compareLatencies);
+        // Débit de l'opération seule : rapporté au temps passé dans ses appels
+        double busy = 0;
+        for (size_t k = 0; k < op->count; ++k) {
+            busy += op->latencies[k] / 1e9;
+        }
+        double rate = busy > 0 ? op->count / busy : 0;
+        double mb = busy > 0 ? op->bytes / busy / (1024 * 1024) : 0;
+        double mean = busy * 1e6 / op->count;
+        double p50 = percentile(op->latencies, op->count, 500);
+        double p99 = percentile(op->latencies, op->count, 990);
+        double p999 = percentile(op->latencies, op->count, 999);
+        printf("%-8s %10zu %8d %12.0f %12.2f %10.2f %10.2f %10.2f %10.2f\n", op_names[i], op->count, op->errors,
+               rate, mb, mean, p50, p99, p999);
+        if (csv != NULL) {
+            fprintf(csv, "%s,%zu,%d,%lu,%.6f,%.1f,%.3f,%.3f,%.3f,%.3f,%.3f\n", op_names[i], op->count, op->errors,
+                    op->bytes, busy, rate, mb, mean, p50, p99, p999);
+        }
+    }
+
+    double rate = seconds > 0 ? total_ops / seconds : 0;
+    double mb = seconds > 0 ? total_bytes / seconds / (1024 * 1024) : 0;
+    printf("\n%zu opérations en %.3f s : %.0f op/s, %.2f Mo/s\n", total_ops, seconds, rate, mb);
+    if (max_lag > 0) {
+        printf("Retard maximal sur la trace : %.3f ms\n", max_lag / 1e6);
+    }
+    if (csv != NULL) {
+        fprintf(csv, "total,%zu,,%lu,%.6f,%.1f,%.3f,,,,\n", total_ops, total_bytes, seconds, rate, mb);
+        if (fclose(csv) != 0) {
+            perror("Erreur lors de l'écriture du fichier CSV");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Fonction pour rejouer une trace d'opérations sur une partition.
+ * @param partition La partition.
+ * @param trace La trace, lue jusqu'à sa fin.
+ * @param timed 1 pour respecter les instants enregistrés, 0 pour rejouer à pleine vitesse.
+ * @param csv_path Le chemin du fichier CSV à créer, NULL pour n'afficher que le tableau.
+ * @return 0 si toutes les opérations ont réussi, -1 si la trace est invalide ou si une opération a échoué.
+ */
+int replayTrace(Partition* partition, FILE* trace, int timed, const char* csv_path) {
+    Replay* replay = calloc(1, sizeof(Replay));
+    if (replay == NULL) {
+        perror("Erreur lors de l'allocation de mémoire pour le rejeu");
+        return -1;
+    }
+    replay->partition = partition;
+
+    char line[REPLAY_MAX_LINE];
+    int line_number = 0, status = 0;
+    uint64_t start = nowNs(), max_lag = 0;
+    while (status == 0 && fgets(line, sizeof(line), trace) != NULL) {
+        line_number++;
+        unsigned long long at;
+        int offset = 0;
+        char first = '\0';
+        if (sscanf(line, " %c", &first) != 1 || first == '#') {
+            continue; // Ligne vide ou commentaire
+        }
+        if (strchr(line, '\n') == NULL && !feof(trace)) {
+            printf("Erreur : ligne %d de la trace trop longue.\n", line_number);
+            status = -1;
+            break;
+        }
+        if (sscanf(line, "%llu %n", &at, &offset) != 1) {
+            printf("Erreur : ligne %d de la trace sans instant.\n", line_number);
+            status = -1;
+            break;
+        }
+
+        if (timed) {
+            uint64_t target = start + at * 1000ull;
+            uint64_t now = nowNs();
+            if (now < target) {
+                sleepUntil(target);
+            } else if (now - target > max_lag) {
+                max_lag = now - target;
+            }
+        }
+        status = runLine(replay, line + offset, line_number);
+    }
+    double seconds = (nowNs() - start) / 1e9;
+
+    int errors = 0;
+    for (int i = 0; i < REPLAY_NUM_OPS; ++i) {
+        errors += replay->ops[i].errors;
+    }
+    if (status == 0 && (report(replay, seconds, max_lag, csv_path) == -1 || errors > 0)) {
+        status = -1;
+    }
+
+    for (int i = 0; i < REPLAY_NUM_OPS; ++i) {
+        free(replay->ops[i].latencies);
+    }
+    free(replay->files);
+    free(replay->buffer);
+    free(replay);
+    return status;
+}
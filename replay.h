@@ -0,0 +1,59 @@
+/**
+ * @file replay.h
+ * @brief Ce fichier contient les déclarations du rejeu non interactif d'une trace d'opérations sur une partition.
+ */
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <stdio.h>
+
+struct Partition;
+
+/**
+ * @def REPLAY_MAX_IO
+ * @brief Taille maximale d'une lecture ou d'une écriture de la trace, en octets.
+ */
+#define REPLAY_MAX_IO (16 * 1024 * 1024)
+
+/**
+ * @def REPLAY_MAX_LINE
+ * @brief Longueur maximale d'une ligne de la trace.
+ */
+#define REPLAY_MAX_LINE 512
+
+/**
+ * @brief Fonction pour rejouer une trace d'opérations sur une partition.
+ * 
+ * Chaque ligne de la trace décrit une opération, précédée de l'instant où
+ * elle a été enregistrée, en microsecondes depuis le début de la trace :
+ * 
+ *     <us> open <nom>
+ *     <us> write <nom> <octets>
+ *     <us> read <nom> <octets>
+ *     <us> seek <nom> <décalage> set|cur|end
+ *     <us> delete <nom>
+ *     <us> sync
+ *     <us> mkdir <nom>
+ * 
+ * Les noms sont des chemins depuis la racine de la partition, dont les
+ * répertoires sont créés par mkdir. Les lignes vides et celles commençant
+ * par # sont ignorées. Un fichier utilisé sans open préalable est ouvert
+ * (ou créé) à sa première opération, sans compter cette ouverture. Les
+ * écritures utilisent un contenu fixe.
+ * 
+ * Sans respect des instants, les opérations s'enchaînent aussi vite que
+ * possible ; sinon chacune attend son instant, et le retard maximal par
+ * rapport à la trace est rapporté. Le nombre d'opérations par seconde, le
+ * débit et les latences p50, p99 et p999 de chaque type d'opération sont
+ * affichés, et écrits au format CSV si un chemin est donné.
+ * 
+ * @param partition La partition.
+ * @param trace La trace, lue jusqu'à sa fin.
+ * @param timed 1 pour respecter les instants enregistrés, 0 pour rejouer à pleine vitesse.
+ * @param csv_path Le chemin du fichier CSV à créer, NULL pour n'afficher que le tableau.
+ * @return 0 si toutes les opérations ont réussi, -1 si la trace est invalide ou si une opération a échoué.
+ */
+int replayTrace(struct Partition* partition, FILE* trace, int timed, const char* csv_path);
+
+#endif /* REPLAY_H_ */
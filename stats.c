@@ -0,0 +1,266 @@
+/**
+ * @file stats.c
+ * @brief Ce fichier contient les définitions des compteurs d'activité et des histogrammes de latence, tenus par thread et additionnés à la lecture.
+ */
+
+#include <time.h>
+
+#include "projet.h"
+
+/**
+ * @brief Emplacement du thread courant, -1 tant qu'il n'en a reçu aucun.
+ */
+static __thread int thread_slot = -1;
+
+/**
+ * @brief Nombre d'appels de chaque fonction suivie restant avant le prochain appel chronométré du thread.
+ */
+static __thread unsigned char sample_countdown[STATS_NUM_OPS];
+
+/**
+ * @brief Emplacements attribués, un bit par emplacement : l'emplacement partagé 0 est toujours marqué.
+ */
+static uint64_t used_slots = 1;
+
+/**
+ * @brief Clé dont le destructeur rend son emplacement à la fin de chaque thread.
+ */
+static pthread_key_t slot_key;
+
+/**
+ * @brief Garantit la création unique de slot_key.
+ */
+static pthread_once_t slot_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Noms des fonctions suivies, indexés par STATS_OPEN à STATS_DELETE.
+ */
+static const char* op_names[STATS_NUM_OPS] = { "myOpen", "myRead", "myWrite", "mySeek", "deleteFileFromPartition" };
+
+/**
+ * @brief Descriptions des compteurs d'activité, indexées par STATS_SYSCALLS à STATS_DEDUP_NANOSECONDS.
+ */
+static const char* counter_names[STATS_NUM_COUNTERS] = {
+    "appels système", "blocs alloués", "blocs libérés", "succès du cache", "défauts du cache",
+    "succès du cache des entrées", "défauts du cache des entrées", "blocs corrompus", "blocs partagés",
+    "blocs copiés avant écriture", "octets à compresser", "octets compressés écrits",
+    "blocs empreintés à l'écriture", "blocs dédupliqués", "ns de déduplication à l'écriture"
+};
+
+/**
+ * @brief Rend l'emplacement d'un thread qui se termine.
+ * @param value L'emplacement plus un, associé au thread par pthread_setspecific.
+ */
+static void releaseSlot(void* value) {
+    // Le prochain propriétaire voit toutes les valeurs ajoutées par celui-ci
+    __atomic_fetch_and(&used_slots, ~(1ull << ((uintptr_t)value - 1)), __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Crée la clé qui rend les emplacements à la fin des threads.
+ */
+static void createSlotKey() {
+    pthread_key_create(&slot_key, releaseSlot);
+}
+
+/**
+ * @brief Attribue un emplacement libre au thread courant.
+ * @return L'emplacement, 0 (partagé) si tous sont attribués.
+ */
+static int claimSlot() {
+    pthread_once(&slot_once, createSlotKey);
+    uint64_t used = __atomic_load_n(&used_slots, __ATOMIC_RELAXED);
+    while (~used != 0) {
+        int slot = __builtin_ctzll(~used);
+        if (slot >= STATS_SLOTS) {
+            break;
+        }
+        if (__atomic_compare_exchange_n(&used_slots, &used, used | (1ull << slot), 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            pthread_setspecific(slot_key, (void*)(uintptr_t)(slot + 1));
+            return slot;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Ajoute une valeur à l'un des compteurs du thread courant.
+ * 
+ * Dans un emplacement propre au thread, la valeur est relue et réécrite
+ * sans instruction atomique de lecture-modification-écriture ; les lectures
+ * et écritures restent atomiques pour statsMerge.
+ * 
+ * @param counter Le compteur, dans l'emplacement du thread.
+ * @param value La valeur à ajouter.
+ */
+static void addCounter(unsigned long* counter, unsigned long value) {
+    if (thread_slot == 0) {
+        __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+    } else {
+        __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Renvoie les compteurs du thread courant, en lui attribuant un emplacement à son premier appel.
+ * @param table Les compteurs de la partition.
+ * @return Les compteurs du thread.
+ */
+static Stats* threadStats(StatsTable* table) {
+    if (thread_slot == -1) {
+        thread_slot = claimSlot();
+    }
+    return &table->slots[thread_slot].stats;
+}
+
+/**
+ * @brief Calcule la case de l'histogramme d'une latence.
+ * @param nanoseconds La latence.
+ * @return La case : le nombre de bits significatifs de la latence, borné par STATS_BUCKETS - 1.
+ */
+static int bucketOf(uint64_t nanoseconds) {
+    int bucket = nanoseconds == 0 ? 0 : 64 - __builtin_clzll(nanoseconds);
+    return bucket < STATS_BUCKETS ? bucket : STATS_BUCKETS - 1;
+}
+
+/**
+ * @brief Fonction pour initialiser les compteurs d'une partition.
+ * @param table Les compteurs à remettre à zéro.
+ */
+void statsInit(StatsTable* table) {
+    memset(table, 0, sizeof(StatsTable));
+}
+
+/**
+ * @brief Fonction pour lire l'horloge utilisée par les histogrammes.
+ * @return L'heure de l'horloge monotone, en nanosecondes.
+ */
+uint64_t statsNow() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @brief Fonction pour marquer le début d'un appel d'une fonction suivie.
+ * 
+ * Chaque fonction a son propre décompte : une alternance régulière de
+ * fonctions, comme mySeek suivi de myRead, ne fausse pas l'échantillon.
+ * 
+ * @param op La fonction, de STATS_OPEN à STATS_DELETE.
+ * @return L'heure du début de l'appel si celui-ci est chronométré, 0 sinon.
+ */
+uint64_t statsStart(int op) {
+    if (sample_countdown[op] > 0) {
+        sample_countdown[op]--;
+        return 0;
+    }
+    sample_countdown[op] = STATS_SAMPLE_PERIOD - 1;
+    return statsNow();
+}
+
+/**
+ * @brief Fonction pour enregistrer un appel d'une fonction suivie.
+ * @param table Les compteurs de la partition.
+ * @param op La fonction, de STATS_OPEN à STATS_DELETE.
+ * @param start La valeur renvoyée par statsStart au début de l'appel.
+ * @param result Le nombre d'octets transférés, négatif si l'appel a échoué.
+ */
+void statsRecord(StatsTable* table, int op, uint64_t start, long result) {
+    OpStats* counters = &threadStats(table)->ops[op];
+    addCounter(&counters->calls, 1);
+    if (result < 0) {
+        addCounter(&counters->errors, 1);
+    } else if (result > 0) {
+        addCounter(&counters->bytes, result);
+    }
+    if (start != 0) {
+        uint64_t elapsed = statsNow() - start;
+        addCounter(&counters->timed, 1);
+        addCounter(&counters->nanoseconds, elapsed);
+        addCounter(&counters->histogram[bucketOf(elapsed)], 1);
+    }
+}
+
+/**
+ * @brief Fonction pour ajouter une valeur à un compteur d'activité.
+ * @param table Les compteurs de la partition.
+ * @param counter Le compteur, de STATS_SYSCALLS à STATS_DEDUP_NANOSECONDS.
+ * @param value La valeur à ajouter.
+ */
+void statsAdd(StatsTable* table, int counter, unsigned long value) {
+    addCounter(&threadStats(table)->counters[counter], value);
+}
+
+/**
+ * @brief Fonction pour additionner les compteurs de tous les threads.
+ * 
+ * Les compteurs continuent d'avancer pendant la lecture : la somme n'est
+ * pas un instantané exact, mais chaque compteur est lu atomiquement.
+ * 
+ * @param table Les compteurs de la partition.
+ * @param stats La somme à remplir.
+ */
+void statsMerge(StatsTable* table, Stats* stats) {
+    memset(stats, 0, sizeof(Stats));
+    for (int s = 0; s < STATS_SLOTS; ++s) {
+        Stats* slot = &table->slots[s].stats;
+        for (int op = 0; op < STATS_NUM_OPS; ++op) {
+            OpStats* from = &slot->ops[op];
+            OpStats* to = &stats->ops[op];
+            to->calls += __atomic_load_n(&from->calls, __ATOMIC_RELAXED);
+            to->errors += __atomic_load_n(&from->errors, __ATOMIC_RELAXED);
+            to->bytes += __atomic_load_n(&from->bytes, __ATOMIC_RELAXED);
+            to->timed += __atomic_load_n(&from->timed, __ATOMIC_RELAXED);
+            to->nanoseconds += __atomic_load_n(&from->nanoseconds, __ATOMIC_RELAXED);
+            for (int b = 0; b < STATS_BUCKETS; ++b) {
+                to->histogram[b] += __atomic_load_n(&from->histogram[b], __ATOMIC_RELAXED);
+            }
+        }
+        for (int c = 0; c < STATS_NUM_COUNTERS; ++c) {
+            stats->counters[c] += __atomic_load_n(&slot->counters[c], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief Fonction pour estimer un centile de latence à partir d'un histogramme.
+ * @param op Les compteurs de la fonction.
+ * @param per_mille Le centile, en millièmes (500 pour la médiane).
+ * @return La borne supérieure de la case contenant le centile, en nanosecondes, 0 si aucun appel.
+ */
+uint64_t statsPercentile(const OpStats* op, unsigned per_mille) {
+    unsigned long total = 0;
+    for (int b = 0; b < STATS_BUCKETS; ++b) {
+        total += op->histogram[b];
+    }
+    // Rang de l'appel cherché parmi les appels triés par latence, à partir de 1
+    unsigned long rank = (total * per_mille + 999) / 1000;
+    unsigned long seen = 0;
+    for (int b = 0; b < STATS_BUCKETS && total > 0; ++b) {
+        seen += op->histogram[b];
+        if (seen >= rank) {
+            return b == 0 ? 0 : (1ull << b) - 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Fonction pour obtenir le nom d'une fonction suivie.
+ * @param op La fonction, de STATS_OPEN à STATS_DELETE.
+ * @return Le nom de la fonction.
+ */
+const char* statsOpName(int op) {
+    return op_names[op];
+}
+
+/**
+ * @brief Fonction pour obtenir la description d'un compteur d'activité.
+ * @param counter Le compteur, de STATS_SYSCALLS à STATS_DEDUP_NANOSECONDS.
+ * @return La description du compteur.
+ */
+const char* statsCounterName(int counter) {
+    return counter_names[counter];
+}
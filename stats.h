@@ -0,0 +1,280 @@
+/**
+ * @file stats.h
+ * @brief Ce fichier contient les déclarations des compteurs d'activité et des histogrammes de latence de l'API de fichiers.
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdint.h>
+
+/**
+ * @def STATS_SLOTS
+ * @brief Nombre d'emplacements de compteurs par partition (au plus 64) : l'emplacement 0 est partagé, les autres appartiennent chacun à un thread.
+ */
+#define STATS_SLOTS 32
+
+/**
+ * @def STATS_BUCKETS
+ * @brief Nombre de cases des histogrammes de latence.
+ * 
+ * La case 0 compte les latences nulles, la case b les latences comprises
+ * entre 2^(b-1) et 2^b - 1 nanosecondes ; la dernière case compte aussi
+ * toutes les latences plus longues.
+ */
+#define STATS_BUCKETS 32
+
+/**
+ * @def STATS_SAMPLE_PERIOD
+ * @brief Un appel sur STATS_SAMPLE_PERIOD de chaque fonction suivie est chronométré, par thread.
+ * 
+ * Lire l'horloge coûte autant qu'un petit myRead servi par le cache :
+ * chronométrer chaque appel en doublerait la durée. Les compteurs d'appels,
+ * d'erreurs et d'octets restent exacts.
+ */
+#define STATS_SAMPLE_PERIOD 8
+
+/**
+ * @def STATS_OPEN
+ * @brief Indice des compteurs de myOpen.
+ */
+#define STATS_OPEN 0
+
+/**
+ * @def STATS_READ
+ * @brief Indice des compteurs de myRead.
+ */
+#define STATS_READ 1
+
+/**
+ * @def STATS_WRITE
+ * @brief Indice des compteurs de myWrite.
+ */
+#define STATS_WRITE 2
+
+/**
+ * @def STATS_SEEK
+ * @brief Indice des compteurs de mySeek.
+ */
+#define STATS_SEEK 3
+
+/**
+ * @def STATS_DELETE
+ * @brief Indice des compteurs de deleteFileFromPartition.
+ */
+#define STATS_DELETE 4
+
+/**
+ * @def STATS_NUM_OPS
+ * @brief Nombre de fonctions suivies.
+ */
+#define STATS_NUM_OPS 5
+
+/**
+ * @def STATS_SYSCALLS
+ * @brief Indice du compteur des appels système d'entrée/sortie sur la partition (lectures, écritures, fdatasync, io_uring_enter).
+ */
+#define STATS_SYSCALLS 0
+
+/**
+ * @def STATS_BLOCKS_ALLOCATED
+ * @brief Indice du compteur des blocs de données alloués.
+ */
+#define STATS_BLOCKS_ALLOCATED 1
+
+/**
+ * @def STATS_BLOCKS_FREED
+ * @brief Indice du compteur des blocs de données libérés.
+ */
+#define STATS_BLOCKS_FREED 2
+
+/**
+ * @def STATS_CACHE_HITS
+ * @brief Indice du compteur des demandes satisfaites par le cache de blocs, recopié par myStats depuis les compteurs du cache.
+ */
+#define STATS_CACHE_HITS 3
+
+/**
+ * @def STATS_CACHE_MISSES
+ * @brief Indice du compteur des demandes ayant nécessité une lecture de la partition, recopié par myStats depuis les compteurs du cache.
+ */
+#define STATS_CACHE_MISSES 4
+
+/**
+ * @def STATS_DENTRY_HITS
+ * @brief Indice du compteur des noms de chemins trouvés dans le cache des entrées de répertoires.
+ */
+#define STATS_DENTRY_HITS 5
+
+/**
+ * @def STATS_DENTRY_MISSES
+ * @brief Indice du compteur des noms de chemins cherchés dans l'arbre de leur répertoire.
+ */
+#define STATS_DENTRY_MISSES 6
+
+/**
+ * @def STATS_CHECKSUM_ERRORS
+ * @brief Indice du compteur des blocs lus qui ne correspondent pas à leur code de contrôle.
+ */
+#define STATS_CHECKSUM_ERRORS 7
+
+/**
+ * @def STATS_BLOCKS_SHARED
+ * @brief Indice du compteur des blocs de données partagés par une copie de fichier (myClone, mySnapshot) sans être copiés.
+ */
+#define STATS_BLOCKS_SHARED 8
+
+/**
+ * @def STATS_BLOCKS_COPIED
+ * @brief Indice du compteur des blocs partagés copiés avant d'être écrits.
+ */
+#define STATS_BLOCKS_COPIED 9
+
+/**
+ * @def STATS_COMPRESS_INPUT
+ * @brief Indice du compteur des octets de données des fichiers compressés, avant compression.
+ */
+#define STATS_COMPRESS_INPUT 10
+
+/**
+ * @def STATS_COMPRESS_OUTPUT
+ * @brief Indice du compteur des octets de blocs écrits pour ces données, après compression.
+ */
+#define STATS_COMPRESS_OUTPUT 11
+
+/**
+ * @def STATS_DEDUP_HASHED
+ * @brief Indice du compteur des blocs entiers dont l'écriture a calculé et cherché l'empreinte.
+ */
+#define STATS_DEDUP_HASHED 12
+
+/**
+ * @def STATS_DEDUP_BLOCKS
+ * @brief Indice du compteur des blocs économisés par la déduplication : blocs partagés au lieu d'être écrits et copies fusionnées par myDedup.
+ */
+#define STATS_DEDUP_BLOCKS 13
+
+/**
+ * @def STATS_DEDUP_NANOSECONDS
+ * @brief Indice du compteur du temps passé par les écritures à dédupliquer leurs blocs, en nanosecondes.
+ */
+#define STATS_DEDUP_NANOSECONDS 14
+
+/**
+ * @def STATS_NUM_COUNTERS
+ * @brief Nombre de compteurs d'activité hors fonctions suivies.
+ */
+#define STATS_NUM_COUNTERS 15
+
+/**
+ * @struct OpStats
+ * @brief Compteurs et histogramme de latence d'une fonction de l'API.
+ */
+typedef struct {
+    unsigned long calls; /**< Appels. */
+    unsigned long errors; /**< Appels en erreur. */
+    unsigned long bytes; /**< Octets lus ou écrits. */
+    unsigned long timed; /**< Appels chronométrés, un sur STATS_SAMPLE_PERIOD. */
+    unsigned long nanoseconds; /**< Durée cumulée des appels chronométrés. */
+    unsigned long histogram[STATS_BUCKETS]; /**< Nombre d'appels chronométrés par case de latence. */
+} OpStats;
+
+/**
+ * @struct Stats
+ * @brief Compteurs d'activité d'une partition, ceux d'un thread ou leur somme.
+ */
+typedef struct {
+    OpStats ops[STATS_NUM_OPS]; /**< Compteurs de chaque fonction suivie, indexés par STATS_OPEN à STATS_DELETE. */
+    unsigned long counters[STATS_NUM_COUNTERS]; /**< Autres compteurs, indexés par STATS_SYSCALLS à STATS_DEDUP_NANOSECONDS. */
+} Stats;
+
+/**
+ * @struct StatsSlot
+ * @brief Emplacement de compteurs, aligné sur une ligne de cache pour que deux threads n'écrivent jamais dans la même.
+ */
+typedef struct {
+    _Alignas(64) Stats stats; /**< Compteurs des threads associés à l'emplacement. */
+} StatsSlot;
+
+/**
+ * @struct StatsTable
+ * @brief Compteurs d'activité d'une partition, répartis entre les threads.
+ * 
+ * Chaque thread reçoit à son premier compteur un emplacement qui lui
+ * appartient jusqu'à sa fin, le même pour toutes les partitions : il y
+ * ajoute ses valeurs sans verrou ni instruction atomique de
+ * lecture-modification-écriture. Au-delà de STATS_SLOTS - 1 threads
+ * vivants, les threads supplémentaires partagent l'emplacement 0 avec des
+ * additions atomiques. Les emplacements ne sont additionnés qu'à la
+ * lecture, par statsMerge.
+ */
+typedef struct {
+    StatsSlot slots[STATS_SLOTS]; /**< Emplacements des threads. */
+} StatsTable;
+
+/**
+ * @brief Fonction pour initialiser les compteurs d'une partition.
+ * @param table Les compteurs à remettre à zéro.
+ */
+void statsInit(StatsTable* table);
+
+/**
+ * @brief Fonction pour lire l'horloge utilisée par les histogrammes.
+ * @return L'heure de l'horloge monotone, en nanosecondes.
+ */
+uint64_t statsNow();
+
+/**
+ * @brief Fonction pour marquer le début d'un appel d'une fonction suivie.
+ * @param op La fonction, de STATS_OPEN à STATS_DELETE.
+ * @return L'heure du début de l'appel si celui-ci est chronométré, 0 sinon.
+ */
+uint64_t statsStart(int op);
+
+/**
+ * @brief Fonction pour enregistrer un appel d'une fonction suivie.
+ * @param table Les compteurs de la partition.
+ * @param op La fonction, de STATS_OPEN à STATS_DELETE.
+ * @param start La valeur renvoyée par statsStart au début de l'appel.
+ * @param result Le nombre d'octets transférés, négatif si l'appel a échoué.
+ */
+void statsRecord(StatsTable* table, int op, uint64_t start, long result);
+
+/**
+ * @brief Fonction pour ajouter une valeur à un compteur d'activité.
+ * @param table Les compteurs de la partition.
+ * @param counter Le compteur, de STATS_SYSCALLS à STATS_DEDUP_NANOSECONDS.
+ * @param value La valeur à ajouter.
+ */
+void statsAdd(StatsTable* table, int counter, unsigned long value);
+
+/**
+ * @brief Fonction pour additionner les compteurs de tous les threads.
+ * @param table Les compteurs de la partition.
+ * @param stats La somme à remplir.
+ */
+void statsMerge(StatsTable* table, Stats* stats);
+
+/**
+ * @brief Fonction pour estimer un centile de latence à partir d'un histogramme.
+ * @param op Les compteurs de la fonction.
+ * @param per_mille Le centile, en millièmes (500 pour la médiane).
+ * @return La borne supérieure de la case contenant le centile, en nanosecondes, 0 si aucun appel.
+ */
+uint64_t statsPercentile(const OpStats* op, unsigned per_mille);
+
+/**
+ * @brief Fonction pour obtenir le nom d'une fonction suivie.
+ * @param op La fonction, de STATS_OPEN à STATS_DELETE.
+ * @return Le nom de la fonction.
+ */
+const char* statsOpName(int op);
+
+/**
+ * @brief Fonction pour obtenir la description d'un compteur d'activité.
+ * @param counter Le compteur, de STATS_SYSCALLS à STATS_DEDUP_NANOSECONDS.
+ * @return La description du compteur.
+ */
+const char* statsCounterName(int counter);
+
+#endif /* STATS_H_ */